@@ -128,7 +128,7 @@ namespace uedit
         std::vector< std::size_t > mSelectedMultiColliders;
         bool mMousePressed;
         PointDraggerSet<ungod::RigidbodyComponent<CONTEXT>> mColliderPointDraggers;
-        owls::SignalLink<void, ungod::Entity, const sf::FloatRect&> mLink;
+        owls::SlotLink<ungod::Entity, const sf::FloatRect&> mLink;
         EntityCollidersWindow<CONTEXT>& mCollidersWindow;
     };
 
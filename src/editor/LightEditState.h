@@ -3,6 +3,7 @@
 
 #include "EntityEditState.h"
 #include "ungod/visual/Light.h"
+#include "owls/SlotSignal.h"
 #include "PointDragger.h"
 
 namespace uedit
@@ -67,7 +68,7 @@ namespace uedit
         std::vector< std::size_t > mSelectedMultiColliders;
         const EntityLightWindow& mEntityLightWindow;
         PointDraggerSet<ungod::ShadowEmitterComponent> mShadowEmitterDraggers;
-        owls::SignalLink<void, ungod::Entity, const sf::FloatRect&> mLink;
+        owls::SlotLink<ungod::Entity, const sf::FloatRect&> mLink;
 
         static constexpr float DRAG_DISTANCE = 20.0f;
 
@@ -74,15 +74,19 @@ namespace uedit
 
     void TilemapActions::floodFillTileMap(ungod::Entity e, unsigned ix, unsigned iy, const std::vector<int>& replacementIDs)
     {
-        const ungod::TileMap& tm = e.get<ungod::TileMapComponent>().getTileMap();
-        ungod::TileData oldData;
-        unsigned oldmapx = tm.getMapSizeX();
-        unsigned oldmapy = tm.getMapSizeY();
-        oldData.ids = std::make_shared<std::vector<int>>(*tm.getTileData().ids);
-        mActionManager.action(std::function([this, ix, iy, replacementIDs](ungod::Entity e)
-            { e.getWorld().getTileMapHandler().floodFillTileMap(e, ix, iy, replacementIDs); }),
-            std::function([this, oldData, oldmapx, oldmapy](ungod::Entity e)
-                { e.getWorld().getTileMapHandler().setTiles(e, oldData, oldmapx, oldmapy); }),
+        //the fill is performed once, redo replays the recorded changes to reproduce random replacements
+        auto changes = std::make_shared<ungod::TileChangeSet>();
+        auto filled = std::make_shared<bool>(false);
+        mActionManager.action(std::function([this, ix, iy, replacementIDs, changes, filled](ungod::Entity e)
+            {
+                if (*filled)
+                    e.getWorld().getTileMapHandler().applyTileChanges(e, *changes);
+                else
+                    *changes = e.getWorld().getTileMapHandler().floodFillTileMap(e, ix, iy, replacementIDs);
+                *filled = true;
+            }),
+            std::function([this, changes](ungod::Entity e)
+                { e.getWorld().getTileMapHandler().applyTileChanges(e, *changes, true); }),
             e);
     }
 
@@ -111,10 +115,9 @@ namespace uedit
     void TilemapActions::extend(ungod::Entity e, unsigned leftExtend, unsigned topExtend, unsigned rightExtend, unsigned bottomExtend, int id)
     {
         const ungod::TileMap& tm = e.get<ungod::TileMapComponent>().getTileMap();
-        ungod::TileData oldData;
+        ungod::TileData oldData = tm.getTileData();
         unsigned oldmapx = tm.getMapSizeX();
         unsigned oldmapy = tm.getMapSizeY();
-        oldData.ids = std::make_shared<std::vector<int>>(*tm.getTileData().ids);
         mActionManager.action(std::function([this, leftExtend, topExtend, rightExtend, bottomExtend, id](ungod::Entity e)
             { e.getWorld().getTileMapHandler().extendTilemap(e, leftExtend, topExtend, rightExtend, bottomExtend, id); }),
             std::function([this, oldData, oldmapx, oldmapy](ungod::Entity e)
@@ -14,7 +14,7 @@ namespace uedit
     {
         ungod::TileMap const* tm = &mPreview.mEntity.modify<ungod::TileMapComponent>().getTileMap();
 
-        if (!tm->getTileData().ids)
+        if (tm->getTileStorage().empty())
             return;
 
 		if (!preview.mEntity.has<ungod::TransformComponent>())
@@ -64,7 +64,7 @@ namespace uedit
     {
         ungod::TileMap const* tm = &mPreview.mEntity.modify<ungod::TileMapComponent>().getTileMap();
 
-        if (!tm->getTileData().ids)
+        if (tm->getTileStorage().empty())
             return;
 
         if (!mPreview.mEntity.has<ungod::VisualsComponent>())
@@ -111,7 +111,7 @@ namespace uedit
     {
         ungod::TileMap const* tm = &mPreview.mEntity.modify<ungod::TileMapComponent>().getTileMap();
 
-        if (!tm->getTileData().ids)
+        if (tm->getTileStorage().empty())
             return;
 
         if (mMouseDown)
@@ -197,7 +197,7 @@ namespace uedit
     {
         ungod::TileMap const* tm = &mPreview.mEntity.modify<ungod::TileMapComponent>().getTileMap();
 
-        if (!tm->getTileData().ids)
+        if (tm->getTileStorage().empty())
             return;
 
         switch (event.type)
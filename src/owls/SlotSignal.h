@@ -0,0 +1,259 @@
+/*
+* This is owls - a single file and header only framework for signals and event emitting.
+* Copyright (C) 2016 Felix Becker - fb132550@uni-greifswald.de
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+
+#ifndef OWLS_SLOT_SIGNAL_H
+#define OWLS_SLOT_SIGNAL_H
+
+#include <functional>
+#include <vector>
+#include <tuple>
+#include <type_traits>
+#include <algorithm>
+
+namespace owls
+{
+    template <typename ... PARAM> class SlotSignal;
+
+    /** \brief A linkage object between a SlotSignal and one of its callbacks. Is returned by
+    * the connect method of SlotSignal and can be used to disconnect later. */
+    template<typename ... PARAM>
+    class SlotLink
+    {
+    friend class SlotSignal<PARAM...>;
+    public:
+        SlotLink() : mSignal(nullptr), mID(0) {}
+
+        /** \brief Can be called to disconnect this linkage. The
+        * callback attached at the connect-call, that returned this SlotLink
+        * will be removed from the signals slots. */
+        void disconnect();
+
+    private:
+        SlotLink(SlotSignal<PARAM...>* signal, unsigned id) : mSignal(signal), mID(id) {}
+
+    private:
+        SlotSignal<PARAM...>* mSignal;
+        unsigned mID;
+    };
+
+
+    /** \brief A signal with the same interface as Signal, that keeps its callbacks in a contiguous
+    * vector of slots instead of a linked list of ref counted handlers. Emitting to no listeners
+    * is a single size check and emitting to n listeners is a linear walk over n slots.
+    * Callbacks connected during an emit are invoked from the next emit on, callbacks disconnected
+    * during an emit are skipped immediately and removed once the outermost emit returns.
+    * Additionally, emissions can be deferred: defer() copies the arguments into a queue that is
+    * emitted in order on the next flush(), which allows a handler to batch the emissions of a frame.
+    * Emissions deferred while no callback is connected are dropped.
+    */
+    template<typename ... PARAM>
+    class SlotSignal
+    {
+    friend class SlotLink<PARAM...>;
+    public:
+        using Callback = std::function<void(PARAM...)>;
+        using LinkCallback = std::function<void(SlotLink<PARAM...>, PARAM...)>;
+
+        SlotSignal() : mNextID(1), mEmitDepth(0), mDirty(false) {}
+        SlotSignal(const SlotSignal& other) = delete;
+
+        /** \brief Connects a new callback. The returned SlotLink can be used to disconnect later. */
+        SlotLink<PARAM...> connect(const Callback& callback);
+
+        /** \brief Connects a new (linked) callback. The returned SlotLink can be used to disconnect later. */
+        SlotLink<PARAM...> connect(const LinkCallback& callback);
+
+        /** \brief Disconnects all callbacks. */
+        void disconnectAll();
+
+        std::size_t callbackCount() const { return mSlots.size() + mPending.size(); }
+
+        /** \brief Emits the given parameters to all connected callbacks. */
+        void emit(PARAM... param);
+
+        /** \brief Emits the given parameters to all connected callbacks. */
+        void operator()(PARAM... param) { emit(param...); }
+
+        /** \brief Queues an emission. The arguments are copied and passed to the callbacks on the next flush. */
+        void defer(PARAM... param);
+
+        /** \brief Emits all deferred emissions in the order they were queued. */
+        void flush();
+
+        /** \brief Returns the number of deferred emissions waiting for a flush. */
+        std::size_t deferredCount() const { return mDeferred.size(); }
+
+    private:
+        struct Slot
+        {
+            Callback callback;
+            unsigned id; ///<0 marks a slot that was disconnected during an emit
+        };
+
+        std::vector<Slot> mSlots;
+        std::vector<Slot> mPending; ///<slots connected during an emit
+        std::vector< std::tuple<std::decay_t<PARAM>...> > mDeferred;
+        unsigned mNextID;
+        unsigned mEmitDepth;
+        bool mDirty;
+
+    private:
+        void disconnect(unsigned id);
+        void compact();
+        template<std::size_t ... I>
+        void emitDeferred(const std::tuple<std::decay_t<PARAM>...>& args, std::index_sequence<I...>);
+    };
+
+
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////IMPLEMENTATION////////////////////////////////////////////////////////////////
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    template<typename ... PARAM>
+    void SlotLink<PARAM...>::disconnect()
+    {
+        if (mSignal)
+        {
+            mSignal->disconnect(mID);
+            mSignal = nullptr;
+        }
+    }
+
+
+
+    template<typename ... PARAM>
+    SlotLink<PARAM...> SlotSignal<PARAM...>::connect(const Callback& callback)
+    {
+        unsigned id = mNextID++;
+        //pushing to mSlots while emitting could reallocate the callback that is currently running
+        (mEmitDepth > 0 ? mPending : mSlots).push_back(Slot{ callback, id });
+        return SlotLink<PARAM...>(this, id);
+    }
+
+    template<typename ... PARAM>
+    SlotLink<PARAM...> SlotSignal<PARAM...>::connect(const LinkCallback& callback)
+    {
+        SlotLink<PARAM...> link(this, mNextID);
+        return connect( Callback([callback, link](PARAM ... param) { callback(link, param...); }) );
+    }
+
+    template<typename ... PARAM>
+    void SlotSignal<PARAM...>::disconnectAll()
+    {
+        mPending.clear();
+        if (mEmitDepth > 0)
+        {
+            for (auto& slot : mSlots) slot.id = 0;
+            mDirty = true;
+        }
+        else
+            mSlots.clear();
+    }
+
+    template<typename ... PARAM>
+    void SlotSignal<PARAM...>::emit(PARAM... param)
+    {
+        if (mSlots.empty())
+            return;
+        ++mEmitDepth;
+        //index based, slots connected meanwhile are parked in mPending until the outermost emit returns
+        for (std::size_t i = 0; i < mSlots.size(); ++i)
+        {
+            if (mSlots[i].id != 0)
+                mSlots[i].callback( param... );
+        }
+        if (--mEmitDepth == 0 && (mDirty || !mPending.empty()))
+            compact();
+    }
+
+    template<typename ... PARAM>
+    void SlotSignal<PARAM...>::defer(PARAM... param)
+    {
+        if (!mSlots.empty() || !mPending.empty())
+            mDeferred.emplace_back(param...);
+    }
+
+    template<typename ... PARAM>
+    void SlotSignal<PARAM...>::flush()
+    {
+        //swap out first, so that callbacks may defer new emissions for the next flush
+        std::vector< std::tuple<std::decay_t<PARAM>...> > deferred;
+        deferred.swap(mDeferred);
+        for (const auto& args : deferred)
+            emitDeferred(args, std::index_sequence_for<PARAM...>{});
+        if (mDeferred.empty())
+        {
+            deferred.clear();
+            mDeferred.swap(deferred); //keep the capacity for the next frame
+        }
+    }
+
+    template<typename ... PARAM>
+    template<std::size_t ... I>
+    void SlotSignal<PARAM...>::emitDeferred(const std::tuple<std::decay_t<PARAM>...>& args, std::index_sequence<I...>)
+    {
+        emit( std::get<I>(args)... );
+    }
+
+    template<typename ... PARAM>
+    void SlotSignal<PARAM...>::disconnect(unsigned id)
+    {
+        auto pending = std::find_if(mPending.begin(), mPending.end(), [id] (const Slot& s) { return s.id == id; });
+        if (pending != mPending.end())
+        {
+            mPending.erase(pending);
+            return;
+        }
+        auto slot = std::find_if(mSlots.begin(), mSlots.end(), [id] (const Slot& s) { return s.id == id; });
+        if (slot == mSlots.end())
+            return;
+        if (mEmitDepth > 0)
+        {
+            slot->id = 0;
+            mDirty = true;
+        }
+        else
+            mSlots.erase(slot);
+    }
+
+    template<typename ... PARAM>
+    void SlotSignal<PARAM...>::compact()
+    {
+        if (mDirty)
+        {
+            mSlots.erase(std::remove_if(mSlots.begin(), mSlots.end(), [] (const Slot& s) { return s.id == 0; }), mSlots.end());
+            mDirty = false;
+        }
+        for (auto& slot : mPending)
+            mSlots.push_back(std::move(slot));
+        mPending.clear();
+    }
+}
+
+#endif // OWLS_SLOT_SIGNAL_H
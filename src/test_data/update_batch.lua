@@ -0,0 +1,12 @@
+normal = ungod.newStateBehavior("normal")
+
+function normal.onInit(static, instance)
+    instance.updates = 0
+end
+
+function normal.onBatchUpdate(static, instances, delta)
+    for i = 1, #instances do
+        local instance = instances[i]
+        instance.updates = instance.updates + 1
+    end
+end
@@ -0,0 +1,9 @@
+normal = ungod.newStateBehavior("normal")
+
+function normal.onInit(static, instance)
+    instance.updates = 0
+end
+
+function normal.onUpdate(static, instance, delta)
+    instance.updates = instance.updates + 1
+end
@@ -0,0 +1,244 @@
+/*
+* This file is part of the ungod - framework.
+* Copyright (C) 2016 Felix Becker - fb132550@uni-greifswald.de
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#include "ungod/AI/InferenceService.h"
+#include <algorithm>
+
+namespace ungod
+{
+    namespace AI
+    {
+        namespace detail
+        {
+            unsigned roundUpPow2(unsigned n)
+            {
+                unsigned p = 1;
+                while (p < n)
+                    p <<= 1;
+                return p;
+            }
+        }
+
+
+        InferenceService::InferenceService(const InferenceSettings& settings) :
+            mSettings(settings), mBusy(false), mRunning(false), mInvocations(0), mProcessed(0)
+        {
+            mSettings.maxBatchSize = std::max(1u, mSettings.maxBatchSize);
+        }
+
+
+        InferenceService::~InferenceService()
+        {
+            stopWorker();
+        }
+
+
+        bool InferenceService::setModel(Model model)
+        {
+            stopWorker();
+            mPending.clear();
+            mSubmitted.clear();
+            mInputSizes.clear();
+            if (!mPredictor.setModel(model, mSettings.numThreads))
+                return false;
+
+            for (std::size_t i = 0; i < mPredictor.getInputCount(); i++)
+            {
+                const std::vector<int>& dims = mPredictor.getModelInputDims(i);
+                std::size_t size = 1;
+                for (std::size_t d = 1; d < dims.size(); d++)
+                    size *= (std::size_t)dims[d];
+                mInputSizes.push_back(size);
+            }
+            //outputs are only typed after the first allocation
+            mPredictor.setBatchSize(1);
+            for (std::size_t i = 0; i < mPredictor.getInputCount(); i++)
+                if (!mPredictor.getInput<float>(i))
+                {
+                    Logger::warning("Inference service requires float inputs.");
+                    return false;
+                }
+            for (std::size_t i = 0; i < mPredictor.getOutputCount(); i++)
+                if (!mPredictor.getOutput<float>(i))
+                {
+                    Logger::warning("Inference service requires float outputs.");
+                    return false;
+                }
+
+            if (mSettings.threaded)
+            {
+                mRunning = true;
+                mWorker = std::thread(&InferenceService::workerLoop, this);
+            }
+            return true;
+        }
+
+
+        bool InferenceService::request(Samples inputs, const Callback& callback)
+        {
+            if (inputs.size() != mInputSizes.size())
+            {
+                Logger::warning("Inference request with", inputs.size(), "inputs for a model with", mInputSizes.size(), "inputs.");
+                return false;
+            }
+            for (std::size_t i = 0; i < inputs.size(); i++)
+                if (inputs[i].size() != mInputSizes[i])
+                {
+                    Logger::warning("Inference request input", i, "has size", inputs[i].size(), "but the model expects", mInputSizes[i]);
+                    return false;
+                }
+            mPending.push_back(Request{ std::move(inputs), callback, {}, false });
+            return true;
+        }
+
+
+        void InferenceService::tick()
+        {
+            std::vector<Request> done;
+            if (mSettings.threaded)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    if (mBusy) //the previous batch is still running, keep queueing
+                        return;
+                    done.swap(mSubmitted);
+                    if (!mPending.empty())
+                    {
+                        mSubmitted.swap(mPending);
+                        mBusy = true;
+                    }
+                }
+                mCondition.notify_all();
+            }
+            else
+            {
+                done.swap(mPending);
+                run(done);
+            }
+            deliver(done);
+        }
+
+
+        void InferenceService::flush()
+        {
+            std::vector<Request> done;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock, [this] { return !mBusy; });
+                done.swap(mSubmitted);
+            }
+            deliver(done);
+            done.clear();
+            //the worker is idle, so the interpreter can be used from here
+            done.swap(mPending);
+            run(done);
+            deliver(done);
+        }
+
+
+        void InferenceService::workerLoop()
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            while (true)
+            {
+                mCondition.wait(lock, [this] { return mBusy || !mRunning; });
+                if (!mRunning)
+                    return;
+                lock.unlock();
+                run(mSubmitted);
+                lock.lock();
+                mBusy = false;
+                mCondition.notify_all();
+            }
+        }
+
+
+        void InferenceService::stopWorker()
+        {
+            if (!mWorker.joinable())
+                return;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock, [this] { return !mBusy; });
+                mRunning = false;
+            }
+            mCondition.notify_all();
+            mWorker.join();
+        }
+
+
+        void InferenceService::run(std::vector<Request>& requests)
+        {
+            for (std::size_t offset = 0; offset < requests.size(); offset += mSettings.maxBatchSize)
+            {
+                std::size_t count = std::min<std::size_t>(mSettings.maxBatchSize, requests.size() - offset);
+                unsigned batchSize = std::min(detail::roundUpPow2((unsigned)count), mSettings.maxBatchSize);
+                if (!mPredictor.setBatchSize((int)batchSize))
+                {
+                    Logger::warning("Could not allocate tensors for an inference batch of size", batchSize);
+                    return;
+                }
+
+                //pack the samples row by row, padding rows are zero
+                for (std::size_t i = 0; i < mInputSizes.size(); i++)
+                {
+                    float* data = mPredictor.getInput<float>(i);
+                    for (std::size_t r = 0; r < count; r++)
+                        std::copy(requests[offset + r].inputs[i].begin(), requests[offset + r].inputs[i].end(), data + r*mInputSizes[i]);
+                    std::fill(data + count*mInputSizes[i], data + batchSize*mInputSizes[i], 0.0f);
+                }
+
+                if (!mPredictor.invoke())
+                {
+                    Logger::warning("Inference invocation failed for a batch of", count, "requests.");
+                    continue;
+                }
+                mInvocations++;
+
+                //scatter the output rows back to the requests
+                for (std::size_t r = 0; r < count; r++)
+                    requests[offset + r].outputs.resize(mPredictor.getOutputCount());
+                for (std::size_t o = 0; o < mPredictor.getOutputCount(); o++)
+                {
+                    const float* data = mPredictor.getOutput<float>(o);
+                    std::size_t rowSize = mPredictor.getOutputSize(o) / batchSize;
+                    for (std::size_t r = 0; r < count; r++)
+                        requests[offset + r].outputs[o].assign(data + r*rowSize, data + (r + 1)*rowSize);
+                }
+                for (std::size_t r = 0; r < count; r++)
+                    requests[offset + r].ok = true;
+                mProcessed += count;
+            }
+        }
+
+
+        void InferenceService::deliver(std::vector<Request>& requests)
+        {
+            for (auto& request : requests)
+                if (request.ok && request.callback)
+                    request.callback(request.outputs);
+        }
+    }
+}
@@ -0,0 +1,129 @@
+/*
+* This file is part of the ungod - framework.
+* Copyright (C) 2016 Felix Becker - fb132550@uni-greifswald.de
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#ifndef UNGOD_AI_INFERENCE_SERVICE_H
+#define UNGOD_AI_INFERENCE_SERVICE_H
+
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include "ungod/AI/Predictor.h"
+
+namespace ungod
+{
+    namespace AI
+    {
+        /** \brief Settings of an InferenceService. */
+        struct InferenceSettings
+        {
+            InferenceSettings() : maxBatchSize(256), numThreads(1), threaded(false) {}
+
+            unsigned maxBatchSize; ///< maximum number of requests packed into a single invocation
+            int numThreads; ///< threads the interpreter may use within an invocation
+            bool threaded; ///< if true, invocations run on a worker thread
+        };
+
+        /**
+        * \brief Collects prediction requests of many actors and answers them with few batched invocations of a model.
+        * Every input and output of the model is expected to be a float tensor whose first dimension is the batch.
+        * Requests are queued during a frame, tick packs them into the input tensors, invokes the interpreter once per
+        * maxBatchSize requests and scatters the output rows back to the callbacks of the requests.
+        * Batch sizes are rounded up to a power of two, so that the interpreter rarely reallocates its tensors.
+        * If threaded, tick hands the queued requests to a worker and delivers the results of the previous tick,
+        * the main thread never waits for the interpreter. Callbacks are always invoked on the thread calling tick.
+        */
+        class InferenceService
+        {
+        public:
+            using Samples = std::vector<std::vector<float>>; ///< one sample per model input or output
+            using Callback = std::function<void(const Samples& outputs)>;
+
+            InferenceService(const InferenceSettings& settings = InferenceSettings());
+            InferenceService(const InferenceService&) = delete;
+            InferenceService& operator=(const InferenceService&) = delete;
+            ~InferenceService();
+
+            /** \brief Loads the model. Returns false if it can not be interpreted or has non float inputs or outputs. */
+            bool setModel(Model model);
+
+            /** \brief Queues a request. inputs holds a sample for each model input, in the order of the model inputs and
+            * with the size of the input without its batch dimension. Returns false if the inputs do not match the model. */
+            bool request(Samples inputs, const Callback& callback);
+
+            /** \brief Runs the queued requests and delivers the results, see class description. */
+            void tick();
+
+            /** \brief Waits for the worker, runs all queued requests and delivers all results. */
+            void flush();
+
+            /** \brief Returns the number of values of a sample for the i-th model input. */
+            std::size_t getInputSize(std::size_t i) const { return mInputSizes[i]; }
+
+            std::size_t getInputCount() const { return mInputSizes.size(); }
+
+            /** \brief Returns the number of requests waiting for the next tick. */
+            std::size_t getPendingCount() const { return mPending.size(); }
+
+            /** \brief Returns the number of interpreter invocations so far. */
+            unsigned getInvocations() const { return mInvocations.load(); }
+
+            /** \brief Returns the number of requests answered so far. */
+            std::size_t getProcessedRequests() const { return mProcessed.load(); }
+
+        private:
+            struct Request
+            {
+                Samples inputs;
+                Callback callback;
+                Samples outputs;
+                bool ok;
+            };
+
+            InferenceSettings mSettings;
+            Predictor mPredictor;
+            std::vector<std::size_t> mInputSizes;
+            std::vector<Request> mPending; ///< only touched by the thread calling request and tick
+            std::vector<Request> mSubmitted; ///< owned by the worker while mBusy is set
+            std::mutex mMutex;
+            std::condition_variable mCondition;
+            std::thread mWorker;
+            bool mBusy;
+            bool mRunning;
+            std::atomic<unsigned> mInvocations;
+            std::atomic<std::size_t> mProcessed;
+
+        private:
+            void workerLoop();
+            void stopWorker();
+            void run(std::vector<Request>& requests);
+            void deliver(std::vector<Request>& requests);
+        };
+    }
+}
+
+#endif // UNGOD_AI_INFERENCE_SERVICE_H
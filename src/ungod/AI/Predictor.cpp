@@ -29,23 +29,80 @@ namespace ungod
 {
     namespace AI
     {
-        bool Predictor::setModel(Model model)
+        bool Predictor::setModel(Model model, int numThreads)
         {
+            mInterpreter.reset();
+            mInputIDs.clear();
+            mInputDims.clear();
+            mCurInputDims.clear();
+            mBatchSize = -1;
+            if (!model.isLoaded())
+                return false;
             tflite::ops::builtin::BuiltinOpResolver resolver;
             tflite::InterpreterBuilder builder(*model.get(), resolver);
             builder(&mInterpreter);
             ungod::Logger::assertion((bool)mInterpreter, "Failed to build interpreter.");
-            if (mInterpreter)
-                mInterpreter->SetNumThreads(1);
-            return (bool)mInterpreter;
+            if (!mInterpreter)
+                return false;
+            mModel = model;
+            mInterpreter->SetNumThreads(numThreads);
+            for (std::size_t i = 0; i < mInterpreter->inputs().size(); i++)
+            {
+                mInputIDs.emplace(mInterpreter->GetInputName((int)i), (int)i);
+                const TfLiteTensor* tensor = mInterpreter->input_tensor(i);
+                mInputDims.emplace_back(tensor->dims->data, tensor->dims->data + tensor->dims->size);
+            }
+            return mInterpreter->AllocateTensors() == kTfLiteOk;
         }
 
-        int Predictor::getInputTensorID(const std::string& name)
+        bool Predictor::invoke()
         {
-            for (int i = 0; i < mInterpreter->inputs().size(); i++)
-                if (mInterpreter->GetInputName(i) == name)
-                    return i;
-            return -1;
+            return mInterpreter->Invoke() == kTfLiteOk;
+        }
+
+        int Predictor::getInputTensorID(const std::string& name) const
+        {
+            auto id = mInputIDs.find(name);
+            return id != mInputIDs.end() ? id->second : -1;
+        }
+
+        std::size_t Predictor::getOutputCount() const
+        {
+            return mInterpreter ? mInterpreter->outputs().size() : 0;
+        }
+
+        bool Predictor::setBatchSize(int batchSize)
+        {
+            if (batchSize == mBatchSize)
+                return true;
+            mBatchSize = batchSize;
+            for (std::size_t i = 0; i < mInputDims.size(); i++)
+            {
+                std::vector<int> dims = mInputDims[i];
+                dims[0] = batchSize;
+                resizeInput((int)i, dims);
+            }
+            return mInterpreter->AllocateTensors() == kTfLiteOk;
+        }
+
+        std::size_t Predictor::getOutputSize(std::size_t i) const
+        {
+            const TfLiteTensor* tensor = mInterpreter->output_tensor(i);
+            std::size_t size = 1;
+            for (int d = 0; d < tensor->dims->size; d++)
+                size *= (std::size_t)tensor->dims->data[d];
+            return size;
+        }
+
+        bool Predictor::resizeInput(int id, const std::vector<int>& dims)
+        {
+            //inputs are addressed by their position, the interpreter resizes by tensor index
+            auto& current = mCurInputDims[mInterpreter->GetInputName(id)];
+            if (current == dims)
+                return false;
+            current = dims;
+            mInterpreter->ResizeInputTensor(mInterpreter->inputs()[id], dims);
+            return true;
         }
     }
 }
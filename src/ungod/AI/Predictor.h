@@ -57,31 +57,57 @@ namespace ungod
         /** 
         * \brief An predictor that feeds an input to an underlying machine learning model and returns the computed output.
         * Is also responsible for loading and interpreting a model before inference.
+        * Names, tensor ids and the shapes of the model inputs are looked up once when the model is set.
         */
         class Predictor
         {
         public:
-            Predictor() = default;
+            Predictor() : mBatchSize(-1) {}
 
-            bool setModel(Model model);
+            /** \brief Builds the interpreter for the given model. numThreads is the number of threads
+            * the interpreter may use within a single invocation. */
+            bool setModel(Model model, int numThreads = 1);
 
             /** \brief Returns input tensors to set. Reallocates on first invoke and every invoke with dims unqual to the 
             * previous call. */
             template<typename T>
             std::unordered_map<std::string, Tensor<T>> getInputTensors(const std::vector<std::string>& names, const std::vector<std::vector< int >>& dims);
 
-            /** \brief Invokes the model and returns the computed output tensors. */
+            /** \brief Invokes the model. The computed output tensors can be accessed afterwards. */
+            bool invoke();
 
+            /** \brief Returns the index of the model input with the given name or -1 if there is none. */
+            int getInputTensorID(const std::string& name) const;
+
+            std::size_t getInputCount() const { return mInputDims.size(); }
+            std::size_t getOutputCount() const;
+
+            /** \brief Returns the shape of the i-th input as stored in the model. */
+            const std::vector<int>& getModelInputDims(std::size_t i) const { return mInputDims[i]; }
+
+            /** \brief Resizes the first dimension of all inputs to the given batch size. Tensors are only
+            * reallocated if the size changed. */
+            bool setBatchSize(int batchSize);
+
+            /** \brief Returns the data of the i-th input or output tensor. */
+            template<typename T>
+            T* getInput(std::size_t i) { return mInterpreter->typed_input_tensor<T>((int)i); }
+            template<typename T>
+            const T* getOutput(std::size_t i) const { return mInterpreter->typed_output_tensor<T>((int)i); }
+
+            /** \brief Returns the number of elements of the i-th output tensor. */
+            std::size_t getOutputSize(std::size_t i) const;
 
         private:
-            Model mModel;
+            Model mModel; ///<the interpreter refers to the model buffer, so it is kept alive here
             std::unique_ptr<tflite::Interpreter> mInterpreter;
-            int mCurNumNodes;
-            int mCurNumEdges;
+            std::unordered_map<std::string, int> mInputIDs;
+            std::vector<std::vector<int>> mInputDims;
             std::unordered_map<std::string, std::vector< int >> mCurInputDims;
+            int mBatchSize;
 
         private:
-            int getInputTensorID(const std::string& name);
+            bool resizeInput(int id, const std::vector<int>& dims);
         };
 
 
@@ -91,7 +117,7 @@ namespace ungod
         void Tensor<T>::set(const std::vector<int>& pos, T t)
         {
             T* toset = mData;
-            for (int dim = 0; dim < mShape.size(); dim++)
+            for (int dim = 0; dim < (int)mShape.size(); dim++)
                 toset += pos[dim] * dimsBelow(dim);
             (*toset) = t;
         }
@@ -100,8 +126,8 @@ namespace ungod
         int Tensor<T>::dimsBelow(int dim)
         {
             int dims = 1;
-            for (int i = dim + 1; i < mShape.size(); i++)
-                dims *= mShape[dim];
+            for (int i = dim + 1; i < (int)mShape.size(); i++)
+                dims *= mShape[i];
             return dims;
         }
 
@@ -113,24 +139,19 @@ namespace ungod
             ungod::Logger::assertion(names.size() == this->mInterpreter->inputs().size(), "number of model inputs and requested tensors do not match");
             std::unordered_map<std::string, Tensor<T>> inputs;
             bool allocationRequired = false;
-            std::vector<int> ids{ names.size() };
-            for (int i = 0; i < names.size(); i++)
+            std::vector<int> ids(names.size());
+            for (std::size_t i = 0; i < names.size(); i++)
             {
                 ids[i] = this->getInputTensorID(names[i]);
                 ungod::Logger::assertion(ids[i] != -1, "no input tensor with name " + names[i]);
-                auto batch = this->mCurInputDims.insert({ names[i], {-1} }).first;
-                if (batch->second != dims[i])
-                {
+                if (resizeInput(ids[i], dims[i]))
                     allocationRequired = true;
-                    batch->second = dims[i];
-                    this->mInterpreter->ResizeInputTensor(ids[i], dims[i]);
-                }
             }
             if (allocationRequired)
                 ungod::Logger::assertion(this->mInterpreter->AllocateTensors() == kTfLiteOk, "can not allocate tensors");
-            for (int i = 0; i < names.size(); i++)
+            for (std::size_t i = 0; i < names.size(); i++)
             {
-                inputs.emplace(names[i], this->mInterpreter->typed_input_tensor<T>(ids[i]), dims[i]);
+                inputs.emplace(names[i], Tensor<T>(this->mInterpreter->typed_input_tensor<T>(ids[i]), dims[i]));
             }
             return inputs;
         }
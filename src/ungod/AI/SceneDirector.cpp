@@ -23,7 +23,9 @@
 *    source distribution.
 */
 
-#include "ungod/AI/TreeSearch.h"
+#include "ungod/AI/SceneDirector.h"
+#include "ungod/base/Transform.h"
+#include "ungod/physics/Movement.h"
 #include <cmath>
 #include <limits>
 
@@ -31,6 +33,245 @@ namespace ungod
 {
     namespace AI
     {
+        namespace detail
+        {
+            constexpr float DIAGONAL = 0.70710678f;
 
+            //acceleration directions of the actor actions, action 0 is idle
+            const sf::Vector2f ACTION_DIRECTIONS[SceneSimulator::ACTION_COUNT] =
+            {
+                { 0.0f, 0.0f },
+                { 0.0f, -1.0f }, { DIAGONAL, -DIAGONAL }, { 1.0f, 0.0f }, { DIAGONAL, DIAGONAL },
+                { 0.0f, 1.0f }, { -DIAGONAL, DIAGONAL }, { -1.0f, 0.0f }, { -DIAGONAL, -DIAGONAL }
+            };
+        }
+
+
+        constexpr unsigned SceneSimulator::ACTION_COUNT;
+        constexpr unsigned SceneSimulator::DEFAULT_HORIZON;
+        constexpr float SceneSimulator::DEFAULT_DELTA;
+        constexpr std::size_t SceneSimulator::INVALID_BODY;
+
+
+        SceneSimulator::SceneSimulator(unsigned horizon, float delta) : mShared(std::make_shared<Shared>()), mStep(0)
+        {
+            mShared->actors = 0;
+            mShared->horizon = horizon;
+            mShared->delta = delta;
+        }
+
+
+        SceneSimulator::SceneSimulator(const SceneSpecs& specs, unsigned horizon, float delta) : SceneSimulator(horizon, delta)
+        {
+            auto extract = [this] (const std::vector<Entity>& entities, bool opponent)
+            {
+                for (auto e : entities)
+                {
+                    if (!e.has<TransformComponent>())
+                        continue;
+                    sf::FloatRect bounds = e.get<TransformComponent>().getBounds();
+                    sf::Vector2f halfSize{ bounds.width / 2, bounds.height / 2 };
+                    sf::Vector2f center{ bounds.left + halfSize.x, bounds.top + halfSize.y };
+                    if (e.has<MovementComponent>())
+                    {
+                        const MovementComponent& movement = e.get<MovementComponent>();
+                        std::size_t i = addBody(center, halfSize, opponent, movement.getMaxForce(), movement.getMaxVelocity(), movement.getBaseSpeed());
+                        mMobility[i].velocity = movement.getVelocity();
+                    }
+                    else
+                        addBody(center, halfSize, opponent, 0.0f, 0.0f, 0.0f);
+                }
+            };
+            extract(specs.mActors, false);
+            extract(specs.mOpponents, true);
+            setGlobalAttributes(specs.mGlobalAttributes);
+            snapshot();
+        }
+
+
+        std::size_t SceneSimulator::addBody(const sf::Vector2f& center, const sf::Vector2f& halfSize, bool opponent,
+                                            float maxForce, float maxVelocity, float baseSpeed)
+        {
+            if (!opponent && getActorCount() < mPosition.size())
+            {
+                Logger::warning("Actors must be added to a scene simulator before opponents. Rejecting the actor.");
+                return INVALID_BODY;
+            }
+            Shared& shared = modifyShared();
+            if (!opponent)
+                shared.actors++;
+            shared.halfSize.push_back(halfSize);
+            shared.maxForce.push_back(maxForce);
+            shared.maxVelocity.push_back(maxVelocity);
+            shared.baseSpeed.push_back(baseSpeed);
+            mPosition.push_back(center);
+            mMobility.emplace_back();
+            shared.initialPosition = mPosition;
+            shared.initialMobility = mMobility;
+            return mPosition.size() - 1;
+        }
+
+
+        void SceneSimulator::setGlobalAttributes(const std::vector<float>& globals)
+        {
+            modifyShared().globals = globals;
+        }
+
+
+        void SceneSimulator::setValueFunction(const ValueFunction& value)
+        {
+            modifyShared().value = value;
+        }
+
+
+        void SceneSimulator::snapshot()
+        {
+            Shared& shared = modifyShared();
+            shared.initialPosition = mPosition;
+            shared.initialMobility = mMobility;
+            mStep = 0;
+            mPendingActions.clear();
+        }
+
+
+        void SceneSimulator::reset()
+        {
+            mPosition = mShared->initialPosition;
+            mMobility = mShared->initialMobility;
+            mStep = 0;
+            mPendingActions.clear();
+        }
+
+
+        void SceneSimulator::applyActions(const std::vector<int>& actions)
+        {
+            for (std::size_t i = 0; i < mShared->actors && i < actions.size(); i++)
+                if (actions[i] > 0 && actions[i] < (int)ACTION_COUNT)
+                    accelerate(mMobility[i], detail::ACTION_DIRECTIONS[actions[i]], 1.0f);
+            step();
+        }
+
+
+        void SceneSimulator::step()
+        {
+            const Shared& shared = *mShared;
+            if (shared.actors > 0)
+                for (std::size_t i = shared.actors; i < mPosition.size(); i++)
+                {
+                    std::size_t target = 0;
+                    float best = std::numeric_limits<float>::max();
+                    for (std::size_t a = 0; a < shared.actors; a++)
+                    {
+                        float d = sqMagnitude(mPosition[a] - mPosition[i]);
+                        if (d < best)
+                        {
+                            best = d;
+                            target = a;
+                        }
+                    }
+                    seek(mMobility[i], mPosition[i], mPosition[target], 1.0f);
+                }
+
+            //same integration as the MovementHandler
+            for (std::size_t i = 0; i < mPosition.size(); i++)
+            {
+                if (shared.baseSpeed[i] > 0.0f)
+                {
+                    mobilize(mMobility[i], shared.maxForce[i], shared.maxVelocity[i]);
+                    mPosition[i] += shared.delta * shared.baseSpeed[i] * mMobility[i].velocity;
+                }
+                resetAcceleration(mMobility[i]);
+            }
+
+            separate();
+            mStep++;
+        }
+
+
+        std::unique_ptr<SearchEnvironment> SceneSimulator::clone() const
+        {
+            return std::unique_ptr<SearchEnvironment>(new SceneSimulator(*this));
+        }
+
+
+        void SceneSimulator::assign(const SearchEnvironment& other)
+        {
+            //vectors keep their capacity, so this does not allocate once the sizes match
+            const SceneSimulator& sim = static_cast<const SceneSimulator&>(other);
+            mShared = sim.mShared;
+            mPosition = sim.mPosition;
+            mMobility = sim.mMobility;
+            mPendingActions = sim.mPendingActions;
+            mStep = sim.mStep;
+        }
+
+
+        void SceneSimulator::apply(unsigned action)
+        {
+            mPendingActions.push_back((int)action);
+            if (mPendingActions.size() >= mShared->actors)
+            {
+                applyActions(mPendingActions);
+                mPendingActions.clear();
+            }
+        }
+
+
+        float SceneSimulator::getValue() const
+        {
+            return mShared->value ? mShared->value(*this) : 0.0f;
+        }
+
+
+        std::size_t SceneSimulator::getObservationSize() const
+        {
+            return 4 * mPosition.size() + mShared->globals.size();
+        }
+
+
+        void SceneSimulator::getObservation(float* out) const
+        {
+            for (std::size_t i = 0; i < mPosition.size(); i++)
+            {
+                *out++ = mPosition[i].x;
+                *out++ = mPosition[i].y;
+                *out++ = mMobility[i].velocity.x;
+                *out++ = mMobility[i].velocity.y;
+            }
+            for (float g : mShared->globals)
+                *out++ = g;
+        }
+
+
+        SceneSimulator::Shared& SceneSimulator::modifyShared()
+        {
+            if (mShared.use_count() > 1)
+                mShared = std::make_shared<Shared>(*mShared);
+            return *mShared;
+        }
+
+
+        void SceneSimulator::separate()
+        {
+            //scenes contain few bodies, so all pairs are tested
+            const Shared& shared = *mShared;
+            for (std::size_t i = 0; i < mPosition.size(); i++)
+                for (std::size_t j = i + 1; j < mPosition.size(); j++)
+                {
+                    sf::Vector2f d = mPosition[j] - mPosition[i];
+                    float overlapX = shared.halfSize[i].x + shared.halfSize[j].x - std::abs(d.x);
+                    float overlapY = shared.halfSize[i].y + shared.halfSize[j].y - std::abs(d.y);
+                    if (overlapX <= 0.0f || overlapY <= 0.0f)
+                        continue;
+                    float mobileI = shared.baseSpeed[i] > 0.0f ? 1.0f : 0.0f;
+                    float mobileJ = shared.baseSpeed[j] > 0.0f ? 1.0f : 0.0f;
+                    if (mobileI + mobileJ == 0.0f)
+                        continue;
+                    sf::Vector2f push = overlapX < overlapY ? sf::Vector2f{ d.x < 0.0f ? -overlapX : overlapX, 0.0f } :
+                                                              sf::Vector2f{ 0.0f, d.y < 0.0f ? -overlapY : overlapY };
+                    mPosition[i] -= push * (mobileI / (mobileI + mobileJ));
+                    mPosition[j] += push * (mobileJ / (mobileI + mobileJ));
+                }
+        }
     }
 }
@@ -23,16 +23,23 @@
 *    source distribution.
 */
 
-#ifndef UNGOD_AI_TREE_SEARCH_H
-#define UNGOD_AI_TREE_SEARCH_H
+#ifndef UNGOD_AI_SCENE_DIRECTOR_H
+#define UNGOD_AI_SCENE_DIRECTOR_H
 
 #include <tuple>
+#include <memory>
+#include <functional>
+#include <limits>
 #include "ungod/AI/Predictor.h"
 #include "ungod/AI/SceneSpecs.h"
+#include "ungod/AI/TreeSearch.h"
+#include "ungod/physics/MobilityUnit.h"
 #include "ungod/serialization/Serializable.h"
 
 namespace ungod
 {
+    class World;
+
     namespace AI
     {
         /** \brief Extracts SceneSpecs from a world and passes them to a TreeSearch predictor. */
@@ -54,27 +61,103 @@ namespace ungod
         * system tries to look ahead through a tree search based simulation. */
         class DynamicObjectComponent : public Serializable<DynamicObjectComponent>
         {
-        }
+        };
 
         /** \brief A resetable view on a scene with dynamic objects that can be used to conduct a simulation that looks ahead
-        * to decide on actions. Does not modify the underlying world and its contents when simulating. */
-        class SceneSimulator
+        * to decide on actions. Does not modify the underlying world and its contents when simulating.
+        * The scene is reduced to plain arrays of bodies, actors first, then opponents. Only positions and mobility units
+        * change during a simulation, all other properties are shared between copies, so that copying a simulator is cheap.
+        * A step applies the steering math of the MovementHandler to all bodies and separates overlapping bounding boxes
+        * along the axis of least penetration. Actors are controlled by actions, opponents seek the nearest actor. */
+        class SceneSimulator : public SearchEnvironment
         {
         public:
-            SceneSimulator() = default;
+            static constexpr unsigned ACTION_COUNT = 9; ///<idle and acceleration towards one of 8 directions
+            static constexpr unsigned DEFAULT_HORIZON = 64; ///<number of steps until the simulation is terminal
+            static constexpr float DEFAULT_DELTA = 20.0f; ///<simulated milliseconds per step
+            static constexpr std::size_t INVALID_BODY = std::numeric_limits<std::size_t>::max(); ///<returned for rejected bodies
+
+            using ValueFunction = std::function<float(const SceneSimulator&)>;
+
+        public:
+            SceneSimulator(unsigned horizon = DEFAULT_HORIZON, float delta = DEFAULT_DELTA);
+
+            /** \brief Extracts the actors and opponents of the scene. Entities without transform are skipped,
+            * entities without movement component are immovable. */
+            SceneSimulator(const SceneSpecs& specs, unsigned horizon = DEFAULT_HORIZON, float delta = DEFAULT_DELTA);
+
+            /** \brief Adds a body with the given center and half extents of its bounding box. Returns its index.
+            * Actors must be added before opponents, an actor added after an opponent is rejected and INVALID_BODY is returned. */
+            std::size_t addBody(const sf::Vector2f& center, const sf::Vector2f& halfSize, bool opponent,
+                                float maxForce = 1.0f, float maxVelocity = 1.0f, float baseSpeed = 0.2f);
+
+            void setGlobalAttributes(const std::vector<float>& globals);
 
-            /** \brief Resets the simulator to the state where it was constructed. */
+            /** \brief Sets the function that rates the current state. Without a function, every state has value 0. */
+            void setValueFunction(const ValueFunction& value);
+
+            /** \brief Makes the current state the state reset returns to. */
+            void snapshot();
+
+            /** \brief Resets the simulator to the state where it was constructed or last snapshot. */
             void reset();
 
-            /** \brief Applies the given actions to all actors. */
+            /** \brief Applies the given actions to all actors and advances the simulation by a single step. */
             void applyActions(const std::vector<int>& actions);
 
+            /** \brief Advances the simulation by a single step, actors keep drifting. */
+            void step();
+
+            std::size_t getBodyCount() const { return mPosition.size(); }
+            std::size_t getActorCount() const { return mShared->actors; }
+            std::size_t getOpponentCount() const { return mPosition.size() - mShared->actors; }
+            const sf::Vector2f& getPosition(std::size_t i) const { return mPosition[i]; }
+            const sf::Vector2f& getVelocity(std::size_t i) const { return mMobility[i].velocity; }
+            unsigned getStepCount() const { return mStep; }
+            const std::vector<float>& getGlobalAttributes() const { return mShared->globals; }
+
+            /** \brief Search interface. Every call of apply chooses the action of the next actor,
+            * the simulation steps once all actors have an action. */
+            virtual std::unique_ptr<SearchEnvironment> clone() const override;
+            virtual void assign(const SearchEnvironment& other) override;
+            virtual unsigned getActionCount() const override { return ACTION_COUNT; }
+            virtual bool isValid(unsigned action) const override { return action < ACTION_COUNT && !isTerminal(); }
+            virtual void apply(unsigned action) override;
+            virtual bool isTerminal() const override { return mStep >= mShared->horizon; }
+            virtual float getValue() const override;
+            virtual std::size_t getObservationSize() const override;
+            virtual void getObservation(float* out) const override;
+
         private:
+            /** \brief Data that does not change during a simulation. */
+            struct Shared
+            {
+                std::vector<sf::Vector2f> halfSize;
+                std::vector<float> maxForce;
+                std::vector<float> maxVelocity;
+                std::vector<float> baseSpeed;
+                std::vector<float> globals;
+                std::vector<sf::Vector2f> initialPosition;
+                std::vector<MobilityUnit> initialMobility;
+                std::size_t actors;
+                unsigned horizon;
+                float delta;
+                ValueFunction value;
+            };
+
+            std::shared_ptr<Shared> mShared;
+            std::vector<sf::Vector2f> mPosition;
+            std::vector<MobilityUnit> mMobility;
+            std::vector<int> mPendingActions;
+            unsigned mStep;
 
+        private:
+            /** \brief Returns the shared data for modification, copying it if other simulators refer to it. */
+            Shared& modifyShared();
+            void separate();
         };
     }
 }
 
 
-#endif // UNGOD_AI_TREE_SEARCH_H
-
+#endif // UNGOD_AI_SCENE_DIRECTOR_H
@@ -23,8 +23,8 @@
 *    source distribution.
 */
 
-#ifndef UNGOD_AI_TREE_SEARCH_H
-#define UNGOD_AI_TREE_SEARCH_H
+#ifndef UNGOD_AI_SCENE_SPECS_H
+#define UNGOD_AI_SCENE_SPECS_H
 
 #include "ungod/base/Entity.h"
 
@@ -44,5 +44,5 @@ namespace ungod
 }
 
 
-#endif // UNGOD_AI_TREE_SEARCH_H
+#endif // UNGOD_AI_SCENE_SPECS_H
 
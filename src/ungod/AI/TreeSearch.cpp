@@ -26,69 +26,381 @@
 #include "ungod/AI/TreeSearch.h"
 #include <cmath>
 #include <limits>
+#include <random>
+#include <algorithm>
 
 namespace ungod
 {
     namespace AI
     {
-        /*MonteCarloNode::MonteCarloNode(float prior) : mVisitCount(0), mPrior(prior), mValueSum(0.0f) {}
+        namespace detail
+        {
+            inline void atomicAdd(std::atomic<float>& target, float value)
+            {
+                float current = target.load(std::memory_order_relaxed);
+                while (!target.compare_exchange_weak(current, current + value, std::memory_order_relaxed)) {}
+            }
+        }
+
+
+        void PredictorEvaluator::evaluate(const std::vector<const SearchEnvironment*>& leaves, std::vector<float>& logits, std::vector<float>& values)
+        {
+            std::fill(logits.begin(), logits.end(), 0.0f);
+            std::fill(values.begin(), values.end(), 0.0f);
+            if (leaves.empty())
+                return;
+            std::size_t observationSize = leaves.front()->getObservationSize();
+            std::size_t actions = leaves.front()->getActionCount();
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mPredictor.getOutputCount() < 2 || !mPredictor.setBatchSize((int)leaves.size()))
+            {
+                Logger::warning("Predictor can not evaluate a batch of", leaves.size(), "leaves.");
+                return;
+            }
+            float* input = mPredictor.getInput<float>(0);
+            for (std::size_t i = 0; i < leaves.size(); i++)
+                leaves[i]->getObservation(input + i*observationSize);
+            if (!mPredictor.invoke())
+            {
+                Logger::warning("Predictor invocation failed during tree search.");
+                return;
+            }
+            if (mPredictor.getOutputSize(0) != leaves.size()*actions || mPredictor.getOutputSize(1) != leaves.size())
+            {
+                Logger::warning("Predictor outputs do not match the action count of the search environment.");
+                return;
+            }
+            std::copy(mPredictor.getOutput<float>(0), mPredictor.getOutput<float>(0) + leaves.size()*actions, logits.begin());
+            std::copy(mPredictor.getOutput<float>(1), mPredictor.getOutput<float>(1) + leaves.size(), values.begin());
+        }
+
+
+        void RolloutEvaluator::evaluate(const std::vector<const SearchEnvironment*>& leaves, std::vector<float>& logits, std::vector<float>& values)
+        {
+            thread_local std::minstd_rand rng((unsigned)std::hash<std::thread::id>()(std::this_thread::get_id()));
+            thread_local std::vector<unsigned> valid;
+            std::fill(logits.begin(), logits.end(), 0.0f);
+            for (std::size_t i = 0; i < leaves.size(); i++)
+            {
+                auto env = leaves[i]->clone();
+                for (unsigned depth = 0; depth < mMaxDepth && !env->isTerminal(); depth++)
+                {
+                    valid.clear();
+                    for (unsigned a = 0; a < env->getActionCount(); a++)
+                        if (env->isValid(a))
+                            valid.push_back(a);
+                    if (valid.empty())
+                        break;
+                    env->apply(valid[rng() % valid.size()]);
+                }
+                values[i] = env->getValue();
+            }
+        }
+
+
+        TreeSearch::TreeSearch(LeafEvaluator& evaluator, const SearchSettings& settings) :
+            mEvaluator(evaluator), mSettings(settings), mRoot(nullptr), mBudget(0), mCompleted(0), mGeneration(0), mActive(0), mRunning(true)
+        {
+            mSettings.threads = std::max(1u, mSettings.threads);
+            mSettings.batchSize = std::max(1u, mSettings.batchSize);
+            mSettings.maxNodes = std::max(1u, mSettings.maxNodes);
+            unsigned trees = mSettings.rootParallel ? mSettings.threads : 1;
+            for (unsigned i = 0; i < trees; i++)
+            {
+                mArenas.emplace_back(new Arena());
+                mArenas.back()->nodes.reset(new Node[mSettings.maxNodes]);
+                mArenas.back()->capacity = (int)mSettings.maxNodes;
+                resetArena(*mArenas.back());
+            }
+            for (unsigned i = 1; i < mSettings.threads; i++)
+                mWorkers.emplace_back(&TreeSearch::workerLoop, this, i);
+        }
+
+
+        TreeSearch::~TreeSearch()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mRunning = false;
+            }
+            mCondition.notify_all();
+            for (auto& worker : mWorkers)
+                worker.join();
+        }
+
+
+        const std::vector<unsigned>& TreeSearch::search(const SearchEnvironment& root)
+        {
+            mVisits.assign(root.getActionCount(), 0);
+            mRoot = &root;
+            mCompleted = 0;
+            mBudget = (int)mSettings.simulations;
+            for (auto& arena : mArenas)
+                resetArena(*arena);
+
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mGeneration++;
+                mActive = (unsigned)mWorkers.size();
+            }
+            mCondition.notify_all();
+            simulate(0);
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock, [this] { return mActive == 0; });
+            }
+
+            for (const auto& arena : mArenas)
+            {
+                const Node& node = arena->nodes[0];
+                if (node.state.load() != EXPANDED)
+                    continue;
+                for (int c = node.firstChild; c < node.firstChild + node.childCount; c++)
+                    mVisits[arena->nodes[c].action] += (unsigned)arena->nodes[c].visits.load();
+            }
+            mRoot = nullptr;
+            return mVisits;
+        }
 
-        bool MonteCarloNode::isLeaf() const
+
+        int TreeSearch::decide(const SearchEnvironment& root)
         {
-            return mChildren.empty();
+            search(root);
+            int best = -1;
+            for (unsigned a = 0; a < mVisits.size(); a++)
+                if (root.isValid(a) && (best < 0 || mVisits[a] > mVisits[best]))
+                    best = (int)a;
+            return best;
         }
 
-        float MonteCarloNode::value() const
+
+        std::size_t TreeSearch::getNodeCount() const
         {
-            if mVisitCount == 0
-                return 0.0f;
-            else
-                return mValueSum / mVisitCount;
+            std::size_t count = 0;
+            for (const auto& arena : mArenas)
+                count += (std::size_t)std::min(arena->size.load(), arena->capacity);
+            return count;
+        }
+
+
+        void TreeSearch::workerLoop(unsigned index)
+        {
+            unsigned generation = 0;
+            std::unique_lock<std::mutex> lock(mMutex);
+            while (true)
+            {
+                mCondition.wait(lock, [this, generation] { return !mRunning || mGeneration != generation; });
+                if (!mRunning)
+                    return;
+                generation = mGeneration;
+                lock.unlock();
+                simulate(index);
+                lock.lock();
+                if (--mActive == 0)
+                    mCondition.notify_all();
+            }
         }
 
-        void MonteCarloNode::expand(const std::vector<float>& logits, const std::vector<bool>& valid)
+
+        void TreeSearch::simulate(unsigned index)
         {
-            ungod::Logger::assertion(mChildren.empty(), "Can not expand a non leaf.");
-            ungod::Logger::assertion(logits.size() == valid.size(), "Logit and valid vectors do not have matching sizes.");
-            float expSum = 0.0f;
-            for (int i = 0; i < logits.size(); i++)
+            Arena& arena = mSettings.rootParallel ? *mArenas[index] : *mArenas[0];
+            //root parallel threads share nothing, not even the simulation budget
+            std::atomic<int> ownBudget((int)(mSettings.simulations / mSettings.threads + (index < mSettings.simulations % mSettings.threads ? 1 : 0)));
+            std::atomic<int>& budget = mSettings.rootParallel ? ownBudget : mBudget;
+
+            std::size_t actions = mRoot->getActionCount();
+            std::vector<Leaf> leaves(mSettings.batchSize);
+            for (auto& leaf : leaves)
+                leaf.env = mRoot->clone();
+            std::vector<const SearchEnvironment*> batch;
+            std::vector<float> logits;
+            std::vector<float> values;
+
+            while (true)
             {
-                if (valid[i])
+                std::size_t count = 0;
+                bool collided = false;
+                while (count < leaves.size() && !collided && budget.fetch_sub(1) > 0)
+                {
+                    Leaf& leaf = leaves[count];
+                    leaf.env->assign(*mRoot);
+                    leaf.path.assign(1, 0);
+                    arena.nodes[0].visits.fetch_add(1, std::memory_order_relaxed);
+                    detail::atomicAdd(arena.nodes[0].valueSum, -mSettings.virtualLoss);
+                    int current = 0;
+                    while (true)
+                    {
+                        Node& node = arena.nodes[current];
+                        uint8_t state = node.state.load(std::memory_order_acquire);
+                        if (state == EXPANDED)
+                        {
+                            if (node.childCount == 0)
+                            {
+                                backup(arena, leaf.path, node.terminalValue);
+                                break;
+                            }
+                            current = selectChild(arena, node);
+                            Node& child = arena.nodes[current];
+                            child.visits.fetch_add(1, std::memory_order_relaxed);
+                            detail::atomicAdd(child.valueSum, -mSettings.virtualLoss);
+                            leaf.env->apply(child.action);
+                            leaf.path.push_back(current);
+                            continue;
+                        }
+                        if (state == UNEXPANDED && node.state.compare_exchange_strong(state, (uint8_t)EXPANDING, std::memory_order_acquire))
+                        {
+                            if (leaf.env->isTerminal())
+                            {
+                                float value = leaf.env->getValue();
+                                expand(arena, node, *leaf.env, nullptr, value);
+                                backup(arena, leaf.path, value);
+                            }
+                            else
+                                count++;
+                            break;
+                        }
+                        //the leaf is already being evaluated, give the simulation back and evaluate what we have
+                        revert(arena, leaf.path);
+                        budget.fetch_add(1);
+                        collided = true;
+                        break;
+                    }
+                }
+
+                if (count == 0)
                 {
-                    float expLogit = exp(logits[i]);
-                    mChildren.emplace(i, std::make_unique<MonteCarloNode>(expLogit));
-                    expSum += expLogit;
+                    if (!collided)
+                        return;
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                batch.clear();
+                for (std::size_t i = 0; i < count; i++)
+                    batch.push_back(leaves[i].env.get());
+                logits.resize(count*actions);
+                values.resize(count);
+                mEvaluator.evaluate(batch, logits, values);
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    expand(arena, arena.nodes[leaves[i].path.back()], *leaves[i].env, logits.data() + i*actions, values[i]);
+                    backup(arena, leaves[i].path, values[i]);
                 }
             }
-            for (auto& element : mChildren)
-                element.second->mPrior /= expSum;
         }
 
-        std::tuple<int, MonteCarloNode*> MonteCarloNode::selectChild(float pbCBase, float pbCInit)
-        {   
-            //compute UCB score for each child and return the node with the highest value
-            int action = -1; 
-            MonteCarloNode* child = nullptr;
+
+        void TreeSearch::resetArena(Arena& arena)
+        {
+            arena.size = 1;
+            Node& root = arena.nodes[0];
+            root.firstChild = -1;
+            root.childCount = 0;
+            root.action = 0;
+            root.prior = 1.0f;
+            root.terminalValue = 0.0f;
+            root.visits = 0;
+            root.valueSum = 0.0f;
+            root.state = UNEXPANDED;
+        }
+
+
+        int TreeSearch::allocate(Arena& arena, unsigned count)
+        {
+            int first = arena.size.fetch_add((int)count, std::memory_order_relaxed);
+            if (first + (int)count > arena.capacity)
+                return -1;
+            return first;
+        }
+
+
+        int TreeSearch::selectChild(const Arena& arena, const Node& node) const
+        {
+            //PUCT score, visits include the virtual visits of concurrent simulations
+            float parentVisits = (float)node.visits.load(std::memory_order_relaxed);
+            float pbc = (std::log((parentVisits + mSettings.pbCBase + 1.0f) / mSettings.pbCBase) + mSettings.pbCInit) * std::sqrt(parentVisits);
+            int best = node.firstChild;
             float bestScore = std::numeric_limits<float>::lowest();
-            for (auto& element : mChildren)
+            for (int c = node.firstChild; c < node.firstChild + node.childCount; c++)
             {
-                float pbc = log((mVisitCount + pbCBase + 1) / pbCBase) + pbCInit;
-                pbc *= sqrt(mVisitCount / (element.second->mVisitCount + 1));
-                float ucbScore = pbc * element.second->mPrior + element.second->value();
+                const Node& child = arena.nodes[c];
+                int visits = child.visits.load(std::memory_order_relaxed);
+                float value = visits > 0 ? child.valueSum.load(std::memory_order_relaxed) / visits : 0.0f;
+                float score = value + pbc * child.prior / (1.0f + visits);
+                if (score > bestScore)
+                {
+                    best = c;
+                    bestScore = score;
+                }
+            }
+            return best;
+        }
+
 
-                if (ucbScore > bestScore)
+        void TreeSearch::expand(Arena& arena, Node& node, const SearchEnvironment& env, const float* logits, float value)
+        {
+            node.firstChild = -1;
+            node.childCount = 0;
+            node.terminalValue = value;
+            if (logits)
+            {
+                unsigned valid = 0;
+                float maxLogit = std::numeric_limits<float>::lowest();
+                for (unsigned a = 0; a < env.getActionCount(); a++)
+                    if (env.isValid(a))
+                    {
+                        valid++;
+                        maxLogit = std::max(maxLogit, logits[a]);
+                    }
+                //a full arena turns the leaf into a node with a fixed value
+                int first = valid > 0 ? allocate(arena, valid) : -1;
+                if (first >= 0)
                 {
-                    action = element.first;
-                    child = element.second.get();
-                    bestScore = ucbScore;
+                    float expSum = 0.0f;
+                    int c = first;
+                    for (unsigned a = 0; a < env.getActionCount(); a++)
+                    {
+                        if (!env.isValid(a))
+                            continue;
+                        Node& child = arena.nodes[c++];
+                        child.firstChild = -1;
+                        child.childCount = 0;
+                        child.action = (uint16_t)a;
+                        child.prior = std::exp(logits[a] - maxLogit);
+                        child.terminalValue = 0.0f;
+                        child.visits.store(0, std::memory_order_relaxed);
+                        child.valueSum.store(0.0f, std::memory_order_relaxed);
+                        child.state.store(UNEXPANDED, std::memory_order_relaxed);
+                        expSum += child.prior;
+                    }
+                    for (c = first; c < first + (int)valid; c++)
+                        arena.nodes[c].prior /= expSum;
+                    node.firstChild = first;
+                    node.childCount = (uint16_t)valid;
                 }
             }
-            return { action, child };
+            node.state.store(EXPANDED, std::memory_order_release);
         }
 
-        void TreeSearch::decide(const SceneSpecs& scene)
+
+        void TreeSearch::backup(Arena& arena, const std::vector<int>& path, float value)
         {
+            //the visits were counted on the way down, only the virtual loss has to be replaced by the value
+            for (int index : path)
+                detail::atomicAdd(arena.nodes[index].valueSum, value + mSettings.virtualLoss);
+            mCompleted++;
+        }
 
-        }*/
+
+        void TreeSearch::revert(Arena& arena, const std::vector<int>& path)
+        {
+            for (int index : path)
+            {
+                arena.nodes[index].visits.fetch_sub(1, std::memory_order_relaxed);
+                detail::atomicAdd(arena.nodes[index].valueSum, mSettings.virtualLoss);
+            }
+        }
     }
 }
@@ -26,7 +26,12 @@
 #ifndef UNGOD_AI_TREE_SEARCH_H
 #define UNGOD_AI_TREE_SEARCH_H
 
-#include <tuple>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
 #include "ungod/AI/Predictor.h"
 #include "ungod/AI/SceneSpecs.h"
 
@@ -34,49 +39,184 @@ namespace ungod
 {
     namespace AI
     {
-        /** \brief A node in a monte carlo search tree.
+        /**
+        * \brief Interface of a simulation the tree search can look ahead in. The search only holds the
+        * state at the root and reaches all other states by copying it and applying actions.
+        * Values are seen from the side that runs the search and are expected in range [-1, 1].
         */
-       /* class MonteCarloNode
+        class SearchEnvironment
         {
         public:
-            MonteCarloNode(float prior = 0.0f);
+            virtual ~SearchEnvironment() = default;
 
-            bool isLeaf() const;
+            /** \brief Creates a copy of the environment. */
+            virtual std::unique_ptr<SearchEnvironment> clone() const = 0;
 
-            float value() const;*/
+            /** \brief Overwrites the state with the state of other, which is of the same type.
+            * Used to reset scratch environments without allocations. */
+            virtual void assign(const SearchEnvironment& other) = 0;
 
-            /** \brief Creates a new child node for each valid action and computes priors based on predicted logits. */
-           /* void expand(const std::vector<float>& logits, const std::vector<bool>& valid);
+            /** \brief Returns the number of distinct actions, including currently invalid ones. */
+            virtual unsigned getActionCount() const = 0;
 
-            std::tuple<int, MonteCarloNode*> selectChild(float pbCBase, float pbCInit);
+            virtual bool isValid(unsigned action) const = 0;
+
+            virtual void apply(unsigned action) = 0;
+
+            virtual bool isTerminal() const = 0;
+
+            /** \brief Returns the value of the current state. Used at terminal states and for playouts. */
+            virtual float getValue() const = 0;
+
+            /** \brief Returns the number of floats written by getObservation. */
+            virtual std::size_t getObservationSize() const = 0;
+
+            /** \brief Writes the input of a predictor for the current state. */
+            virtual void getObservation(float* out) const = 0;
+        };
+
+
+        /** \brief Evaluates a batch of leaf states. Writes getActionCount() logits per leaf into logits and
+        * one value per leaf into values. Is called concurrently by the search threads. */
+        class LeafEvaluator
+        {
+        public:
+            virtual ~LeafEvaluator() = default;
+
+            virtual void evaluate(const std::vector<const SearchEnvironment*>& leaves, std::vector<float>& logits, std::vector<float>& values) = 0;
+        };
+
+
+        /** \brief Evaluates leaves with a single invocation of a predictor per batch. The first model input
+        * takes the observations, the first output holds the action logits and the second output the values.
+        * Invocations of concurrent searches are serialized. */
+        class PredictorEvaluator : public LeafEvaluator
+        {
+        public:
+            PredictorEvaluator(Predictor& predictor) : mPredictor(predictor) {}
+
+            virtual void evaluate(const std::vector<const SearchEnvironment*>& leaves, std::vector<float>& logits, std::vector<float>& values) override;
+
+        private:
+            Predictor& mPredictor;
+            std::mutex mMutex;
+        };
+
+
+        /** \brief Evaluates leaves with uniform priors and the value reached by a random playout of at most maxDepth actions. */
+        class RolloutEvaluator : public LeafEvaluator
+        {
+        public:
+            RolloutEvaluator(unsigned maxDepth = 64) : mMaxDepth(maxDepth) {}
+
+            virtual void evaluate(const std::vector<const SearchEnvironment*>& leaves, std::vector<float>& logits, std::vector<float>& values) override;
 
         private:
-            int mVisitCount;
-            float mPrior;
-            float mValueSum;
-            std::unordered_map<int, std::unique_ptr<MonteCarloNode>> mChildren;
-        };*/
-
-        /** 
-        * \brief Class that runs monte carlo tree search with a predictor
-        * to decide on actions for a scene of actors.
+            unsigned mMaxDepth;
+        };
+
+
+        /** \brief Settings of a TreeSearch. */
+        struct SearchSettings
+        {
+            SearchSettings() : simulations(800), threads(1), batchSize(8), maxNodes(1u << 18),
+                virtualLoss(1.0f), pbCBase(19652.0f), pbCInit(1.25f), rootParallel(false) {}
+
+            unsigned simulations; ///< number of simulations per search, summed over all threads
+            unsigned threads; ///< number of search threads including the calling thread
+            unsigned batchSize; ///< number of leaves a thread collects before calling the evaluator
+            unsigned maxNodes; ///< capacity of the node arena of a tree
+            float virtualLoss; ///< penalty on the value of nodes that are currently being evaluated by another thread
+            float pbCBase; ///< exploration parameters of the PUCT formula
+            float pbCInit;
+            bool rootParallel; ///< if true, every thread searches its own tree and the root visits are summed up
+        };
+
+
+        /**
+        * \brief Monte carlo tree search guided by a LeafEvaluator.
+        * Nodes live in a preallocated arena, the children of a node occupy a contiguous range of it.
+        * With multiple threads, all threads descend the same tree and mark their paths with a virtual loss,
+        * so that concurrent simulations spread over different leaves. Alternatively every thread searches a
+        * tree on its own (root parallel). The threads are kept alive between searches.
         */
-       /* class TreeSearch
+        class TreeSearch
         {
         public:
-            TreeSearch(Predictor& predictor) : mPredictor(predictor) {}
+            TreeSearch(LeafEvaluator& evaluator, const SearchSettings& settings = SearchSettings());
+            TreeSearch(const TreeSearch&) = delete;
+            TreeSearch& operator=(const TreeSearch&) = delete;
+            ~TreeSearch();
+
+            /** \brief Searches from the given state and returns the number of visits of each root action. */
+            const std::vector<unsigned>& search(const SearchEnvironment& root);
 
-            void decide(const SceneSpecs& scene);
+            /** \brief Searches from the given state and returns the most visited action or -1 if there is no valid action. */
+            int decide(const SearchEnvironment& root);
+
+            /** \brief Returns the number of simulations completed by the last search. */
+            unsigned getSimulations() const { return mCompleted.load(); }
+
+            /** \brief Returns the number of nodes created by the last search, summed over all trees. */
+            std::size_t getNodeCount() const;
+
+            const SearchSettings& getSettings() const { return mSettings; }
 
         private:
-            Predictor mPredictor;
+            enum NodeState : uint8_t { UNEXPANDED, EXPANDING, EXPANDED };
+
+            struct Node
+            {
+                int firstChild;
+                uint16_t childCount;
+                uint16_t action;
+                float prior;
+                float terminalValue; ///<value of an expanded node without children
+                std::atomic<int> visits;
+                std::atomic<float> valueSum;
+                std::atomic<uint8_t> state;
+            };
+
+            struct Arena
+            {
+                std::unique_ptr<Node[]> nodes;
+                std::atomic<int> size;
+                int capacity;
+            };
+
+            struct Leaf
+            {
+                std::vector<int> path;
+                std::unique_ptr<SearchEnvironment> env;
+            };
+
+            LeafEvaluator& mEvaluator;
+            SearchSettings mSettings;
+            std::vector<std::unique_ptr<Arena>> mArenas;
+            std::vector<unsigned> mVisits;
+            const SearchEnvironment* mRoot;
+            std::atomic<int> mBudget;
+            std::atomic<unsigned> mCompleted;
+
+            std::vector<std::thread> mWorkers;
+            std::mutex mMutex;
+            std::condition_variable mCondition;
+            unsigned mGeneration;
+            unsigned mActive;
+            bool mRunning;
 
         private:
-            void rolloutOne(const SceneSpecs& scene);
-        };*/
+            void workerLoop(unsigned index);
+            void simulate(unsigned index);
+            void resetArena(Arena& arena);
+            int allocate(Arena& arena, unsigned count);
+            int selectChild(const Arena& arena, const Node& node) const;
+            void expand(Arena& arena, Node& node, const SearchEnvironment& env, const float* logits, float value);
+            void backup(Arena& arena, const std::vector<int>& path, float value);
+            void revert(Arena& arena, const std::vector<int>& path);
+        };
     }
 }
 
 
 #endif // UNGOD_AI_TREE_SEARCH_H
-
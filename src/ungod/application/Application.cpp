@@ -27,6 +27,7 @@
 #include "ungod/application/ScriptedGameState.h"
 #include "ungod/application/ScriptedMenuState.h"
 #include <boost/filesystem.hpp>
+#include <algorithm>
 #include "ungod/script/Registration.h"
 
 namespace ungod
@@ -39,18 +40,53 @@ namespace ungod
                                                        "<graphics_settings image_quality=\"0\"/>"\
                                                        "<light unshadow_vertex_shader=\"data/shaders/light/unshadowShader.vert\" unshadow_frag_shader=\"data/shaders/light/unshadowShader.frag\"\
                                                        light_vertex_shader=\"data/shaders/light/lightOverShapeShader.vert\" light_frag_shader=\"data/shaders/light/lightOverShapeShader.frag\"\
-                                                       default_penumbra_texture=\"data/shaders/light/penumbraTexture.png\"/>"\
+                                                       default_penumbra_texture=\"data/shaders/light/penumbraTexture.png\" light_budget=\"32\" resolution_divisor=\"1\"/>"\
+                                                       "<water reflection_resolution_divisor=\"2\"/>"\
+                                                       "<audio music_emitter_rate=\"10\" stream_buffers=\"16\"/>"\
+                                                       "<pathfinding threads=\"0\" budget=\"2000\" flow_cell_size=\"32\" flow_agent_radius=\"16\"/>"\
+                                                       "<crowd neighbor_radius=\"64\" time_horizon=\"1000\"/>"\
+                                                       "<assets budget=\"256\" loader_threads=\"2\"/>"\
+                                                       "<script bytecode_cache=\"data/script_cache\" gc_paced=\"1\" gc_memory_ceiling=\"512\"/>"\
                                                        "</config>";
     const unsigned Application::DEFAULT_VIDEO_WIDTH = 800;
     const unsigned Application::DEFAULT_VIDEO_HEIGHT = 600;
     const unsigned Application::DEFAULT_VIDEO_BPP = 32;
+    constexpr float Application::SCRIPT_GC_PAUSE;
+    constexpr std::size_t Application::SCRIPT_GC_MIN_THRESHOLD;
+    constexpr float Application::SCRIPT_GC_SLACK_MARGIN;
+
+    namespace detail
+    {
+        std::size_t luaMemory(lua_State* L)
+        {
+            return static_cast<std::size_t>(lua_gc(L, LUA_GCCOUNT, 0)) * 1024u + static_cast<std::size_t>(lua_gc(L, LUA_GCCOUNTB, 0));
+        }
+
+        //lua 5.1 and luajit reset the collection threshold with every step or full collection,
+        //which restarts the automatic collector, so it is stopped again
+        void keepCollectorStopped(lua_State* L)
+        {
+#if LUA_VERSION_NUM < 502
+            lua_gc(L, LUA_GCSTOP, 0);
+#else
+            (void)L;
+#endif
+        }
+    }
 
     Application::Application(unsigned hertz, unsigned maxUpdates) :
         mDelta(1000.0f/hertz),
         mMaxUpdates(maxUpdates),
         mAssetmanager(),
+        mAudioStreamer(),
         mStatemanager(*this),
         mScriptState(),
+        mScriptGCPaced(false),
+        mScriptGCCycle(false),
+        mScriptGCThreshold(SCRIPT_GC_MIN_THRESHOLD),
+        mScriptGCCeiling(0),
+        mScriptGCTime(0.0f),
+        mScriptGCSteps(0),
         mWindow(),
         mVideoMode(DEFAULT_VIDEO_WIDTH, DEFAULT_VIDEO_HEIGHT, DEFAULT_VIDEO_BPP),
         mWindowStyle(sf::Style::Close | sf::Style::Resize),
@@ -243,6 +279,10 @@ namespace ungod
     {
         mRunning = true;
 
+        Script::setBytecodeCache(mConfig.getOr<std::string>("script/bytecode_cache", ""));
+        mAudioStreamer.setPoolBuffers(mConfig.getOr<unsigned>("audio/stream_buffers", AudioStreamer::DEFAULT_POOL_BUFFERS));
+        mAssetmanager.setBudget(static_cast<std::size_t>(mConfig.getOr<unsigned>("assets/budget", 256u)) * 1024u * 1024u);
+        mAssetmanager.getLoader().init(mConfig.getOr<unsigned>("assets/loader_threads", AssetLoader::DEFAULT_THREADS));
         resetScriptState();
 
         mConfig.onConfigurationChanged([this] (Configuration& config, const std::string& item)
@@ -271,12 +311,68 @@ namespace ungod
 
     void Application::mainloop()
     {
+        //the collector only runs in the idle time between the frames, not during update and render
+        setScriptGCPaced(mConfig.getOr<bool>("script/gc_paced", true),
+                         static_cast<std::size_t>(mConfig.getOr<unsigned>("script/gc_memory_ceiling", 512u)) * 1024u * 1024u);
+
         while(mRunning && mStatemanager.hasState() && mWindow.isOpen())
         {
             processEvents();
             if (update())
                 render();
+            collectScriptGarbage();
+        }
+
+        setScriptGCPaced(false, mScriptGCCeiling);
+    }
+
+    void Application::setScriptGCPaced(bool paced, std::size_t memoryCeiling)
+    {
+        if (paced && !mScriptGCPaced)
+            lua_gc(mScriptState->lua_state(), LUA_GCSTOP, 0);
+        else if (!paced && mScriptGCPaced)
+            lua_gc(mScriptState->lua_state(), LUA_GCRESTART, 0);
+        mScriptGCPaced = paced;
+        mScriptGCCeiling = memoryCeiling;
+    }
+
+    void Application::collectScriptGarbage()
+    {
+        if (!mScriptGCPaced)
+            return;
+        lua_State* L = mScriptState->lua_state();
+        sf::Clock clock;
+
+        if (detail::luaMemory(L) > mScriptGCCeiling)
+        {
+            lua_gc(L, LUA_GCCOLLECT, 0);
+            detail::keepCollectorStopped(L);
+            mScriptStats.emergencyCollections++;
+            mScriptGCCycle = false;
+            mScriptGCThreshold = std::max(static_cast<std::size_t>(detail::luaMemory(L) * SCRIPT_GC_PAUSE), SCRIPT_GC_MIN_THRESHOLD);
+            mScriptGCTime += clock.getElapsedTime().asMicroseconds() / 1000.0f;
+            return;
         }
+
+        if (!mScriptGCCycle && detail::luaMemory(L) < mScriptGCThreshold)
+            return;
+        mScriptGCCycle = true;
+
+        //time until the next update is due
+        float slack = mDelta - mAccumulator - mUpdateTimer.getElapsedTime().asMicroseconds() / 1000.0f - SCRIPT_GC_SLACK_MARGIN;
+        //at least one step per call, so that collection keeps up even if frames take longer than the update delta
+        do
+        {
+            mScriptGCSteps++;
+            if (lua_gc(L, LUA_GCSTEP, 0))
+            {
+                mScriptGCCycle = false;
+                mScriptGCThreshold = std::max(static_cast<std::size_t>(detail::luaMemory(L) * SCRIPT_GC_PAUSE), SCRIPT_GC_MIN_THRESHOLD);
+                break;
+            }
+        } while (clock.getElapsedTime().asMicroseconds() / 1000.0f < slack);
+        detail::keepCollectorStopped(L);
+        mScriptGCTime += clock.getElapsedTime().asMicroseconds() / 1000.0f;
     }
 
     void Application::processEvents()
@@ -328,9 +424,24 @@ namespace ungod
              mAccumulator -= mDelta;
              updated = true;
         }
+        if (updated)
+            updateScriptStats();
         return updated;
     }
 
+    void Application::updateScriptStats()
+    {
+        mScriptStats.gcTime = mScriptGCTime;
+        mScriptStats.gcSteps = mScriptGCSteps;
+        mScriptGCTime = 0.0f;
+        mScriptGCSteps = 0;
+        mScriptStats.memory = detail::luaMemory(mScriptState->lua_state());
+        mScriptStats.peakMemory = std::max(mScriptStats.peakMemory, mScriptStats.memory);
+        mScriptStats.delayedEvents = mEventScheduler.getDelayedEventCount();
+        mScriptStats.pooledEvents = mEventScheduler.getEventPool().getPoolSize();
+        mScriptStats.allocatedEvents = mEventScheduler.getEventPool().getAllocated();
+    }
+
     void Application::render()
     {
         mWindow.clear(mBackgroundColor);
@@ -348,17 +459,28 @@ namespace ungod
         mEventScheduler.handleCustomEvent(makeCustomEvent(mScriptState, type, data, delay));
     }
 
+    void Application::emitPooledCustomEvent(const std::string& type, script::Environment data, float delay)
+    {
+        mEventScheduler.emit(mScriptState, type, data, delay);
+    }
+
     void Application::resetScriptState()
     {
         //setup script stuff
+        mEventScheduler.clear(); //pooled and delayed events belong to the old state
+        mScriptStats = ScriptStats();
+        mScriptGCCycle = false;
+        mScriptGCThreshold = SCRIPT_GC_MIN_THRESHOLD;
         mScriptState = std::make_shared<script::State>();
+        if (mScriptGCPaced)
+            lua_gc(mScriptState->lua_state(), LUA_GCSTOP, 0);
         mGlobalScriptEnvironment = mScriptState->create_named_table("ungod");
 
         ScriptStateBase scriptBase{ mScriptState, getGlobalScriptEnv() };
 
         //register functionality
         scriptRegistration::registerWorld(scriptBase);
-        scriptRegistration::registerAssets(scriptBase);
+        scriptRegistration::registerAssets(scriptBase, mAssetmanager);
         scriptRegistration::registerUtility(scriptBase);
         scriptRegistration::registerGui(scriptBase);
         scriptRegistration::registerInput(scriptBase);
@@ -37,6 +37,7 @@
 #include "ungod/visual/Camera.h"
 #include "ungod/audio/MusicPlayer.h"
 #include "ungod/audio/Audio.h"
+#include "ungod/audio/AudioStreamer.h"
 #include "ungod/base/Input.h"
 #include "ungod/visual/Font.h"
 #include "ungod/script/EventHandler.h"
@@ -51,6 +52,21 @@ namespace ungod
                              CORRUPTED_SAVE_FILE = 102,
                              INIT_FAILED = 103};
 
+    /** \brief Statistics of the lua state, renewed once per frame. */
+    struct ScriptStats
+    {
+        ScriptStats() : memory(0), peakMemory(0), gcTime(0.0f), gcSteps(0), emergencyCollections(0), delayedEvents(0), pooledEvents(0), allocatedEvents(0) {}
+
+        std::size_t memory; ///< bytes in use by lua
+        std::size_t peakMemory; ///< maximum of memory since the last reset of the script state
+        float gcTime; ///< milliseconds spent in garbage collection since the previous frame
+        unsigned gcSteps; ///< number of incremental collection steps since the previous frame
+        unsigned emergencyCollections; ///< number of full collections caused by exceeding the memory ceiling
+        std::size_t delayedEvents; ///< number of custom events waiting for their dispatch
+        std::size_t pooledEvents; ///< number of event tables available for reuse
+        std::size_t allocatedEvents; ///< number of event tables created so far
+    };
+
     /** \brief The main application class. Usually the only thing one has to deal with in the
     * main() method of the program. Runs the main loop and manages the states. Also resposible for
     * things a different cursors. */
@@ -119,6 +135,10 @@ namespace ungod
         /** \brief Forwards a custom event to all transcendent states. */
         void emitCustomEvent(const std::string& type, script::Environment data, float delay = 0.0f);
 
+        /** \brief Forwards a custom event to all transcendent states. The event table is taken from a pool and is cleared
+        * and reused after the dispatch, so listeners must not keep a reference to it. */
+        void emitPooledCustomEvent(const std::string& type, script::Environment data, float delay = 0.0f);
+
         /** \brief Connects a callback to the on target size changed signal.*/
         owls::SignalLink<void, const sf::Vector2u&> onTargetSizeChanged(const std::function<void(const sf::Vector2u&)>& callback);
 
@@ -140,6 +160,12 @@ namespace ungod
         /** \brief Returns the audio manager. */
         SoundProfileManager& getSoundProfileManager() { return mSoundProfileManager; }
 
+        /** \brief Returns the streamer that decodes music emitters ahead of playback. */
+        AudioStreamer& getAudioStreamer() { return mAudioStreamer; }
+
+        /** \brief Returns the asset manager. Released assets are cached up to the budget of config assets/budget in MB. */
+        AssetManager& getAssetManager() { return mAssetmanager; }
+
         /** \brief Returns a reference to the input manager. */
         InputManager& getInputManager() { return mInputManager; }
 
@@ -149,6 +175,17 @@ namespace ungod
         /** \brief Get a default font for debugging and simple text. */
         const Font& getDefaultFont() const { return mDefaultFont; }
 
+        /** \brief Returns the lua memory and garbage collection statistics of the last frame. */
+        const ScriptStats& getScriptStats() const { return mScriptStats; }
+
+        /** \brief Stops the automatic lua collector, so that it is only driven by collectScriptGarbage, or restarts it.
+        * The memory ceiling is given in bytes. The mainloop sets both from the config (script/gc_paced, script/gc_memory_ceiling in MB). */
+        void setScriptGCPaced(bool paced, std::size_t memoryCeiling);
+
+        /** \brief Performs incremental lua garbage collection in the time left until the next update is due.
+        * Does nothing unless the collector is paced. If lua memory exceeds the ceiling, a full collection is performed. */
+        void collectScriptGarbage();
+
         void processEvents();
         bool update();
         void render();
@@ -160,10 +197,18 @@ namespace ungod
         const std::string mTitle;
         //management
         AssetManager mAssetmanager;
+        AudioStreamer mAudioStreamer; ///< declared before the states, streams of their worlds are read until they are destroyed
         StateManager mStatemanager;
         script::SharedState mScriptState;
         script::Environment mGlobalScriptEnvironment;
         script::EventScheduler mEventScheduler;
+        ScriptStats mScriptStats;
+        bool mScriptGCPaced; ///< true if the automatic lua collector is stopped and driven by collectScriptGarbage
+        bool mScriptGCCycle; ///< true while an incremental collection cycle is in progress
+        std::size_t mScriptGCThreshold; ///< memory that starts the next collection cycle
+        std::size_t mScriptGCCeiling;
+        float mScriptGCTime;
+        unsigned mScriptGCSteps;
         //video
         sf::RenderWindow mWindow;
         sf::VideoMode mVideoMode;
@@ -199,6 +244,9 @@ namespace ungod
         static const unsigned DEFAULT_VIDEO_WIDTH;
         static const unsigned DEFAULT_VIDEO_HEIGHT;
         static const unsigned DEFAULT_VIDEO_BPP;
+        static constexpr float SCRIPT_GC_PAUSE = 2.0f; ///< a new cycle starts if memory grew by this factor since the last one
+        static constexpr std::size_t SCRIPT_GC_MIN_THRESHOLD = 4u*1024u*1024u;
+        static constexpr float SCRIPT_GC_SLACK_MARGIN = 1.0f; ///< milliseconds of the idle time that are not used for collection
 
     /**
     * These methods are accessable from derived classes, useable when the
@@ -206,6 +254,7 @@ namespace ungod
     */
     protected:
         void init(bool initStateFromConfig = true);
+        void updateScriptStats();
         void createWindow();
         void createWindow(sf::WindowHandle handle);
         void mainloop();
@@ -148,6 +148,14 @@ namespace ungod
                 }
                 relativeCamPosTxt.setPosition(0, 90);
                 target.draw(relativeCamPosTxt);
+
+                const ScriptStats& stats = mApp.getScriptStats();
+                sf::Text scriptStatsTxt("Lua memory: " + std::to_string(stats.memory / 1024) + " KB (peak " + std::to_string(stats.peakMemory / 1024) +
+                                        " KB) \t GC: " + std::to_string(stats.gcTime) + " ms in " + std::to_string(stats.gcSteps) + " steps \t Pooled events: " +
+                                        std::to_string(stats.pooledEvents) + "/" + std::to_string(stats.allocatedEvents),
+                                        mApp.getDefaultFont().get(), DEBUG_TEXT_SIZE);
+                scriptStatsTxt.setPosition(0, 120);
+                target.draw(scriptStatsTxt);
             }
         }
     }
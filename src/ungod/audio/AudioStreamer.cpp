@@ -0,0 +1,313 @@
+/*
+* This file is part of the ungod - framework.
+* Copyright (C) 2016 Felix Becker - fb132550@uni-greifswald.de
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#include "ungod/audio/AudioStreamer.h"
+#include <algorithm>
+#include <chrono>
+
+namespace ungod
+{
+    namespace detail
+    {
+        constexpr std::size_t DECODE_CHUNK = 8192; ///<samples decoded at once before they are copied into a ring
+    }
+
+
+    AudioStream::AudioStream(std::unique_ptr<SampleSource> source, bool loop) :
+        mSource(std::move(source)), mBuffer(nullptr), mReadPos(0), mCount(0),
+        mWanted(false), mReady(false), mFailed(false), mEnded(false), mLoop(loop), mUnderruns(0),
+        mChannelCount(0), mSampleRate(0), mStarved(false) {}
+
+
+    bool AudioStream::isFinished() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mEnded.load() && mCount == 0;
+    }
+
+
+    bool AudioStream::isBuffered() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mBuffer != nullptr;
+    }
+
+
+    std::size_t AudioStream::getBufferedSamples() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mCount;
+    }
+
+
+    constexpr std::size_t AudioStreamer::BUFFER_SAMPLES;
+    constexpr unsigned AudioStreamer::DEFAULT_POOL_BUFFERS;
+    constexpr unsigned AudioStreamer::DECODE_INTERVAL;
+
+
+    AudioStreamer::AudioStreamer(unsigned poolBuffers, bool threaded) :
+        mDecodeBuffer(detail::DECODE_CHUNK), mPoolBuffers(poolBuffers), mBuffersInUse(0),
+        mUnderruns(0), mPoolExhaustions(0), mRunning(threaded)
+    {
+        if (threaded)
+            mThread = std::thread(&AudioStreamer::decoderLoop, this);
+    }
+
+
+    AudioStreamer::~AudioStreamer()
+    {
+        mRunning = false;
+        wake();
+        if (mThread.joinable())
+            mThread.join();
+    }
+
+
+    void AudioStreamer::setPoolBuffers(unsigned poolBuffers)
+    {
+        mPoolBuffers = poolBuffers;
+    }
+
+
+    std::shared_ptr<AudioStream> AudioStreamer::createStream(std::unique_ptr<SampleSource> source, bool loop)
+    {
+        auto stream = std::make_shared<AudioStream>(std::move(source), loop);
+        std::lock_guard<std::mutex> lock(mStreamsMutex);
+        mStreams.push_back(stream);
+        return stream;
+    }
+
+
+    std::shared_ptr<AudioStream> AudioStreamer::createStream(const std::string& filepath, bool loop)
+    {
+        return createStream(std::unique_ptr<SampleSource>(new FileSampleSource(filepath)), loop);
+    }
+
+
+    void AudioStreamer::prebuffer(AudioStream& stream)
+    {
+        if (!stream.mWanted.exchange(true))
+            wake();
+    }
+
+
+    void AudioStreamer::release(AudioStream& stream)
+    {
+        if (stream.mWanted.exchange(false))
+            wake();
+    }
+
+
+    std::size_t AudioStreamer::read(AudioStream& stream, sf::Int16* samples, std::size_t count)
+    {
+        std::size_t copied = 0;
+        bool low = false;
+        {
+            std::lock_guard<std::mutex> lock(stream.mMutex);
+            if (stream.mBuffer)
+            {
+                copied = std::min(count, stream.mCount);
+                std::size_t first = std::min(copied, BUFFER_SAMPLES - stream.mReadPos);
+                std::copy(stream.mBuffer + stream.mReadPos, stream.mBuffer + stream.mReadPos + first, samples);
+                std::copy(stream.mBuffer, stream.mBuffer + (copied - first), samples + first);
+                stream.mReadPos = (stream.mReadPos + copied) % BUFFER_SAMPLES;
+                stream.mCount -= copied;
+                low = stream.mCount < BUFFER_SAMPLES / 2;
+            }
+        }
+        if (copied < count && !stream.mEnded.load())
+        {
+            stream.mUnderruns++;
+            mUnderruns++;
+        }
+        if (low)
+            wake();
+        return copied;
+    }
+
+
+    void AudioStreamer::process()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mStreamsMutex);
+            //streams only referenced by the streamer are dead
+            for (auto& stream : mStreams)
+            {
+                if (stream.use_count() == 1 && stream->mBuffer)
+                    detachBuffer(*stream);
+            }
+            mStreams.erase(std::remove_if(mStreams.begin(), mStreams.end(),
+                           [] (const std::shared_ptr<AudioStream>& s) { return s.use_count() == 1; }), mStreams.end());
+            mProcessing = mStreams;
+        }
+
+        for (auto& stream : mProcessing)
+        {
+            if (!stream->mWanted.load())
+            {
+                stream->mStarved = false;
+                if (stream->mBuffer)
+                    detachBuffer(*stream);
+                continue;
+            }
+            if (stream->mFailed.load())
+                continue;
+            if (!stream->mReady.load())
+            {
+                if (!stream->mSource->open() || stream->mSource->getChannelCount() == 0)
+                {
+                    stream->mFailed = true;
+                    continue;
+                }
+                stream->mChannelCount = stream->mSource->getChannelCount();
+                stream->mSampleRate = stream->mSource->getSampleRate();
+                stream->mReady.store(true, std::memory_order_release);
+            }
+            if (!stream->mBuffer && !attachBuffer(*stream))
+                continue;
+            fill(*stream);
+        }
+        mProcessing.clear();
+    }
+
+
+    std::size_t AudioStreamer::getStreamCount() const
+    {
+        std::lock_guard<std::mutex> lock(mStreamsMutex);
+        return mStreams.size();
+    }
+
+
+    void AudioStreamer::decoderLoop()
+    {
+        while (mRunning.load())
+        {
+            process();
+            std::unique_lock<std::mutex> lock(mWakeMutex);
+            mWake.wait_for(lock, std::chrono::milliseconds(DECODE_INTERVAL));
+        }
+    }
+
+
+    void AudioStreamer::wake()
+    {
+        mWake.notify_one();
+    }
+
+
+    bool AudioStreamer::attachBuffer(AudioStream& stream)
+    {
+        std::unique_ptr<sf::Int16[]> buffer;
+        if (!mFreeBuffers.empty())
+        {
+            buffer = std::move(mFreeBuffers.back());
+            mFreeBuffers.pop_back();
+        }
+        else if (mUsedBuffers.size() < mPoolBuffers.load())
+            buffer.reset(new sf::Int16[BUFFER_SAMPLES]);
+        else
+        {
+            if (!stream.mStarved)
+                mPoolExhaustions++;
+            stream.mStarved = true;
+            return false;
+        }
+        stream.mStarved = false;
+        {
+            std::lock_guard<std::mutex> lock(stream.mMutex);
+            stream.mBuffer = buffer.get();
+            stream.mReadPos = 0;
+            stream.mCount = 0;
+        }
+        mUsedBuffers.push_back(std::move(buffer));
+        mBuffersInUse = mUsedBuffers.size();
+        return true;
+    }
+
+
+    void AudioStreamer::detachBuffer(AudioStream& stream)
+    {
+        sf::Int16* buffer;
+        {
+            std::lock_guard<std::mutex> lock(stream.mMutex);
+            buffer = stream.mBuffer;
+            stream.mBuffer = nullptr;
+            stream.mReadPos = 0;
+            stream.mCount = 0;
+        }
+        auto used = std::find_if(mUsedBuffers.begin(), mUsedBuffers.end(), [buffer] (const std::unique_ptr<sf::Int16[]>& b) { return b.get() == buffer; });
+        if (used == mUsedBuffers.end())
+            return;
+        //buffers above a lowered pool size are freed
+        if (mUsedBuffers.size() + mFreeBuffers.size() <= mPoolBuffers.load())
+            mFreeBuffers.push_back(std::move(*used));
+        mUsedBuffers.erase(used);
+        mBuffersInUse = mUsedBuffers.size();
+    }
+
+
+    void AudioStreamer::fill(AudioStream& stream)
+    {
+        std::size_t channels = stream.mChannelCount;
+        std::size_t space;
+        {
+            std::lock_guard<std::mutex> lock(stream.mMutex);
+            space = BUFFER_SAMPLES - stream.mCount;
+        }
+        bool restarted = false;
+        while (!stream.mEnded.load())
+        {
+            //only whole frames, so that reads of whole frames stay aligned
+            std::size_t request = std::min(space, mDecodeBuffer.size());
+            request -= request % channels;
+            if (request == 0)
+                break;
+            std::size_t decoded = stream.mSource->read(mDecodeBuffer.data(), request);
+            if (decoded > 0)
+            {
+                restarted = false;
+                std::lock_guard<std::mutex> lock(stream.mMutex);
+                std::size_t writePos = (stream.mReadPos + stream.mCount) % BUFFER_SAMPLES;
+                std::size_t first = std::min(decoded, BUFFER_SAMPLES - writePos);
+                std::copy(mDecodeBuffer.begin(), mDecodeBuffer.begin() + first, stream.mBuffer + writePos);
+                std::copy(mDecodeBuffer.begin() + first, mDecodeBuffer.begin() + decoded, stream.mBuffer);
+                stream.mCount += decoded;
+                space -= decoded;
+            }
+            if (decoded < request)
+            {
+                if (!stream.mLoop.load())
+                    stream.mEnded = true;
+                else if (restarted) //the source delivers nothing at all
+                    break;
+                else
+                {
+                    stream.mSource->restart();
+                    restarted = true;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,209 @@
+/*
+* This file is part of the ungod - framework.
+* Copyright (C) 2016 Felix Becker - fb132550@uni-greifswald.de
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#ifndef UNGOD_AUDIO_STREAMER_H
+#define UNGOD_AUDIO_STREAMER_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <SFML/Audio/InputSoundFile.hpp>
+
+namespace ungod
+{
+    class AudioStreamer;
+
+    /** \brief Interface for decoders that deliver interleaved 16 bit samples to an AudioStreamer.
+    * All methods are called from the decoder thread. */
+    class SampleSource
+    {
+    public:
+        virtual ~SampleSource() {}
+
+        /** \brief Opens the source, returns false on failure. */
+        virtual bool open() = 0;
+
+        virtual unsigned getChannelCount() const = 0;
+        virtual unsigned getSampleRate() const = 0;
+
+        /** \brief Reads up to maxCount samples and returns the number of samples read. Returns less than requested at the end of the source. */
+        virtual std::size_t read(sf::Int16* samples, std::size_t maxCount) = 0;
+
+        /** \brief Moves back to the first sample. */
+        virtual void restart() = 0;
+    };
+
+
+    /** \brief Decodes an audio file with sf::InputSoundFile. The file is not touched before open is called. */
+    class FileSampleSource : public SampleSource
+    {
+    public:
+        FileSampleSource(const std::string& filepath) : mFilepath(filepath) {}
+
+        virtual bool open() override { return mFile.openFromFile(mFilepath); }
+        virtual unsigned getChannelCount() const override { return mFile.getChannelCount(); }
+        virtual unsigned getSampleRate() const override { return mFile.getSampleRate(); }
+        virtual std::size_t read(sf::Int16* samples, std::size_t maxCount) override { return (std::size_t)mFile.read(samples, maxCount); }
+        virtual void restart() override { mFile.seek(0); }
+
+    private:
+        std::string mFilepath;
+        sf::InputSoundFile mFile;
+    };
+
+
+    /** \brief A single stream of decoded samples. The decoder thread of the owning AudioStreamer fills
+    * the ring buffer of the stream while it is prebuffered, a consumer drains it via AudioStreamer::read. */
+    class AudioStream
+    {
+    friend class AudioStreamer;
+    public:
+        AudioStream(std::unique_ptr<SampleSource> source, bool loop);
+
+        /** \brief Returns true as soon as the source is opened and channel count and sample rate are known. */
+        bool isReady() const { return mReady.load(std::memory_order_acquire); }
+
+        /** \brief Returns true if the source could not be opened. */
+        bool hasFailed() const { return mFailed.load(); }
+
+        /** \brief Returns true if a non looping source is decoded completely and all samples are read. */
+        bool isFinished() const;
+
+        /** \brief Sets whether the source is restarted when it reaches its end. */
+        void setLoop(bool loop) { mLoop = loop; }
+
+        /** \brief Returns true if the stream currently occupies a buffer of the pool. */
+        bool isBuffered() const;
+
+        /** \brief Returns the number of decoded samples that are ready to be read. */
+        std::size_t getBufferedSamples() const;
+
+        /** \brief Returns the number of reads that could not be served completely. */
+        unsigned getUnderruns() const { return mUnderruns.load(); }
+
+        /** \brief Channel count and sample rate, valid once the stream is ready. */
+        unsigned getChannelCount() const { return mChannelCount; }
+        unsigned getSampleRate() const { return mSampleRate; }
+
+    private:
+        std::unique_ptr<SampleSource> mSource; ///<only touched by the decoder thread
+        mutable std::mutex mMutex; ///<guards the ring buffer
+        sf::Int16* mBuffer;
+        std::size_t mReadPos;
+        std::size_t mCount;
+        std::atomic<bool> mWanted;
+        std::atomic<bool> mReady;
+        std::atomic<bool> mFailed;
+        std::atomic<bool> mEnded;
+        std::atomic<bool> mLoop;
+        std::atomic<unsigned> mUnderruns;
+        unsigned mChannelCount;
+        unsigned mSampleRate;
+        bool mStarved; ///<true while the stream waits for a buffer of the exhausted pool
+    };
+
+
+    /**
+    * \brief Decodes audio streams ahead of playback on a dedicated thread.
+    * Every prebuffered stream gets a ring buffer from a bounded pool of PCM buffers, which the decoder thread keeps filled.
+    * Consumers, for example the sound stream thread of a StreamedMusic, only copy samples out of the ring and
+    * never touch the disk or the decoder. If a read can not be served because the decoder fell behind, the read
+    * is counted as an underrun. If the pool is exhausted, further streams are not buffered until a buffer is released.
+    * A streamer constructed without thread does not decode on its own, process has to be called instead.
+    * This allows to drive streams headless and deterministic, without any audio device.
+    */
+    class AudioStreamer
+    {
+    public:
+        static constexpr std::size_t BUFFER_SAMPLES = 44100; ///<samples per ring buffer, half a second of 44.1kHz stereo
+        static constexpr unsigned DEFAULT_POOL_BUFFERS = 16;
+        static constexpr unsigned DECODE_INTERVAL = 20; ///<milliseconds the decoder thread sleeps if no stream needs data
+
+        AudioStreamer(unsigned poolBuffers = DEFAULT_POOL_BUFFERS, bool threaded = true);
+        AudioStreamer(const AudioStreamer&) = delete;
+        AudioStreamer& operator=(const AudioStreamer&) = delete;
+        ~AudioStreamer();
+
+        /** \brief Sets the maximum number of buffers of the pool. Buffers in use are not reclaimed. */
+        void setPoolBuffers(unsigned poolBuffers);
+
+        /** \brief Creates a new stream. Nothing is decoded until the stream is prebuffered. */
+        std::shared_ptr<AudioStream> createStream(std::unique_ptr<SampleSource> source, bool loop = false);
+        std::shared_ptr<AudioStream> createStream(const std::string& filepath, bool loop = false);
+
+        /** \brief Requests the decoder to open the stream and fill its ring buffer. */
+        void prebuffer(AudioStream& stream);
+
+        /** \brief Hands the buffer of the stream back to the pool. Must not be called while the stream is read from.
+        * The decoder continues where it stopped if the stream is prebuffered again. */
+        void release(AudioStream& stream);
+
+        /** \brief Copies up to count samples from the ring buffer of the stream and returns the number of copied samples.
+        * Reading less than count samples from a stream that did not end is counted as an underrun. */
+        std::size_t read(AudioStream& stream, sf::Int16* samples, std::size_t count);
+
+        /** \brief Performs a single decoding pass over all streams. Called repeatedly by the decoder thread. */
+        void process();
+
+        /** \brief Returns the total number of underruns of all streams. */
+        unsigned getUnderruns() const { return mUnderruns.load(); }
+
+        /** \brief Returns the number of pool buffers currently attached to streams. */
+        std::size_t getBuffersInUse() const { return mBuffersInUse.load(); }
+
+        /** \brief Returns the number of prebuffer requests that could not be served because the pool was exhausted. */
+        unsigned getPoolExhaustions() const { return mPoolExhaustions.load(); }
+
+        /** \brief Returns the number of streams alive. */
+        std::size_t getStreamCount() const;
+
+    private:
+        std::vector<std::shared_ptr<AudioStream>> mStreams;
+        mutable std::mutex mStreamsMutex;
+        std::vector<std::unique_ptr<sf::Int16[]>> mFreeBuffers; ///<only touched by the decoder
+        std::vector<std::unique_ptr<sf::Int16[]>> mUsedBuffers;
+        std::vector<sf::Int16> mDecodeBuffer; ///<samples are decoded here before they are copied into a ring
+        std::vector<std::shared_ptr<AudioStream>> mProcessing;
+        std::atomic<unsigned> mPoolBuffers;
+        std::atomic<std::size_t> mBuffersInUse;
+        std::atomic<unsigned> mUnderruns;
+        std::atomic<unsigned> mPoolExhaustions;
+        std::mutex mWakeMutex;
+        std::condition_variable mWake;
+        std::atomic<bool> mRunning;
+        std::thread mThread;
+
+        void decoderLoop();
+        void wake();
+        bool attachBuffer(AudioStream& stream);
+        void detachBuffer(AudioStream& stream);
+        void fill(AudioStream& stream);
+    };
+}
+
+#endif // UNGOD_AUDIO_STREAMER_H
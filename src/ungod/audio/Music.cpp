@@ -24,7 +24,113 @@
 */
 
 #include "ungod/audio/Music.h"
+#include "ungod/base/Logger.h"
+#include <boost/filesystem.hpp>
 
 namespace ungod
 {
+    StreamedMusic::StreamedMusic() : mStreamer(nullptr), mPlayPending(false), mInitialized(false) {}
+
+
+    StreamedMusic::~StreamedMusic()
+    {
+        //the sound stream thread must not call onGetData anymore when the stream is gone
+        sf::SoundStream::stop();
+    }
+
+
+    bool StreamedMusic::openFromFile(AudioStreamer& streamer, const std::string& filepath)
+    {
+        stop();
+        mStream.reset();
+        mInitialized = false;
+        if (!boost::filesystem::exists(filepath))
+        {
+            Logger::warning("Could not open music file", filepath);
+            return false;
+        }
+        mStreamer = &streamer;
+        mStream = streamer.createStream(filepath);
+        return true;
+    }
+
+
+    void StreamedMusic::setLoop(bool loop)
+    {
+        if (mStream)
+            mStream->setLoop(loop);
+    }
+
+
+    void StreamedMusic::prebuffer()
+    {
+        if (mStream)
+            mStreamer->prebuffer(*mStream);
+    }
+
+
+    void StreamedMusic::release()
+    {
+        stop();
+        if (mStream)
+            mStreamer->release(*mStream);
+    }
+
+
+    void StreamedMusic::play()
+    {
+        if (!mStream)
+            return;
+        prebuffer();
+        mPlayPending = true;
+        update();
+    }
+
+
+    void StreamedMusic::stop()
+    {
+        mPlayPending = false;
+        sf::SoundStream::stop();
+    }
+
+
+    void StreamedMusic::update()
+    {
+        if (!mPlayPending)
+            return;
+        if (mStream->hasFailed())
+        {
+            Logger::warning("Could not decode music stream, playback cancelled.");
+            mPlayPending = false;
+            return;
+        }
+        if (!mStream->isReady())
+            return;
+        if (!mInitialized)
+        {
+            initialize(mStream->getChannelCount(), mStream->getSampleRate());
+            mChunk.resize(mStream->getSampleRate() / 10 * mStream->getChannelCount()); //100 milliseconds per chunk
+            mInitialized = true;
+        }
+        mPlayPending = false;
+        sf::SoundStream::play();
+    }
+
+
+    bool StreamedMusic::onGetData(Chunk& data)
+    {
+        std::size_t count = mStreamer->read(*mStream, mChunk.data(), mChunk.size());
+        if (count == 0 && mStream->isFinished())
+            return false;
+        //keep the device fed with silence if the decoder fell behind
+        std::fill(mChunk.begin() + count, mChunk.end(), 0);
+        data.samples = mChunk.data();
+        data.sampleCount = mChunk.size();
+        return true;
+    }
+
+
+    void StreamedMusic::onSeek(sf::Time timeOffset)
+    {
+    }
 }
@@ -27,7 +27,9 @@
 #define UNGODMUSIC_H
 
 #include "ungod/ressource_management/Asset.h"
+#include "ungod/audio/AudioStreamer.h"
 #include <SFML/Audio/Music.hpp>
+#include <SFML/Audio/SoundStream.hpp>
 
 
 namespace ungod
@@ -38,6 +40,66 @@ namespace ungod
         bool loaded;
         std::string filepath;
     };
+
+
+    /** \brief A sound stream that plays samples decoded ahead by an AudioStreamer.
+    * Opening does not touch the file, the header is read by the decoder thread once the music is prebuffered.
+    * A play call before that is deferred until update finds the stream ready. Seeking is not supported,
+    * after a stop the music continues where the decoder is. */
+    class StreamedMusic : public sf::SoundStream
+    {
+    public:
+        StreamedMusic();
+        ~StreamedMusic();
+
+        /** \brief Creates the stream. Returns false if the file does not exist. */
+        bool openFromFile(AudioStreamer& streamer, const std::string& filepath);
+
+        /** \brief Sets whether the music loops. */
+        void setLoop(bool loop);
+
+        /** \brief Requests the decoder to buffer the beginning of the music. */
+        void prebuffer();
+
+        /** \brief Hands the decoded samples back to the pool. Stops the music. */
+        void release();
+
+        /** \brief Plays the music, as soon as it is ready. Prebuffers if not yet done. */
+        void play();
+
+        /** \brief Stops the music. */
+        void stop();
+
+        /** \brief Starts a deferred play call if the stream became ready. */
+        void update();
+
+        /** \brief Returns the stream or nullptr if nothing was opened. */
+        const AudioStream* getStream() const { return mStream.get(); }
+
+        /** \brief Returns the streamer the music was opened with. */
+        AudioStreamer* getStreamer() const { return mStreamer; }
+
+    protected:
+        virtual bool onGetData(Chunk& data) override;
+        virtual void onSeek(sf::Time timeOffset) override;
+
+    private:
+        AudioStreamer* mStreamer;
+        std::shared_ptr<AudioStream> mStream;
+        std::vector<sf::Int16> mChunk; ///<handed to the sound stream
+        bool mPlayPending;
+        bool mInitialized;
+    };
+
+
+    struct StreamedMusicData
+    {
+        StreamedMusicData() : loaded(false) {}
+
+        StreamedMusic music;
+        bool loaded;
+        std::string filepath;
+    };
 }
 
 #endif // UNGODMUSIC_H
@@ -26,21 +26,19 @@
 #include "ungod/audio/MusicEmitter.h"
 #include "ungod/base/Transform.h"
 #include "ungod/physics/Physics.h"
-#include "quadtree/QuadTree.h"
-#include "ungod/base/Entity.h"
+#include <algorithm>
 
 namespace ungod
 {
     MusicEmitterComponent::MusicEmitterComponent() : mDistanceCap(DEFAULT_DISTANCE_CAP), mVolume(1.0f), mActive(true), mBound(false) {}
 
     MusicEmitterComponent::MusicEmitterComponent(const MusicEmitterComponent& other) : 
-        mDistanceCap(other.mDistanceCap), mVolume(other.mVolume), mActive(other.mActive), mBound(other.mBound)
+        mDistanceCap(other.mDistanceCap), mVolume(other.mVolume), mActive(other.mActive), mBound(false)
     {
         if (other.mMusicData.loaded)
         {
             mMusicData.filepath = other.mMusicData.filepath;
-            mMusicData.loaded = other.mMusicData.loaded;
-            mMusicData.music.openFromFile(mMusicData.filepath);
+            mMusicData.loaded = mMusicData.music.openFromFile(*other.mMusicData.music.getStreamer(), mMusicData.filepath);
             mMusicData.music.setLoop(true);
         }
     }
@@ -69,26 +67,32 @@ namespace ungod
     }
 
 
-    MusicEmitterMixer::MusicEmitterMixer() : 
-        mMaxDistanceCap(DEFAULT_MAX_DISTANCE_CAP), mMuteSound(false)
+    constexpr std::size_t MusicEmitterMixer::MUSIC_PLAY_CAP;
+    constexpr float MusicEmitterMixer::DEFAULT_MAX_DISTANCE_CAP;
+    constexpr unsigned MusicEmitterMixer::DEFAULT_UPDATE_RATE;
+    constexpr float MusicEmitterMixer::GRID_CELL_SIZE;
+
+
+    MusicEmitterMixer::MusicEmitterMixer(AudioStreamer& streamer) : 
+        mEmitterGrid(GRID_CELL_SIZE), mStreamer(streamer), mMaxDistanceCap(DEFAULT_MAX_DISTANCE_CAP), 
+        mUpdateInterval(1000.0f / DEFAULT_UPDATE_RATE), mSinceUpdate(0.0f), mListener(nullptr), mMuteSound(false)
     {
-        for (unsigned i = 0; i < MUSIC_PLAY_CAP; i++)
-        {
-            mCurrentlyPlaying[i] = std::make_pair<MusicEmitterComponent*, TransformComponent*>(nullptr, nullptr);
-        }
+        for (auto& slot : mCurrentlyPlaying)
+            slot = PlayingSlot{ Entity(), 0.0f, 0.0f };
     }
 
 
-    void MusicEmitterMixer::init(const AudioListener* listener)
+    void MusicEmitterMixer::init(const AudioListener* listener, unsigned updateRate)
     {
         mListener = listener;
+        setUpdateRate(updateRate);
     }
 
 
     void MusicEmitterMixer::loadMusic(Entity e, const std::string& fileID)
     {
         auto& data = e.modify<MusicEmitterComponent>().mMusicData;
-        data.loaded = data.music.openFromFile(fileID);
+        data.loaded = data.music.openFromFile(mStreamer, fileID);
         if (data.loaded)
         {
             data.filepath = fileID;
@@ -106,14 +110,10 @@ namespace ungod
         e.modify<MusicEmitterComponent>().mActive = active;
         if (!active)
         {
-            for (unsigned i = 0; i < MUSIC_PLAY_CAP; i++)
+            for (auto& slot : mCurrentlyPlaying)
             {
-                if (mCurrentlyPlaying[i].first && mCurrentlyPlaying[i].first->mMusicData.loaded)
-                {
-                    mCurrentlyPlaying[i].first->mMusicData.music.stop();
-                    mCurrentlyPlaying[i].first = nullptr;
-                    mCurrentlyPlaying[i].second = nullptr;
-                }
+                if (slot.entity == e)
+                    stopSlot(slot);
             }
         }
     }
@@ -125,20 +125,11 @@ namespace ungod
 
     void MusicEmitterMixer::muteAll()
     {
-        //update volumes of active emitters, may remove them
-        for (unsigned i = 0; i < MUSIC_PLAY_CAP; i++)
-        {
-            if (!mCurrentlyPlaying[i].first)
-                continue;
-
-            if (mCurrentlyPlaying[i].first->mMusicData.loaded)
-            {
-                mCurrentlyPlaying[i].first->mMusicData.music.stop();
-            }
-            mCurrentlyPlaying[i].first->mBound = false;
-            mCurrentlyPlaying[i].first = nullptr;
-            mCurrentlyPlaying[i].second = nullptr;
-        }
+        for (auto& slot : mCurrentlyPlaying)
+            stopSlot(slot);
+        for (auto e : mPrebuffered)
+            e.modify<MusicEmitterComponent>().mMusicData.music.release();
+        mPrebuffered.clear();
     }
 
     void MusicEmitterMixer::setMuteSound(bool mute)
@@ -147,86 +138,156 @@ namespace ungod
         muteAll();
     }
 
-    void MusicEmitterMixer::update(float delta, quad::QuadTree<Entity>& quadtree)
+    void MusicEmitterMixer::setUpdateRate(unsigned rate)
+    {
+        mUpdateInterval = rate > 0 ? 1000.0f / rate : 0.0f;
+        mSinceUpdate = mUpdateInterval; //assign on the next update
+    }
+
+    void MusicEmitterMixer::addEmitter(Entity e)
+    {
+        if (!e.has<MusicEmitterComponent>() || !e.has<TransformComponent>())
+            return;
+        sf::Vector2f position = e.get<TransformComponent>().getCenterPosition();
+        auto cell = mEmitterCells.find(e);
+        if (cell != mEmitterCells.end())
+            cell->second = mEmitterGrid.move(e, cell->second, position);
+        else
+            mEmitterCells.emplace(e, mEmitterGrid.insert(e, position));
+    }
+
+    void MusicEmitterMixer::removeEmitter(Entity e)
+    {
+        auto cell = mEmitterCells.find(e);
+        if (cell == mEmitterCells.end())
+            return;
+        mEmitterGrid.erase(e, cell->second);
+        mEmitterCells.erase(cell);
+        if (mPrebuffered.erase(e) > 0 && e.has<MusicEmitterComponent>())
+            e.modify<MusicEmitterComponent>().mMusicData.music.release();
+        for (auto& slot : mCurrentlyPlaying)
+        {
+            if (slot.entity == e)
+                stopSlot(slot);
+        }
+    }
+
+    void MusicEmitterMixer::moveEmitter(Entity e)
+    {
+        auto cell = mEmitterCells.find(e);
+        if (cell != mEmitterCells.end())
+            cell->second = mEmitterGrid.move(e, cell->second, e.get<TransformComponent>().getCenterPosition());
+    }
+
+    void MusicEmitterMixer::update(float delta)
     {
         if (mMuteSound)
             return;
 
-        //check if new emitters are in range
-        quad::PullResult<Entity> result;
+        mSinceUpdate += delta;
+        if (mSinceUpdate >= mUpdateInterval)
+        {
+            mSinceUpdate = 0.0f;
+            assignSlots();
+        }
 
-        sf::Vector2f listenerWorldPos = mListener->getWorldPosition();
-        quadtree.retrieve(result, { listenerWorldPos.x-mMaxDistanceCap*0.5f, listenerWorldPos.y-mMaxDistanceCap*0.5f, mMaxDistanceCap, mMaxDistanceCap });
-
-        dom::Utility<Entity>::iterate<TransformComponent, MusicEmitterComponent>(result.getList(),
-              [this, listenerWorldPos] (Entity e, TransformComponent& transf, MusicEmitterComponent& emitter)
-              {
-                  if (emitter.mActive && !emitter.mBound && emitter.mMusicData.loaded)
-                  {
-                      float dist = distance(transf.getCenterPosition(), listenerWorldPos);
-                      if (dist < emitter.mDistanceCap)
-                      {
-                            //check if there is a free slot or a slot with greater distance
-                            float maxdist = dist;
-                            int indexToUse = -1;
-                            for (unsigned i = 0; i < MUSIC_PLAY_CAP; i++)
-                            {
-                                if (!mCurrentlyPlaying[i].first) //free slot found
-                                {
-                                    indexToUse = (int)i;
-                                    break;
-                                }
-                                else
-                                {
-                                    float distother = distance(mCurrentlyPlaying[i].second->getCenterPosition(), listenerWorldPos);
-                                    if (distother > maxdist)
-                                    {
-                                        maxdist = distother;
-                                        indexToUse = (int)i;
-                                    }
-                                }
-                            }
-                            if (indexToUse >= 0)
-                            {
-                                if (mCurrentlyPlaying[indexToUse].first)
-                                {
-                                    if (mCurrentlyPlaying[indexToUse].first->mMusicData.loaded)
-                                        mCurrentlyPlaying[indexToUse].first->mMusicData.music.stop();
-                                    mCurrentlyPlaying[indexToUse].first->mBound = false;
-                                    mCurrentlyPlaying[indexToUse].first = nullptr;
-                                    mCurrentlyPlaying[indexToUse].second = nullptr;
-                                }
-                                mCurrentlyPlaying[indexToUse].first = &emitter;
-                                mCurrentlyPlaying[indexToUse].second = &transf;
-                                mCurrentlyPlaying[indexToUse].first->mBound = true;
-                                float scaling = mListener->getScaling(mCurrentlyPlaying[indexToUse].second->getCenterPosition() , mCurrentlyPlaying[indexToUse].first->mDistanceCap);
-                                mCurrentlyPlaying[indexToUse].first->mMusicData.music.setVolume( 100.0f * mCurrentlyPlaying[indexToUse].first->mVolume * scaling );
-                                mCurrentlyPlaying[indexToUse].first->mMusicData.music.play();
-                            }
-                      }
-                  }
-              });
-
-
-        //update volumes of active emitters, may remove them
-        for (unsigned i = 0; i < MUSIC_PLAY_CAP; i++)
+        //interpolate towards the volumes of the last assignment
+        float t = mUpdateInterval > 0.0f ? std::min(1.0f, mSinceUpdate / mUpdateInterval) : 1.0f;
+        for (auto& slot : mCurrentlyPlaying)
         {
-            if (!mCurrentlyPlaying[i].first)
+            if (!slot.entity)
                 continue;
+            StreamedMusic& music = slot.entity.modify<MusicEmitterComponent>().mMusicData.music;
+            music.update(); //starts playback once the stream is decoded
+            music.setVolume( slot.startVolume + (slot.targetVolume - slot.startVolume) * t );
+        }
+    }
+
+    void MusicEmitterMixer::assignSlots()
+    {
+        sf::Vector2f listenerWorldPos = mListener->getWorldPosition();
+        sf::Vector2f halfExtent{ mMaxDistanceCap*0.5f, mMaxDistanceCap*0.5f };
 
-            if ( distance(mCurrentlyPlaying[i].second->getCenterPosition(), mListener->getWorldPosition()) > mCurrentlyPlaying[i].first->mDistanceCap )
+        //collect the emitters in range, everything within the max distance cap is prebuffered
+        mCandidates.clear();
+        mInRange.clear();
+        mEmitterGrid.query(listenerWorldPos - halfExtent, listenerWorldPos + halfExtent, [this, listenerWorldPos] (Entity e)
             {
-                if (mCurrentlyPlaying[i].first->mMusicData.loaded)
-                    mCurrentlyPlaying[i].first->mMusicData.music.stop();
-                mCurrentlyPlaying[i].first->mBound = false;
-                mCurrentlyPlaying[i].first = nullptr;
-                mCurrentlyPlaying[i].second = nullptr;
-            }
-            else if (mCurrentlyPlaying[i].first->mMusicData.loaded)
+                MusicEmitterComponent& emitter = e.modify<MusicEmitterComponent>();
+                if (!emitter.mActive || !emitter.mMusicData.loaded)
+                    return;
+                float dist = distance(e.get<TransformComponent>().getCenterPosition(), listenerWorldPos);
+                if (dist > mMaxDistanceCap)
+                    return;
+                mInRange.insert(e);
+                if (mPrebuffered.insert(e).second)
+                    emitter.mMusicData.music.prebuffer();
+                if (dist < emitter.mDistanceCap)
+                    mCandidates.emplace_back(dist, e);
+            });
+        for (auto it = mPrebuffered.begin(); it != mPrebuffered.end();)
+        {
+            if (mInRange.count(*it) == 0)
             {
-                float scaling = mListener->getScaling(mCurrentlyPlaying[i].second->getCenterPosition() , mCurrentlyPlaying[i].first->mDistanceCap);
-                mCurrentlyPlaying[i].first->mMusicData.music.setVolume( 100.0f * mCurrentlyPlaying[i].first->mVolume * scaling );
+                it->modify<MusicEmitterComponent>().mMusicData.music.release();
+                it = mPrebuffered.erase(it);
             }
+            else
+                ++it;
+        }
+
+        //only the nearest MUSIC_PLAY_CAP emitters need to be ordered
+        std::size_t count = std::min(MUSIC_PLAY_CAP, mCandidates.size());
+        std::partial_sort(mCandidates.begin(), mCandidates.begin() + count, mCandidates.end(),
+                          [] (const std::pair<float, Entity>& a, const std::pair<float, Entity>& b) { return a.first < b.first; });
+
+        //free the slots of emitters that are no longer among the nearest
+        for (auto& slot : mCurrentlyPlaying)
+        {
+            if (slot.entity && std::none_of(mCandidates.begin(), mCandidates.begin() + count,
+                                            [&slot] (const std::pair<float, Entity>& c) { return c.second == slot.entity; }))
+                stopSlot(slot);
+        }
+
+        //start the new ones in the free slots
+        for (std::size_t i = 0; i < count; i++)
+        {
+            MusicEmitterComponent& emitter = mCandidates[i].second.modify<MusicEmitterComponent>();
+            if (emitter.mBound)
+                continue;
+            auto slot = std::find_if(mCurrentlyPlaying.begin(), mCurrentlyPlaying.end(), [] (const PlayingSlot& s) { return !s.entity; });
+            slot->entity = mCandidates[i].second;
+            emitter.mBound = true;
+            float volume = 100.0f * emitter.mVolume * mListener->getScaling(slot->entity.get<TransformComponent>().getCenterPosition(), emitter.mDistanceCap);
+            slot->startVolume = volume;
+            slot->targetVolume = volume;
+            emitter.mMusicData.music.setVolume(volume);
+            emitter.mMusicData.music.play();
+        }
+
+        //new targets for the interpolation
+        for (auto& slot : mCurrentlyPlaying)
+        {
+            if (!slot.entity)
+                continue;
+            const MusicEmitterComponent& emitter = slot.entity.get<MusicEmitterComponent>();
+            slot.startVolume = slot.targetVolume;
+            slot.targetVolume = 100.0f * emitter.mVolume * mListener->getScaling(slot.entity.get<TransformComponent>().getCenterPosition(), emitter.mDistanceCap);
+        }
+    }
+
+    void MusicEmitterMixer::stopSlot(PlayingSlot& slot)
+    {
+        if (!slot.entity)
+            return;
+        //the component is already gone if the emitter was removed from the entity
+        if (slot.entity.has<MusicEmitterComponent>())
+        {
+            MusicEmitterComponent& emitter = slot.entity.modify<MusicEmitterComponent>();
+            if (emitter.mMusicData.loaded)
+                emitter.mMusicData.music.stop();
+            emitter.mBound = false;
         }
+        slot.entity = Entity();
     }
 }
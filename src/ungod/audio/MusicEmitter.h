@@ -28,14 +28,17 @@
 
 #include <utility>
 #include <array>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
 #include "ungod/audio/Music.h"
 #include "ungod/audio/Listener.h"
 #include "ungod/serialization/Serializable.h"
-#include "quadtree/QuadTree.h"
+#include "ungod/base/Entity.h"
+#include "ungod/utility/SpatialHash.h"
 
 namespace ungod
 {
-    class Entity;
     class MusicEmitterMixer;
     class TransformComponent;
     class World;
@@ -72,7 +75,7 @@ namespace ungod
         bool isActive() const;
 
     private:
-        MusicData mMusicData;
+        StreamedMusicData mMusicData;
         float mDistanceCap;
         float mVolume;
         bool mActive;
@@ -80,16 +83,24 @@ namespace ungod
     };
 
 
-    /** \brief A mixer class for music emitters. Holds a cap for the maximum number of emitters playing concurrently. */
+    /** \brief A mixer class for music emitters. Holds a cap for the maximum number of emitters playing concurrently.
+    * Emitters of entities in the world are kept in a spatial hash that is only touched when an emitter
+    * is added, removed or moved. The slots are reassigned to the nearest emitters in range at a fixed, low rate,
+    * in between the volumes of the playing emitters are interpolated towards the values of the last assignment.
+    * Emitters are decoded by the AudioStreamer of the application. They are prebuffered as soon as they come within
+    * the max distance cap of the listener, so that playback starts without touching the disk on the main thread. */
     class MusicEmitterMixer
     {
     public:
         static constexpr std::size_t MUSIC_PLAY_CAP = 5;  ///maximum number of sounds playable concurrently
         static constexpr float DEFAULT_MAX_DISTANCE_CAP = 3000.0f;
+        static constexpr unsigned DEFAULT_UPDATE_RATE = 10; ///<slot assignments per second
+        static constexpr float GRID_CELL_SIZE = 500.0f;
 
-        MusicEmitterMixer();
+        MusicEmitterMixer(AudioStreamer& streamer);
 
-        void init(const AudioListener* listener);
+        /** \brief Inits the mixer. updateRate is the number of slot assignments per second, 0 assigns on every update. */
+        void init(const AudioListener* listener, unsigned updateRate = DEFAULT_UPDATE_RATE);
 
         /** \brief Loads the music for the music emitter. */
         void loadMusic(Entity e, const std::string& fileID);
@@ -109,14 +120,51 @@ namespace ungod
         /** \brief Mutes all sounds. Stops all sounds currently playing. */
         void setMuteSound(bool mute = true);
 
-        /** \brief updates the music volumes and may starts new emitters */
-        void update(float delta, quad::QuadTree<Entity>& quadtree);
+        /** \brief Sets the number of slot assignments per second. */
+        void setUpdateRate(unsigned rate);
+
+        /** \brief Inserts the emitter of the given entity into the emitter grid, if it has one.
+        * Called by the world when the entity is added. */
+        void addEmitter(Entity e);
+
+        /** \brief Removes the entity from the emitter grid and stops its music. Called by the world when the entity is removed. */
+        void removeEmitter(Entity e);
+
+        /** \brief Updates the grid cell of the entity, if it is a known emitter. Called when the entity moved. */
+        void moveEmitter(Entity e);
+
+        /** \brief Returns the number of emitters that hold prebuffered samples. */
+        std::size_t getPrebufferedCount() const { return mPrebuffered.size(); }
+
+        /** \brief Returns the number of emitters in the grid. */
+        std::size_t getEmitterCount() const { return mEmitterCells.size(); }
+
+        /** \brief Interpolates the music volumes and reassigns the slots if the update interval elapsed. */
+        void update(float delta);
 
     private:
-        std::array<std::pair<MusicEmitterComponent*, TransformComponent*>, MUSIC_PLAY_CAP> mCurrentlyPlaying;
+        struct PlayingSlot
+        {
+            Entity entity;
+            float startVolume;
+            float targetVolume;
+        };
+
+        std::array<PlayingSlot, MUSIC_PLAY_CAP> mCurrentlyPlaying;
+        SpatialHash<Entity> mEmitterGrid;
+        std::unordered_map<Entity, SpatialHash<Entity>::CellKey> mEmitterCells;
+        std::vector<std::pair<float, Entity>> mCandidates; ///<reused by assignSlots
+        std::unordered_set<Entity> mPrebuffered; ///<emitters within the max distance cap
+        std::unordered_set<Entity> mInRange; ///<reused by assignSlots
+        AudioStreamer& mStreamer;
         float mMaxDistanceCap;
+        float mUpdateInterval;
+        float mSinceUpdate;
         const AudioListener* mListener;
         bool mMuteSound;
+
+        void assignSlots();
+        void stopSlot(PlayingSlot& slot);
     };
 }
 
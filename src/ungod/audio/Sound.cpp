@@ -30,6 +30,11 @@ namespace ungod
     {
         return data.loadFromFile(filepath);
     }
+
+    std::size_t LoadBehavior<sf::SoundBuffer>::getMemorySize(const sf::SoundBuffer& data)
+    {
+        return sizeof(sf::SoundBuffer) + (std::size_t)data.getSampleCount() * sizeof(sf::Int16);
+    }
 }
 
 
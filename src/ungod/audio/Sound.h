@@ -38,6 +38,7 @@ namespace ungod
     {
         static bool loadFromFile(const std::string& filepath, sf::SoundBuffer& data);
         static std::string getIdentifier() { return "Sound"; }
+        static std::size_t getMemorySize(const sf::SoundBuffer& data);
     };
 }
 
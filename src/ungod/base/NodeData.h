@@ -49,6 +49,7 @@ namespace ungod
     {
         static bool loadFromFile(const std::string& filepath, NodeDataStruct& data, WorldGraphNode* node);
         static std::string getIdentifier() { return "NodeData"; }
+        static constexpr bool CACHEABLE = false; ///< node data is bound to the node it was loaded for
     };
 }
 
@@ -28,6 +28,7 @@
 
 #include <SFML/Graphics/Transformable.hpp>
 #include "owls/Signal.h"
+#include "owls/SlotSignal.h"
 #include "ungod/base/Entity.h"
 #include "ungod/serialization/Serializable.h"
 
@@ -142,10 +143,10 @@ namespace ungod
 
     private:
         quad::QuadTree<Entity>& mQuadTree;
-        owls::Signal<Entity, const sf::Vector2f&> mPositionChangedSignal;
-        owls::Signal<Entity, const sf::Vector2f&> mScaleChangedSignal;
-        owls::Signal<Entity, const sf::Vector2f&> mSizeChangedSignal;
-        owls::Signal<Entity, const sf::Vector2f&> mMoveContentsSignal;
+        owls::SlotSignal<Entity, const sf::Vector2f&> mPositionChangedSignal;
+        owls::SlotSignal<Entity, const sf::Vector2f&> mScaleChangedSignal;
+        owls::SlotSignal<Entity, const sf::Vector2f&> mSizeChangedSignal;
+        owls::SlotSignal<Entity, const sf::Vector2f&> mMoveContentsSignal;
         owls::Request<sf::Vector2f(Entity)> mLowerBoundRequest;
         owls::Request<sf::Vector2f(Entity)> mUpperBoundRequest;
     };
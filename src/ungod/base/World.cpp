@@ -43,13 +43,15 @@ namespace ungod
         mMovementHandler(mQuadTree, mTransformHandler),
         mSteeringHandler(),
         mPathPlanner(),
+        mCrowdHandler(),
         mVisualsHandler(),
         mMovementCollisionHandler(mQuadTree),
         mSemanticsCollisionHandler(mQuadTree),
         mMovementRigidbodyHandler(),
         mSemanticsRigidbodyHandler(),
+        mFlowFieldPlanner(),
         mListener(),
-        mMusicEmitterMixer(),
+        mMusicEmitterMixer(node.getGraph().getState().getApp().getAudioStreamer()),
         mSoundHandler(),
         mLightHandler(),
         mTileMapHandler(),
@@ -111,6 +113,12 @@ namespace ungod
 
         onComponentAdded<ParticleSystemComponent>([this](Entity e) { mParticleSystemHandler.handleParticleSystemAdded(e); });
 
+        //keep the emitter grid of the music mixer in sync with the entities in the world
+        onComponentAdded<MusicEmitterComponent>([this](Entity e) { if (mQuadTree.getOwner(e)) mMusicEmitterMixer.addEmitter(e); });
+        onComponentRemoved<MusicEmitterComponent>([this](Entity e) { mMusicEmitterMixer.removeEmitter(e); });
+        mTransformHandler.onPositionChanged([this](Entity e, const sf::Vector2f&) { mMusicEmitterMixer.moveEmitter(e); });
+        mTransformHandler.onSizeChanged([this](Entity e, const sf::Vector2f&) { mMusicEmitterMixer.moveEmitter(e); });
+
 
         //connect lower bounds methods
         mTransformHandler.onLowerBoundRequest([this](Entity e) -> sf::Vector2f { return mVisualsHandler.getLowerBound(e); });
@@ -137,8 +145,14 @@ namespace ungod
         mSteeringHandler.init(master.getSteeringManager());
         mLightHandler.init(master.getLightManager());
         mListener = std::unique_ptr<AudioListener>(new CameraListener(master.getWorldGraph().getCamera(), *this));
-        mMusicEmitterMixer.init(mListener.get());
+        mMusicEmitterMixer.init(mListener.get(), master.getApp().getConfig().getOr<unsigned>("audio/music_emitter_rate", MusicEmitterMixer::DEFAULT_UPDATE_RATE));
         mSoundHandler.init(master.getApp().getSoundProfileManager(), mListener.get());
+        mPathPlanner.init(master.getApp().getConfig().getOr<unsigned>("pathfinding/threads", 0u),
+                          master.getApp().getConfig().getOr<float>("pathfinding/budget", PathPlanner::DEFAULT_REQUEST_BUDGET));
+        mFlowFieldPlanner.init(*this, master.getApp().getConfig().getOr<float>("pathfinding/flow_cell_size", FlowFieldPlanner::DEFAULT_CELL_SIZE),
+                               master.getApp().getConfig().getOr<float>("pathfinding/flow_agent_radius", FlowFieldPlanner::DEFAULT_AGENT_RADIUS));
+        mCrowdHandler.init(master.getApp().getConfig().getOr<float>("crowd/neighbor_radius", CrowdHandler::DEFAULT_NEIGHBOR_RADIUS),
+                           master.getApp().getConfig().getOr<float>("crowd/time_horizon", CrowdHandler::DEFAULT_TIME_HORIZON));
         mTileMapHandler.init(*this);
         mWaterHandler.init(*this);
         mParentChildHandler.init(*this);
@@ -185,7 +199,10 @@ namespace ungod
 	void World::setSize(const sf::Vector2f& layersize) 
 	{
         if (getSize() != layersize)
+        {
 		    mQuadTree.setBoundary({ 0.0f,0.0f,layersize.x,layersize.y });
+            mFlowFieldPlanner.invalidate();
+        }
 	}
 
     void World::extend(const sf::Vector2f& leftTopExtensions, const sf::Vector2f& rightBotExtensions)
@@ -202,6 +219,7 @@ namespace ungod
             mQuadTree.getContent(pull);
             mQuadTree.clear();
             mQuadTree.setBoundary(bounds);
+            mFlowFieldPlanner.invalidate();
             while (!pull.done())
             {
                 Entity e = pull.poll();
@@ -223,19 +241,19 @@ namespace ungod
         //second step: sort out the entities, that are not in the update area
         checkEntityQuery(mInUpdateRange, bounds);
 
-        mEntityBehaviorHandler.update(mInUpdateRange.getList(), delta);
+        mEntityBehaviorHandler.update(delta, bounds);
         mMovementHandler.update(mInUpdateRange.getList(), delta);
         mSteeringHandler.update(mInUpdateRange.getList(), delta, mMovementHandler);
         mPathPlanner.update(mInUpdateRange.getList(), delta, mMovementHandler);
+        mCrowdHandler.update(mInUpdateRange.getList());
         mMovementCollisionHandler.checkCollisions(mInUpdateRange.getList());
         mSemanticsCollisionHandler.checkCollisions(mInUpdateRange.getList());
-        mMusicEmitterMixer.update(delta, mQuadTree);
+        mMusicEmitterMixer.update(delta);
         mSoundHandler.update(delta);
         mLightHandler.update(mInUpdateRange.getList(), delta);
         mParticleSystemHandler.update(mInUpdateRange.getList(), delta);
         mTileMapHandler.update(mInUpdateRange.getList(), *this);
         mWaterHandler.update(mInUpdateRange.getList(), mNode.getGraph().getCamera());
-        mMusicEmitterMixer.update(delta, mQuadTree);
 
         mMaster->getRenderer().update(mInUpdateRange.getList(), delta, mVisualsHandler);
     }
@@ -279,11 +297,21 @@ namespace ungod
 	void World::addEntity(Entity e)
 	{
 		mQuadTree.insert(e);
+		if (e.has<TransformComponent>())
+			mWaterHandler.invalidateReflections(e.get<TransformComponent>().getBounds());
+		else
+			mWaterHandler.invalidateReflections();
+		mMusicEmitterMixer.addEmitter(e);
 	}
 
 	void World::addEntityNearby(Entity e, Entity hint)
 	{
 		mQuadTree.insertNearby(e, hint);
+		if (e.has<TransformComponent>())
+			mWaterHandler.invalidateReflections(e.get<TransformComponent>().getBounds());
+		else
+			mWaterHandler.invalidateReflections();
+		mMusicEmitterMixer.addEmitter(e);
 	}
 
     void World::destroy(Entity e)
@@ -295,6 +323,8 @@ namespace ungod
     {
         if (e.has<TransformComponent>())
             mQuadTree.removeFromItsNode(e);
+        mWaterHandler.invalidateReflections();
+        mMusicEmitterMixer.removeEmitter(e);
     }
 
     void World::destroyNamed(Entity e)
@@ -306,6 +336,7 @@ namespace ungod
     Entity World::makeCopy(Entity e)
     {
         Entity cpy = e.getInstantiation()->makeCopy(e.mHandle);
+        mEntityBehaviorHandler.scheduleCopy(cpy);
         mEntityCreationSignal(cpy);
         return cpy;
     }
@@ -315,6 +346,7 @@ namespace ungod
         if (&e.getWorld() != this)
         {
             Entity fcpy = e.getInstantiation()->makeForeignCopy(e.mHandle, *this);
+            mEntityBehaviorHandler.scheduleCopy(fcpy);
             if (fcpy.has<EntityBehaviorComponent>())
             {
                 const auto& eb = fcpy.get<EntityBehaviorComponent>();
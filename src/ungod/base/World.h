@@ -37,6 +37,8 @@
 #include "ungod/visual/Visual.h"
 #include "ungod/physics/Movement.h"
 #include "ungod/physics/Path.h"
+#include "ungod/physics/FlowField.h"
+#include "ungod/physics/Crowd.h"
 #include "ungod/physics/CollisionHandler.h"
 #include "ungod/physics/Steering.h"
 #include "ungod/base/Input.h"
@@ -223,6 +225,14 @@ namespace ungod
         PathPlanner& getPathPlanner() { return mPathPlanner; }
         const PathPlanner& getPathPlanner() const { return mPathPlanner; }
 
+        /** \brief For moving large groups of entities towards shared goals. */
+        FlowFieldPlanner& getFlowFieldPlanner() { return mFlowFieldPlanner; }
+        const FlowFieldPlanner& getFlowFieldPlanner() const { return mFlowFieldPlanner; }
+
+        /** \brief For steering entities with crowd components around each other. */
+        CrowdHandler& getCrowdHandler() { return mCrowdHandler; }
+        const CrowdHandler& getCrowdHandler() const { return mCrowdHandler; }
+
         /** \brief Returns a reference to the visuals manager. */
         VisualsHandler& getVisualsHandler() { return mVisualsHandler; }
         const VisualsHandler& getVisualsHandler() const { return mVisualsHandler; }
@@ -336,11 +346,13 @@ namespace ungod
         MovementHandler mMovementHandler;
         SteeringHandler<script::Environment> mSteeringHandler;
         PathPlanner mPathPlanner;
+        CrowdHandler mCrowdHandler;
         VisualsHandler mVisualsHandler;
         CollisionHandler<MOVEMENT_COLLISION_CONTEXT> mMovementCollisionHandler;
         CollisionHandler<SEMANTICS_COLLISION_CONTEXT> mSemanticsCollisionHandler;
         RigidbodyHandler<MOVEMENT_COLLISION_CONTEXT> mMovementRigidbodyHandler;
         RigidbodyHandler<SEMANTICS_COLLISION_CONTEXT> mSemanticsRigidbodyHandler;
+        FlowFieldPlanner mFlowFieldPlanner;  //after the rigidbody handlers, disconnects from their signals on destruction
         std::unique_ptr<AudioListener> mListener;
         MusicEmitterMixer mMusicEmitterMixer;
         SoundHandler mSoundHandler;
@@ -42,6 +42,7 @@ namespace ungod
     template<typename GETTER > class SteeringComponent;
     template<std::size_t i> class RigidbodyComponent;
     class PathFinderComponent;
+    class CrowdComponent;
     class VisualsComponent;
     class VertexArrayComponent;
     class SpriteComponent;
@@ -82,7 +83,7 @@ namespace ungod
                                                         SpriteComponent, MultiComponent<SpriteComponent>, VertexArrayComponent, VisualAffectorComponent, MultiComponent<VisualAffectorComponent>,
                                                         AnimationComponent, MultiComponent<AnimationComponent>, BigSpriteComponent, 
 														RigidbodyComponent<SEMANTICS_COLLISION_CONTEXT>, MultiComponent<RigidbodyComponent<SEMANTICS_COLLISION_CONTEXT>>,
-                                                        EntityUpdateTimer, BehaviorParameterComponent, SoundEmitterComponent, SteeringComponent<script::Environment>, PathFinderComponent, ShadowEmitterComponent, LightEmitterComponent, LightAffectorComponent,
+                                                        EntityUpdateTimer, BehaviorParameterComponent, SoundEmitterComponent, SteeringComponent<script::Environment>, PathFinderComponent, CrowdComponent, ShadowEmitterComponent, LightEmitterComponent, LightAffectorComponent,
                                                         MultiComponent<LightAffectorComponent>, MultiComponent<LightEmitterComponent>, MultiComponent<ShadowEmitterComponent>, ParticleSystemComponent,
                                                         ParentComponent, ChildComponent>;
 
@@ -90,7 +91,7 @@ namespace ungod
     using ActorBaseComponents = BaseComponents<TransformComponent, VisualsComponent, RigidbodyComponent<MOVEMENT_COLLISION_CONTEXT>, MovementComponent, EntityBehaviorComponent>;
     using ActorOptionalComponents = OptionalComponents<SpriteMetadataComponent, SpriteComponent, MultiComponent<SpriteComponent>, VertexArrayComponent, VisualAffectorComponent, MultiComponent<VisualAffectorComponent>,
                                                        AnimationComponent, MultiComponent<AnimationComponent>, RigidbodyComponent<SEMANTICS_COLLISION_CONTEXT>,
-                                                       EntityUpdateTimer, BehaviorParameterComponent, SoundEmitterComponent, SteeringComponent<script::Environment>, PathFinderComponent, ShadowEmitterComponent, LightEmitterComponent, LightAffectorComponent,
+                                                       EntityUpdateTimer, BehaviorParameterComponent, SoundEmitterComponent, SteeringComponent<script::Environment>, PathFinderComponent, CrowdComponent, ShadowEmitterComponent, LightEmitterComponent, LightAffectorComponent,
                                                        MultiComponent<LightAffectorComponent>, MultiComponent<LightEmitterComponent>, MultiComponent<ShadowEmitterComponent>, ParticleSystemComponent,
                                                        ParentComponent, ChildComponent>;
 
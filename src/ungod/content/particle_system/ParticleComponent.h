@@ -31,6 +31,7 @@
 #include "ungod/content/particle_system/ParticleSystem.h"
 #include "ungod/serialization/SerialParticleSystem.h"
 #include "ungod/utility/ScopedAccessor.h"
+#include "owls/SlotSignal.h"
 
 namespace ungod
 {
@@ -216,10 +217,10 @@ namespace ungod
         const ParticleFunctorMaster mParticleFunctorMaster;
         sf::Clock mAABBUpdate;
         int mRectUpdateTimer;
-        owls::Signal< Entity, const sf::FloatRect& > mContentsChangedSignal;
-        owls::Signal< Entity, const std::string&, const PSData& > mEmitterChangedSignal;
-        owls::Signal< Entity, const std::string&, const PSData& > mTexRectInitChangedSignal;
-        owls::Signal< Entity, const std::string&, const PSData& > mAffectorChangedSignal;
+        owls::SlotSignal< Entity, const sf::FloatRect& > mContentsChangedSignal;
+        owls::SlotSignal< Entity, const std::string&, const PSData& > mEmitterChangedSignal;
+        owls::SlotSignal< Entity, const std::string&, const PSData& > mTexRectInitChangedSignal;
+        owls::SlotSignal< Entity, const std::string&, const PSData& > mAffectorChangedSignal;
     };
 
 
@@ -28,62 +28,82 @@
 
 namespace ungod
 {
-    void floodFill(TileMap& tilemap, unsigned ix, unsigned iy, const std::vector<int>& replacementIDs)
+    namespace detail
     {
+        //pushes a seed for every connected segment of unvisited target tiles in column x between y0 and y1
+        void pushSegments(const TileMap& tilemap, const std::vector<bool>& visited, std::stack<std::pair<unsigned, unsigned>>& seeds,
+                          unsigned x, unsigned y0, unsigned y1, int targetID)
+        {
+            bool inSegment = false;
+            for (unsigned y = y0; y <= y1; ++y)
+            {
+                bool matches = !visited[(std::size_t)x * tilemap.getMapSizeY() + y] && tilemap.getTileID(x, y) == targetID;
+                if (matches && !inSegment)
+                    seeds.emplace(x, y);
+                inSegment = matches;
+            }
+        }
+    }
+
+
+    TileChangeSet floodFill(TileMap& tilemap, unsigned ix, unsigned iy, const std::vector<int>& replacementIDs)
+    {
+        TileChangeSet changes;
+        const unsigned sizeX = tilemap.getMapSizeX();
+        const unsigned sizeY = tilemap.getMapSizeY();
+        if (ix >= sizeX || iy >= sizeY || replacementIDs.empty())
+            return changes;
+
         int targetID = tilemap.getTileID(ix, iy);
-        //if (targetID == -1)
-            //return;
+        if (replacementIDs.size() == 1 && replacementIDs[0] == targetID)
+            return changes;
 
-        std::vector<bool> visited((std::size_t)tilemap.getMapSizeX()* (std::size_t)tilemap.getMapSizeY(), false);
+        //tiles are only written after the scan, so unvisited tiles still hold their original ids
+        std::vector<bool> visited((std::size_t)sizeX * (std::size_t)sizeY, false);
 
-        std::stack<std::pair<unsigned, unsigned>> nodestack;
-        nodestack.emplace(ix, iy);
+        std::stack<std::pair<unsigned, unsigned>> seeds;
+        seeds.emplace(ix, iy);
 
-        while (!nodestack.empty())
+        while (!seeds.empty())
         {
-            auto cur = nodestack.top();
-            nodestack.pop();
+            unsigned x = seeds.top().first;
+            unsigned y = seeds.top().second;
+            seeds.pop();
 
-            if (visited[tilemap.getMapSizeX()*cur.second + cur.first])
+            std::size_t column = (std::size_t)x * sizeY;
+            if (visited[column + y])
                 continue;
 
-            visited[tilemap.getMapSizeX()*cur.second + cur.first] = true;
+            //expand the seed to the maximal vertical span of target tiles
+            unsigned north = y;
+            unsigned south = y;
+            while (north > 0 && !visited[column + north - 1] && tilemap.getTileID(x, north - 1) == targetID)
+                --north;
+            while (south + 1 < sizeY && !visited[column + south + 1] && tilemap.getTileID(x, south + 1) == targetID)
+                ++south;
 
-            unsigned west = cur.first;
-            unsigned east = cur.first;
-            while (west > 0 && tilemap.getTileID(west - 1, cur.second) == targetID)
-            {
-                --west;
-            }
-            while (east+1 < tilemap.getMapSizeX() && tilemap.getTileID(east + 1, cur.second) == targetID)
+            //record the span, merging consecutive tiles that get the same replacement
+            for (unsigned i = north; i <= south; ++i)
             {
-                ++east;
-            }
-            for (unsigned i = west; i <= east; ++i)
-            {
-                if (replacementIDs.size() == 1)
-                    tilemap.setTile(replacementIDs[0], i, cur.second);
+                visited[column + i] = true;
+                int id = replacementIDs.size() == 1 ? replacementIDs[0] :
+                            replacementIDs[NumberGenerator::getRandBetw(0, (int)replacementIDs.size() - 1)];
+                if (i > north && changes.runs.back().newID == id)
+                    changes.runs.back().length++;
                 else
-                    tilemap.setTile(replacementIDs[NumberGenerator::getRandBetw(0, (unsigned)replacementIDs.size() - 1)], i, cur.second);
-
-                if (cur.second > 0 && tilemap.getTileID(i, cur.second-1) == targetID)
-                    nodestack.emplace(i,cur.second-1);
-
-                if (i > 0 && cur.second > 0 && tilemap.getTileID(i-1, cur.second-1) == targetID)
-                    nodestack.emplace(i-1,cur.second-1);
-
-                if (i < tilemap.getMapSizeX()-1 && cur.second > 0 && tilemap.getTileID(i+1, cur.second-1) == targetID)
-                    nodestack.emplace(i+1,cur.second-1);
-
-                if (cur.second < tilemap.getMapSizeY()-1 && tilemap.getTileID(i, cur.second+1) == targetID)
-                    nodestack.emplace(i,cur.second+1);
-
-                if (i > 0 && cur.second < tilemap.getMapSizeY()-1 && tilemap.getTileID(i-1, cur.second+1) == targetID)
-                    nodestack.emplace(i-1,cur.second+1);
-
-                if (i < tilemap.getMapSizeX()-1 && cur.second < tilemap.getMapSizeY()-1 && tilemap.getTileID(i+1, cur.second+1) == targetID)
-                    nodestack.emplace(i+1,cur.second+1);
+                    changes.runs.push_back({ x, i, 1u, targetID, id });
             }
+
+            //neighbor columns, including diagonals
+            unsigned top = north > 0 ? north - 1 : 0;
+            unsigned bottom = south + 1 < sizeY ? south + 1 : south;
+            if (x > 0)
+                detail::pushSegments(tilemap, visited, seeds, x - 1, top, bottom, targetID);
+            if (x + 1 < sizeX)
+                detail::pushSegments(tilemap, visited, seeds, x + 1, top, bottom, targetID);
         }
+
+        tilemap.applyChanges(changes);
+        return changes;
     }
 }
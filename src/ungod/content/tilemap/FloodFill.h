@@ -33,9 +33,11 @@ namespace ungod
 {
     /** \brief Performs floot fill on the given tilemap with a given init-position.
     * This will replace the ids of all tiles in a connected area of tiles with the same id.
+    * Tiles are connected to all eight neighbors. The area is scanned column by column.
     * Selects randomly from the given vector of ids to fill the flootable space.
-    * If the appropriate flag is set, inactive tiles will automatically be activated.*/
-    void floodFill(TileMap& tilemap, unsigned ix, unsigned iy, const std::vector<int>& replacementIDs);
+    * Returns the applied changes as vertical runs, which can be passed to TileMap::applyChanges
+    * to undo or redo the fill. */
+    TileChangeSet floodFill(TileMap& tilemap, unsigned ix, unsigned iy, const std::vector<int>& replacementIDs);
 }
 
 #endif // UNGOD_FLOOD_FILL_H
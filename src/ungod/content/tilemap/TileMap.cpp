@@ -24,24 +24,23 @@
 */
 
 #include "ungod/content/tilemap/TileMap.h"
+#include <cmath>
 
 namespace ungod
 {
     TileMap::TileMap() :
-        mMeta(nullptr),
+        mChunksX(0),
+        mChunksY(0),
+        mVisibleChunks(0,0,0,0),
+        mVisibleVertices(sf::Quads),
         mTileWidth(0),
         mTileHeight(0),
+        mHorizontalSize(0),
+        mVerticalSize(0),
         mMapSizeX(0),
         mMapSizeY(0),
-        mAltered(true),
-        mLastMetaX(0),
-        mLastMetaY(0),
-        mOverextendX(0),
-        mOverextendY(0)
+        mMeta(nullptr)
     {
-        mVertices.setPrimitiveType(sf::Quads);
-        mHorizontalSize = 0;
-        mVerticalSize = 0;
     }
 
 
@@ -53,92 +52,126 @@ namespace ungod
 
     bool TileMap::update(const sf::Vector2f& windowPosition)
     {
-        if (!mTiles.ids)
+        if (mTiles.empty() || mChunks.empty() || mTileWidth == 0 || mTileHeight == 0)
             return false;
 
-        const auto& ids = *mTiles.ids;
+        //compute the range of chunks intersecting the window
+        int tileX = (int)std::floor((windowPosition.x - getPosition().x) / (getScale().x * mTileWidth));
+        int tileY = (int)std::floor((windowPosition.y - getPosition().y) / (getScale().y * mTileHeight));
+        int cx0 = std::max(0, (int)std::floor((float)tileX / CHUNK_SIZE));
+        int cy0 = std::max(0, (int)std::floor((float)tileY / CHUNK_SIZE));
+        int cx1 = std::min((int)mChunksX, (int)std::floor((float)(tileX + (int)mHorizontalSize) / CHUNK_SIZE) + 1);
+        int cy1 = std::min((int)mChunksY, (int)std::floor((float)(tileY + (int)mVerticalSize) / CHUNK_SIZE) + 1);
+        sf::IntRect visible{ cx0, cy0, std::max(0, cx1 - cx0), std::max(0, cy1 - cy0) };
+
+        //drop the chunks that left the window
+        for (int cx = mVisibleChunks.left; cx < mVisibleChunks.left + mVisibleChunks.width; cx++)
+            for (int cy = mVisibleChunks.top; cy < mVisibleChunks.top + mVisibleChunks.height; cy++)
+            {
+                if (!visible.contains(cx, cy))
+                    dropChunk((unsigned)cx, (unsigned)cy);
+            }
+        bool changed = visible != mVisibleChunks;
+        mVisibleChunks = visible;
+
+        //(re)generate chunks that entered the window or were altered
+        for (int cx = visible.left; cx < visible.left + visible.width; cx++)
+            for (int cy = visible.top; cy < visible.top + visible.height; cy++)
+            {
+                if (mChunks[cx * mChunksY + cy].dirty)
+                {
+                    buildChunk((unsigned)cx, (unsigned)cy);
+                    changed = true;
+                }
+            }
 
-        bool active = false;
-        if (mVertices.getVertexCount())
+        //merge the visible chunks, so that they are drawn in one pass
+        if (changed)
         {
-            int metaX = (int)(std::round(windowPosition.x - getPosition().x) / (getScale().x * mTileWidth)) - (int)mOverextendX;
-            int metaY = (int)(std::round(windowPosition.y - getPosition().y) / (getScale().y * mTileHeight)) - (int)mOverextendY;
-
-            if (!mAltered && 
-                (unsigned)std::abs(mLastMetaX - metaX) < mOverextendX  && 
-                (unsigned)std::abs(mLastMetaY - metaY) < mOverextendY)
-                return true;
-
-            mLastMetaX = metaX;
-            mLastMetaY = metaY;
-            mAltered = false;
-
-            unsigned cutMetaX = (unsigned)std::max(0, metaX);
-            unsigned cutMetaY = (unsigned)std::max(0, metaY);
-
-            for (unsigned x = cutMetaX; x < cutMetaX + mHorizontalSize && x < mMapSizeX; x++)
-                for (unsigned y = cutMetaY; y < cutMetaY + mVerticalSize && y < mMapSizeY; y++)
+            mVisibleVertices.clear();
+            for (int cx = visible.left; cx < visible.left + visible.width; cx++)
+                for (int cy = visible.top; cy < visible.top + visible.height; cy++)
                 {
-                    unsigned j = x * mMapSizeY + y;
-                    sf::Vertex* quad = &mVertices[(y - cutMetaY + (x - cutMetaX) * mVerticalSize) * 4];
-
-                    if (ids[j] >= 0)
-                    {
-                        // define the 4 corners
-                        quad[0].position = sf::Vector2f((float)(x * mTileWidth), (float)(y * mTileHeight));
-                        quad[1].position = sf::Vector2f((float)((x + 1) * mTileWidth), (float)(y * mTileHeight));
-                        quad[2].position = sf::Vector2f((float)((x + 1) * mTileWidth), (float)((y + 1) * mTileHeight));
-                        quad[3].position = sf::Vector2f((float)(x * mTileWidth), (float)((y + 1) * mTileHeight));
-
-                        // define the 4 texture coordinates
-                        quad[0].texCoords = sf::Vector2f((float)(mTilePositions[ids[j]].x),
-                            (float)(mTilePositions[ids[j]].y));
-                        quad[1].texCoords = sf::Vector2f((float)(mTilePositions[ids[j]].x + mTileWidth),
-                            (float)(mTilePositions[ids[j]].y));
-                        quad[2].texCoords = sf::Vector2f((float)(mTilePositions[ids[j]].x + mTileWidth),
-                            (float)(mTilePositions[ids[j]].y + mTileHeight));
-                        quad[3].texCoords = sf::Vector2f((float)(mTilePositions[ids[j]].x),
-                            (float)(mTilePositions[ids[j]].y + mTileHeight));
-
-                        quad[0].color = sf::Color::White;
-                        quad[1].color = sf::Color::White;
-                        quad[2].color = sf::Color::White;
-                        quad[3].color = sf::Color::White;
-
-                        active = true;
-                    }
-                    else  //do not draw this tile
-                    {
-                        // define the 4 corners
-                        quad[0].position = sf::Vector2f(0, 0);
-                        quad[1].position = sf::Vector2f(0, 0);
-                        quad[2].position = sf::Vector2f(0, 0);
-                        quad[3].position = sf::Vector2f(0, 0);
-
-                        // define the 4 texture coordinates
-                        quad[0].texCoords = sf::Vector2f(0, 0);
-                        quad[1].texCoords = sf::Vector2f(0, 0);
-                        quad[2].texCoords = sf::Vector2f(0, 0);
-                        quad[3].texCoords = sf::Vector2f(0, 0);
-
-                        // define the 4 texture coordinates
-                        quad[0].color = sf::Color::Transparent;
-                        quad[1].color = sf::Color::Transparent;
-                        quad[2].color = sf::Color::Transparent;
-                        quad[3].color = sf::Color::Transparent;
-                    }
+                    const sf::VertexArray& vertices = mChunks[cx * mChunksY + cy].vertices;
+                    for (std::size_t i = 0; i < vertices.getVertexCount(); i++)
+                        mVisibleVertices.append(vertices[i]);
                 }
         }
 
-        return active;
+        return mVisibleVertices.getVertexCount() > 0;
     }
 
 
     void TileMap::render(sf::RenderTarget& target, const sf::Texture* tex, sf::RenderStates states) const
     {
+        if (mVisibleVertices.getVertexCount() == 0)
+            return;
         states.transform *= getTransform();
         states.texture = tex;
-        target.draw(mVertices, states);
+        target.draw(mVisibleVertices, states);
+    }
+
+
+    void TileMap::resetChunks()
+    {
+        mChunksX = (mMapSizeX + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        mChunksY = (mMapSizeY + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        mChunks.clear();
+        mChunks.resize((std::size_t)mChunksX * (std::size_t)mChunksY);
+        mVisibleChunks = { 0,0,0,0 };
+        mVisibleVertices.clear();
+    }
+
+
+    void TileMap::invalidateChunks()
+    {
+        for (auto& chunk : mChunks)
+            chunk.dirty = true;
+    }
+
+
+    void TileMap::buildChunk(unsigned cx, unsigned cy)
+    {
+        Chunk& chunk = mChunks[cx * mChunksY + cy];
+        chunk.vertices.clear();
+        chunk.dirty = false;
+
+        unsigned xEnd = std::min(mMapSizeX, (cx + 1) * CHUNK_SIZE);
+        unsigned yEnd = std::min(mMapSizeY, (cy + 1) * CHUNK_SIZE);
+
+        for (unsigned x = cx * CHUNK_SIZE; x < xEnd; x++)
+            for (unsigned y = cy * CHUNK_SIZE; y < yEnd; y++)
+            {
+                int id = mTiles.get(x, y);
+                if (id < 0 || (std::size_t)id >= mTilePositions.size())  //do not draw this tile
+                    continue;
+
+                const sf::Vector2u& texPos = mTilePositions[id];
+
+                chunk.vertices.append(sf::Vertex{ sf::Vector2f((float)(x * mTileWidth), (float)(y * mTileHeight)),
+                                                   sf::Vector2f((float)texPos.x, (float)texPos.y) });
+                chunk.vertices.append(sf::Vertex{ sf::Vector2f((float)((x + 1) * mTileWidth), (float)(y * mTileHeight)),
+                                                   sf::Vector2f((float)(texPos.x + mTileWidth), (float)texPos.y) });
+                chunk.vertices.append(sf::Vertex{ sf::Vector2f((float)((x + 1) * mTileWidth), (float)((y + 1) * mTileHeight)),
+                                                   sf::Vector2f((float)(texPos.x + mTileWidth), (float)(texPos.y + mTileHeight)) });
+                chunk.vertices.append(sf::Vertex{ sf::Vector2f((float)(x * mTileWidth), (float)((y + 1) * mTileHeight)),
+                                                   sf::Vector2f((float)texPos.x, (float)(texPos.y + mTileHeight)) });
+            }
+    }
+
+
+    void TileMap::dropChunk(unsigned cx, unsigned cy)
+    {
+        Chunk& chunk = mChunks[cx * mChunksY + cy];
+        chunk.vertices = sf::VertexArray{ sf::Quads };
+        chunk.dirty = true;
+    }
+
+
+    void TileMap::markDirty(unsigned x, unsigned y0, unsigned y1)
+    {
+        for (unsigned cy = y0 / CHUNK_SIZE; cy <= y1 / CHUNK_SIZE; cy++)
+            mChunks[(x / CHUNK_SIZE) * mChunksY + cy].dirty = true;
     }
 
 
@@ -154,21 +187,37 @@ namespace ungod
             Logger::warning("Map dimensions do not fit with the number of given tile ids.");
             return false;
         }
-        mTiles = tiles;
+        if (!mTiles.assign(*tiles.ids, mapSizeX, mapSizeY))
+        {
+            Logger::warning("Tile ids must be in range [-1,", TileStorage::MAX_ID, "].");
+            return false;
+        }
         mMapSizeX = mapSizeX;
         mMapSizeY = mapSizeY;
-        mAltered = true;
+        resetChunks();
         return true;
     }
 
 
     void TileMap::setTile(int id, unsigned x, unsigned y)
     {
-        unsigned estimatedPos = x * mMapSizeY + y;
-        if (!mTiles.ids || estimatedPos < 0 || estimatedPos >= mTiles.ids->size())
+        if (!mTiles.set(x, y, id))
             return;
-        (*mTiles.ids)[estimatedPos] = id;
-        mAltered = true;
+        mChunks[(x / CHUNK_SIZE) * mChunksY + y / CHUNK_SIZE].dirty = true;
+    }
+
+
+    void TileMap::applyChanges(const TileChangeSet& changes, bool revert)
+    {
+        for (const auto& run : changes.runs)
+        {
+            if (run.length == 0 || run.x >= mMapSizeX || run.y + run.length > mMapSizeY)
+                continue;
+            int id = revert ? run.oldID : run.newID;
+            for (unsigned y = run.y; y < run.y + run.length; y++)
+                mTiles.set(run.x, y, id);
+            markDirty(run.x, run.y, run.y + run.length - 1);
+        }
     }
 
 
@@ -178,10 +227,11 @@ namespace ungod
         mTileWidth = tileWidth;
         mTileHeight = tileHeight;
         mKeymap = keymap;
+        mTilePositions.clear();
         mTilePositions.reserve(mKeymap.size());
         for (const auto& key : mKeymap)
             keylookup(key);
-        mAltered = true;
+        invalidateChunks();
     }
 
     void TileMap::keylookup(const std::string& key)
@@ -209,7 +259,7 @@ namespace ungod
     {
         mKeymap.emplace_back(key);
         keylookup(key);
-        mAltered = true;
+        invalidateChunks();
     }
 
     int TileMap::getTileID(const sf::Vector2f& position) const
@@ -220,10 +270,15 @@ namespace ungod
 
     int TileMap::getTileID(unsigned x, unsigned y) const
     {
-        unsigned estimatedPos = x * mMapSizeY + y;
-        if (!mTiles.ids || estimatedPos < 0 || estimatedPos >= mTiles.ids->size())
-            return -1;
-        return mTiles.ids->at(estimatedPos);
+        return mTiles.get(x, y);
+    }
+
+    TileData TileMap::getTileData() const
+    {
+        TileData data;
+        if (!mTiles.empty())
+            data.ids = std::make_shared<std::vector<int>>(mTiles.toVector());
+        return data;
     }
 
     sf::Vector2i TileMap::getTileIndices(const sf::Vector2f& position) const
@@ -246,19 +301,10 @@ namespace ungod
 
     void TileMap::setViewSize(const sf::Vector2f& targetsize)
     {
-        unsigned hs = (unsigned)ceil(targetsize.x / (getScale().x*mTileWidth) ) + 1;
-        unsigned vs = (unsigned)ceil(targetsize.y / (getScale().y*mTileHeight) ) + 1;
-        unsigned ox = std::min(100, (int)std::floor(hs / 5));
-        unsigned oy = std::min(80, (int)std::floor(vs / 4));
-        if (hs + 2*ox == mHorizontalSize && 
-            vs + 2*oy == mVerticalSize)
+        if (mTileWidth == 0 || mTileHeight == 0)
             return;
-        mOverextendX = ox;
-        mOverextendY = oy;
-        mHorizontalSize = hs + 2*ox;
-        mVerticalSize = vs + 2*oy;
-        mVertices.resize(mHorizontalSize*mVerticalSize*4);
-        mAltered = true;
+        mHorizontalSize = (unsigned)ceil(targetsize.x / (getScale().x*mTileWidth) ) + 1;
+        mVerticalSize = (unsigned)ceil(targetsize.y / (getScale().y*mTileHeight) ) + 1;
     }
 
 
@@ -270,16 +316,22 @@ namespace ungod
 
     void TileMap::extend(unsigned leftExtend, unsigned topExtend, unsigned rightExtend, unsigned bottomExtend, int id)
     {
-        if (!mTiles.ids) return;
+        if (mTiles.empty()) return;
+        if (id < -1 || id > TileStorage::MAX_ID)
+        {
+            Logger::warning("Tile ids must be in range [-1,", TileStorage::MAX_ID, "].");
+            return;
+        }
+        std::vector<int> ids = mTiles.toVector();
         //y requires insertions at every mapSizeY-th position...
         std::vector<int> top, bottom;
         top.resize(topExtend, id);
         bottom.resize(bottomExtend, id);
         for (unsigned x = 0; x < mMapSizeX; x++)
         {
-            mTiles.ids->insert(mTiles.ids->begin() + x * (mMapSizeY + topExtend + bottomExtend), 
+            ids.insert(ids.begin() + x * (mMapSizeY + topExtend + bottomExtend), 
                 top.begin(), top.end());
-            mTiles.ids->insert(mTiles.ids->begin() + ((x+1) * (mMapSizeY + topExtend + bottomExtend) - bottomExtend),
+            ids.insert(ids.begin() + ((x+1) * (mMapSizeY + topExtend + bottomExtend) - bottomExtend),
                 bottom.begin(), bottom.end());
         }
         mMapSizeY += topExtend + bottomExtend;
@@ -287,9 +339,10 @@ namespace ungod
         std::vector<int> left, right;
         left.resize(leftExtend * mMapSizeY, -1);
         right.resize(rightExtend * mMapSizeY, -1);
-        mTiles.ids->insert(mTiles.ids->begin(), left.begin(), left.end());
-        mTiles.ids->insert(mTiles.ids->end(), right.begin(), right.end());
+        ids.insert(ids.begin(), left.begin(), left.end());
+        ids.insert(ids.end(), right.begin(), right.end());
         mMapSizeX += leftExtend + rightExtend;
-        mAltered = true;
+        mTiles.assign(ids, mMapSizeX, mMapSizeY);
+        resetChunks();
     }
 }
@@ -30,6 +30,7 @@
 #include "ungod/serialization/Serializable.h"
 #include "ungod/serialization/SerialTileMap.h"
 #include "ungod/serialization/MetaData.h"
+#include "ungod/content/tilemap/TileStorage.h"
 #include <memory>
 
 namespace ungod
@@ -39,21 +40,54 @@ namespace ungod
         std::shared_ptr<std::vector<int>> ids;
     };
 
+    /** \brief A vertical run of length tiles starting at (x,y) whose ids changed from oldID to newID. */
+    struct TileRun
+    {
+        unsigned x;
+        unsigned y;
+        unsigned length;
+        int oldID;
+        int newID;
+    };
+
+    /** \brief Compact record of changes to a tilemap that can be used to undo and redo them. */
+    struct TileChangeSet
+    {
+        std::vector<TileRun> runs;
+
+        bool empty() const { return runs.empty(); }
+    };
+
     /**
-    * \brief Class which uses a vertex array to encapsulate a tiled texture.
-    * The tilemap can consist of different tiles and renders only the part of
-    * them, which intersects the screen. Base of the map is a 2D-vector containing
-    * int values representing the number of the tile in the texture (line by line).
+    * \brief Class which uses vertex arrays to encapsulate a tiled texture.
+    * The map is split into chunks of CHUNK_SIZE x CHUNK_SIZE tiles, each with its own vertex array.
+    * Only chunks intersecting the screen hold vertex data and only chunks whose tiles were altered are
+    * regenerated. The visible chunks are merged into one vertex array, so that the map is drawn with a single call. Base of the map is a 2D-vector containing int values representing the number of the
+    * tile in the texture (line by line).
     */
     class TileMap : public sf::Transformable, public Serializable<TileMap>
     {
     friend struct SerialBehavior<TileMap>;
     friend struct DeserialBehavior<TileMap>;
+    public:
+        static constexpr unsigned CHUNK_SIZE = 32; ///<edge length of a chunk in tiles
+
     private:
-        sf::VertexArray mVertices; ///<contains only as much vertices, as required to cover the screen area
+        struct Chunk
+        {
+            Chunk() : vertices(sf::Quads), dirty(true) {}
+            sf::VertexArray vertices; ///<quads of all active tiles of the chunk
+            bool dirty; ///<true if the vertices must be regenerated before the chunk is drawn
+        };
+
+        std::vector<Chunk> mChunks; ///<chunks of the map, stored column by column like the tiles
+        unsigned mChunksX;
+        unsigned mChunksY;
+        sf::IntRect mVisibleChunks; ///<range of chunks that currently hold vertex data
+        sf::VertexArray mVisibleVertices; ///<quads of all visible chunks, merged when the visible range or a visible chunk changes
         std::vector<sf::Vector2u> mTilePositions; ///<tex positions for each tile type
         std::vector<std::string> mKeymap; ///<keys for each tile type
-        TileData mTiles; ///<stores tile data for the whole map
+        TileStorage mTiles; ///<stores tile data for the whole map in compressed form
 
         unsigned mTileWidth;
         unsigned mTileHeight;
@@ -61,16 +95,26 @@ namespace ungod
         unsigned mVerticalSize;
         unsigned mMapSizeX;
         unsigned mMapSizeY;
-        bool mAltered;
-        int mLastMetaX;
-        int mLastMetaY;
-        unsigned mOverextendX;
-        unsigned mOverextendY;
 
         const MetaMap* mMeta;
 
         void keylookup(const std::string& key);
 
+        //resizes the chunk grid to the map size and marks all chunks dirty
+        void resetChunks();
+
+        //marks all chunks dirty, e.g. if texture positions changed
+        void invalidateChunks();
+
+        //regenerates the vertices of the given chunk
+        void buildChunk(unsigned cx, unsigned cy);
+
+        //releases the vertices of a chunk that left the visible area
+        void dropChunk(unsigned cx, unsigned cy);
+
+        //marks the chunks containing the tiles (x, y0) ... (x, y1) dirty
+        void markDirty(unsigned x, unsigned y0, unsigned y1);
+
     public:
         //constructors
         TileMap();
@@ -78,19 +122,25 @@ namespace ungod
         /** \brief Links a meta map to the tile maps that provides texture positions given string keys. */
         void setMetaMap(const MetaMap& meta);
 
-        /** \brief Updates the visible part of the tilemap given the current window position relative to the tilemap. */
+        /** \brief Updates the visible part of the tilemap given the current window position relative to the tilemap.
+        * Chunks entering the visible area or containing altered tiles are (re)generated, chunks leaving it are dropped.
+        * Returns true if at least one active tile is visible. */
         bool update(const sf::Vector2f& windowPosition);
 
-        /** \brief Returns true if at least one active tile was rendered. */
+        /** \brief Renders all visible chunks with one draw call. */
         void render(sf::RenderTarget& target, const sf::Texture* tex, sf::RenderStates states) const;
 
-        /** Initializes the map by setting the given tiles and dimensions. The product of dimensions has to match the number of tiles. 
-        * The tilemap takes ownership of the tiledata. */
+        /** Initializes the map by setting the given tiles and dimensions. The product of dimensions has to match the number of tiles.
+        * The ids are copied into the compressed tile storage and must be in range [-1, TileStorage::MAX_ID]. */
         bool setTiles(const TileData& tiles, unsigned mapSizeX, unsigned mapSizeY);
 
         /** \brief Sets the id of the given tile. */
         void setTile(int id, unsigned x, unsigned y);
 
+        /** \brief Writes the new ids of the given change set to the map, or the old ids if revert is set.
+        * Only chunks touched by the changes are regenerated. */
+        void applyChanges(const TileChangeSet& changes, bool revert = false);
+
         /** \brief Sets the key data that connects tile ids to texture infos. */
         void setTileDims(unsigned tileWidth, unsigned tileHeight,
                        const std::vector<std::string>& keymap = {});
@@ -123,7 +173,11 @@ namespace ungod
 
         sf::FloatRect getBounds() const;
 
-        const TileData& getTileData() const { return mTiles; }
+        /** \brief Returns an uncompressed copy of the tile ids. The ids are empty if no tiles are set. */
+        TileData getTileData() const;
+
+        /** \brief Returns the compressed tile storage. */
+        const TileStorage& getTileStorage() const { return mTiles; }
 
         /** \brief Extends the tilemap in x and/or y direction by appending rows or columns and
         * keeping the exting tiles intact. */
@@ -96,9 +96,14 @@ namespace ungod
         e.modify<TileMapComponent>().mTileMap.addKey(key);
     }
 
-    void TileMapHandler::floodFillTileMap(TileMapComponent& tilemap, unsigned ix, unsigned iy, const std::vector<int>& replacementIDs)
+    TileChangeSet TileMapHandler::floodFillTileMap(TileMapComponent& tilemap, unsigned ix, unsigned iy, const std::vector<int>& replacementIDs)
     {
-        floodFill(tilemap.mTileMap, ix, iy, replacementIDs);
+        return floodFill(tilemap.mTileMap, ix, iy, replacementIDs);
+    }
+
+    void TileMapHandler::applyTileChanges(Entity e, const TileChangeSet& changes, bool revert)
+    {
+        e.modify<TileMapComponent>().mTileMap.applyChanges(changes, revert);
     }
 
     TilemapBrush TileMapHandler::makeTilemapBrush(Entity e, const std::string& identifier)
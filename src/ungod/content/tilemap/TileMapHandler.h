@@ -28,6 +28,7 @@
 
 #include <SFML/Graphics/RenderTexture.hpp>
 #include "owls/Signal.h"
+#include "owls/SlotSignal.h"
 #include "ungod/content/tilemap/TileMap.h"
 #include "ungod/content/tilemap/TileMapBrush.h"
 #include "ungod/base/Entity.h"
@@ -92,10 +93,13 @@ namespace ungod
         /** \brief Appends a key to the tilemap keytable. Requires a MetaDataComponent. */
         void addKey(Entity e, const std::string& key);
 
-        /** \brief Performs flood fill for the given entity with a tilemap component. */
-        inline void floodFillTileMap(Entity e, unsigned ix, unsigned iy, const std::vector<int>& replacementIDs)
-        { floodFillTileMap(e.modify<TileMapComponent>(), ix, iy, replacementIDs); }
-        void floodFillTileMap(TileMapComponent& tilemap, unsigned ix, unsigned iy, const std::vector<int>& replacementIDs);
+        /** \brief Performs flood fill for the given entity with a tilemap component. Returns the applied changes. */
+        inline TileChangeSet floodFillTileMap(Entity e, unsigned ix, unsigned iy, const std::vector<int>& replacementIDs)
+        { return floodFillTileMap(e.modify<TileMapComponent>(), ix, iy, replacementIDs); }
+        TileChangeSet floodFillTileMap(TileMapComponent& tilemap, unsigned ix, unsigned iy, const std::vector<int>& replacementIDs);
+
+        /** \brief Applies (or reverts) a change set, e.g. one returned by floodFillTileMap. */
+        void applyTileChanges(Entity e, const TileChangeSet& changes, bool revert = false);
 
         /** \brief Returns a brush object that can be used to paint on the tilemap associated with entity e.
         * Changes to the tilemap through the brush, are send notifications the renderer. */
@@ -111,7 +115,7 @@ namespace ungod
 		/** \brief Registers new callback for the ContentsChanged signal. */
 		inline decltype(auto) onContentsChanged(const std::function<void(Entity, const sf::FloatRect&)>& callback)
 		{
-			mContentsChangedSignal.connect(callback);
+			return mContentsChangedSignal.connect(callback);
 		}
 
         /** \brief Extends the tilemap in x and/or y direction by appending rows or columns and
@@ -122,7 +126,7 @@ namespace ungod
         void tilemapCallback(Entity e, TileMapComponent& tmc, const std::function<void(TileMap&)>& callback);
 
     private:
-		owls::Signal<Entity, const sf::FloatRect&> mContentsChangedSignal;
+		owls::SlotSignal<Entity, const sf::FloatRect&> mContentsChangedSignal;
 
     private:
         void viewSizeChanged(const World& world, const sf::Vector2f& viewsize);
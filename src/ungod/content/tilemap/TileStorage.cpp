@@ -0,0 +1,222 @@
+/*
+* This file is part of the ungod - framework.
+* Copyright (C) 2016 Felix Becker - fb132550@uni-greifswald.de
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#include "ungod/content/tilemap/TileStorage.h"
+#include <algorithm>
+
+namespace ungod
+{
+    namespace detail
+    {
+        //smallest supported index width that can address num palette entries
+        uint8_t paletteBits(std::size_t num)
+        {
+            if (num <= 1) return 0;
+            if (num <= 2) return 1;
+            if (num <= 4) return 2;
+            if (num <= 16) return 4;
+            if (num <= 256) return 8;
+            return 16;
+        }
+
+        inline uint16_t encodeID(int id)
+        {
+            return (uint16_t)(id + 1);
+        }
+
+        inline int decodeID(uint16_t value)
+        {
+            return (int)value - 1;
+        }
+    }
+
+
+    TileStorage::TileStorage() : mBlocksY(0), mSizeX(0), mSizeY(0) {}
+
+
+    bool TileStorage::assign(const std::vector<int>& ids, unsigned sizeX, unsigned sizeY)
+    {
+        if ((std::size_t)sizeX * (std::size_t)sizeY != ids.size())
+            return false;
+        if (std::any_of(ids.begin(), ids.end(), [] (int id) { return id < -1 || id > MAX_ID; }))
+            return false;
+
+        unsigned blocksX = (sizeX + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        unsigned blocksY = (sizeY + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        std::vector<Block> blocks;
+        blocks.resize((std::size_t)blocksX * (std::size_t)blocksY);
+
+        std::vector<uint16_t> values;
+        for (unsigned bx = 0; bx < blocksX; bx++)
+            for (unsigned by = 0; by < blocksY; by++)
+            {
+                Block& b = blocks[bx * blocksY + by];
+                unsigned width = std::min(BLOCK_SIZE, sizeX - bx * BLOCK_SIZE);
+                b.height = (uint16_t)std::min(BLOCK_SIZE, sizeY - by * BLOCK_SIZE);
+                b.count = (uint16_t)(width * b.height);
+                values.clear();
+                for (unsigned x = bx * BLOCK_SIZE; x < bx * BLOCK_SIZE + width; x++)
+                    for (unsigned y = by * BLOCK_SIZE; y < by * BLOCK_SIZE + b.height; y++)
+                        values.push_back(detail::encodeID(ids[(std::size_t)x * sizeY + y]));
+                pack(b, values, 0);
+            }
+
+        mBlocks = std::move(blocks);
+        mBlocksY = blocksY;
+        mSizeX = sizeX;
+        mSizeY = sizeY;
+        return true;
+    }
+
+
+    void TileStorage::clear()
+    {
+        mBlocks.clear();
+        mBlocksY = 0;
+        mSizeX = 0;
+        mSizeY = 0;
+    }
+
+
+    int TileStorage::get(unsigned x, unsigned y) const
+    {
+        if (x >= mSizeX || y >= mSizeY)
+            return -1;
+        unsigned local;
+        const Block& b = block(x, y, local);
+        return detail::decodeID(b.palette[readIndex(b, local)]);
+    }
+
+
+    bool TileStorage::set(unsigned x, unsigned y, int id)
+    {
+        if (x >= mSizeX || y >= mSizeY || id < -1 || id > MAX_ID)
+            return false;
+        unsigned local;
+        Block& b = block(x, y, local);
+        uint16_t value = detail::encodeID(id);
+
+        auto it = std::find(b.palette.begin(), b.palette.end(), value);
+        if (it == b.palette.end())
+        {
+            if (b.palette.size() >= (std::size_t{1} << b.bitsPerTile))
+            {
+                //palette is exhausted, drop unused entries and widen the indices if still required
+                std::vector<uint16_t> values;
+                unpack(b, values);
+                pack(b, values, 1);
+            }
+            b.palette.push_back(value);
+            it = b.palette.end() - 1;
+        }
+        writeIndex(b, local, (unsigned)(it - b.palette.begin()));
+        return true;
+    }
+
+
+    std::vector<int> TileStorage::toVector() const
+    {
+        std::vector<int> ids;
+        ids.reserve((std::size_t)mSizeX * (std::size_t)mSizeY);
+        for (unsigned x = 0; x < mSizeX; x++)
+            for (unsigned y = 0; y < mSizeY; y++)
+                ids.push_back(get(x, y));
+        return ids;
+    }
+
+
+    std::size_t TileStorage::getMemoryUsage() const
+    {
+        std::size_t bytes = sizeof(TileStorage) + mBlocks.capacity() * sizeof(Block);
+        for (const auto& b : mBlocks)
+            bytes += b.palette.capacity() * sizeof(uint16_t) + b.bits.capacity() * sizeof(uint32_t);
+        return bytes;
+    }
+
+
+    const TileStorage::Block& TileStorage::block(unsigned x, unsigned y, unsigned& local) const
+    {
+        const Block& b = mBlocks[(x / BLOCK_SIZE) * mBlocksY + y / BLOCK_SIZE];
+        local = (x % BLOCK_SIZE) * b.height + y % BLOCK_SIZE;
+        return b;
+    }
+
+
+    TileStorage::Block& TileStorage::block(unsigned x, unsigned y, unsigned& local)
+    {
+        Block& b = mBlocks[(x / BLOCK_SIZE) * mBlocksY + y / BLOCK_SIZE];
+        local = (x % BLOCK_SIZE) * b.height + y % BLOCK_SIZE;
+        return b;
+    }
+
+
+    unsigned TileStorage::readIndex(const Block& b, unsigned i)
+    {
+        if (b.bitsPerTile == 0)
+            return 0;
+        unsigned perWord = 32 / b.bitsPerTile;
+        unsigned shift = (i % perWord) * b.bitsPerTile;
+        return (b.bits[i / perWord] >> shift) & ((1u << b.bitsPerTile) - 1);
+    }
+
+
+    void TileStorage::writeIndex(Block& b, unsigned i, unsigned index)
+    {
+        if (b.bitsPerTile == 0)
+            return;
+        unsigned perWord = 32 / b.bitsPerTile;
+        unsigned shift = (i % perWord) * b.bitsPerTile;
+        uint32_t mask = ((1u << b.bitsPerTile) - 1) << shift;
+        uint32_t& word = b.bits[i / perWord];
+        word = (word & ~mask) | ((index << shift) & mask);
+    }
+
+
+    void TileStorage::pack(Block& b, const std::vector<uint16_t>& values, std::size_t reserve)
+    {
+        b.palette.clear();
+        for (auto v : values)
+            if (std::find(b.palette.begin(), b.palette.end(), v) == b.palette.end())
+                b.palette.push_back(v);
+        b.palette.shrink_to_fit();
+
+        b.bitsPerTile = detail::paletteBits(b.palette.size() + reserve);
+        b.bits.clear();
+        if (b.bitsPerTile > 0)
+            b.bits.resize((values.size() * b.bitsPerTile + 31) / 32, 0u);
+        b.bits.shrink_to_fit();
+
+        for (unsigned i = 0; i < values.size(); i++)
+            writeIndex(b, i, (unsigned)(std::find(b.palette.begin(), b.palette.end(), values[i]) - b.palette.begin()));
+    }
+
+
+    void TileStorage::unpack(const Block& b, std::vector<uint16_t>& values)
+    {
+        values.resize(b.count);
+        for (unsigned i = 0; i < b.count; i++)
+            values[i] = b.palette[readIndex(b, i)];
+    }
+}
@@ -0,0 +1,131 @@
+/*
+* This file is part of the ungod - framework.
+* Copyright (C) 2016 Felix Becker - fb132550@uni-greifswald.de
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#ifndef UNGOD_TILE_STORAGE_H
+#define UNGOD_TILE_STORAGE_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace ungod
+{
+    /**
+    * \brief Compact random access storage for the tile ids of a tilemap.
+    * The map is split into blocks of BLOCK_SIZE x BLOCK_SIZE tiles. Every block keeps a palette of the
+    * 16 bit ids it contains and stores a bit-packed palette index per tile. A block consisting of a single id
+    * needs no per-tile memory at all, a block with up to 16 different ids needs 4 bits per tile.
+    * Valid ids are in range [-1, MAX_ID], where -1 marks an inactive tile.
+    * Tiles are addressed column by column like the uncompressed tile data (x * sizeY + y).
+    */
+    class TileStorage
+    {
+    public:
+        static constexpr unsigned BLOCK_SIZE = 32; ///<edge length of a block in tiles
+        static constexpr int MAX_ID = 65534; ///<largest id that can be stored
+
+    public:
+        TileStorage();
+
+        /** \brief Replaces the content of the storage with the given column-major ids.
+        * Returns false and leaves the storage untouched if the number of ids does not match the
+        * dimensions or an id is out of range. */
+        bool assign(const std::vector<int>& ids, unsigned sizeX, unsigned sizeY);
+
+        /** \brief Removes all tiles. */
+        void clear();
+
+        /** \brief Returns the id of the given tile or -1 if the tile does not exist. */
+        int get(unsigned x, unsigned y) const;
+
+        /** \brief Sets the id of the given tile. Returns false if the tile does not exist or the id is out of range. */
+        bool set(unsigned x, unsigned y, int id);
+
+        /** \brief Decompresses all ids in column-major order. */
+        std::vector<int> toVector() const;
+
+        /** \brief Calls func(id, count) for every run of equal ids in column-major order. */
+        template<typename F>
+        void forEachRun(F func) const;
+
+        /** \brief Returns the number of bytes occupied by the storage (palettes, packed indices and block headers). */
+        std::size_t getMemoryUsage() const;
+
+        bool empty() const { return mBlocks.empty(); }
+        unsigned getSizeX() const { return mSizeX; }
+        unsigned getSizeY() const { return mSizeY; }
+
+    private:
+        struct Block
+        {
+            Block() : bitsPerTile(0), height(0), count(0) {}
+            std::vector<uint16_t> palette; ///<ids occuring in the block, offset by one so that 0 denotes an inactive tile
+            std::vector<uint32_t> bits; ///<palette indices, packed into words
+            uint8_t bitsPerTile; ///<0, 1, 2, 4, 8 or 16
+            uint16_t height; ///<number of tiles per column of the block
+            uint16_t count; ///<number of tiles in the block
+        };
+
+        std::vector<Block> mBlocks; ///<stored column by column like the tiles
+        unsigned mBlocksY;
+        unsigned mSizeX;
+        unsigned mSizeY;
+
+        const Block& block(unsigned x, unsigned y, unsigned& local) const;
+        Block& block(unsigned x, unsigned y, unsigned& local);
+
+        static unsigned readIndex(const Block& b, unsigned i);
+        static void writeIndex(Block& b, unsigned i, unsigned index);
+
+        //rebuilds palette and packed indices of the block from raw values, leaving room for reserve more palette entries
+        static void pack(Block& b, const std::vector<uint16_t>& values, std::size_t reserve);
+        static void unpack(const Block& b, std::vector<uint16_t>& values);
+    };
+
+
+    template<typename F>
+    void TileStorage::forEachRun(F func) const
+    {
+        if (empty())
+            return;
+        int current = get(0, 0);
+        std::size_t count = 0;
+        for (unsigned x = 0; x < mSizeX; x++)
+            for (unsigned y = 0; y < mSizeY; y++)
+            {
+                int id = get(x, y);
+                if (id != current)
+                {
+                    func(current, count);
+                    current = id;
+                    count = 0;
+                }
+                count++;
+            }
+        func(current, count);
+    }
+}
+
+#endif // UNGOD_TILE_STORAGE_H
@@ -27,113 +27,146 @@
 #include "ungod/base/Entity.h"
 #include "ungod/base/World.h"
 #include "ungod/content/tilemap/TileMap.h"
+#include <algorithm>
 
 namespace ungod
 {
+    namespace detail
+    {
+        //true if rect, given in the parent coordinates of the tilemap, covers an active tile
+        bool coversActiveTile(const TileMap& tilemap, const sf::FloatRect& rect)
+        {
+            sf::FloatRect covered;
+            if (!tilemap.getBounds().intersects(rect, covered))
+                return false;
+            sf::Vector2i from = tilemap.getTileIndices({ covered.left, covered.top });
+            sf::Vector2i to = tilemap.getTileIndices({ covered.left + covered.width, covered.top + covered.height });
+            for (int x = std::max(0, from.x); x <= to.x; x++)
+                for (int y = std::max(0, from.y); y <= to.y; y++)
+                    if (tilemap.getTileID((unsigned)x, (unsigned)y) >= 0)
+                        return true;
+            return false;
+        }
+    }
+
     constexpr float Water::DEFAULT_DISTORTION;
     constexpr float Water::DEFAULT_FLOW;
     constexpr float Water::DEFAULT_REFLECTION_OPACITY;
     constexpr float Water::BOUNDING_BOX_SCALING;
     constexpr float Water::BOUNDS_OVERLAP;
+    constexpr float Water::REFLECTION_CACHE_MARGIN;
 
-    Water::Water() : mShowShaders(false),
+    Water::Water() : mDistortionTexture(nullptr), mShowShaders(false),
                     mDistortionFactor(DEFAULT_DISTORTION), mFlowFactor(DEFAULT_FLOW), mReflectionOpacity(DEFAULT_REFLECTION_OPACITY)
     {
     }
 
-    Water::Water(const Water& other)
+    Water::Water(const Water& other) : mDistortionTexture(nullptr)
     {
         mShowShaders = other.mShowShaders;
         mDistortionFactor = other.mDistortionFactor;
         mFlowFactor = other.mFlowFactor;
         mReflectionOpacity = other.mReflectionOpacity;
-        init(other.mDistortionTextureFile, mFragmentShaderID, mVertexShaderID);
-        targetsizeChanged(other.mTargetSize);
+        mTargetSize = other.mTargetSize;
+        if (!other.mDistortionTextureFile.empty())
+            init(other.mDistortionTextureFile, other.mFragmentShaderID, other.mVertexShaderID);
+        mShowShaders = mShowShaders && other.mShowShaders;
     }
 
-    bool Water::render(sf::RenderTarget& target, sf::RenderTexture& rendertex, const TileMap& tilemap, const sf::Texture* tilemapTex, sf::RenderStates states, const std::vector<ungod::World*>& reflectionWorlds) const
+    bool Water::render(sf::RenderTarget& target, sf::RenderTexture& rendertex, sf::RenderTexture& reflectiontex, sf::Shader* reflectionShader,
+                       const TileMap& tilemap, const sf::Texture* tilemapTex,
+                       sf::RenderStates states, const std::vector<ungod::World*>& reflectionWorlds) const
     {
         rendertex.clear(sf::Color::Transparent);
 
         rendertex.setView(target.getView());
         tilemap.render(rendertex, tilemapTex, states);
 
+        //forget about worlds that are no longer reflected (or unloaded)
+        mReflectionCache.erase(std::remove_if(mReflectionCache.begin(), mReflectionCache.end(), [&reflectionWorlds] (const ReflectionCache& cache)
+            { return std::find(reflectionWorlds.begin(), reflectionWorlds.end(), cache.world) == reflectionWorlds.end(); }),
+            mReflectionCache.end());
+
         sf::Vector2f windowUpLeftPosition = target.mapPixelToCoords(sf::Vector2i(0, 0));
+        sf::Vector2f viewSize = target.getView().getSize();
+        sf::FloatRect globalTMBounds = states.transform.transformRect(tilemap.getBounds());
 
-        for (ungod::World* world : reflectionWorlds)
+        //reflections are only visible where the view overlaps the water
+        sf::FloatRect visibleWater;
+        if (!reflectionWorlds.empty() && mReflectionOpacity > 0.0f &&
+            globalTMBounds.intersects({ windowUpLeftPosition, viewSize }, visibleWater))
         {
-            sf::RenderStates worldStates;
-            worldStates.transform.translate(world->getNode().getPosition() - world->getNode().getGraph().getActiveNode()->getPosition());
+            reflectiontex.clear(sf::Color::Transparent);
+            reflectiontex.setView(target.getView());
+            sf::Transform globalToTilemap = states.transform.getInverse();
+            bool reflected = false;
+            //the opacity is applied per entity, as overlapping reflections would blend differently otherwise
+            float opacity = std::min(1.0f, mReflectionOpacity);
+            if (reflectionShader)
+                reflectionShader->setUniform("opacity", opacity);
 
-            windowUpLeftPosition = world->getNode().mapToLocalPosition(windowUpLeftPosition);
+            for (ungod::World* world : reflectionWorlds)
+            {
+                sf::Vector2f worldOffset = world->getNode().getPosition() - world->getNode().getGraph().getActiveNode()->getPosition();
+                sf::RenderStates worldStates;
+                worldStates.transform.translate(worldOffset);
+                worldStates.shader = reflectionShader;
 
-            //render reflections
-            quad::PullResult<Entity> pull;
-            world->getQuadTree().retrieve(pull, { windowUpLeftPosition.x,
-                                                    windowUpLeftPosition.y - (BOUNDING_BOX_SCALING - 1) * target.getView().getSize().y,
-                                                    target.getView().getSize().x,
-                                                    BOUNDING_BOX_SCALING * target.getView().getSize().y });
+                sf::Vector2f localUpLeft = world->getNode().mapToLocalPosition(windowUpLeftPosition);
+                const ReflectionCache& cache = getReflectionCache(*world, { localUpLeft.x,
+                                                    localUpLeft.y - (BOUNDING_BOX_SCALING - 1) * viewSize.y,
+                                                    viewSize.x,
+                                                    BOUNDING_BOX_SCALING * viewSize.y });
 
-            dom::Utility<Entity>::iterate<TransformComponent, VisualsComponent>(pull.getList(),
-                [this, &states, worldStates, world, &rendertex, &tilemap](Entity e, TransformComponent& transf, VisualsComponent& vis)
+                for (Entity e : cache.entities)
                 {
-                    auto globalTMBounds = states.transform.transformRect(tilemap.getBounds());
-                    auto transformedUpLeft = world->getNode().mapToLocalPosition(sf::Vector2f{ globalTMBounds.left, globalTMBounds.top });
-                    globalTMBounds.left = transformedUpLeft.x;
-                    globalTMBounds.top = transformedUpLeft.y;
-                    if (globalTMBounds.intersects(e.get<TransformComponent>().getBounds()))
-                    {
-                        //get the bounds of the visual contents of the entity
-                        //we need to take the untransformed bounds here
-                        //this is kind of a "hack" to avoid that rotation will mess up visuals
-                        sf::Vector2f lowerBounds = world->getVisualsHandler().getUntransformedLowerBound(e);
-                        sf::Vector2f upperBounds = world->getVisualsHandler().getUntransformedUpperBound(e);
-
-                        float curOpacity = vis.getOpacity();
-                        VisualsHandler::setOpacity(e, curOpacity * mReflectionOpacity);
-                        if (!e.has<WaterComponent>())
-                            world->getState()->getRenderer().renderEntity(e, transf, vis, rendertex, worldStates, true, BOUNDS_OVERLAP * (-2 * lowerBounds.y + upperBounds.y));
-                        VisualsHandler::setOpacity(e, curOpacity);
-                    }
-                });
+                    TransformComponent& transf = e.modify<TransformComponent>();
+                    if (!globalTMBounds.intersects(worldStates.transform.transformRect(transf.getBounds())))
+                        continue;
+
+                    //get the bounds of the visual contents of the entity
+                    //we need to take the untransformed bounds here
+                    //this is kind of a "hack" to avoid that rotation will mess up visuals
+                    sf::Vector2f lowerBounds = world->getVisualsHandler().getUntransformedLowerBound(e);
+                    sf::Vector2f upperBounds = world->getVisualsHandler().getUntransformedUpperBound(e);
+                    float offsety = BOUNDS_OVERLAP * (-2 * lowerBounds.y + upperBounds.y);
+
+                    //skip entities whose mirrored visuals do not cover a visible water tile
+                    sf::Transform flipped = worldStates.transform * transf.getTransform();
+                    flipped.scale(1.0f, -1.0f);
+                    flipped.translate(0.0f, offsety);
+                    sf::FloatRect reflectionBounds = flipped.transformRect({ upperBounds, lowerBounds - upperBounds });
+                    sf::FloatRect visibleReflection;
+                    if (!reflectionBounds.intersects(visibleWater, visibleReflection) ||
+                        !detail::coversActiveTile(tilemap, globalToTilemap.transformRect(visibleReflection)))
+                        continue;
+
+                    world->getState()->getRenderer().renderEntity(e, transf, e.modify<VisualsComponent>(), reflectiontex, worldStates, true, offsety);
+                    reflected = true;
+                }
+            }
+
+            if (reflected)
+            {
+                //reflectiontex holds premultiplied colors, scaling all channels applies the reflection opacity if the shader did not
+                reflectiontex.display();
+                sf::Sprite reflections(reflectiontex.getTexture());
+                reflections.setScale((float)rendertex.getSize().x / reflectiontex.getSize().x, (float)rendertex.getSize().y / reflectiontex.getSize().y);
+                sf::Uint8 layerOpacity = reflectionShader ? 255 : (sf::Uint8)(255 * opacity);
+                reflections.setColor({ layerOpacity, layerOpacity, layerOpacity, layerOpacity });
+                rendertex.setView(rendertex.getDefaultView());
+                rendertex.draw(reflections, sf::RenderStates{ sf::BlendMode(sf::BlendMode::One, sf::BlendMode::OneMinusSrcAlpha) });
+            }
         }
 
         //drawing to the rendertex done, attach it to a sprite
         rendertex.display();
         sf::Sprite renderbody(rendertex.getTexture());
-        /*sf::IntRect texRect = renderbody.getTextureRect();
-        sf::Vector2f posUL = states.transform.getInverse().transformPoint(tilemap.getPosition());
-        sf::Vector2i nodeScreenUpLeft = target.mapCoordsToPixel(posUL);
-        sf::Vector2i nodeScreenDownRight = target.mapCoordsToPixel(posUL + sf::Vector2f{tilemap.getBounds().width, tilemap.getBounds().height});
-
-        //may cut off the sprite
-        if (nodeScreenUpLeft.x > 0)
-        {
-            texRect.left = std::min(texRect.width, nodeScreenUpLeft.x);
-            renderbody.setPosition(nodeScreenUpLeft.x, renderbody.getPosition().y);
-            texRect.width = std::max(0, texRect.width - nodeScreenUpLeft.x);
-        }
-        if (nodeScreenUpLeft.y > 0)
-        {
-            texRect.top = std::min(texRect.height, nodeScreenUpLeft.y);
-            renderbody.setPosition(renderbody.getPosition().x, nodeScreenUpLeft.y);
-            texRect.height = std::max(0, texRect.height - nodeScreenUpLeft.y);
-        }
-        if (nodeScreenDownRight.x < target.getSize().x)
-        {
-            texRect.width = std::max(0, nodeScreenDownRight.x);
-        }
-        if (nodeScreenDownRight.y < target.getSize().y)
-        {
-            texRect.height = std::max(0, nodeScreenDownRight.y);
-        }
-
-        renderbody.setTextureRect(texRect); */
 
         sf::RenderStates waterstates;
 
         //apply the shader and draw the rendertex to the target
-        if (mShowShaders)
+        if (mShowShaders && mDistortionTexture)
         {
             waterstates.shader = &mWaterShader;
         }
@@ -149,6 +182,42 @@ namespace ungod
         return true; 
     }
 
+    const Water::ReflectionCache& Water::getReflectionCache(World& world, const sf::FloatRect& area) const
+    {
+        auto cache = std::find_if(mReflectionCache.begin(), mReflectionCache.end(), [&world] (const ReflectionCache& c) { return c.world == &world; });
+        if (cache == mReflectionCache.end())
+        {
+            mReflectionCache.emplace_back();
+            cache = mReflectionCache.end() - 1;
+            cache->world = &world;
+        }
+
+        bool covered = cache->area.left <= area.left && cache->area.top <= area.top &&
+                       cache->area.left + cache->area.width >= area.left + area.width &&
+                       cache->area.top + cache->area.height >= area.top + area.height;
+        //only changes that touch the queried area outdate the cache
+        if (covered && !world.getWaterHandler().reflectionsChanged(cache->revision, cache->area))
+        {
+            cache->revision = world.getWaterHandler().getReflectionRevision();
+            return *cache;
+        }
+
+        //query a larger area, so that the cache stays valid while the view moves a bit
+        cache->area = { area.left - REFLECTION_CACHE_MARGIN * area.width, area.top - REFLECTION_CACHE_MARGIN * area.height,
+                        (1 + 2 * REFLECTION_CACHE_MARGIN) * area.width, (1 + 2 * REFLECTION_CACHE_MARGIN) * area.height };
+        cache->revision = world.getWaterHandler().getReflectionRevision();
+        cache->entities.clear();
+
+        quad::PullResult<Entity> pull;
+        world.getQuadTree().retrieve(pull, { cache->area.left, cache->area.top, cache->area.width, cache->area.height });
+        for (Entity e : pull.getList())
+        {
+            if (e.has<TransformComponent>() && e.has<VisualsComponent>() && !e.has<WaterComponent>())
+                cache->entities.emplace_back(e);
+        }
+        return *cache;
+    }
+
     void Water::update(const Camera& cam)
     {
         mWaterShader.setUniform("time", mDistortionTimer.getElapsedTime().asSeconds());
@@ -158,6 +227,7 @@ namespace ungod
     void Water::init(const std::string& distortionTex, const std::string& fragmentShader, const std::string& vertexShader)
     {
         mDistortionTextureFile = distortionTex;
+        mDistortionTexture = nullptr;
         if (!sf::Shader::isAvailable())
         {
             ungod::Logger::warning("Shaders are not available on the operating system. \n Water is rendered with disabled shaders");
@@ -175,7 +245,6 @@ namespace ungod
                 mVertexShaderID = vertexShader;
                 mFragmentShaderID = fragmentShader;
                 mShowShaders = true;
-                targetsizeChanged(mTargetSize);
             }
         }
     }
@@ -184,17 +253,12 @@ namespace ungod
     {
         if (targetsize == mTargetSize) return;
         mTargetSize = targetsize;
-        if (mShowShaders && targetsize.x > 0u && targetsize.y > 0u)
-        {
-            buildDistortionTexture(targetsize);
-            mWaterShader.setUniform("screenSize", sf::Vector2f{ (float)mTargetSize.x, (float)mTargetSize.y });
-        }
+        setDistortionTexture(mDistortionTexture);
     }
 
     void Water::setShaders(bool flag)
     {
         mShowShaders = flag;
-        targetsizeChanged(mTargetSize);
     }
 
     void Water::setDistortionFactor(float distortion)
@@ -214,33 +278,16 @@ namespace ungod
         mReflectionOpacity = opacity;
     }
 
-    void Water::buildDistortionTexture(const sf::Vector2u& texsize)
+    void Water::setDistortionTexture(const sf::Texture* texture)
     {
-        sf::Image source;
-        if (!source.loadFromFile(mDistortionTextureFile))
+        mDistortionTexture = texture;
+        if (!mDistortionTexture)
             return;
-        sf::Image target;
-        target.create(texsize.x, texsize.y);
-        for (unsigned x = 0; x < texsize.x; ++x)
-            for (unsigned y = 0; y < texsize.y; ++y)
-            {
-                target.setPixel(x,y, source.getPixel(x%source.getSize().x, y%source.getSize().y) );
-            }
-        if (mDistortionTexture.loadFromImage(target))
-        {
-            mDistortionTexture.setRepeated(true);
-            mDistortionTexture.setSmooth(true);
-            mWaterShader.setUniform("distortionMapTexture", mDistortionTexture);
-            mWaterShader.setUniform("distortionMapSize", sf::Vector2f{(float)mDistortionTexture.getSize().x, (float)mDistortionTexture.getSize().y});
-            mWaterShader.setUniform("currentTexture", sf::Shader::CurrentTexture);
-            mWaterShader.setUniform("distortionFactor", mDistortionFactor);
-            mWaterShader.setUniform("flowFactor", mFlowFactor);
-            mShowShaders = true;
-        }
-        else
-        {
-            Logger::warning("Can't load distortion map for water shader.");
-            mShowShaders = false;
-        }
+        mWaterShader.setUniform("distortionMapTexture", *mDistortionTexture);
+        mWaterShader.setUniform("distortionMapSize", sf::Vector2f{(float)mDistortionTexture->getSize().x, (float)mDistortionTexture->getSize().y});
+        mWaterShader.setUniform("currentTexture", sf::Shader::CurrentTexture);
+        mWaterShader.setUniform("distortionFactor", mDistortionFactor);
+        mWaterShader.setUniform("flowFactor", mFlowFactor);
+        mWaterShader.setUniform("screenSize", sf::Vector2f{ (float)mTargetSize.x, (float)mTargetSize.y });
     }
 }
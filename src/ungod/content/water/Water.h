@@ -28,6 +28,7 @@
 
 #include <SFML/Graphics.hpp>
 #include "ungod/serialization/SerialWater.h"
+#include "ungod/base/Entity.h"
 
 namespace ungod
 {
@@ -40,6 +41,7 @@ namespace ungod
     {
     friend struct SerialBehavior<Water>;
     friend struct DeserialBehavior<Water>;
+    friend class WaterHandler;
 
     public:
         static constexpr float DEFAULT_DISTORTION = 0.01f;
@@ -47,18 +49,30 @@ namespace ungod
         static constexpr float DEFAULT_REFLECTION_OPACITY = 0.5f;
         static constexpr float BOUNDING_BOX_SCALING = 3.0f;  ///< indicates how high the imaginary bounding box for the quad tree search is
         static constexpr float BOUNDS_OVERLAP = 0.95f;  ///< indicates how much the visuals and the reflected visuals of an entity overlap in y-direction, smaller <-> more overlap
+        static constexpr float REFLECTION_CACHE_MARGIN = 0.5f;  ///< the cached reflection query area exceeds the required area by this fraction of its size on every side
 
     public:
         /** \brief Default constructs the water object for later initialization. */
         Water();
         Water(const Water& other);
 
-        /** \brief Renders shaders and reflections (if activated) on top of the given tilemap. */
-        bool render(sf::RenderTarget& target, sf::RenderTexture& rendertex, const TileMap& tilemap, const sf::Texture* tilemapTex, sf::RenderStates states, const std::vector<ungod::World*>& reflectionWorlds = {}) const;
+        /** \brief Renders shaders and reflections (if activated) on top of the given tilemap.
+        * Reflections are drawn to reflectiontex, which may be smaller than the target, and are composed on top of the tilemap.
+        * The reflection opacity is applied to every reflected entity through the reflection shader, so that overlapping
+        * reflections blend as if drawn directly. Without the shader, it is applied to the composed reflections.
+        * The entities to reflect are cached per reflection world and only queried again if the view leaves the
+        * cached area or the world signals changes. */
+        bool render(sf::RenderTarget& target, sf::RenderTexture& rendertex, sf::RenderTexture& reflectiontex, sf::Shader* reflectionShader,
+                    const TileMap& tilemap, const sf::Texture* tilemapTex,
+                    sf::RenderStates states, const std::vector<ungod::World*>& reflectionWorlds = {}) const;
+
+        /** \brief Drops the cached reflection entities. They are queried again with the next render call. */
+        void invalidateReflections() const { mReflectionCache.clear(); }
 
         void update(const Camera& cam);
 
-        /** \brief Provides appropriate resources to set up all internals of the water. */
+        /** \brief Provides appropriate resources to set up all internals of the water.
+        * The distortion texture is provided by the WaterHandler and shared by all water bodies using the same map. */
         void init(const std::string& distortionTex, const std::string& fragmentShader, const std::string& vertexShader);
 
         /** \brief Fits to a new target size. */
@@ -79,6 +93,9 @@ namespace ungod
         /** \brief Returns the filepath of the currently loaded distortion map. */
         const std::string& getDistortionMapID() const { return mDistortionTextureFile; }
 
+        /** \brief Returns the distortion texture sampled by the shader or nullptr, if the WaterHandler did not provide one yet. */
+        const sf::Texture* getDistortionTexture() const { return mDistortionTexture; }
+
         /** \brief Returns the filepath of the currently loaded fragment shader. */
         const std::string& getFragmentShaderID() const { return mFragmentShaderID; }
 
@@ -92,7 +109,7 @@ namespace ungod
         float getReflectionOpacity() const { return mReflectionOpacity; }
 
     private:
-        sf::Texture mDistortionTexture;
+        const sf::Texture* mDistortionTexture; ///<the distortion map tiled over the render target, owned by the WaterHandler
         std::string mDistortionTextureFile;
         sf::Shader mWaterShader;
         std::string mVertexShaderID;
@@ -108,8 +125,22 @@ namespace ungod
         float mFlowFactor;
         float mReflectionOpacity; 
 
+        struct ReflectionCache
+        {
+            ReflectionCache() : world(nullptr), revision(0) {}
+            const World* world;
+            unsigned revision; ///<reflection revision of the world at the time of the query
+            sf::FloatRect area; ///<queried area in local coordinates of the world
+            std::vector<Entity> entities; ///<entities inside the area that have visuals and are not water themselves
+        };
+        mutable std::vector<ReflectionCache> mReflectionCache;
+
     private:
-        void buildDistortionTexture(const sf::Vector2u& texsize);
+        //passes the shared distortion texture and the parameters to the shader
+        void setDistortionTexture(const sf::Texture* texture);
+
+        //returns the up to date cache entry for the given world and the area that must be covered
+        const ReflectionCache& getReflectionCache(World& world, const sf::FloatRect& area) const;
     };
 }
 
@@ -27,10 +27,12 @@
 #include "ungod/application/Application.h"
 #include "ungod/base/World.h"
 #include "ungod/base/WorldGraphNode.h"
+#include <unordered_set>
 
 namespace ungod
 {
     constexpr std::size_t WaterComponent::MAX_REFLECTION_WORLDS;
+    constexpr std::size_t WaterHandler::MAX_REFLECTION_CHANGES;
 
     std::vector<World*> WaterComponent::getReflectionWorlds() const
     {
@@ -61,13 +63,59 @@ namespace ungod
             {
                 targetSizeChanged(world, targetsize);
             });
+        //cached reflections of entities of this world become outdated if entities move into them, resize or vanish
+        world.getTransformHandler().onPositionChanged([this](Entity e, const sf::Vector2f&) { invalidateReflections(e.get<TransformComponent>().getBounds()); });
+        world.getTransformHandler().onSizeChanged([this](Entity e, const sf::Vector2f&) { invalidateReflections(e.get<TransformComponent>().getBounds()); });
+        world.getTransformHandler().onScaleChanged([this](Entity e, const sf::Vector2f&) { invalidateReflections(e.get<TransformComponent>().getBounds()); });
+        world.onEntityDestruction([this](Entity) { invalidateReflections(); });
+    }
+
+    void WaterHandler::invalidateReflections(const sf::FloatRect& bounds)
+    {
+        mReflectionChanges.emplace_back(++mReflectionRevision, bounds);
+        if (mReflectionChanges.size() > MAX_REFLECTION_CHANGES)
+        {
+            mReflectionResetRevision = mReflectionChanges.front().first;
+            mReflectionChanges.pop_front();
+        }
+    }
+
+    void WaterHandler::invalidateReflections()
+    {
+        mReflectionResetRevision = ++mReflectionRevision;
+        mReflectionChanges.clear();
+    }
+
+    bool WaterHandler::reflectionsChanged(unsigned revision, const sf::FloatRect& area) const
+    {
+        if (revision < mReflectionResetRevision)
+            return true;
+        for (auto change = mReflectionChanges.rbegin(); change != mReflectionChanges.rend() && change->first > revision; ++change)
+        {
+            //entities without extent are treated as points
+            if (area.intersects(change->second) || area.contains(change->second.left, change->second.top))
+                return true;
+        }
+        return false;
     }
 
     void WaterHandler::update(const std::list<Entity>& entities, const Camera& cam)
     {
         dom::Utility<Entity>::iterate<WaterComponent>(entities,
-            [&cam](Entity e, WaterComponent& wc)
+            [this, &cam](Entity e, WaterComponent& wc)
             {
+                //water bodies get their distortion texture the first time they are updated with active shaders
+                if (wc.mWater.isShowingShaders() && !wc.mWater.getDistortionTexture() && mTargetSize.x > 0u && mTargetSize.y > 0u)
+                {
+                    const sf::Texture* texture = getDistortionTexture(wc.mWater.getDistortionMapID());
+                    if (texture)
+                        wc.mWater.setDistortionTexture(texture);
+                    else
+                    {
+                        Logger::warning("Can't load distortion map for water shader.");
+                        wc.mWater.setShaders(false);
+                    }
+                }
                 wc.mWater.update(cam);
             });
     }
@@ -132,12 +180,76 @@ namespace ungod
 
     void WaterHandler::targetSizeChanged(const World& world, const sf::Vector2u& targetsize)
     {
-        world.getUniverse().iterateOverComponents<WaterComponent>([targetsize](WaterComponent& water)
+        if (targetsize != mTargetSize)
+        {
+            mTargetSize = targetsize;
+            //drop the textures of maps that are no longer used, rebuild the others once for all water bodies
+            std::unordered_set<std::string> used;
+            world.getUniverse().iterateOverComponents<WaterComponent>([&used](WaterComponent& water)
+                {
+                    if (water.mWater.getDistortionTexture())
+                        used.emplace(water.mWater.getDistortionMapID());
+                });
+            for (auto it = mDistortionTextures.begin(); it != mDistortionTextures.end();)
             {
+                if (used.count(it->first) == 0 || !buildDistortionTexture(it->second))
+                    it = mDistortionTextures.erase(it);
+                else
+                    ++it;
+            }
+        }
+        world.getUniverse().iterateOverComponents<WaterComponent>([this, targetsize](WaterComponent& water)
+            {
+                //water bodies whose texture could not be rebuilt get a new one with the next update
+                if (water.mWater.getDistortionTexture() && mDistortionTextures.count(water.mWater.getDistortionMapID()) == 0)
+                    water.mWater.setDistortionTexture(nullptr);
                 water.mWater.targetsizeChanged(targetsize);
             });
     }
 
+    const sf::Texture* WaterHandler::getDistortionTexture(const std::string& distortionMap)
+    {
+        auto it = mDistortionTextures.find(distortionMap);
+        if (it == mDistortionTextures.end())
+        {
+            DistortionTexture distortion;
+            distortion.map.load(distortionMap, LoadPolicy::SYNC);
+            distortion.texture = std::make_unique<sf::RenderTexture>();
+            if (!buildDistortionTexture(distortion))
+                return nullptr;
+            it = mDistortionTextures.emplace(distortionMap, std::move(distortion)).first;
+        }
+        return &it->second.texture->getTexture();
+    }
+
+    bool WaterHandler::buildDistortionTexture(DistortionTexture& distortion) const
+    {
+        if (!distortion.map.isLoaded() || mTargetSize.x == 0u || mTargetSize.y == 0u)
+            return false;
+        if (distortion.texture->getSize() != mTargetSize && !distortion.texture->create(mTargetSize.x, mTargetSize.y))
+        {
+            Logger::warning("Can't create distortion texture for water shader.");
+            return false;
+        }
+        //the shader samples the map in target coordinates, so it is tiled on the gpu instead of relying on the
+        //repeat flag of the shared map
+        const sf::Texture& source = distortion.map.get();
+        if (source.getSize().x == 0u || source.getSize().y == 0u)
+            return false;
+        sf::Sprite tile(source);
+        distortion.texture->clear();
+        for (unsigned x = 0; x < mTargetSize.x; x += source.getSize().x)
+            for (unsigned y = 0; y < mTargetSize.y; y += source.getSize().y)
+            {
+                tile.setPosition((float)x, (float)y);
+                distortion.texture->draw(tile, sf::BlendNone);
+            }
+        distortion.texture->display();
+        distortion.texture->setRepeated(true);
+        distortion.texture->setSmooth(true);
+        return true;
+    }
+
     WaterHandler::~WaterHandler()
     {
         mTargetSizeLink.disconnect();
@@ -27,9 +27,13 @@
 #define UNGOD_WATER_HANDLER_H
 
 #include <array>
+#include <deque>
+#include <memory>
+#include <unordered_map>
 #include <utility>
 #include "ungod/content/water/Water.h"
 #include "ungod/base/Entity.h"
+#include "ungod/visual/Image.h"
 #include "owls/Signal.h"
 
 namespace ungod
@@ -64,11 +68,15 @@ namespace ungod
         std::array< std::pair<WorldGraphNode*, std::string>, MAX_REFLECTION_WORLDS> mReflectionWorlds;
     };
 
-    /** \brief A class that manages water-entities. */
+    /** \brief A class that manages water-entities. The distortion maps of the water shaders are tiled over a texture of
+    * the target size once per map and shared by all water bodies of the world that use the same map. */
     class WaterHandler
     {
     public:
-        WaterHandler() = default;
+        static constexpr std::size_t MAX_REFLECTION_CHANGES = 1024; ///< number of changes that are remembered for the reflection caches
+
+    public:
+        WaterHandler() : mReflectionRevision(0), mReflectionResetRevision(0) {}
 
         void init(World & world);
 
@@ -110,14 +118,44 @@ namespace ungod
         { setWaterReflectionOpacity(e.modify<WaterComponent>(), opacity); }
         static void setWaterReflectionOpacity(WaterComponent& water, float opacity);
 
+        /** \brief Rebuilds the shared distortion textures for the new target size and passes it to all water bodies. */
         void targetSizeChanged(const World& world, const sf::Vector2u& targetsize);
 
+        /** \brief Signals that an entity with the given bounds moved, resized or was added to the world. Water bodies
+        * query their reflected entities again if their reflected area intersects the bounds. */
+        void invalidateReflections(const sf::FloatRect& bounds);
+
+        /** \brief Signals that the reflected entity sets of the world became outdated everywhere, e.g. because an entity was removed. */
+        void invalidateReflections();
+
+        /** \brief Returns a counter that is increased with every change of the reflected entities of the world. */
+        unsigned getReflectionRevision() const { return mReflectionRevision; }
+
+        /** \brief Returns true if a change after the given revision affects the given area in local coordinates of the world. */
+        bool reflectionsChanged(unsigned revision, const sf::FloatRect& area) const;
+
         ~WaterHandler();
 
     private:
         owls::SignalLink<void, const sf::Vector2u&> mTargetSizeLink; 
+        unsigned mReflectionRevision;
+        unsigned mReflectionResetRevision; ///< changes up to this revision are no longer known
+        std::deque< std::pair<unsigned, sf::FloatRect> > mReflectionChanges; ///< bounds of the latest changes with their revision
+
+        struct DistortionTexture
+        {
+            Image map; ///<the distortion map as loaded from file
+            std::unique_ptr<sf::RenderTexture> texture; ///<the map tiled over the target size
+        };
+        std::unordered_map<std::string, DistortionTexture> mDistortionTextures; ///<shared distortion textures by map file
+        sf::Vector2u mTargetSize;
 
     private:
+        //returns the shared distortion texture of the given map file, builds it on first use, nullptr if it can not be built
+        const sf::Texture* getDistortionTexture(const std::string& distortionMap);
+
+        //tiles the distortion map over the texture, returns false on failure
+        bool buildDistortionTexture(DistortionTexture& distortion) const;
     };
 }
 
@@ -32,6 +32,7 @@
 #include <SFML/Graphics/ConvexShape.hpp>
 #include "quadtree/QuadTree.h"
 #include "owls/Signal.h"
+#include "owls/SlotSignal.h"
 #include "ungod/physics/Collision.h"
 #include "ungod/base/Entity.h"
 #include "ungod/serialization/CollisionSerial.h"
@@ -151,8 +152,8 @@ namespace ungod
 		static void moveColliders(Entity e, const sf::Vector2f& vec);
 
     private:
-        owls::Signal<Entity, const sf::FloatRect&> mContentsChangedSignal;
-        owls::Signal<Entity> mContentRemoved;
+        owls::SlotSignal<Entity, const sf::FloatRect&> mContentsChangedSignal;
+        owls::SlotSignal<Entity> mContentRemoved;
 
         void move(Entity e, const sf::Vector2f& vec);
 
@@ -206,9 +207,9 @@ namespace ungod
         quad::QuadTree<Entity>* mQuadtree;
         std::array< CollidingEntitiesMap, 2 > mDoubleBuffers;
         bool mBufferActive;
-        owls::Signal<Entity, Entity> mCollisionBeginSignal;
-        owls::Signal<Entity, Entity, const sf::Vector2f&, const Collider&, const Collider&> mCollisionSignal;
-        owls::Signal<Entity, Entity> mCollisionEndSignal;
+        owls::SlotSignal<Entity, Entity> mCollisionBeginSignal;
+        owls::SlotSignal<Entity, Entity, const sf::Vector2f&, const Collider&, const Collider&> mCollisionSignal;
+        owls::SlotSignal<Entity, Entity> mCollisionEndSignal;
 
     private:
         void notifyCollision(Entity e1, Entity e2, const sf::Vector2f& mdv, const Collider& c1, const Collider& c2);
@@ -0,0 +1,238 @@
+/*
+* This file is part of the ungod - framework.
+* Copyright (C) 2016 Felix Becker - fb132550@uni-greifswald.de
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#include "ungod/physics/Crowd.h"
+#include "ungod/physics/Movement.h"
+#include "ungod/base/Transform.h"
+#include <cmath>
+#include <algorithm>
+
+namespace ungod
+{
+    namespace detail
+    {
+        //converts a condition to 1.0f or 0.0f, vectorized as a compare and a bitwise and
+        inline float mask(bool condition)
+        {
+            return condition ? 1.0f : 0.0f;
+        }
+    }
+
+    constexpr float CrowdHandler::DEFAULT_NEIGHBOR_RADIUS;
+    constexpr float CrowdHandler::DEFAULT_TIME_HORIZON;
+    constexpr std::size_t CrowdHandler::DEFAULT_MAX_NEIGHBORS;
+    constexpr float CrowdHandler::DEFAULT_RADIUS;
+    constexpr float CrowdHandler::DEFAULT_SEPARATION;
+    constexpr float CrowdHandler::DEFAULT_ALIGNMENT;
+    constexpr float CrowdHandler::DEFAULT_COHESION;
+    constexpr float CrowdHandler::DEFAULT_AVOIDANCE;
+
+
+    CrowdComponent::CrowdComponent() :
+        mRadius(CrowdHandler::DEFAULT_RADIUS),
+        mSeparation(CrowdHandler::DEFAULT_SEPARATION),
+        mAlignment(CrowdHandler::DEFAULT_ALIGNMENT),
+        mCohesion(CrowdHandler::DEFAULT_COHESION),
+        mAvoidance(CrowdHandler::DEFAULT_AVOIDANCE) {}
+
+
+    CrowdHandler::CrowdHandler() :
+        mNeighborRadius(DEFAULT_NEIGHBOR_RADIUS),
+        mTimeHorizon(DEFAULT_TIME_HORIZON),
+        mMaxNeighbors(DEFAULT_MAX_NEIGHBORS),
+        mGrid(DEFAULT_NEIGHBOR_RADIUS) {}
+
+
+    void CrowdHandler::init(float neighborRadius, float timeHorizon)
+    {
+        mNeighborRadius = std::max(neighborRadius, 1.0f);
+        mTimeHorizon = std::max(timeHorizon, 1.0f);
+        mGrid = SpatialHash<uint32_t>(mNeighborRadius);
+    }
+
+
+    void CrowdHandler::update(const std::list<Entity>& entities)
+    {
+        mUnits.clear();
+        mPosX.clear(); mPosY.clear();
+        mVelX.clear(); mVelY.clear();
+        mMaxSpeed.clear();
+        mRadius.clear();
+        mSeparation.clear(); mAlignment.clear(); mCohesion.clear(); mAvoidance.clear();
+
+        dom::Utility<Entity>::iterate<TransformComponent, MovementComponent, CrowdComponent>(entities,
+          [this] (Entity e, TransformComponent& transf, MovementComponent& movement, CrowdComponent& crowd)
+          {
+                sf::Vector2f position = transf.getCenterPosition();
+                mUnits.push_back(&movement.mMobilityUnit);
+                mPosX.push_back(position.x);
+                mPosY.push_back(position.y);
+                mVelX.push_back(movement.getBaseSpeed() * movement.getVelocity().x);
+                mVelY.push_back(movement.getBaseSpeed() * movement.getVelocity().y);
+                mMaxSpeed.push_back(std::max(movement.getBaseSpeed() * movement.getMaxVelocity(), 1e-6f));
+                mRadius.push_back(crowd.mRadius);
+                mSeparation.push_back(crowd.mSeparation);
+                mAlignment.push_back(crowd.mAlignment);
+                mCohesion.push_back(crowd.mCohesion);
+                mAvoidance.push_back(crowd.mAvoidance);
+          });
+
+        mGrid.reset();
+        for (uint32_t i = 0; i < mUnits.size(); ++i)
+            mGrid.insert(i, { mPosX[i], mPosY[i] });
+
+        mNX.resize(mMaxNeighbors); mNY.resize(mMaxNeighbors);
+        mNVX.resize(mMaxNeighbors); mNVY.resize(mMaxNeighbors);
+        mNR.resize(mMaxNeighbors);
+
+        const float range = mNeighborRadius * mNeighborRadius;
+        for (uint32_t i = 0; i < mUnits.size(); ++i)
+        {
+            const float x = mPosX[i], y = mPosY[i];
+            mNeighbors.clear();
+            mGrid.query({ x - mNeighborRadius, y - mNeighborRadius }, { x + mNeighborRadius, y + mNeighborRadius },
+                [this, i, x, y, range] (uint32_t j)
+                {
+                    const float dx = mPosX[j] - x, dy = mPosY[j] - y;
+                    const float dist = dx*dx + dy*dy;
+                    if (j != i && dist < range)
+                        mNeighbors.emplace_back(dist, j);
+                });
+            //only the nearest mMaxNeighbors neighbors are taken into account
+            std::size_t num = std::min(mMaxNeighbors, mNeighbors.size());
+            if (num == 0)
+                continue;
+            std::partial_sort(mNeighbors.begin(), mNeighbors.begin() + num, mNeighbors.end(),
+                              [] (const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b) { return a.first < b.first; });
+
+            for (std::size_t k = 0; k < num; ++k)
+            {
+                uint32_t j = mNeighbors[k].second;
+                mNX[k] = mPosX[j];
+                mNY[k] = mPosY[j];
+                mNVX[k] = mVelX[j];
+                mNVY[k] = mVelY[j];
+                mNR[k] = mRadius[j];
+            }
+
+            ungod::accelerate(*mUnits[i], steer(i, num), 1.0f);
+        }
+    }
+
+
+    sf::Vector2f CrowdHandler::steer(std::size_t i, std::size_t numNeighbors) const
+    {
+        const float px = mPosX[i], py = mPosY[i];
+        const float vx = mVelX[i], vy = mVelY[i];
+        const float radius = mRadius[i];
+        const float invRange = 1.0f / mNeighborRadius;
+        const float invHorizon = 1.0f / mTimeHorizon;
+        const float horizon = mTimeHorizon;
+        const float* nx = mNX.data();
+        const float* ny = mNY.data();
+        const float* nvx = mNVX.data();
+        const float* nvy = mNVY.data();
+        const float* nr = mNR.data();
+
+        float sepX = 0.0f, sepY = 0.0f;
+        float velX = 0.0f, velY = 0.0f;
+        float cenX = 0.0f, cenY = 0.0f;
+        float avoX = 0.0f, avoY = 0.0f;
+
+        //conditions are applied as 0/1 masks instead of branches, so that the loop can be vectorized
+        //(gcc -O3 vectorizes it if errno and trapping math are disabled: -fno-math-errno -fno-trapping-math)
+        for (std::size_t k = 0; k < numNeighbors; ++k)
+        {
+            const float dx = nx[k] - px, dy = ny[k] - py;
+            const float dist = std::sqrt(dx*dx + dy*dy);
+            const float invDist = detail::mask(dist > 1e-4f) / std::max(dist, 1e-4f);
+            const float reach = radius + nr[k];
+            const float invReach = detail::mask(reach > 0.0f) / std::max(reach, 1e-6f);
+
+            //separation, falls off linearly with the distance
+            const float push = std::max(0.0f, 1.0f - dist * invRange) * invDist;
+            sepX -= dx * push;
+            sepY -= dy * push;
+
+            velX += nvx[k];
+            velY += nvy[k];
+            cenX += dx;
+            cenY += dy;
+
+            //time of the closest approach under the current relative velocity and the offset of the neighbor at that time
+            const float wx = vx - nvx[k], wy = vy - nvy[k];
+            const float w2 = wx*wx + wy*wy;
+            const float t = detail::mask(w2 > 1e-8f) * (dx*wx + dy*wy) / std::max(w2, 1e-8f);
+            const float cx = dx - wx*t, cy = dy - wy*t;
+            const float miss = std::sqrt(cx*cx + cy*cy);
+
+            //steer away from the offset, on a head-on course sidestep to the right of the relative velocity.
+            //the neighbor sees the negated relative velocity and thus sidesteps in the opposite direction
+            const float headOn = detail::mask(miss < 1e-3f);
+            const float ax = headOn * wy - (1.0f - headOn) * cx;
+            const float ay = -headOn * wx - (1.0f - headOn) * cy;
+            const float len = headOn * std::sqrt(w2) + (1.0f - headOn) * miss;
+            const float invLen = detail::mask(len > 1e-6f) / std::max(len, 1e-6f);
+
+            //both agents take half of the responsibility for resolving the collision
+            const float threat = detail::mask(t > 0.0f) * detail::mask(t < horizon) * detail::mask(miss < reach);
+            const float avoid = threat * 0.5f * (1.0f - t * invHorizon) * (reach - miss) * invReach;
+            const float overlap = std::max(0.0f, reach - dist) * invReach;
+
+            avoX += ax * invLen * avoid - dx * invDist * overlap;
+            avoY += ay * invLen * avoid - dy * invDist * overlap;
+        }
+
+        const float invNum = 1.0f / (float)numNeighbors;
+        const float invSpeed = 1.0f / mMaxSpeed[i];
+
+        sf::Vector2f force;
+        force.x = mSeparation[i] * sepX +
+                  mAlignment[i] * (velX * invNum - vx) * invSpeed +
+                  mCohesion[i] * cenX * invNum * invRange +
+                  mAvoidance[i] * avoX;
+        force.y = mSeparation[i] * sepY +
+                  mAlignment[i] * (velY * invNum - vy) * invSpeed +
+                  mCohesion[i] * cenY * invNum * invRange +
+                  mAvoidance[i] * avoY;
+        return force;
+    }
+
+
+    void CrowdHandler::setRadius(Entity e, float radius)
+    {
+        e.modify<CrowdComponent>().mRadius = std::max(radius, 0.0f);
+    }
+
+
+    void CrowdHandler::setWeights(Entity e, float separation, float alignment, float cohesion, float avoidance)
+    {
+        CrowdComponent& crowd = e.modify<CrowdComponent>();
+        crowd.mSeparation = separation;
+        crowd.mAlignment = alignment;
+        crowd.mCohesion = cohesion;
+        crowd.mAvoidance = avoidance;
+    }
+}
@@ -0,0 +1,138 @@
+/*
+* This file is part of the ungod - framework.
+* Copyright (C) 2016 Felix Becker - fb132550@uni-greifswald.de
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#ifndef UNGOD_CROWD_H
+#define UNGOD_CROWD_H
+
+#include <vector>
+#include <list>
+#include <cstdint>
+#include <utility>
+#include <SFML/System/Vector2.hpp>
+#include "ungod/base/Entity.h"
+#include "ungod/utility/SpatialHash.h"
+
+namespace ungod
+{
+    struct MobilityUnit;
+
+    /**
+    * \ingroup Components
+    * \brief A component that lets an entity with a movement component take part in crowd steering. Members of
+    * a crowd keep distance to their neighbors, adapt to their heading and avoid collisions with them.
+    */
+    class CrowdComponent : public Serializable<CrowdComponent>
+    {
+    friend class CrowdHandler;
+    friend struct SerialBehavior<CrowdComponent, Entity>;
+    friend struct DeserialBehavior<CrowdComponent, Entity, DeserialMemory&>;
+    public:
+        CrowdComponent();
+
+        /** \brief Returns the radius of the body of the entity that neighbors try to avoid. */
+        float getRadius() const { return mRadius; }
+
+        float getSeparation() const { return mSeparation; }
+        float getAlignment() const { return mAlignment; }
+        float getCohesion() const { return mCohesion; }
+        float getAvoidance() const { return mAvoidance; }
+
+    private:
+        float mRadius;
+        float mSeparation; //< weight of the force that pushes away from close neighbors
+        float mAlignment; //< weight of the force that matches the velocity of the neighbors
+        float mCohesion; //< weight of the force that pulls towards the center of the neighbors
+        float mAvoidance; //< weight of the force that steers away from predicted collisions
+    };
+
+
+    /** \brief Computes crowd steering forces for all entities with crowd and movement components.
+    * Every update, the positions of the crowd members are hashed into a uniform grid with a cell size equal to the
+    * neighbor radius, so that the neighbors of an entity are found in the 3x3 cells around it. The forces
+    * (separation, alignment, cohesion and a reciprocal velocity based collision avoidance) are computed in a single
+    * pass over flat arrays of the positions and velocities and are added to the accelerations of the entities.
+    * The movement handler applies them in the next update, together with the forces of other steering behaviors. */
+    class CrowdHandler
+    {
+    public:
+        CrowdHandler();
+
+        /** \brief Sets the distance in which entities perceive each other and the time (in milliseconds) that
+        * collisions are predicted ahead. */
+        void init(float neighborRadius = DEFAULT_NEIGHBOR_RADIUS, float timeHorizon = DEFAULT_TIME_HORIZON);
+
+        /** \brief Computes the crowd forces of the given entities and accelerates them. */
+        void update(const std::list<Entity>& entities);
+
+        /** \brief Sets the radius of the body of the given entity. */
+        void setRadius(Entity e, float radius);
+
+        /** \brief Sets the weights of the forces for the given entity. A weight of 0 disables a force. */
+        void setWeights(Entity e, float separation, float alignment, float cohesion, float avoidance);
+
+        /** \brief Sets the maximum number of neighbors an entity reacts to. The nearest neighbors are chosen. */
+        void setMaxNeighbors(std::size_t maxNeighbors) { mMaxNeighbors = maxNeighbors; }
+
+        /** \brief Returns the number of entities processed in the last update. */
+        std::size_t getAgentCount() const { return mUnits.size(); }
+
+        float getNeighborRadius() const { return mNeighborRadius; }
+        float getTimeHorizon() const { return mTimeHorizon; }
+
+    private:
+        float mNeighborRadius;
+        float mTimeHorizon;
+        std::size_t mMaxNeighbors;
+        SpatialHash<uint32_t> mGrid;
+
+        //per agent data, rebuilt every update
+        std::vector<MobilityUnit*> mUnits;
+        std::vector<float> mPosX, mPosY;
+        std::vector<float> mVelX, mVelY;  //in world units per millisecond
+        std::vector<float> mMaxSpeed;  //in world units per millisecond
+        std::vector<float> mRadius;
+        std::vector<float> mSeparation, mAlignment, mCohesion, mAvoidance;
+
+        //squared distances and indices of the neighbors of the current agent, the data of the nearest is gathered into contiguous arrays
+        std::vector< std::pair<float, uint32_t> > mNeighbors;
+        std::vector<float> mNX, mNY, mNVX, mNVY, mNR;
+
+    public:
+        static constexpr float DEFAULT_NEIGHBOR_RADIUS = 64.0f;
+        static constexpr float DEFAULT_TIME_HORIZON = 1000.0f;
+        static constexpr std::size_t DEFAULT_MAX_NEIGHBORS = 16;
+        static constexpr float DEFAULT_RADIUS = 16.0f;
+        static constexpr float DEFAULT_SEPARATION = 0.5f;
+        static constexpr float DEFAULT_ALIGNMENT = 0.1f;
+        static constexpr float DEFAULT_COHESION = 0.05f;
+        static constexpr float DEFAULT_AVOIDANCE = 1.0f;
+
+    private:
+        /** \brief Computes the force of agent i from the gathered neighbor data. */
+        sf::Vector2f steer(std::size_t i, std::size_t numNeighbors) const;
+    };
+}
+
+#endif // UNGOD_CROWD_H
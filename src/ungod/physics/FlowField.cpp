@@ -0,0 +1,300 @@
+/*
+* This file is part of the ungod - framework.
+* Copyright (C) 2016 Felix Becker - fb132550@uni-greifswald.de
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#include "ungod/physics/FlowField.h"
+#include "ungod/physics/Path.h"
+#include "ungod/base/World.h"
+#include "ungod/base/Logger.h"
+#include "ungod/utility/Vec2fTraits.h"
+#include "ungod/utility/MarchingSquares.h"
+#include <queue>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+
+namespace ungod
+{
+    constexpr float FlowFieldPlanner::DEFAULT_CELL_SIZE;
+    constexpr float FlowFieldPlanner::DEFAULT_AGENT_RADIUS;
+    constexpr std::size_t FlowFieldPlanner::DEFAULT_MAX_FIELDS;
+    constexpr std::size_t FlowFieldPlanner::MAX_GRID_CELLS;
+
+    namespace detail
+    {
+        //the 8 neighbor offsets and their travel costs in cells
+        const int FLOW_OFFSET_X[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+        const int FLOW_OFFSET_Y[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+        const float FLOW_COST[8] = { 1.0f, 1.0f, 1.0f, 1.0f, 1.41421356f, 1.41421356f, 1.41421356f, 1.41421356f };
+
+        sf::Vector2f normalizedOrZero(const sf::Vector2f& v)
+        {
+            float len = std::sqrt(v.x * v.x + v.y * v.y);
+            return len > 1e-6f ? v / len : sf::Vector2f();
+        }
+    }
+
+
+    FlowFieldPlanner::FlowFieldPlanner() :
+        mWorld(nullptr), mCellSize(DEFAULT_CELL_SIZE), mAgentRadius(DEFAULT_AGENT_RADIUS), mDirty(false),
+        mSizeX(0), mSizeY(0), mMaxFields(DEFAULT_MAX_FIELDS), mUseCounter(0) {}
+
+
+    void FlowFieldPlanner::init(World& world, float cellSize, float agentRadius)
+    {
+        mChangedLink.disconnect();
+        mRemovedLink.disconnect();
+        mWorld = &world;
+        mCellSize = cellSize > 0.0f ? cellSize : DEFAULT_CELL_SIZE;
+        mAgentRadius = agentRadius;
+        mChangedLink = world.getMovementRigidbodyHandler().onContentsChanged([this] (Entity e, const sf::FloatRect&)
+            {
+                if (e.isStatic())
+                    invalidate();
+            });
+        mRemovedLink = world.getMovementRigidbodyHandler().onContentRemoved([this] (Entity e)
+            {
+                if (e.isStatic())
+                    invalidate();
+            });
+        invalidate();
+    }
+
+
+    void FlowFieldPlanner::setObstacles(const std::vector<PointContainer>& obstacles, const sf::FloatRect& bounds, float cellSize)
+    {
+        mFields.clear();
+        mDirty = false;
+        mCellSize = cellSize > 0.0f ? cellSize : DEFAULT_CELL_SIZE;
+        if (bounds.width <= 0.0f || bounds.height <= 0.0f)
+        {
+            mSizeX = 0;
+            mSizeY = 0;
+            mBlocked.clear();
+            return;
+        }
+        float cells = std::ceil(bounds.width / mCellSize) * std::ceil(bounds.height / mCellSize);
+        if (cells > (float)MAX_GRID_CELLS)
+        {
+            mCellSize *= std::sqrt(cells / (float)MAX_GRID_CELLS) * 1.01f;
+            Logger::warning("Flow field area is too large for the given cell size, cell size increased to ", mCellSize);
+            Logger::endl();
+        }
+
+        mOrigin = { bounds.left, bounds.top };
+        MarchingSquares<PointContainer, sf::Vector2f> rasterizer(mOrigin, { bounds.left + bounds.width, bounds.top + bounds.height }, mCellSize, mCellSize);
+        rasterizer.rasterize(obstacles.begin(), obstacles.end());
+        mSizeX = (unsigned)rasterizer.getImageSizeX();
+        mSizeY = (unsigned)rasterizer.getImageSizeY();
+        mBlocked = rasterizer.getBitImage();
+    }
+
+
+    void FlowFieldPlanner::invalidate()
+    {
+        mFields.clear();
+        if (mWorld)
+            mDirty = true;
+    }
+
+
+    sf::Vector2f FlowFieldPlanner::getDirection(const sf::Vector2f& position, const sf::Vector2f& goal)
+    {
+        update();
+        int goalCell = cellIndex(goal);
+        int cell = cellIndex(position);
+        if (goalCell < 0 || cell < 0 || cell == goalCell || mBlocked[goalCell])
+            return {};
+        const Field& field = getField((std::size_t)goalCell);
+        if (field.cost[cell] == std::numeric_limits<float>::infinity())
+            return {};
+
+        //blend the directions of the 4 surrounding cell centers, unreachable cells do not contribute
+        float fx = (position.x - mOrigin.x) / mCellSize - 0.5f;
+        float fy = (position.y - mOrigin.y) / mCellSize - 0.5f;
+        int x0 = (int)std::floor(fx);
+        int y0 = (int)std::floor(fy);
+        float tx = fx - x0;
+        float ty = fy - y0;
+        sf::Vector2f blended;
+        for (int k = 0; k < 4; ++k)
+        {
+            int x = x0 + (k & 1);
+            int y = y0 + (k >> 1);
+            if (x < 0 || y < 0 || x >= (int)mSizeX || y >= (int)mSizeY)
+                continue;
+            std::size_t i = (std::size_t)y * mSizeX + x;
+            if (field.cost[i] == std::numeric_limits<float>::infinity())
+                continue;
+            float weight = ((k & 1) ? tx : 1.0f - tx) * ((k >> 1) ? ty : 1.0f - ty);
+            blended += weight * ((int)i == goalCell ? detail::normalizedOrZero(goal - position) : field.direction[i]);
+        }
+        blended = detail::normalizedOrZero(blended);
+        if (blended.x == 0.0f && blended.y == 0.0f)
+            return field.direction[cell];
+        return blended;
+    }
+
+
+    float FlowFieldPlanner::getDistance(const sf::Vector2f& position, const sf::Vector2f& goal)
+    {
+        update();
+        int goalCell = cellIndex(goal);
+        int cell = cellIndex(position);
+        if (goalCell < 0 || cell < 0 || mBlocked[goalCell])
+            return std::numeric_limits<float>::infinity();
+        return getField((std::size_t)goalCell).cost[cell] * mCellSize;
+    }
+
+
+    bool FlowFieldPlanner::isBlocked(const sf::Vector2f& position)
+    {
+        update();
+        int cell = cellIndex(position);
+        return cell < 0 || mBlocked[cell];
+    }
+
+
+    void FlowFieldPlanner::setMaxCachedFields(std::size_t maxFields)
+    {
+        mMaxFields = std::max(maxFields, std::size_t{1});
+        while (mFields.size() > mMaxFields)
+            mFields.erase(std::min_element(mFields.begin(), mFields.end(),
+                        [] (const auto& a, const auto& b) { return a.second.lastUse < b.second.lastUse; }));
+    }
+
+
+    FlowFieldPlanner::~FlowFieldPlanner()
+    {
+        mChangedLink.disconnect();
+        mRemovedLink.disconnect();
+    }
+
+
+    void FlowFieldPlanner::update()
+    {
+        if (!mDirty || !mWorld)
+            return;
+        const auto& boundary = mWorld->getQuadTree().getBoundary();
+        setObstacles(PathPlanner::collectObstacles(*mWorld, mAgentRadius),
+                     sf::FloatRect(boundary.position.x, boundary.position.y, boundary.size.x, boundary.size.y), mCellSize);
+    }
+
+
+    int FlowFieldPlanner::cellIndex(const sf::Vector2f& point) const
+    {
+        float fx = std::floor((point.x - mOrigin.x) / mCellSize);
+        float fy = std::floor((point.y - mOrigin.y) / mCellSize);
+        if (fx < 0.0f || fy < 0.0f || fx >= (float)mSizeX || fy >= (float)mSizeY)
+            return -1;
+        return (int)fy * (int)mSizeX + (int)fx;
+    }
+
+
+    const FlowFieldPlanner::Field& FlowFieldPlanner::getField(std::size_t goal)
+    {
+        auto res = mFields.find(goal);
+        if (res == mFields.end())
+        {
+            if (mFields.size() >= mMaxFields)
+                mFields.erase(std::min_element(mFields.begin(), mFields.end(),
+                            [] (const auto& a, const auto& b) { return a.second.lastUse < b.second.lastUse; }));
+            res = mFields.emplace(goal, Field()).first;
+            integrate(res->second, goal);
+        }
+        res->second.lastUse = ++mUseCounter;
+        return res->second;
+    }
+
+
+    void FlowFieldPlanner::integrate(Field& field, std::size_t goal) const
+    {
+        const float inf = std::numeric_limits<float>::infinity();
+        std::size_t numCells = (std::size_t)mSizeX * mSizeY;
+        field.cost.assign(numCells, inf);
+        field.direction.assign(numCells, sf::Vector2f());
+
+        //dijkstra from the goal cell outwards, stale queue entries are skipped
+        using Entry = std::pair<float, std::size_t>;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+        field.cost[goal] = 0.0f;
+        open.emplace(0.0f, goal);
+        while (!open.empty())
+        {
+            Entry cur = open.top();
+            open.pop();
+            if (cur.first > field.cost[cur.second])
+                continue;
+            int x = (int)(cur.second % mSizeX);
+            int y = (int)(cur.second / mSizeX);
+            for (int k = 0; k < 8; ++k)
+            {
+                if (!isPassable(x, y, detail::FLOW_OFFSET_X[k], detail::FLOW_OFFSET_Y[k]))
+                    continue;
+                std::size_t next = (std::size_t)(y + detail::FLOW_OFFSET_Y[k]) * mSizeX + (x + detail::FLOW_OFFSET_X[k]);
+                float cost = cur.first + detail::FLOW_COST[k];
+                if (cost < field.cost[next])
+                {
+                    field.cost[next] = cost;
+                    open.emplace(cost, next);
+                }
+            }
+        }
+
+        //every reachable cell points towards its cheapest neighbor
+        for (std::size_t i = 0; i < numCells; ++i)
+        {
+            if (i == goal || field.cost[i] == inf)
+                continue;
+            int x = (int)(i % mSizeX);
+            int y = (int)(i / mSizeX);
+            float best = field.cost[i];
+            for (int k = 0; k < 8; ++k)
+            {
+                if (!isPassable(x, y, detail::FLOW_OFFSET_X[k], detail::FLOW_OFFSET_Y[k]))
+                    continue;
+                float cost = field.cost[(std::size_t)(y + detail::FLOW_OFFSET_Y[k]) * mSizeX + (x + detail::FLOW_OFFSET_X[k])];
+                if (cost < best)
+                {
+                    best = cost;
+                    field.direction[i] = detail::normalizedOrZero(sf::Vector2f((float)detail::FLOW_OFFSET_X[k], (float)detail::FLOW_OFFSET_Y[k]));
+                }
+            }
+        }
+    }
+
+
+    bool FlowFieldPlanner::isPassable(int x, int y, int dx, int dy) const
+    {
+        int nx = x + dx;
+        int ny = y + dy;
+        if (nx < 0 || ny < 0 || nx >= (int)mSizeX || ny >= (int)mSizeY)
+            return false;
+        if (mBlocked[(std::size_t)ny * mSizeX + nx])
+            return false;
+        if (dx != 0 && dy != 0)  //no corner cutting
+            return !mBlocked[(std::size_t)y * mSizeX + nx] && !mBlocked[(std::size_t)ny * mSizeX + x];
+        return true;
+    }
+}
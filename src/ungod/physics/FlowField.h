@@ -0,0 +1,136 @@
+/*
+* This file is part of the ungod - framework.
+* Copyright (C) 2016 Felix Becker - fb132550@uni-greifswald.de
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#ifndef UNGOD_FLOW_FIELD_H
+#define UNGOD_FLOW_FIELD_H
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <SFML/System/Vector2.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include "ungod/base/Entity.h"
+#include "owls/SlotSignal.h"
+
+namespace ungod
+{
+    class World;
+
+    /**
+    * \brief A planner for large groups of entities that share a goal. Instead of searching a path for every
+    * entity, the static obstacles are rasterized into a grid and a single integration field is computed per goal
+    * cell, that stores the travel cost from every cell to the goal. Entities sample the direction of descent
+    * at their position (see SteeringHandler::followFlowField), so the cost of moving a crowd is independent
+    * of the number of its members.
+    * Fields are cached per goal cell and dropped whenever a static collider of the movement collision context
+    * changes.
+    */
+    class FlowFieldPlanner
+    {
+    public:
+        using PointContainer = std::vector<sf::Vector2f>;
+
+        /** \brief Default constructor for later initialization. */
+        FlowFieldPlanner();
+
+        /** \brief Binds the planner to the world. The obstacles are the colliders of static entities in the movement
+        * collision context, extended by the agent radius. They are rasterized lazily on the first query after a change. */
+        void init(World& world, float cellSize = DEFAULT_CELL_SIZE, float agentRadius = DEFAULT_AGENT_RADIUS);
+
+        /** \brief Rasterizes the given obstacles (convex polygons, already extended by the agent radius) in the given area.
+        * Replaces the obstacles of the world until the next invalidation. */
+        void setObstacles(const std::vector<PointContainer>& obstacles, const sf::FloatRect& bounds, float cellSize);
+
+        /** \brief Drops all cached fields. If the planner is bound to a world, the obstacles are rasterized again on the next query. */
+        void invalidate();
+
+        /** \brief Returns the normalized direction to move along from the given position in order to reach the goal.
+        * Returns a zero vector if the position is in the goal cell or if the goal is not reachable from the position. */
+        sf::Vector2f getDirection(const sf::Vector2f& position, const sf::Vector2f& goal);
+
+        /** \brief Returns the approximate travel distance from the given position to the goal or infinity, if the goal
+        * is not reachable. */
+        float getDistance(const sf::Vector2f& position, const sf::Vector2f& goal);
+
+        /** \brief Returns true if the cell containing the given position is blocked by an obstacle. */
+        bool isBlocked(const sf::Vector2f& position);
+
+        /** \brief Sets the maximum number of goal cells fields are cached for. The least recently used ones are dropped first. */
+        void setMaxCachedFields(std::size_t maxFields);
+
+        std::size_t getCachedFieldCount() const { return mFields.size(); }
+        unsigned getSizeX() const { return mSizeX; }
+        unsigned getSizeY() const { return mSizeY; }
+        float getCellSize() const { return mCellSize; }
+
+        ~FlowFieldPlanner();
+
+    private:
+        /** \brief Integration and direction field towards a single goal cell. */
+        struct Field
+        {
+            std::vector<float> cost;  //travel cost to the goal in cells, infinity for unreachable cells
+            std::vector<sf::Vector2f> direction;  //normalized direction to the cheapest neighbor
+            uint64_t lastUse;
+        };
+
+        World* mWorld;
+        float mCellSize;
+        float mAgentRadius;
+        bool mDirty;
+        sf::Vector2f mOrigin;
+        unsigned mSizeX;
+        unsigned mSizeY;
+        std::vector<bool> mBlocked;  //row major, true = blocked
+        std::unordered_map<std::size_t, Field> mFields;  //by goal cell
+        std::size_t mMaxFields;
+        uint64_t mUseCounter;
+        owls::SlotLink<Entity, const sf::FloatRect&> mChangedLink;
+        owls::SlotLink<Entity> mRemovedLink;
+
+    public:
+        static constexpr float DEFAULT_CELL_SIZE = 32.0f;
+        static constexpr float DEFAULT_AGENT_RADIUS = 16.0f;
+        static constexpr std::size_t DEFAULT_MAX_FIELDS = 16;
+        static constexpr std::size_t MAX_GRID_CELLS = 1u << 22;  //the cell size is increased for larger areas
+
+    private:
+        /** \brief Rasterizes the obstacles of the world if they changed since the last query. */
+        void update();
+
+        /** \brief Returns the index of the cell containing the point or -1 if the point is outside of the grid. */
+        int cellIndex(const sf::Vector2f& point) const;
+
+        /** \brief Returns the cached field of the given goal cell or computes it. */
+        const Field& getField(std::size_t goal);
+
+        void integrate(Field& field, std::size_t goal) const;
+
+        /** \brief Returns true if one can move from the cell (x,y) by (dx,dy) without cutting a blocked corner. */
+        bool isPassable(int x, int y, int dx, int dy) const;
+    };
+}
+
+#endif // UNGOD_FLOW_FIELD_H
@@ -28,6 +28,7 @@
 
 #include <SFML/System/Vector2.hpp>
 #include "owls/Signal.h"
+#include "owls/SlotSignal.h"
 #include "ungod/base/Entity.h"
 #include "ungod/physics/Path.h"
 #include "ungod/physics/MobilityUnit.h"
@@ -46,6 +47,7 @@ namespace ungod
     class MovementComponent : public ungod::Serializable<MovementComponent>
     {
     friend class MovementHandler;
+    friend class CrowdHandler;
      friend struct SerialBehavior<MovementComponent, Entity>;
     friend struct DeserialBehavior<MovementComponent, Entity, DeserialMemory&>;
     public:
@@ -161,9 +163,9 @@ namespace ungod
         TransformHandler* mTransformer;
 
         //signals
-        owls::Signal<Entity, const sf::Vector2f&> mBeginMovingSignal;
-        owls::Signal<Entity> mEndMovingSignal;
-        owls::Signal<Entity, MovementComponent::Direction, MovementComponent::Direction> mDirectionChangedSignal;
+        owls::SlotSignal<Entity, const sf::Vector2f&> mBeginMovingSignal;
+        owls::SlotSignal<Entity> mEndMovingSignal;
+        owls::SlotSignal<Entity, MovementComponent::Direction, MovementComponent::Direction> mDirectionChangedSignal;
 
     public:
         static constexpr float sBaseSpeed = 0.2f;
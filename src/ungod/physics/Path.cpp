@@ -30,9 +30,127 @@
 #include "ungod/utility/Vec2fTraits.h"
 #include "ungod/utility/DelaunayTriangulation.h"
 #include "ungod/utility/DisjointSets.h"
+#include <unordered_map>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <chrono>
+#include <iterator>
 
 namespace ungod
 {
+    namespace detail
+    {
+        //twice the signed area of the triangle abc
+        inline float triarea2(const sf::Vector2f& a, const sf::Vector2f& b, const sf::Vector2f& c)
+        {
+            return (c.x - a.x) * (b.y - a.y) - (b.x - a.x) * (c.y - a.y);
+        }
+
+        inline bool samePoint(const sf::Vector2f& a, const sf::Vector2f& b)
+        {
+            return std::abs(a.x - b.x) < 0.001f && std::abs(a.y - b.y) < 0.001f;
+        }
+
+        //returns true if p lies on the line through a and b
+        inline bool onLine(const sf::Vector2f& a, const sf::Vector2f& b, const sf::Vector2f& p)
+        {
+            return std::abs(triarea2(a, b, p)) < 0.001f * (std::abs(b.x - a.x) + std::abs(b.y - a.y));
+        }
+
+        //the point where the line from position to target crosses the portal ab, clamped to the portal
+        sf::Vector2f portalEntry(const sf::Vector2f& a, const sf::Vector2f& b, const sf::Vector2f& position, const sf::Vector2f& target)
+        {
+            sf::Vector2f edge = b - a;
+            sf::Vector2f line = target - position;
+            float denom = line.x * edge.y - line.y * edge.x;
+            float t = 0.5f;
+            if (std::abs(denom) > 1e-6f)
+                t = std::min(1.0f, std::max(0.0f, ((a.x - position.x) * line.y - (a.y - position.y) * line.x) / denom));
+            return a + edge * t;
+        }
+
+        //points on the edges count as contained
+        bool triangleContainsPoint(const sf::Vector2f& a, const sf::Vector2f& b, const sf::Vector2f& c, const sf::Vector2f& p)
+        {
+            float d1 = triarea2(a, b, p);
+            float d2 = triarea2(b, c, p);
+            float d3 = triarea2(c, a, p);
+            bool neg = d1 < 0 || d2 < 0 || d3 < 0;
+            bool pos = d1 > 0 || d2 > 0 || d3 > 0;
+            return !(neg && pos);
+        }
+
+        //points on the outline do not count as contained
+        bool polygonContains(const PointContainer& polygon, const sf::Vector2f& p)
+        {
+            if (polygon.size() < 3)
+                return false;
+            bool neg = false, pos = false;
+            for (std::size_t i = 0; i < polygon.size(); ++i)
+            {
+                float d = triarea2(polygon[i], polygon[(i + 1) % polygon.size()], p);
+                neg = neg || d <= 0;
+                pos = pos || d >= 0;
+                if (neg && pos)
+                    return false;
+            }
+            return true;
+        }
+
+        sf::FloatRect polygonBounds(const PointContainer& polygon)
+        {
+            sf::Vector2f lower = polygon.front(), upper = polygon.front();
+            for (const auto& p : polygon)
+            {
+                lower.x = std::min(lower.x, p.x);
+                lower.y = std::min(lower.y, p.y);
+                upper.x = std::max(upper.x, p.x);
+                upper.y = std::max(upper.y, p.y);
+            }
+            return { lower, upper - lower };
+        }
+
+        //extends a convex polygon (or a segment) by the given radius
+        PointContainer inflatePolygon(const PointContainer& polygon, float radius)
+        {
+            if (polygon.size() == 2)
+            {
+                sf::Vector2f dir = polygon[1] - polygon[0];
+                float len = std::sqrt(dir.x * dir.x + dir.y * dir.y);
+                dir = len > 0.0f ? dir / len : sf::Vector2f(1.0f, 0.0f);
+                sf::Vector2f normal(-dir.y, dir.x);
+                dir *= radius;
+                normal *= radius;
+                return { polygon[0] - dir + normal, polygon[1] + dir + normal, polygon[1] + dir - normal, polygon[0] - dir - normal };
+            }
+            float area = 0.0f;
+            for (std::size_t i = 0; i < polygon.size(); ++i)
+                area += polygon[i].x * polygon[(i + 1) % polygon.size()].y - polygon[(i + 1) % polygon.size()].x * polygon[i].y;
+            float orientation = area > 0.0f ? 1.0f : -1.0f;
+            auto outwardNormal = [&] (const sf::Vector2f& a, const sf::Vector2f& b)
+            {
+                sf::Vector2f d = b - a;
+                float len = std::sqrt(d.x * d.x + d.y * d.y);
+                if (len <= 0.0f)
+                    return sf::Vector2f();
+                return sf::Vector2f(d.y, -d.x) * (orientation / len);
+            };
+            PointContainer inflated;
+            inflated.reserve(polygon.size());
+            for (std::size_t i = 0; i < polygon.size(); ++i)
+            {
+                const sf::Vector2f& prev = polygon[(i + polygon.size() - 1) % polygon.size()];
+                const sf::Vector2f& next = polygon[(i + 1) % polygon.size()];
+                sf::Vector2f n1 = outwardNormal(prev, polygon[i]);
+                sf::Vector2f n2 = outwardNormal(polygon[i], next);
+                float dot = std::max(n1.x * n2.x + n1.y * n2.y, -0.5f); //clamp the miter length at sharp corners
+                inflated.push_back(polygon[i] + (n1 + n2) * (radius / (1.0f + dot)));
+            }
+            return inflated;
+        }
+    }
+
     void BasePath::switchDirection() { mDirection = !mDirection; }
 
 
@@ -89,6 +207,38 @@ namespace ungod
 
 
     constexpr float PathPlanner::DEFAULT_WAYPOINT_RADIUS;
+    constexpr float PathPlanner::NAVMESH_EDGE_SPLIT;
+    constexpr float PathPlanner::DEFAULT_REQUEST_BUDGET;
+
+    PathPlanner::PathPlanner() :
+        mNextTicket(1), mSolvedSearches(0), mRequestBudget(DEFAULT_REQUEST_BUDGET), mInFlight(0), mRunning(false) {}
+
+    void PathPlanner::init(unsigned numThreads, float budget)
+    {
+        mRequestBudget = budget;
+        if (mWorkers.size() == numThreads)
+            return;
+        if (!mWorkers.empty())
+        {
+            {
+                std::lock_guard<std::mutex> lock(mRequestMutex);
+                mRunning = false;
+            }
+            mRequestCV.notify_all();
+            for (auto& worker : mWorkers)
+                worker.join();
+            mWorkers.clear();
+        }
+        mRunning = numThreads > 0;
+        for (unsigned i = 0; i < numThreads; ++i)
+            mWorkers.emplace_back(&PathPlanner::workerLoop, this);
+    }
+
+    PathPlanner::~PathPlanner()
+    {
+        init(0);
+    }
+
 
     PathPlanner::QuadTreeElement::QuadTreeElement(std::size_t cNodeID, PathPlanner& cPathplanner) :
         nodeID(cNodeID)
@@ -100,79 +250,218 @@ namespace ungod
 
     void PathPlanner::buildNavGraph(World& world, float agentRadius)
     {
-        //build a vector of the cornerpoints of all obstacles in the world
-        //extend the geometry by the given radius
-        std::vector<sf::Vector2f> points;
-        DisjointSets<const Collider*> colliderClusters; //bundles together intersecting colliders
+        const auto& boundary = world.getQuadTree().getBoundary();
+        buildNavGraph(collectObstacles(world, agentRadius), sf::FloatRect(boundary.position.x, boundary.position.y, boundary.size.x, boundary.size.y));
+    }
 
-        /*world.forAll<TransformComponent, RigidbodyComponent<MOVEMENT_COLLISION_CONTEXT>>([&] (Entity e, TransformComponent& t, RigidbodyComponent<MOVEMENT_COLLISION_CONTEXT>& rb)
+    std::vector<PointContainer> PathPlanner::collectObstacles(World& world, float agentRadius)
+    {
+        std::vector<PointContainer> obstacles;
+        detail::ParamStack<sf::Vector2f, Collider::MAX_PARAM> axis;
+        detail::ParamStack<sf::Vector2f, Collider::MAX_PARAM / 2> pivots;
+        auto addCollider = [&] (const Collider& collider, const TransformComponent& t)
+        {
+            for (unsigned i = 0; i < collider.getNumRuns(); ++i)
+            {
+                axis.clear();
+                pivots.clear();
+                collider.getAxisAndPivots(t, axis, pivots, i);
+                if (pivots.size() < 2)
+                    continue;
+                PointContainer outline;
+                for (std::size_t k = 0; k < pivots.size(); ++k)
+                    outline.push_back(pivots[k]);
+                obstacles.emplace_back(detail::inflatePolygon(outline, agentRadius));
+            }
+        };
+
+        world.forAll<TransformComponent, RigidbodyComponent<MOVEMENT_COLLISION_CONTEXT>>([&] (Entity e, TransformComponent& t, RigidbodyComponent<MOVEMENT_COLLISION_CONTEXT>& rb)
           {
               if (e.isStatic())
-              {
-                  for (const auto& collider : rb.getColliders())
-                  {
-                        colliderClusters.insertElement(&collider);
-                  }
-
-                  for (std::size_t i = 0; i < rb.getColliders().size(); ++i)
-                  {
-                        //extend geometry and add points to the pointlist
-                        sf::Transform localtrans;
-                        localtrans *= t.getTransform();
-                        localtrans.rotate(rb.getColliders()[i].getRotation(), rb.getColliders()[i].getCenter());
-                        points.emplace_back( localtrans.transformPoint( {rb.getColliders()[i].getUpleft().x - agentRadius, rb.getColliders()[i].getUpleft().y - agentRadius} ) );
-                        points.emplace_back( localtrans.transformPoint( {rb.getColliders()[i].getDownright().x + agentRadius, rb.getColliders()[i].getUpleft().y - agentRadius} ) );
-                        points.emplace_back( localtrans.transformPoint( {rb.getColliders()[i].getDownright().x + agentRadius, rb.getColliders()[i].getDownright().y + agentRadius}  ) );
-                        points.emplace_back( localtrans.transformPoint( {rb.getColliders()[i].getUpleft().x - agentRadius, rb.getColliders()[i].getDownright().y + agentRadius} ) );
-
-                        //find other colliders that collide with the current collider
-                        for (std::size_t j = i+1; j < rb.getColliders().size(); ++j)
-                        {
-                            if (satAlgorithm(rb.getColliders()[i], rb.getColliders()[j], t, t).first)
-                            {
-                                colliderClusters.merge(&rb.getColliders()[i], &rb.getColliders()[j]);
-                            }
-                        }
-                  }
-
-                  //find other entities that collide with the current entity, if found, merge the colliders that overlap
-                  owls::Signal<Entity, Entity, const sf::Vector2f&, const Collider&, const Collider&> collisionSignal;
-                  collisionSignal.connect([&] (Entity e1, Entity e2, const sf::Vector2f& mdv, const Collider& c1, const Collider& c2)
-                      {
-                        colliderClusters.merge(&c1, &c2);
-                      });
-                  quad::PullResult<Entity> pull = world.getEntitiesNearby(e);
-                  for (const auto& other : pull.getList())
-                  {
-                      CollisionManager<MOVEMENT_COLLISION_CONTEXT>::entityCollision(e, other, collisionSignal);
-                  }
-
-                  //now remove for each collider cluster all triangles, that have edges between 2 points of the cluster,
-              }
-          });*/
-
-          //triangulate the points
-          DelaunayTriangulation<sf::Vector2f> triag;
-          triag.run(points, sf::Vector2f(world.getQuadTree().getBoundary().position.x, world.getQuadTree().getBoundary().position.y),
-                            sf::Vector2f(world.getQuadTree().getBoundary().position.x + world.getQuadTree().getBoundary().size.x,
-                                         world.getQuadTree().getBoundary().position.y + world.getQuadTree().getBoundary().size.y));
-
-          //cleanup diagonal edges of each collider and their adjacent triangles
-          for (std::size_t i = 0; i < points.size()/4; ++i)
+                  addCollider(rb.getCollider(), t);
+          });
+        world.forAll<TransformComponent, MultiComponent<RigidbodyComponent<MOVEMENT_COLLISION_CONTEXT>>>([&] (Entity e, TransformComponent& t, MultiComponent<RigidbodyComponent<MOVEMENT_COLLISION_CONTEXT>>& rb)
           {
-              triag.getData().removeAdjacentTriangles(Edge(4*i, 4*i+2));
-              triag.getData().removeAdjacentTriangles(Edge(4*i+1, 4*i+3));
-          }
+              if (e.isStatic())
+                  for (std::size_t i = 0; i < rb.getComponentCount(); ++i)
+                      addCollider(rb.getComponent(i).getCollider(), t);
+          });
+        return obstacles;
+    }
 
-          //for each "cluster" of intersecting obstacles, remove triangles that intersect any colliders
+    void PathPlanner::buildNavGraph(const std::vector<PointContainer>& obstacles, const sf::FloatRect& bounds)
+    {
+        std::vector<sf::FloatRect> boxes;
+        boxes.reserve(obstacles.size());
+        for (const auto& obstacle : obstacles)
+            boxes.emplace_back(detail::polygonBounds(obstacle));
+
+        //bundle together overlapping obstacles, sweeping along the x-axis
+        std::vector<std::size_t> ids(obstacles.size());
+        for (std::size_t i = 0; i < ids.size(); ++i)
+            ids[i] = i;
+        DisjointSets<std::size_t> colliderClusters;
+        colliderClusters.reserve((unsigned)ids.size());
+        for (auto i : ids)
+            colliderClusters.insertElement(i);
+        std::sort(ids.begin(), ids.end(), [&boxes] (std::size_t i, std::size_t j) { return boxes[i].left < boxes[j].left; });
+        std::vector<std::size_t> active;
+        for (auto i : ids)
+        {
+            active.erase(std::remove_if(active.begin(), active.end(), [&] (std::size_t j) { return boxes[j].left + boxes[j].width < boxes[i].left; }), active.end());
+            for (auto j : active)
+                if (boxes[i].intersects(boxes[j]))
+                    colliderClusters.merge(i, j);
+            active.push_back(i);
+        }
 
+        //collect the corner points, long edges are split so that the triangulation follows the outlines
+        //points that lie within another obstacle of the same cluster are useless and dropped
+        std::vector<sf::Vector2f> points;
+        auto addPoint = [&] (const sf::Vector2f& p, std::size_t owner)
+        {
+            if (p.x < bounds.left || p.y < bounds.top || p.x > bounds.left + bounds.width || p.y > bounds.top + bounds.height)
+                return;
+            for (const auto* member : colliderClusters.findSet(owner)->clist)
+                if (member->data != owner && detail::polygonContains(obstacles[member->data], p))
+                    return;
+            points.push_back(p);
+        };
+        auto addOutline = [&] (const PointContainer& outline, bool closed, std::size_t owner)
+        {
+            for (std::size_t i = 0; i < outline.size(); ++i)
+            {
+                addPoint(outline[i], owner);
+                if (!closed && i == outline.size() - 1)
+                    break;
+                const sf::Vector2f& next = outline[(i + 1) % outline.size()];
+                unsigned pieces = (unsigned)std::ceil(distance(outline[i], next) / NAVMESH_EDGE_SPLIT);
+                for (unsigned k = 1; k < pieces; ++k)
+                    addPoint(outline[i] + (next - outline[i]) * ((float)k / pieces), owner);
+            }
+        };
+        for (std::size_t i = 0; i < obstacles.size(); ++i)
+            addOutline(obstacles[i], true, i);
+        std::size_t obstaclePoints = points.size();
+        PointContainer border = { { bounds.left, bounds.top }, { bounds.left + bounds.width, bounds.top },
+                                  { bounds.left + bounds.width, bounds.top + bounds.height }, { bounds.left, bounds.top + bounds.height } };
+        for (std::size_t i = 0; i < border.size(); ++i)
+        {
+            points.push_back(border[i]);
+            const sf::Vector2f& next = border[(i + 1) % border.size()];
+            unsigned pieces = (unsigned)std::ceil(distance(border[i], next) / (4 * NAVMESH_EDGE_SPLIT));
+            for (unsigned k = 1; k < pieces; ++k)
+                points.push_back(border[i] + (next - border[i]) * ((float)k / pieces));
+        }
+        Logger::info("Triangulating", points.size(), "navmesh points,", obstaclePoints, "of them on", obstacles.size(), "obstacles.");
+        Logger::endl();
+
+        //triangulate the points, the super triangle must not touch the border
+        DelaunayTriangulation<sf::Vector2f> triag;
+        triag.run(points, sf::Vector2f(bounds.left - bounds.width, bounds.top - bounds.height),
+                          sf::Vector2f(bounds.left + 2 * bounds.width, bounds.top + 2 * bounds.height));
+
+        //a uniform grid over the obstacles speeds up the inside-tests of the triangles
+        const float cellSize = 4 * NAVMESH_EDGE_SPLIT;
+        int columns = std::max(1, (int)std::ceil(bounds.width / cellSize));
+        int rows = std::max(1, (int)std::ceil(bounds.height / cellSize));
+        std::vector<std::vector<std::size_t>> grid((std::size_t)columns * rows);
+        auto cell = [&] (float x, float y)
+        {
+            int cx = std::min(columns - 1, std::max(0, (int)((x - bounds.left) / cellSize)));
+            int cy = std::min(rows - 1, std::max(0, (int)((y - bounds.top) / cellSize)));
+            return (std::size_t)cy * columns + cx;
+        };
+        for (std::size_t i = 0; i < obstacles.size(); ++i)
+        {
+            std::size_t first = cell(boxes[i].left, boxes[i].top);
+            std::size_t last = cell(boxes[i].left + boxes[i].width, boxes[i].top + boxes[i].height);
+            for (std::size_t y = first / columns; y <= last / columns; ++y)
+                for (std::size_t x = first % columns; x <= last % columns; ++x)
+                    grid[y * columns + x].push_back(i);
+        }
+        auto blocked = [&] (const sf::Vector2f& p)
+        {
+            for (auto i : grid[cell(p.x, p.y)])
+                if (detail::polygonContains(obstacles[i], p))
+                    return true;
+            return false;
+        };
+
+        //associate triangles with graph nodes, ignore triangles that lie within colliders
+        std::vector<NodeParameters> triangles;
+        for (const auto& t : triag.getData().getTriangleContainer())
+        {
+            if (!blocked(triangleCenterOfGravity(points[t.triangle.v0], points[t.triangle.v1], points[t.triangle.v2])))
+                triangles.emplace_back(t.triangle.v0, t.triangle.v1, t.triangle.v2);
+        }
+        buildNavMesh(points, triangles);
 
-          //associate triangles with graph nodes, ignore triangles that lie within colliders
+        //the triangulation is not constrained, so free triangles may still touch across an obstacle
+        for (std::size_t n = 0; n < mNodeParameters.size(); ++n)
+        {
+            NodeParameters& node = mNodeParameters[n];
+            const std::size_t corners[3] = { node.a, node.b, node.c };
+            for (unsigned j = 0; j < 3; ++j)
+                if (node.neighbors[j] >= 0 && blocked(centerPoint(mMeshVertices[corners[j]], mMeshVertices[corners[(j + 1) % 3]])))
+                {
+                    NodeParameters& other = mNodeParameters[node.neighbors[j]];
+                    for (auto& back : other.neighbors)
+                        if (back == (int)n)
+                            back = -1;
+                    node.neighbors[j] = -1;
+                }
+        }
+    }
+
+    void PathPlanner::buildNavMesh(const PointContainer& vertices, const std::vector<NodeParameters>& triangles)
+    {
+        //pending requests refer to nodes of the old mesh
+        cancelRequests();
+
+        mMeshVertices = vertices;
+        mNodeParameters = triangles;
+        mNodeCenters.clear();
+        mSearchContext = SearchContext();
+
+        //connect triangles that share an edge
+        std::unordered_map<uint64_t, std::pair<int, unsigned>> edges;
+        edges.reserve(mNodeParameters.size() * 2);
+        for (std::size_t n = 0; n < mNodeParameters.size(); ++n)
+        {
+            NodeParameters& node = mNodeParameters[n];
+            const std::size_t corners[3] = { node.a, node.b, node.c };
+            mNodeCenters.emplace_back(triangleCenterOfGravity(mMeshVertices[node.a], mMeshVertices[node.b], mMeshVertices[node.c]));
+            for (unsigned j = 0; j < 3; ++j)
+            {
+                node.neighbors[j] = -1;
+                uint64_t u = corners[j];
+                uint64_t v = corners[(j + 1) % 3];
+                uint64_t key = u < v ? (u << 32) | v : (v << 32) | u;
+                auto res = edges.emplace(key, std::make_pair((int)n, j));
+                if (!res.second && res.first->second.first >= 0)
+                {
+                    node.neighbors[j] = res.first->second.first;
+                    mNodeParameters[res.first->second.first].neighbors[res.first->second.second] = (int)n;
+                    res.first->second.first = -1; //an edge connects two triangles at most
+                }
+            }
+        }
 
+        //register the triangles in the node finder
+        mNodeFinder.clear();
+        if (mMeshVertices.empty())
+            return;
+        sf::FloatRect meshBounds = detail::polygonBounds(mMeshVertices);
+        mNodeFinder.setBoundary(quad::Bounds(meshBounds.left, meshBounds.top, meshBounds.width, meshBounds.height));
+        for (std::size_t n = 0; n < mNodeParameters.size(); ++n)
+            mNodeFinder.insert(QuadTreeElement(n, *this));
     }
 
     void PathPlanner::update(const std::list<Entity>& entities, float delta, MovementHandler& mvm)
     {
+        processRequests();
+
         dom::Utility<Entity>::iterate< PathFinderComponent, MovementComponent, TransformComponent >(entities,
           [delta, &mvm, this] (Entity e, PathFinderComponent& pathfinder, MovementComponent& mv, TransformComponent& transf)
           {
@@ -229,46 +518,338 @@ namespace ungod
         pathfinder.mPolicy = policy;
         pathfinder.mSpeed = speed;
         pathfinder.mRadius = radius;
+        pathfinder.mRequest = 0;
     }
 
-    void PathPlanner::findPathTo(Entity e, const sf::Vector2f& position)
+    bool PathPlanner::findPathTo(Entity e, const sf::Vector2f& position)
     {
-        /*Pathfinder& pf = e.modify<Pathfinder>();
-        pf.mActive = true;
-        pf.mPath = createPath(position);*/
+        sf::Vector2f start = e.get<TransformComponent>().getCenterPosition();
+        int startNode = getNodeAt(start);
+        int goalNode = getNodeAt(position);
+        if (startNode < 0 || goalNode < 0)
+            return false;
+
+        PathFinderComponent& pf = e.modify<PathFinderComponent>();
+        pf.mRequest = mNextTicket++;
+
+        std::lock_guard<std::mutex> lock(mRequestMutex);
+        uint64_t key = ((uint64_t)startNode << 32) | (uint64_t)goalNode;
+        auto res = mGroupLookup.find(key);
+        if (res == mGroupLookup.end())
+        {
+            mPendingGroups.emplace_back();
+            mPendingGroups.back().startNode = startNode;
+            mPendingGroups.back().goalNode = goalNode;
+            mPendingGroups.back().found = false;
+            res = mGroupLookup.emplace(key, std::prev(mPendingGroups.end())).first;
+            mRequestCV.notify_one();
+        }
+        res->second->requests.push_back({ e, start, position, pf.mRequest, {} });
+        return true;
     }
 
-    sf::Vector2f PathPlanner::getGravityCenter(std::size_t nodeID)
+    void PathPlanner::onPathFound(const std::function<void(Entity, bool)>& callback)
+    {
+        mPathFoundSignal.connect(callback);
+    }
+
+    std::size_t PathPlanner::getPendingRequests() const
+    {
+        std::lock_guard<std::mutex> lock(mRequestMutex);
+        std::size_t num = 0;
+        for (const auto& group : mPendingGroups)
+            num += group.requests.size();
+        return num;
+    }
+
+    bool PathPlanner::findPath(const sf::Vector2f& start, const sf::Vector2f& target, PointContainer& waypoints)
     {
-        return triangleCenterOfGravity(mMeshVertices[mNodeParameters[nodeID].a], mMeshVertices[mNodeParameters[nodeID].b], mMeshVertices[mNodeParameters[nodeID].c]);
+        waypoints.clear();
+        int startNode = getNodeAt(start);
+        int goalNode = getNodeAt(target);
+        if (startNode < 0 || goalNode < 0 || !searchCorridor(mSearchContext, startNode, goalNode, start, target))
+            return false;
+        pullString(mSearchContext, start, target, waypoints);
+        return true;
     }
 
-    PathPtr PathPlanner::createPath(const sf::Vector2f& position)
+    int PathPlanner::getNodeAt(const sf::Vector2f& position) const
     {
-        /*//find the graph node that is closest to the target position, by querying the quad tree, which stores bounding boxes of the
-        //triangles, the graph nodes correspond to.
-        //That means we look for the triangle, that contains the requested position
-        std::size_t targetNode;
-        bool nodeLinked = false;
         quad::PullResult<PathPlanner::QuadTreeElement> result;
         mNodeFinder.retrieve(result, quad::Bounds(position.x, position.y, 1, 1));
         for (const auto& e : result.getList())
         {
-            if (triangleContains(mMeshVertices[mNodeParameters[e.nodeID].a],
-                                 mMeshVertices[mNodeParameters[e.nodeID].b],
-                                 mMeshVertices[mNodeParameters[e.nodeID].c],
-                                 position))
-             {
-                 targetNode = e.nodeID;
-                 nodeLinked = true;
-                 break;
-             }
+            const NodeParameters& node = mNodeParameters[e.nodeID];
+            if (detail::triangleContainsPoint(mMeshVertices[node.a], mMeshVertices[node.b], mMeshVertices[node.c], position))
+                return (int)e.nodeID;
         }
+        return -1;
+    }
+
+    sf::Vector2f PathPlanner::getGravityCenter(std::size_t nodeID)
+    {
+        return mNodeCenters[nodeID];
+    }
 
-        if (!nodeLinked)  //very bad case, that may occurs under rare conditions
+    bool PathPlanner::searchCorridor(SearchContext& context, int startNode, int goalNode, const sf::Vector2f& start, const sf::Vector2f& target) const
+    {
+        if (context.nodes.size() != mNodeParameters.size() || ++context.stamp == 0)
         {
-            return {};  //todo maybe resolve this by a linear search of the nearest graph node?
-        }*/
-		return PathPtr{};
+            context.nodes.assign(mNodeParameters.size(), SearchNode());
+            context.stamp = 1;
+        }
+        auto visit = [&context] (int n) -> SearchNode&
+        {
+            SearchNode& node = context.nodes[n];
+            if (node.stamp != context.stamp)
+            {
+                node.stamp = context.stamp;
+                node.gscore = std::numeric_limits<float>::infinity();
+                node.origin = -1;
+                node.closed = false;
+            }
+            return node;
+        };
+
+        //A* on the triangle adjacency, the open list is a binary min-heap with lazy deletion of outdated entries
+        //nodes are entered where the line from the entry point of the current triangle to the target crosses the shared edge,
+        //clamped to the edge (its midpoint if the line runs parallel), which follows the later path much closer than the centers do
+        std::greater<std::pair<float, int>> comp;
+        context.open.clear();
+        SearchNode& first = visit(startNode);
+        first.gscore = 0.0f;
+        first.position = start;
+        context.open.emplace_back(distance(start, target), startNode);
+        bool found = false;
+        while (!context.open.empty())
+        {
+            std::pop_heap(context.open.begin(), context.open.end(), comp);
+            int current = context.open.back().second;
+            context.open.pop_back();
+
+            SearchNode& cur = visit(current);
+            if (cur.closed)
+                continue;
+            cur.closed = true;
+            if (current == goalNode)
+            {
+                found = true;
+                break;
+            }
+
+            const NodeParameters& node = mNodeParameters[current];
+            const std::size_t corners[3] = { node.a, node.b, node.c };
+            for (unsigned j = 0; j < 3; ++j)
+            {
+                int next = node.neighbors[j];
+                if (next < 0)
+                    continue;
+                SearchNode& nb = visit(next);
+                if (nb.closed)
+                    continue;
+                sf::Vector2f entry = detail::portalEntry(mMeshVertices[corners[j]], mMeshVertices[corners[(j + 1) % 3]], cur.position, target);
+                float tentativeScore = cur.gscore + distance(cur.position, entry);
+                if (tentativeScore < nb.gscore)
+                {
+                    nb.gscore = tentativeScore;
+                    nb.origin = current;
+                    nb.position = entry;
+                    context.open.emplace_back(tentativeScore + distance(entry, target), next);
+                    std::push_heap(context.open.begin(), context.open.end(), comp);
+                }
+            }
+        }
+        if (!found)
+            return false;
+
+        context.corridor.clear();
+        for (int n = goalNode; n >= 0; n = context.nodes[n].origin)
+            context.corridor.push_back(n);
+        std::reverse(context.corridor.begin(), context.corridor.end());
+        return true;
+    }
+
+    void PathPlanner::pullString(SearchContext& context, const sf::Vector2f& start, const sf::Vector2f& target, PointContainer& waypoints) const
+    {
+        //collect the portals (left, right) between consecutive triangles of the corridor
+        context.portals.clear();
+        context.portals.emplace_back(start, start);
+        for (std::size_t i = 0; i + 1 < context.corridor.size(); ++i)
+        {
+            const NodeParameters& node = mNodeParameters[context.corridor[i]];
+            const std::size_t corners[3] = { node.a, node.b, node.c };
+            for (unsigned j = 0; j < 3; ++j)
+                if (node.neighbors[j] == context.corridor[i + 1])
+                {
+                    const sf::Vector2f& u = mMeshVertices[corners[j]];
+                    const sf::Vector2f& v = mMeshVertices[corners[(j + 1) % 3]];
+                    if (context.portals.size() == 1 && detail::onLine(u, v, start))
+                        break;  //the start lies on the portal, the funnel would degenerate
+                    if (detail::triarea2(mNodeCenters[context.corridor[i]], u, v) > 0.0f)
+                        context.portals.emplace_back(u, v);
+                    else
+                        context.portals.emplace_back(v, u);
+                    break;
+                }
+        }
+        while (context.portals.size() > 1 && detail::onLine(context.portals.back().first, context.portals.back().second, target))
+            context.portals.pop_back();
+        context.portals.emplace_back(target, target);
+
+        //simple stupid funnel algorithm
+        sf::Vector2f apex = start;
+        sf::Vector2f left = start;
+        sf::Vector2f right = start;
+        std::size_t apexIndex = 0, leftIndex = 0, rightIndex = 0;
+        for (std::size_t i = 1; i < context.portals.size(); ++i)
+        {
+            const sf::Vector2f& portalLeft = context.portals[i].first;
+            const sf::Vector2f& portalRight = context.portals[i].second;
+
+            //tighten the right side of the funnel
+            if (detail::triarea2(apex, right, portalRight) <= 0.0f)
+            {
+                if (detail::samePoint(apex, right) || detail::triarea2(apex, left, portalRight) > 0.0f)
+                {
+                    right = portalRight;
+                    rightIndex = i;
+                }
+                else
+                {
+                    //right crossed over left, the left corner becomes a waypoint
+                    if (waypoints.empty() || !detail::samePoint(waypoints.back(), left))
+                        waypoints.push_back(left);
+                    apex = left;
+                    apexIndex = leftIndex;
+                    left = right = apex;
+                    leftIndex = rightIndex = apexIndex;
+                    i = apexIndex;
+                    continue;
+                }
+            }
+
+            //tighten the left side of the funnel
+            if (detail::triarea2(apex, left, portalLeft) >= 0.0f)
+            {
+                if (detail::samePoint(apex, left) || detail::triarea2(apex, right, portalLeft) < 0.0f)
+                {
+                    left = portalLeft;
+                    leftIndex = i;
+                }
+                else
+                {
+                    //left crossed over right, the right corner becomes a waypoint
+                    if (waypoints.empty() || !detail::samePoint(waypoints.back(), right))
+                        waypoints.push_back(right);
+                    apex = right;
+                    apexIndex = rightIndex;
+                    left = right = apex;
+                    leftIndex = rightIndex = apexIndex;
+                    i = apexIndex;
+                    continue;
+                }
+            }
+        }
+        if (waypoints.empty() || !detail::samePoint(waypoints.back(), target))
+            waypoints.push_back(target);
+    }
+
+    void PathPlanner::solve(SearchContext& context, RequestGroup& group) const
+    {
+        //the first request guides the search, the corridor is shared by the whole group
+        const PathRequest& first = group.requests.front();
+        group.found = searchCorridor(context, group.startNode, group.goalNode, first.start, first.target);
+        if (!group.found)
+            return;
+        for (auto& request : group.requests)
+            pullString(context, request.start, request.target, request.waypoints);
+    }
+
+    void PathPlanner::processRequests()
+    {
+        std::vector<RequestGroup> solved;
+        if (mWorkers.empty())
+        {
+            //solve on the main thread until the budget is used up, but at least one group per frame
+            auto start = std::chrono::steady_clock::now();
+            while (!mPendingGroups.empty())
+            {
+                RequestGroup& group = mPendingGroups.front();
+                mGroupLookup.erase(((uint64_t)group.startNode << 32) | (uint64_t)group.goalNode);
+                solve(mSearchContext, group);
+                solved.emplace_back(std::move(group));
+                mPendingGroups.pop_front();
+                if (std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count() >= mRequestBudget)
+                    break;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mRequestMutex);
+            if (solved.empty())
+                solved.swap(mSolvedGroups);
+            else
+            {
+                std::move(mSolvedGroups.begin(), mSolvedGroups.end(), std::back_inserter(solved));
+                mSolvedGroups.clear();
+            }
+        }
+
+        mSolvedSearches += solved.size();
+        for (auto& group : solved)
+            for (auto& request : group.requests)
+            {
+                //the entity may have been destroyed or issued another request meanwhile
+                if (!request.entity.valid() || !request.entity.has<PathFinderComponent>())
+                    continue;
+                PathFinderComponent& pf = request.entity.modify<PathFinderComponent>();
+                if (pf.mRequest != request.ticket)
+                    continue;
+                pf.mRequest = 0;
+                if (group.found)
+                {
+                    pf.mPath = PathPtr{ std::unique_ptr<BasePath>(new ExplicitPath(request.waypoints)) };
+                    pf.mActive = true;
+                    pf.mTimePast = 0.0f;
+                    pf.mPolicy = PathFollowingPolicy::ONE_SHOT;
+                }
+                mPathFoundSignal(request.entity, group.found);
+            }
+    }
+
+    void PathPlanner::cancelRequests()
+    {
+        std::unique_lock<std::mutex> lock(mRequestMutex);
+        mRequestCV.wait(lock, [this] { return mInFlight == 0; });
+        for (auto& group : mPendingGroups)
+        {
+            group.found = false;
+            mSolvedGroups.emplace_back(std::move(group));
+        }
+        mPendingGroups.clear();
+        mGroupLookup.clear();
+    }
+
+    void PathPlanner::workerLoop()
+    {
+        SearchContext context;
+        std::unique_lock<std::mutex> lock(mRequestMutex);
+        while (true)
+        {
+            mRequestCV.wait(lock, [this] { return !mRunning || !mPendingGroups.empty(); });
+            if (!mRunning)
+                return;
+            RequestGroup group = std::move(mPendingGroups.front());
+            mPendingGroups.pop_front();
+            mGroupLookup.erase(((uint64_t)group.startNode << 32) | (uint64_t)group.goalNode);
+            ++mInFlight;
+            lock.unlock();
+
+            solve(context, group);
+
+            lock.lock();
+            --mInFlight;
+            mSolvedGroups.emplace_back(std::move(group));
+            mRequestCV.notify_all();
+        }
     }
 }
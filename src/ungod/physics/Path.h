@@ -27,12 +27,17 @@
 #define UNGOD_PATH_H
 
 #include <list>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include <SFML/System/Vector2.hpp>
 
 #include "ungod/utility/Graph.h"
 #include "ungod/base/Entity.h"
 #include "quadtree/QuadTree.h"
+#include "owls/SlotSignal.h"
 
 namespace ungod
 {
@@ -165,7 +170,7 @@ namespace ungod
     {
     friend class PathPlanner;
     public:
-        PathFinderComponent() : mPath(), mTimePast(0.0f), mActive(false), mPolicy(PathFollowingPolicy::ONE_SHOT), mSpeed(1.0f), mRadius(1.0f) {}
+        PathFinderComponent() : mPath(), mTimePast(0.0f), mActive(false), mPolicy(PathFollowingPolicy::ONE_SHOT), mSpeed(1.0f), mRadius(1.0f), mRequest(0) {}
 
     private:
         PathPtr mPath; //< the current path to follow, may be empty
@@ -174,21 +179,48 @@ namespace ungod
         PathFollowingPolicy mPolicy;
         float mSpeed; //< the speed the path is traversed with
         float mRadius; //< the reach-radius of the waypoints
+        uint64_t mRequest; //< ticket of the pending path request, 0 if there is none
     };
 
 
-    /** \brief A manager class that handles path-lookup and enables path-following for entities. */
+    /** \brief A manager class that handles path-lookup and enables path-following for entities.
+    * Paths are searched on a navmesh, that is a set of triangles covering the walkable area of the world.
+    * Every triangle is a node of the navgraph and is connected to the triangles it shares an edge with.
+    * A query runs A* from the triangle of the start position to the triangle of the target position and
+    * pulls the resulting corridor of triangles taut (funnel algorithm), so that the waypoints are the corners
+    * the path has to bend around.
+    * Path requests of entities are queued and solved later, either time-sliced during update with a fixed budget
+    * per frame or by a set of worker threads. Requests between the same pair of triangles share a single search.
+    * The results are applied during update and announced through the path found signal. */
     class PathPlanner
     {
     public:
+        struct NodeParameters;
+
         /** \brief Default constructor for later initialization. */
-        PathPlanner() : mPathLookup(mNavGraph) {}
+        PathPlanner();
+
+        /** \brief Sets up the request solving. If numThreads is 0, requests are solved during update until the given
+        * budget (in microseconds) is used up. Otherwise, the given number of worker threads solves the requests. */
+        void init(unsigned numThreads, float budget = DEFAULT_REQUEST_BUDGET);
 
         /** \brief Initializes the pathplanner and builds the underlying navgraph depending on the obstacles.
         * Agent radius is a value that defines how much space "left" and "right" of a path must be given, so that
-        * entities that do not exceed the given radius can move along paths without intersecting any of the colliders. */
+        * entities that do not exceed the given radius can move along paths without intersecting any of the colliders.
+        * Obstacles are the colliders of static entities in the movement collision context. */
         void buildNavGraph(World& world, float agentRadius);
 
+        /** \brief Builds the navgraph for the given area. Obstacles are convex polygons that are already extended
+        * by the agent radius. */
+        void buildNavGraph(const std::vector<PointContainer>& obstacles, const sf::FloatRect& bounds);
+
+        /** \brief Returns the world space outlines of the colliders of all static entities in the movement collision
+        * context, extended by the given agent radius. */
+        static std::vector<PointContainer> collectObstacles(World& world, float agentRadius);
+
+        /** \brief Uses the given triangles as navmesh. Triangles with a common pair of vertex indices are connected. */
+        void buildNavMesh(const PointContainer& vertices, const std::vector<NodeParameters>& triangles);
+
         /** \brief Updates all entities with PathFinder and Movement components. */
         void update(const std::list<Entity>& entities, float delta, MovementHandler& mvm);
 
@@ -203,14 +235,39 @@ namespace ungod
                       float speed = DEFAULT_TRAVERSING_SPEED,
                       float radius = DEFAULT_WAYPOINT_RADIUS);
 
-        /** \brief Looks up a path to the given target location and makes the entity follow it. */
-        void findPathTo(Entity e, const sf::Vector2f& position);
+        /** \brief Requests a path to the given target location. Once the request is solved, the entity follows the path
+        * and the path found signal is emitted. A new request or a call to setPath replaces a pending request.
+        * Returns false if the entity or the target is not on the navmesh, no signal is emitted in that case. */
+        bool findPathTo(Entity e, const sf::Vector2f& position);
+
+        /** \brief Solves queued requests until the budget is used up, if there are no workers, and applies the results
+        * of all solved requests. Is invoked by update. */
+        void processRequests();
+
+        /** \brief Registers a callback that is invoked whenever a path request of an entity was solved. The flag
+        * indicates whether a path was found. */
+        void onPathFound(const std::function<void(Entity, bool)>& callback);
+
+        /** \brief Returns the number of queued path requests that are not solved yet. */
+        std::size_t getPendingRequests() const;
+
+        /** \brief Returns the number of request groups processed so far. Every group stands for a single search. */
+        std::size_t getSolvedSearches() const { return mSolvedSearches; }
+
+        /** \brief Searches a path between the given positions. The waypoints exclude the start and end with the target.
+        * Returns false if a position is not on the navmesh or the target can not be reached. */
+        bool findPath(const sf::Vector2f& start, const sf::Vector2f& target, PointContainer& waypoints);
+
+        /** \brief Returns the id of the graph node whose triangle contains the given position or -1. */
+        int getNodeAt(const sf::Vector2f& position) const;
+
+        /** \brief Returns the number of nodes of the navgraph. */
+        std::size_t getNodeCount() const { return mNodeParameters.size(); }
 
         /** \brief Returns the center of gravity for the given graph node. */
         sf::Vector2f getGravityCenter(std::size_t nodeID);
 
-    private:
-        PathPtr createPath(const sf::Vector2f& position);
+        ~PathPlanner();
 
 
     public:
@@ -218,24 +275,103 @@ namespace ungod
         {
             QuadTreeElement(std::size_t cNodeID, PathPlanner& cPathplanner);
 
+            bool operator==(const QuadTreeElement& other) const { return nodeID == other.nodeID; }
+
             std::size_t nodeID;  //< id of the graph node the element corresponds to
             sf::FloatRect bounds;
         };
 
         struct NodeParameters
         {
+            NodeParameters(std::size_t ca, std::size_t cb, std::size_t cc) : a(ca), b(cb), c(cc), neighbors{ -1, -1, -1 } {}
+
             std::size_t a, b, c;  //< corners of the underlying triangle, they map to positions in the mesh-vertices-vector
+            int neighbors[3];  //< nodes behind the edges (a,b), (b,c) and (c,a), -1 if the edge is a border
         };
 
     private:
+        /** \brief Per-node scratch data of a search. Entries are valid if their stamp equals the stamp of the search. */
+        struct SearchNode
+        {
+            SearchNode() : gscore(0.0f), origin(-1), stamp(0), closed(false) {}
+
+            sf::Vector2f position;  //< the point the node is entered at
+            float gscore;
+            int origin;
+            unsigned stamp;
+            bool closed;
+        };
+
+        /** \brief Scratch memory of searches. Every thread that solves requests owns one. */
+        struct SearchContext
+        {
+            SearchContext() : stamp(0) {}
+
+            std::vector<SearchNode> nodes;
+            std::vector<std::pair<float, int>> open;  //binary heap of the A* open list
+            std::vector<int> corridor;
+            std::vector<std::pair<sf::Vector2f, sf::Vector2f>> portals;
+            unsigned stamp;
+        };
+
+        struct PathRequest
+        {
+            Entity entity;
+            sf::Vector2f start;
+            sf::Vector2f target;
+            uint64_t ticket;
+            PointContainer waypoints;
+        };
+
+        /** \brief Requests between the same pair of nodes, they are solved with a single search. */
+        struct RequestGroup
+        {
+            int startNode;
+            int goalNode;
+            std::vector<PathRequest> requests;
+            bool found;
+        };
+
         quad::QuadTree<QuadTreeElement> mNodeFinder;  //speeds up finding of graph nodes near a certain position
-        graph::UndirectedAdjacencyLists mNavGraph;  //navgraph build from a triangulation, where adjacent triangles are connected by edges
-        graph::AStarAlg mPathLookup;
         std::vector<NodeParameters> mNodeParameters;  //stores for each vertex-id of the navgraph, which triangles in corresponds to
+        std::vector<sf::Vector2f> mNodeCenters;  //centers of gravity of the triangles
         std::vector<sf::Vector2f> mMeshVertices; //vertices of the world meshes
+        SearchContext mSearchContext;  //used on the main thread
+
+        std::list<RequestGroup> mPendingGroups;
+        std::unordered_map<uint64_t, std::list<RequestGroup>::iterator> mGroupLookup;  //pending groups by node pair
+        std::vector<RequestGroup> mSolvedGroups;
+        uint64_t mNextTicket;
+        std::size_t mSolvedSearches;
+        float mRequestBudget;
+        std::vector<std::thread> mWorkers;
+        mutable std::mutex mRequestMutex;
+        std::condition_variable mRequestCV;
+        std::size_t mInFlight;  //groups currently solved by workers
+        bool mRunning;
+        owls::SlotSignal<Entity, bool> mPathFoundSignal;
 
         static constexpr float DEFAULT_WAYPOINT_RADIUS = 30.0f;
         static constexpr float DEFAULT_TRAVERSING_SPEED = 1.0f;
+        static constexpr float NAVMESH_EDGE_SPLIT = 64.0f;  //obstacle edges are split into pieces of at most this length before triangulation
+
+    public:
+        static constexpr float DEFAULT_REQUEST_BUDGET = 2000.0f;  //microseconds per frame spent on path requests
+
+    private:
+        /** \brief Runs A* between the given nodes and stores the visited nodes in the corridor. */
+        bool searchCorridor(SearchContext& context, int startNode, int goalNode, const sf::Vector2f& start, const sf::Vector2f& target) const;
+
+        /** \brief Shortens the path through the corridor with the funnel algorithm. */
+        void pullString(SearchContext& context, const sf::Vector2f& start, const sf::Vector2f& target, PointContainer& waypoints) const;
+
+        /** \brief Runs the search of the group and pulls the path of every request. */
+        void solve(SearchContext& context, RequestGroup& group) const;
+
+        /** \brief Fails all pending requests and waits until the workers finished their current groups. */
+        void cancelRequests();
+
+        void workerLoop();
     };
 
 }
@@ -24,6 +24,7 @@
 */
 
 #include "ungod/physics/Movement.h"
+#include "ungod/physics/FlowField.h"
 #include <forward_list>
 
 #ifndef UNGOD_STEERING_H
@@ -125,6 +126,11 @@ namespace ungod
         /** \brief Disconnects the steering pattern from the given entity. */
         void disconnectPattern(Entity e);
 
+        /** \brief Steers the entity along the flow field towards the goal. In the goal cell or where the flow field
+        * yields no direction, the entity arrives at the goal directly. */
+        static void followFlowField(Entity e, MovementHandler& mvm, FlowFieldPlanner& flowField,
+                                    const sf::Vector2f& goal, float speed, int arrivalRadius);
+
     private:
         const SteeringManager<GETTER>* mSteeringManager;
     };
@@ -225,6 +231,19 @@ namespace ungod
         sc.mActive = false;
         sc.mParam = {};
     }
+
+
+    template <class GETTER>
+    void SteeringHandler<GETTER>::followFlowField(Entity e, MovementHandler& mvm, FlowFieldPlanner& flowField,
+                                                  const sf::Vector2f& goal, float speed, int arrivalRadius)
+    {
+        sf::Vector2f position = e.get<TransformComponent>().getCenterPosition();
+        sf::Vector2f direction = flowField.getDirection(position, goal);
+        if (direction.x == 0.0f && direction.y == 0.0f)
+            mvm.arrival(e, goal, speed, arrivalRadius);
+        else
+            mvm.seek(e, position + direction, speed);
+    }
 }
 
 #endif // UNGOD_STEERING_H
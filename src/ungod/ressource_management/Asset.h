@@ -109,6 +109,10 @@ namespace ungod
         */
         void get(std::function<void(const T&)> callback) const;
 
+        /** \brief Raises the priority of a pending async load of the asset, so that it is loaded before other requests,
+        * e.g. because the asset became visible. Does nothing if the asset is not waiting for the loader. */
+        void prioritize(int priority = AssetLoader::VISIBLE_PRIORITY) const;
+
         /**
         * \brief Returns true if and only if the asset is loaded and ready to use. Will return false if
         * it was default constructed and load-method was never called, if the asset was dropped somehow or
@@ -230,6 +234,8 @@ namespace ungod
     {
         if (mData)
         {
+            if (mData->task)
+                mData->task->execute(); //do not wait behind other requests of the loader
             mData->future.wait();
             return *mData->asset;
         }
@@ -251,14 +257,23 @@ namespace ungod
             else
             {
                 std::lock_guard<std::mutex> lg(mData->mutex);
-                if (!mData->isLoaded)
-                    mData->callbackStack.emplace_back( this, callback );
-                else
+                if (mData->isLoaded)
                     callback(*mData->asset);
+                else if (mData->future.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+                    callback(getDefault()); //loading failed meanwhile
+                else
+                    mData->callbackStack.emplace_back( this, callback );
             }
         }
     }
 
+    template <typename T, typename ... PARAM>
+    void Asset<T, PARAM...>::prioritize(int priority) const
+    {
+        if (mData && mData->task && mData->task->isQueued())
+            sManager->getLoader().prioritize(mData->task, priority);
+    }
+
     template <typename T, typename ... PARAM>
     bool Asset<T, PARAM...>::isLoaded() const
     {
@@ -32,6 +32,10 @@
 #include <string>
 #include <list>
 #include <atomic>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include "ungod/ressource_management/AssetLoader.h"
 
 namespace ungod
 {
@@ -43,7 +47,7 @@ namespace ungod
     template<typename T, typename ... PARAM>
     struct AssetData
     {
-		AssetData() : referenceCount(0u), isLoaded(false) {}
+		AssetData() : referenceCount(0u), isLoaded(false), memorySize(0), released(false), releaseStamp(0) {}
 
         //members
         std::unique_ptr<T> asset; ///< a unique-ownership ptr that stores the asset
@@ -51,8 +55,15 @@ namespace ungod
         std::atomic<unsigned> referenceCount; ///< counter for the assets that refer to the data
         bool isLoaded; ///< is true when the asset was successfully loaded
         std::future<void> future; ///< holds the result of a std::aLoadPolicy::SYNC call
+        std::promise<void> promise; ///< fulfills the future of an async load once the loader executed or cancelled it
+        std::shared_ptr<AssetLoader::Task> task; ///< the request of an async load in the loader of the manager
         std::list< std::pair< const Asset<T, PARAM...>*, std::function <void (T&)> > > callbackStack; ///<stores callbacks while asset is loading
         std::mutex mutex; ///< used for syncronization
+        std::size_t memorySize; ///< estimated number of bytes occupied by the loaded asset
+        bool released; ///< is true if no asset refers to the data anymore, but it is kept in the cache of the handler
+        uint64_t releaseStamp; ///< the time the data was released, in release order over all handlers
+        std::list<std::string>::iterator releasedEntry; ///< position in the cache of the handler
+        std::tuple<std::decay_t<PARAM>...> params; ///< the parameters the asset was loaded with
     };
 }
 
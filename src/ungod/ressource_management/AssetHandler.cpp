@@ -27,7 +27,22 @@
 
 namespace ungod
 {
-    AssetManager::AssetManager()
+    AssetStats& AssetStats::operator+=(const AssetStats& other)
+    {
+        loaded += other.loaded;
+        loadedBytes += other.loadedBytes;
+        cached += other.cached;
+        cachedBytes += other.cachedBytes;
+        hits += other.hits;
+        misses += other.misses;
+        evictions += other.evictions;
+        return *this;
+    }
+
+
+    constexpr std::size_t AssetManager::DEFAULT_BUDGET;
+
+    AssetManager::AssetManager() : mBudget(DEFAULT_BUDGET), mMemoryUsage(0), mReleaseCounter(0)
     {
         sID = 0;
     }
@@ -37,6 +52,83 @@ namespace ungod
     {
         for (auto& h : mHandlers)
             h->update();
+        trim();
+    }
+
+
+    void AssetManager::setBudget(std::size_t bytes)
+    {
+        mBudget = bytes;
+        trim();
+    }
+
+
+    void AssetManager::trim()
+    {
+        trim(mBudget);
+    }
+
+
+    void AssetManager::clearCache()
+    {
+        trim(0);
+    }
+
+
+    void AssetManager::trim(std::size_t bytes)
+    {
+        std::unique_lock<std::mutex> lock(mTrimMutex, std::try_to_lock);
+        if (!lock.owns_lock())
+            return; //another thread is already trimming
+        std::vector<Handler*> handlers = getHandlers();
+        while (mMemoryUsage > bytes)
+        {
+            //evict the least recently released asset over all types
+            Handler* oldest = nullptr;
+            uint64_t oldestStamp = std::numeric_limits<uint64_t>::max();
+            for (auto* h : handlers)
+            {
+                uint64_t stamp;
+                if (h->getOldestRelease(stamp) && stamp < oldestStamp)
+                {
+                    oldest = h;
+                    oldestStamp = stamp;
+                }
+            }
+            if (!oldest)
+                break; //all remaining assets are in use
+            oldest->evictOldest();
+        }
+    }
+
+
+    AssetStats AssetManager::getStats() const
+    {
+        AssetStats stats;
+        for (auto* h : getHandlers())
+            stats += h->getStats();
+        return stats;
+    }
+
+
+    AssetStats AssetManager::getStats(const std::string& type) const
+    {
+        AssetStats stats;
+        for (auto* h : getHandlers())
+            if (h->getType() == type)
+                stats += h->getStats();
+        return stats;
+    }
+
+
+    std::vector<Handler*> AssetManager::getHandlers() const
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        std::vector<Handler*> handlers;
+        handlers.reserve(mHandlers.size());
+        for (const auto& h : mHandlers)
+            handlers.push_back(h.get());
+        return handlers;
     }
 
     std::atomic<std::size_t> AssetManager::sID(0);
@@ -29,6 +29,9 @@
 #include <mutex>  
 #include <shared_mutex>
 #include <unordered_map>
+#include <vector>
+#include <type_traits>
+#include <limits>
 #include "ungod/base/Logger.h"
 #include "ungod/ressource_management/AssetData.h"
 #include "ungod/ressource_management/LoadBehavior.h"
@@ -37,9 +40,44 @@ namespace ungod
 {
     /** \brief Defines how an asset should be loaded. */
     enum class LoadPolicy : bool {  SYNC = true, ///<asset is loaded syncronously and can be used directly afterwarts
-                              ASYNC = false ///<asset is loaded in another thread. If another thread tries to use that assets while its still loading, it will wait.
+                              ASYNC = false ///<asset is loaded by the loader threads of the manager. If another thread tries to use that assets while its still loading, it will wait.
                             };
 
+    class AssetManager;
+
+    /** \brief Memory and cache statistics of asset handlers. */
+    struct AssetStats
+    {
+        AssetStats() : loaded(0), loadedBytes(0), cached(0), cachedBytes(0), hits(0), misses(0), evictions(0) {}
+
+        std::size_t loaded; ///< number of assets in memory, including the cached ones
+        std::size_t loadedBytes;
+        std::size_t cached; ///< number of released assets that are kept in memory
+        std::size_t cachedBytes;
+        std::size_t hits; ///< number of requests that were served from the cache
+        std::size_t misses; ///< number of requests that loaded from disk
+        std::size_t evictions; ///< number of cached assets that were freed due to the budget
+
+        AssetStats& operator+=(const AssetStats& other);
+    };
+
+    namespace detail
+    {
+        //LoadBehaviors may provide a static getMemorySize(const T&) that estimates the size of a loaded asset
+        template<typename B, typename T, typename = void>
+        struct HasMemorySize : std::false_type {};
+
+        template<typename B, typename T>
+        struct HasMemorySize<B, T, std::void_t<decltype(B::getMemorySize(std::declval<const T&>()))>> : std::true_type {};
+
+        //LoadBehaviors may set a static constexpr bool CACHEABLE = false to exclude their assets from the cache
+        template<typename B, typename = void>
+        struct IsCacheable : std::true_type {};
+
+        template<typename B>
+        struct IsCacheable<B, std::void_t<decltype(B::CACHEABLE)>> : std::integral_constant<bool, B::CACHEABLE> {};
+    }
+
     /** \brief Base class for all handlers. */
     class Handler
     {
@@ -55,6 +93,16 @@ namespace ungod
 
         virtual void update() = 0;
 
+        /** \brief Returns the memory and cache statistics of the handler. */
+        virtual AssetStats getStats() const = 0;
+
+        /** \brief Retrieves the release stamp of the least recently released asset in the cache.
+        * Returns false if the cache is empty. */
+        virtual bool getOldestRelease(uint64_t& stamp) const = 0;
+
+        /** \brief Frees the least recently released asset in the cache. Returns the number of bytes freed. */
+        virtual std::size_t evictOldest() = 0;
+
         virtual ~Handler() {}
     };
 
@@ -69,14 +117,28 @@ namespace ungod
     friend class Asset<T, PARAM...>;
     public:
         //constructor
-        AssetHandler() : Handler(LoadBehavior<T, PARAM...>::getIdentifier()) {}
+        AssetHandler(AssetManager& manager) : Handler(LoadBehavior<T, PARAM...>::getIdentifier()), mManager(manager),
+            mLoadedBytes(0), mCachedBytes(0), mHits(0), mMisses(0), mEvictions(0) {}
 
         virtual void update() override;
 
+        virtual AssetStats getStats() const override;
+
+        virtual bool getOldestRelease(uint64_t& stamp) const override;
+
+        virtual std::size_t evictOldest() override;
+
     private:
+        AssetManager& mManager;
         std::unordered_map< std::string, std::shared_ptr<AssetData<T, PARAM...>> > mAssetData;  ///<stores loaded assets under fileID as key
         std::list< std::weak_ptr<AssetData<T, PARAM...>> > mPending; ///<stores asset data that is loading asyc and invokes callbacks on main thread if finished
+        std::list<std::string> mReleased; ///<filepaths of released assets that are kept in memory, least recently released first
         mutable std::shared_mutex mLoadDropMutex; ///< protects loading and dropping
+        std::atomic<std::size_t> mLoadedBytes;
+        std::atomic<std::size_t> mCachedBytes;
+        std::atomic<std::size_t> mHits;
+        std::atomic<std::size_t> mMisses;
+        std::atomic<std::size_t> mEvictions;
 
     private:
         /**
@@ -102,13 +164,26 @@ namespace ungod
         /** \brief Sync load utility method. */
         void syncLoad(std::shared_ptr<AssetData<T, PARAM...>> data, const std::string filepath, PARAM&& ... param);
 
+        /** \brief Adds the size of the loaded asset to the memory usage. */
+        void account(AssetData<T, PARAM...>& data);
+
+        /** \brief Estimates the number of bytes occupied by the given asset. */
+        static std::size_t getMemorySize(const T& asset);
+
 		virtual ~AssetHandler();
     };
 
     /** \brief Manages und bundles together the assetshandlers of all types.
-    * There should be only one asset manager at a time. */
+    * There should be only one asset manager at a time.
+    * Assets are not freed immediately when the last asset refering to them is dropped. Instead, they are kept
+    * in a cache, so that they can be reused without loading if they are requested again soon, for example if
+    * the player walks back to a node that was just unloaded. Cached assets are freed in the order they were released,
+    * over all asset types, as soon as the memory of all loaded assets exceeds the budget. A cached asset is only
+    * reused by a request with the same load parameters, otherwise it is replaced by a fresh load.
+    * Async loads are served by a fixed number of loader threads, see AssetLoader. */
     class AssetManager
     {
+    template<typename T, typename ... PARAM> friend class AssetHandler;
     public:
         AssetManager();
 
@@ -117,9 +192,47 @@ namespace ungod
 
         void update();
 
+        /** \brief Sets the memory budget in bytes. A budget of 0 disables the cache. */
+        void setBudget(std::size_t bytes);
+
+        std::size_t getBudget() const { return mBudget; }
+
+        /** \brief Returns the estimated number of bytes occupied by all loaded assets, including the cached ones. */
+        std::size_t getMemoryUsage() const { return mMemoryUsage; }
+
+        /** \brief Frees cached assets, least recently released first, until the memory usage fits into the budget. */
+        void trim();
+
+        /** \brief Frees all cached assets. */
+        void clearCache();
+
+        /** \brief Returns the statistics summed up over all asset types. */
+        AssetStats getStats() const;
+
+        /** \brief Returns the statistics of the asset type with the given identifier, e.g. "Image" or "Sound". */
+        AssetStats getStats(const std::string& type) const;
+
+        /** \brief Returns the loader that executes async loads. */
+        AssetLoader& getLoader() { return mLoader; }
+
     private:
         std::vector< std::unique_ptr<Handler> > mHandlers;
-        std::mutex mMutex;
+        mutable std::mutex mMutex;
+        std::atomic<std::size_t> mBudget;
+        std::atomic<std::size_t> mMemoryUsage;
+        std::atomic<uint64_t> mReleaseCounter;
+        std::mutex mTrimMutex;
+        AssetLoader mLoader; ///< declared after the handlers, so that the workers are joined before the handlers are destroyed
+
+    public:
+        static constexpr std::size_t DEFAULT_BUDGET = 256u * 1024u * 1024u;
+
+    private:
+        /** \brief Frees cached assets, least recently released first, until the memory usage is at most the given number of bytes. */
+        void trim(std::size_t bytes);
+
+        /** \brief Returns a snapshot of the handlers. */
+        std::vector<Handler*> getHandlers() const;
 
         static std::atomic<std::size_t> sID;
 
@@ -142,7 +255,7 @@ namespace ungod
             std::unique_lock<std::mutex> lock(mMutex);
             if (id == mHandlers.size())
             {
-                mHandlers.emplace_back(new AssetHandler<T, PARAM...>());
+                mHandlers.emplace_back(new AssetHandler<T, PARAM...>(*this));
             }
         }
         return static_cast<AssetHandler<T, PARAM...>*>( mHandlers[id].get() );
@@ -153,27 +266,39 @@ namespace ungod
     template<typename T, typename ... PARAM>
     void AssetHandler<T, PARAM...>::update()
     {
-		for (auto data = mPending.begin(); data != mPending.end();)
-		{
-			if (data->expired())
-				data = mPending.erase(data);
-			else
-			{
-				auto shared = data->lock();
-				if (shared->future.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
-				{
-					while (!shared->callbackStack.empty()) //invoke callbacks
-					{
-						//pair contains a pointer to the requesting asset(first) and the callback(second)
-						auto callback = std::move(shared->callbackStack.front());
-						shared->callbackStack.pop_front();
-						callback.second(*(shared->asset));
-					}
-					data = mPending.erase(data);
-				}
-				else
-					data++;
-			}
+        std::vector< std::shared_ptr<AssetData<T, PARAM...>> > finished;
+        {
+            std::unique_lock lock(mLoadDropMutex);
+            for (auto data = mPending.begin(); data != mPending.end();)
+            {
+                auto shared = data->lock();
+                if (!shared)
+                    data = mPending.erase(data);
+                else if (shared->future.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+                {
+                    finished.emplace_back(std::move(shared));
+                    data = mPending.erase(data);
+                }
+                else
+                    data++;
+            }
+        }
+        //callbacks are invoked without holding the lock, since they may load or drop assets
+        for (const auto& shared : finished)
+        {
+            while (true) //invoke callbacks
+            {
+                //pair contains a pointer to the requesting asset(first) and the callback(second)
+                std::pair< const Asset<T, PARAM...>*, std::function <void (T&)> > callback;
+                {
+                    std::lock_guard<std::mutex> lg(shared->mutex);
+                    if (shared->callbackStack.empty())
+                        break;
+                    callback = std::move(shared->callbackStack.front());
+                    shared->callbackStack.pop_front();
+                }
+                callback.second(*(shared->asset));
+            }
         }
     }
 
@@ -184,7 +309,7 @@ namespace ungod
         {
             std::shared_lock lock(mLoadDropMutex);
             auto res = mAssetData.find(path);
-            if (res != mAssetData.end())
+            if (res != mAssetData.end() && !res->second->released)
             {
                 res->second->referenceCount++; //atomic
                 return res->second.get();
@@ -192,16 +317,36 @@ namespace ungod
         }
         //not loaded yet
         std::unique_lock lock(mLoadDropMutex);
+        auto cached = mAssetData.find(path);
+        if (cached != mAssetData.end() && cached->second->released && cached->second->params != std::make_tuple(param...))
+        {
+            //the cached asset was loaded with other parameters, so it is replaced
+            Logger::info("Now dropping asset", path);
+            mReleased.erase(cached->second->releasedEntry);
+            mCachedBytes -= cached->second->memorySize;
+            mLoadedBytes -= cached->second->memorySize;
+            mManager.mMemoryUsage -= cached->second->memorySize;
+            mAssetData.erase(cached);
+        }
         auto res = mAssetData.emplace(path, std::make_shared<AssetData<T, PARAM...>>());
         auto data = res.first->second;
         if (!res.second) //second check to prevent race conditions
         {
+            if (data->released) //revive the asset from the cache
+            {
+                mReleased.erase(data->releasedEntry);
+                data->released = false;
+                mCachedBytes -= data->memorySize;
+                mHits++;
+            }
             data->referenceCount++; //atomic
             return data.get(); // when this return happens, the asset data is already in a prepared state (either fully loaded or loading with valid future)
         }
+        mMisses++;
         data->referenceCount = 1;
         data->isLoaded = false;
         data->filepath = path;
+        data->params = std::make_tuple(param...);
 
         if (policy == LoadPolicy::SYNC)
         {
@@ -215,8 +360,11 @@ namespace ungod
         {
             Logger::info("Now async loading asset", path);
 
-            data->future = std::async(std::launch::async, &AssetHandler<T, PARAM...>::asyncLoad,
-                this, std::weak_ptr<AssetData<T, PARAM...>>{data}, path, std::forward<PARAM>(param)...);
+            data->future = data->promise.get_future();
+            std::weak_ptr<AssetData<T, PARAM...>> weakData{data};
+            data->task = mManager.mLoader.push(
+                [this, weakData, path, param...] () mutable { asyncLoad(weakData, path, std::move(param)...); },
+                [weakData] () { if (auto shared = weakData.lock()) shared->promise.set_value(); } );
 
             mPending.emplace_back(data);
         }
@@ -226,22 +374,46 @@ namespace ungod
     template<typename T, typename ... PARAM>
     void AssetHandler<T, PARAM...>::drop(AssetData<T, PARAM...>* data, Asset<T, PARAM...>* requester)
     {
-        std::unique_lock lock(mLoadDropMutex);
-        data->referenceCount--;
-        for(auto callbackPair = data->callbackStack.begin();
-            callbackPair != data->callbackStack.end();)
-        {
-            if(callbackPair->first == requester)
-                callbackPair = data->callbackStack.erase(callbackPair);
-            else
-                ++callbackPair;
-        }
-        if(data->referenceCount == 0)
+        bool cached = false;
         {
-            Logger::info("Now dropping asset", data->filepath);
-			data->future.wait();
-            mAssetData.erase(data->filepath);
+            std::unique_lock lock(mLoadDropMutex);
+            data->referenceCount--;
+            {
+                std::lock_guard<std::mutex> lg(data->mutex);
+                for(auto callbackPair = data->callbackStack.begin();
+                    callbackPair != data->callbackStack.end();)
+                {
+                    if(callbackPair->first == requester)
+                        callbackPair = data->callbackStack.erase(callbackPair);
+                    else
+                        ++callbackPair;
+                }
+            }
+            if(data->referenceCount == 0)
+            {
+                if (data->task && data->task->cancel())
+                    Logger::info("Cancelled loading of asset", data->filepath);
+                data->future.wait(); //the load may already be executed by a worker
+                if (data->isLoaded && mManager.getBudget() > 0 && detail::IsCacheable<LoadBehavior<T, PARAM...>>::value)
+                {
+                    //keep the asset in memory until the budget is exceeded
+                    data->released = true;
+                    data->releaseStamp = mManager.mReleaseCounter++;
+                    data->releasedEntry = mReleased.insert(mReleased.end(), data->filepath);
+                    mCachedBytes += data->memorySize;
+                    cached = true;
+                }
+                else
+                {
+                    Logger::info("Now dropping asset", data->filepath);
+                    mLoadedBytes -= data->memorySize;
+                    mManager.mMemoryUsage -= data->memorySize;
+                    mAssetData.erase(data->filepath);
+                }
+            }
         }
+        if (cached)
+            mManager.trim(); //must not hold the lock, trimming may evict from this handler
     }
 
     template<typename T, typename ... PARAM>
@@ -255,12 +427,15 @@ namespace ungod
     {
 		auto emptyPtr = acquireAsset();
         bool success = LoadBehavior<T, PARAM...>::loadFromFile(filepath, *emptyPtr, std::forward<PARAM>(param)...);
-        //todo: can this be dropped?
-		if (weakData.expired()) return; //all refering assets dropped before loading was complete
 		auto sharedData = weakData.lock();
-        std::lock_guard<std::mutex> lg(sharedData->mutex);
-        sharedData->asset = std::move(emptyPtr);
-        sharedData->isLoaded = success;
+		if (!sharedData) return; //all refering assets dropped before loading was complete
+        {
+            std::lock_guard<std::mutex> lg(sharedData->mutex);
+            sharedData->asset = std::move(emptyPtr);
+            sharedData->isLoaded = success;
+            account(*sharedData);
+        }
+        sharedData->promise.set_value();
         if (!success)
         {
             Logger::error("Could not load asset", filepath);
@@ -272,6 +447,7 @@ namespace ungod
     {
         data->asset = acquireAsset();
         data->isLoaded = LoadBehavior<T, PARAM...>::loadFromFile(filepath, *data->asset, std::forward<PARAM>(param)...);
+        account(*data);
 
         if (!data->isLoaded)
         {
@@ -279,10 +455,72 @@ namespace ungod
         }
     }
 
+    template<typename T, typename ... PARAM>
+    void AssetHandler<T, PARAM...>::account(AssetData<T, PARAM...>& data)
+    {
+        data.memorySize = getMemorySize(*data.asset);
+        mLoadedBytes += data.memorySize;
+        mManager.mMemoryUsage += data.memorySize;
+    }
+
+    template<typename T, typename ... PARAM>
+    std::size_t AssetHandler<T, PARAM...>::getMemorySize(const T& asset)
+    {
+        if constexpr (detail::HasMemorySize<LoadBehavior<T, PARAM...>, T>::value)
+            return LoadBehavior<T, PARAM...>::getMemorySize(asset);
+        else
+            return sizeof(T);
+    }
+
+    template<typename T, typename ... PARAM>
+    AssetStats AssetHandler<T, PARAM...>::getStats() const
+    {
+        AssetStats stats;
+        {
+            std::shared_lock lock(mLoadDropMutex);
+            stats.loaded = mAssetData.size();
+            stats.cached = mReleased.size();
+        }
+        stats.loadedBytes = mLoadedBytes;
+        stats.cachedBytes = mCachedBytes;
+        stats.hits = mHits;
+        stats.misses = mMisses;
+        stats.evictions = mEvictions;
+        return stats;
+    }
+
+    template<typename T, typename ... PARAM>
+    bool AssetHandler<T, PARAM...>::getOldestRelease(uint64_t& stamp) const
+    {
+        std::shared_lock lock(mLoadDropMutex);
+        if (mReleased.empty())
+            return false;
+        stamp = mAssetData.find(mReleased.front())->second->releaseStamp;
+        return true;
+    }
+
+    template<typename T, typename ... PARAM>
+    std::size_t AssetHandler<T, PARAM...>::evictOldest()
+    {
+        std::unique_lock lock(mLoadDropMutex);
+        if (mReleased.empty())
+            return 0;
+        auto data = mAssetData.find(mReleased.front());
+        std::size_t bytes = data->second->memorySize;
+        Logger::info("Now dropping asset", data->first);
+        mReleased.pop_front();
+        mCachedBytes -= bytes;
+        mLoadedBytes -= bytes;
+        mManager.mMemoryUsage -= bytes;
+        mEvictions++;
+        mAssetData.erase(data);
+        return bytes;
+    }
+
 	template<typename T, typename ... PARAM>
 	AssetHandler<T, PARAM...>::~AssetHandler()
 	{
-		//wait for every pending futures to avoid memory leaks
+		//wait for every pending futures to avoid memory leaks, the loader has already cancelled the requests it did not start
 		for (const auto& data : mPending)
 			if (!data.expired())
 				data.lock()->future.wait();
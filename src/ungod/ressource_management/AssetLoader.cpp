@@ -0,0 +1,172 @@
+/*
+* This file is part of the ungod - framework.
+* Copyright (C) 2016 Felix Becker - fb132550@uni-greifswald.de
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#include "ungod/ressource_management/AssetLoader.h"
+#include <algorithm>
+
+namespace ungod
+{
+    AssetLoader::Task::Task(AssetLoader& loader, const std::function<void()>& work, const std::function<void()>& cancel, int priority) :
+        mLoader(loader), mState(QUEUED), mPriority(priority), mWork(work), mCancel(cancel) {}
+
+
+    bool AssetLoader::Task::execute()
+    {
+        int expected = QUEUED;
+        if (!mState.compare_exchange_strong(expected, CLAIMED))
+            return false;
+        mLoader.mQueued--;
+        mWork();
+        mWork = nullptr;
+        mCancel = nullptr;
+        return true;
+    }
+
+
+    bool AssetLoader::Task::cancel()
+    {
+        int expected = QUEUED;
+        if (!mState.compare_exchange_strong(expected, CANCELLED))
+            return false;
+        mLoader.mQueued--;
+        mCancel();
+        mWork = nullptr;
+        mCancel = nullptr;
+        return true;
+    }
+
+
+    constexpr unsigned AssetLoader::DEFAULT_THREADS;
+    constexpr int AssetLoader::DEFAULT_PRIORITY;
+    constexpr int AssetLoader::VISIBLE_PRIORITY;
+
+    AssetLoader::AssetLoader() : mSequence(0), mQueued(0), mStop(false) {}
+
+
+    void AssetLoader::init(unsigned numThreads)
+    {
+        std::unique_lock<std::mutex> lock(mWorkerMutex);
+        stop();
+        start(std::max(numThreads, 1u));
+    }
+
+
+    std::shared_ptr<AssetLoader::Task> AssetLoader::push(const std::function<void()>& work, const std::function<void()>& cancel, int priority)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mWorkerMutex);
+            if (mWorkers.empty())
+                start(DEFAULT_THREADS);
+        }
+        auto task = std::make_shared<Task>(*this, work, cancel, priority);
+        mQueued++;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mQueue.push(Entry{ priority, mSequence++, task });
+        }
+        mCondition.notify_one();
+        return task;
+    }
+
+
+    void AssetLoader::prioritize(const std::shared_ptr<Task>& task, int priority)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        if (!task->isQueued() || task->mPriority >= priority)
+            return;
+        task->mPriority = priority;
+        mQueue.push(Entry{ priority, mSequence++, task });
+    }
+
+
+    std::size_t AssetLoader::getQueueSize() const
+    {
+        return mQueued;
+    }
+
+
+    unsigned AssetLoader::getThreadCount() const
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        return (unsigned)mWorkers.size();
+    }
+
+
+    AssetLoader::~AssetLoader()
+    {
+        {
+            std::unique_lock<std::mutex> lock(mWorkerMutex);
+            stop();
+        }
+        //nobody is going to execute the remaining requests, but their owners may wait for them
+        while (!mQueue.empty())
+        {
+            auto task = mQueue.top().task;
+            mQueue.pop();
+            task->cancel();
+        }
+    }
+
+
+    void AssetLoader::work()
+    {
+        while (true)
+        {
+            std::shared_ptr<Task> task;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock, [this] () { return mStop || !mQueue.empty(); });
+                if (mStop)
+                    return;
+                task = mQueue.top().task;
+                mQueue.pop();
+            }
+            task->execute(); //does nothing for cancelled tasks and outdated entries of prioritized tasks
+        }
+    }
+
+
+    void AssetLoader::stop()
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mStop = true;
+        }
+        mCondition.notify_all();
+        for (auto& worker : mWorkers)
+            worker.join();
+        std::unique_lock<std::mutex> lock(mMutex);
+        mWorkers.clear();
+        mStop = false;
+    }
+
+
+    void AssetLoader::start(unsigned numThreads)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        for (unsigned i = 0; i < numThreads; i++)
+            mWorkers.emplace_back(&AssetLoader::work, this);
+    }
+}
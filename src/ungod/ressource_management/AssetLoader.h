@@ -0,0 +1,138 @@
+/*
+* This file is part of the ungod - framework.
+* Copyright (C) 2016 Felix Becker - fb132550@uni-greifswald.de
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+namespace ungod
+{
+    /**
+    * \brief A fixed set of worker threads that loads assets asynchronously.
+    * Requests are served by priority and in request order for equal priorities. A request can be cancelled
+    * as long as no worker has picked it up, which is the case for assets that are dropped before they are loaded.
+    * Workers are started with the first request, if they were not started explicitly before.
+    */
+    class AssetLoader
+    {
+    public:
+        /** \brief A single load request. The work is either executed or cancelled, never both. */
+        class Task
+        {
+        friend class AssetLoader;
+        public:
+            Task(AssetLoader& loader, const std::function<void()>& work, const std::function<void()>& cancel, int priority);
+
+            /** \brief Executes the work on the calling thread if no worker picked it up yet and it was not cancelled.
+            * Returns true if the work was executed by this call. */
+            bool execute();
+
+            /** \brief Cancels the task and invokes the cancel callback, if the work was not picked up yet.
+            * Returns true if the task was cancelled by this call. */
+            bool cancel();
+
+            /** \brief Returns true if the task is still waiting in the queue. */
+            bool isQueued() const { return mState == QUEUED; }
+
+        private:
+            enum State : int { QUEUED, CLAIMED, CANCELLED };
+
+            AssetLoader& mLoader;
+            std::atomic<int> mState;
+            int mPriority;  //protected by the mutex of the loader
+            std::function<void()> mWork;
+            std::function<void()> mCancel;
+        };
+
+        AssetLoader();
+
+        /** \brief (Re)starts the loader with the given number of worker threads. Queued requests are kept. */
+        void init(unsigned numThreads);
+
+        /** \brief Queues a request. The work is executed by a worker thread, unless the request is cancelled before.
+        * The cancel callback is invoked instead of the work if the request is cancelled. */
+        std::shared_ptr<Task> push(const std::function<void()>& work, const std::function<void()>& cancel, int priority = DEFAULT_PRIORITY);
+
+        /** \brief Raises the priority of a queued request. Does nothing if the given priority is not higher. */
+        void prioritize(const std::shared_ptr<Task>& task, int priority);
+
+        /** \brief Returns the number of requests that are neither started nor cancelled yet. */
+        std::size_t getQueueSize() const;
+
+        unsigned getThreadCount() const;
+
+        /** \brief Joins the workers and cancels all requests that were not picked up yet. */
+        ~AssetLoader();
+
+    public:
+        static constexpr unsigned DEFAULT_THREADS = 2;
+        static constexpr int DEFAULT_PRIORITY = 0;
+        static constexpr int VISIBLE_PRIORITY = 1; ///< for assets that are on screen
+
+    private:
+        struct Entry
+        {
+            int priority;
+            uint64_t sequence;
+            std::shared_ptr<Task> task;
+        };
+
+        struct EntryOrder
+        {
+            bool operator()(const Entry& a, const Entry& b) const
+            {
+                return a.priority < b.priority || (a.priority == b.priority && a.sequence > b.sequence);
+            }
+        };
+
+        //a prioritized task is queued again, the outdated entry is skipped once popped
+        std::priority_queue<Entry, std::vector<Entry>, EntryOrder> mQueue;
+        std::vector<std::thread> mWorkers;
+        mutable std::mutex mMutex;
+        std::condition_variable mCondition;
+        std::mutex mWorkerMutex;  //serializes starting and stopping of the workers
+        uint64_t mSequence;
+        std::atomic<std::size_t> mQueued;  //number of tasks that are neither started nor cancelled
+        bool mStop;
+
+    private:
+        void work();
+
+        void stop();
+
+        void start(unsigned numThreads);
+    };
+}
+
+#endif // ASSET_LOADER_H
@@ -82,6 +82,9 @@ namespace ungod
             template<typename ... ARGS>
             void execute(std::size_t index, ARGS&& ... args) const;
 
+            /** \brief Returns true if the script defines the callback with given index. */
+            bool hasCallback(std::size_t index) const { return index < mCallbacks.size() && mCallbacks[index]; }
+
             /** \brief Returns the script-side name of the environment. */
             const std::string& getName() const {return mName;}
 
@@ -144,6 +147,12 @@ namespace ungod
             /** \brief Returns the script static environment (equal for all instances). */
             script::Environment getStaticEnvironment() const;
 
+            /** \brief Returns the coupled meta cache. */
+            const MetaCache& getMeta() const { return *mMeta; }
+
+            /** \brief Returns true if an instance environment is set and the script defines the callback with given index. */
+            bool hasCallback(std::size_t index) const { return mEnvironment && mMeta->hasCallback(index); }
+
             /** \brief Returns the null object. */
             static InstanceCache& null() { return sNullInstance; }
         };
@@ -268,6 +277,9 @@ namespace ungod
         /** \brief Returns the name of the underlying script, that is its top level identifier. */
         const std::string& getScriptName() const;
 
+        /** \brief Returns the instance cache of the global state. */
+        const detail::InstanceCache& getGlobalState() const { return mGlobal; }
+
         virtual ~Behavior();
     };
 
@@ -322,6 +334,9 @@ namespace ungod
         /** \brief Returns the underlying static environment. */
         script::Environment getStaticEnvironment() const;
 
+        /** \brief Returns the instance cache of the current state. */
+        const detail::InstanceCache& getCurrentState() const { return *mCurrent; }
+
         virtual ~StateBehavior();
     };
 
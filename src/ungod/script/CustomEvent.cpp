@@ -31,4 +31,41 @@ namespace ungod
     {
         return state->create_table_with("type", type, "delay", delay, "data", env);
     }
+
+
+    constexpr std::size_t CustomEventPool::MAX_POOL_SIZE;
+
+    CustomEvent CustomEventPool::acquire(const script::SharedState& state, const std::string& type, script::Environment data, float delay)
+    {
+        if (mPool.empty())
+        {
+            mAllocated++;
+            return makeCustomEvent(state, type, data, delay);
+        }
+        CustomEvent evt = std::move(mPool.back());
+        mPool.pop_back();
+        evt["type"] = type;
+        evt["delay"] = delay;
+        evt["data"] = data;
+        return evt;
+    }
+
+    void CustomEventPool::release(CustomEvent evt)
+    {
+        if (mPool.size() >= MAX_POOL_SIZE)
+            return;
+        //listeners may have added fields, so remove everything
+        mKeys.clear();
+        evt.for_each([this](const sol::object& key, const sol::object&) { mKeys.push_back(key); });
+        for (const auto& key : mKeys)
+            evt[key] = sol::nil;
+        mKeys.clear();
+        mPool.emplace_back(std::move(evt));
+    }
+
+    void CustomEventPool::clear()
+    {
+        mPool.clear();
+        mKeys.clear();
+    }
 }
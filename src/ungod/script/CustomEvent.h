@@ -43,6 +43,38 @@ namespace ungod
     {
         return state->create_table_with("type", type, "delay", delay, "data", state->create_table_with(std::forward<PARAM>(param)...));
     }
+
+    /** \brief Recycles the tables of dispatched custom events, so that scripts emitting events every frame do not
+    * produce garbage for the lua collector. Released tables are cleared and handed out again by the next acquire call.
+    * Listeners must not keep references to an event table beyond its dispatch (the data table is never recycled). */
+    class CustomEventPool
+    {
+    public:
+        static constexpr std::size_t MAX_POOL_SIZE = 256; ///< number of released tables that are kept at most
+
+    public:
+        CustomEventPool() : mAllocated(0) {}
+
+        /** \brief Returns a custom event with the structure { type, delay, data }, reusing a released table if available. */
+        CustomEvent acquire(const script::SharedState& state, const std::string& type, script::Environment data, float delay);
+
+        /** \brief Clears the event table and keeps it for reuse. */
+        void release(CustomEvent evt);
+
+        /** \brief Drops all pooled tables. Must be called if the script state is reset. */
+        void clear();
+
+        /** \brief Returns the number of tables currently available for reuse. */
+        std::size_t getPoolSize() const { return mPool.size(); }
+
+        /** \brief Returns the number of tables created by the pool so far. */
+        std::size_t getAllocated() const { return mAllocated; }
+
+    private:
+        std::vector<CustomEvent> mPool;
+        std::vector<sol::object> mKeys; ///< reused to collect the keys of a released table
+        std::size_t mAllocated;
+    };
 }
 
 #endif
@@ -33,13 +33,14 @@ namespace ungod
                                                                         "onSerialize", "onDeserialize",
                                                                         "onCollisionEnter", "onCollision", "onCollisionExit",
                                                                         "onMouseEnter", "onMouseExit", "onMouseClick", "onMouseReleased",
-                                                                        "onUpdate",
+                                                                        "onUpdate", "onBatchUpdate",
                                                                         "onButtonDown", "onButtonReleased", "onButtonPressed",
                                                                         "onMovementBegin", "onMovementEnd", "onDirectionChanged",
                                                                         "onAnimationBegin", "onAnimationFrame", "onAnimationEnd",
                                                                         "onCustomEvent",
                                                                         "onAIGetState", "onAIAction",
-                                                                        "onEnteredNewNode" };
+                                                                        "onEnteredNewNode",
+                                                                        "onPathFound" };
 
     EntityBehaviorManager::EntityBehaviorManager(Application& app)
         : mBehaviorManager(app.getScriptState(), app.getGlobalScriptEnv(), IDENTIFIERS, ON_CREATION, ON_INIT, ON_EXIT, ON_STATIC_CONSTR, ON_STATIC_DESTR)
@@ -65,6 +65,10 @@
 * onUpdate(static, instance, delta)
 * -- This method is invoked constantly in a fixed interval of milliseconds, per default 5 times a second.
 *
+* onBatchUpdate(static, instances, delta)
+* -- Replaces onUpdate if defined. Invoked once per update with an array of all instances of the script (or state)
+* -- that are due in this update and share the same interval. Every instance provides its entity by instance.entity.
+*
 * onCreation(static, instance)
 * -- This method is invoked when a script is assigned to the EntityBehavior component of the given entity. (NOT neccessarily when the entity itself is created)
 *
@@ -98,6 +102,9 @@
 * onDirectionChanged(static, instance, old, current)
 * -- This method is invoked when an entity changes its movement-direction.
 *
+* onPathFound(static, instance, found)
+* -- This method is invoked when a path request of the entity was solved. found is false if there is no path to the target.
+*
 * onCustomEvent(static, instance, event)
 * -- This method is invoked when a custom event occurs
 *
@@ -143,13 +150,14 @@ namespace ungod
         ON_SERIALIZED, ON_DESERIALIZED,
         ON_COLLISION_ENTER, ON_COLLISION, ON_COLLISION_EXIT,
         ON_MOUSE_ENTER, ON_MOUSE_EXIT, ON_MOUSE_CLICK, ON_MOUSE_RELEASED,
-        ON_UPDATE,
+        ON_UPDATE, ON_BATCH_UPDATE,
         ON_BUTTON_DOWN, ON_BUTTON_RELEASED, ON_BUTTON_PRESSED,
         ON_MOVEMENT_BEGIN, ON_MOVEMENT_END, ON_DIRECTION_CHANGED,
         ON_ANIMATION_BEGIN, ON_ANIMATION_FRAME, ON_ANIMATION_END,
         ON_CUSTOM_EVENT,
         ON_AI_GET_STATE, ON_AI_ACTION,
-        ON_ENTERED_NEW_NODE
+        ON_ENTERED_NEW_NODE,
+        ON_PATH_FOUND
     };
 
     using ScriptQueues = std::unordered_map< EntityBehaviorHandler*, std::queue<std::pair<Entity, std::string>> >;
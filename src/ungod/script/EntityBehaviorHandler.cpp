@@ -27,9 +27,20 @@
 #include "ungod/base/World.h"
 #include "ungod/application/Application.h"
 #include "ungod/script/SerializationScriptContext.h"
+#include <algorithm>
+#include <cmath>
 
 namespace ungod
 {
+    namespace detail
+    {
+        //the timer wheel ticks in milliseconds, an update is due once the full interval has passed
+        inline uint64_t intervalTicks(float interval)
+        {
+            return static_cast<uint64_t>(std::ceil(std::max(interval, 0.0f)));
+        }
+    }
+
     bool EntityBehaviorComponent::valid() const
     {
         return mBehavior.get();
@@ -62,7 +73,7 @@ namespace ungod
 
 
 
-    EntityBehaviorHandler::EntityBehaviorHandler() : mWorld(nullptr) {}
+    EntityBehaviorHandler::EntityBehaviorHandler() : mWorld(nullptr), mTickRemainder(0.0f), mNextScheduleID(0) {}
 
     void EntityBehaviorHandler::init(World& world)
     {
@@ -72,6 +83,7 @@ namespace ungod
         mReloadLink = world.getState()->getEntityBehaviorManager().onReloadSignal([this](ScriptQueues& toReload) { scriptInternalReassign(toReload); });
 
         world.onEntityCreation([this](Entity e) { entityCreation(e); });
+        world.onComponentAdded<EntityUpdateTimer>([this](Entity e) { scheduleUpdate(e, e.modify<EntityUpdateTimer>(), mUpdateWheel.getTime() + 1); });
         world.onEntityDestruction([this](Entity e) { entityDestruction(e); });
 
         world.onEntitySerialized([this](Entity e, MetaNode serializer, SerializationContext& context) { entitySerialized(e, serializer, context); });
@@ -89,6 +101,7 @@ namespace ungod
         world.getMovementHandler().onBeginMovement([this](Entity e, const sf::Vector2f& vel) { callbackInvoker(ON_MOVEMENT_BEGIN, e, vel); });
         world.getMovementHandler().onEndMovement([this](Entity e) { callbackInvoker(ON_MOVEMENT_END, e); });
         world.getMovementHandler().onDirectionChanged([this](Entity e, MovementComponent::Direction old, MovementComponent::Direction current) { callbackInvoker(ON_DIRECTION_CHANGED, e, old, current); });
+        world.getPathPlanner().onPathFound([this](Entity e, bool found) { callbackInvoker(ON_PATH_FOUND, e, found); });
 
         world.getVisualsHandler().onAnimationStart([this](Entity e, const std::string& key) { callbackInvoker(ON_ANIMATION_BEGIN, e, key); });
         world.getVisualsHandler().onAnimationFrame([this](Entity e, const std::string& key, int frameIndex) { callbackInvoker(ON_ANIMATION_FRAME, e, key, frameIndex); });
@@ -106,31 +119,92 @@ namespace ungod
             });
     }
 
-    void EntityBehaviorHandler::update(const std::list<Entity>& entities, float delta)
+    void EntityBehaviorHandler::update(float delta, const quad::Bounds& area)
     {
-        dom::Utility<Entity>::iterate<EntityBehaviorComponent, EntityUpdateTimer>(entities,
-            [delta, this](Entity e, EntityBehaviorComponent& behavior, EntityUpdateTimer& timer)
+        mTickRemainder += delta;
+        uint64_t ticks = static_cast<uint64_t>(mTickRemainder);
+        mTickRemainder -= ticks;
+
+        mDueEntities.clear();
+        mUpdateWheel.advance(ticks, [this](const ScheduledUpdate& update)
             {
-                if (timer.mTimer.getElapsedTime().asMilliseconds() >= timer.mInterval && behavior.valid())
-                {
-                    behavior.mBehavior->execute(ON_UPDATE, timer.mInterval);
-                    timer.mTimer.restart();
-                }
+                if (update.entity.valid() && update.entity.has<EntityUpdateTimer>() &&
+                    update.entity.get<EntityUpdateTimer>().mScheduleID == update.id)
+                    mDueEntities.push_back(update.entity);
             });
 
-        for (const auto& e : mMetaEntities)
+        for (const auto& e : mDueEntities)
         {
-            if (e.has<EntityUpdateTimer>())
+            EntityUpdateTimer& timer = e.modify<EntityUpdateTimer>();
+            timer.mLastUpdate = mUpdateWheel.getTime();
+            //entities outside of the update area are checked again after their interval
+            scheduleUpdate(e, timer, timer.mLastUpdate + detail::intervalTicks(timer.mInterval));
+            if (!e.has<EntityBehaviorComponent>() || !inUpdateArea(e, area))
+                continue;
+            EntityBehaviorComponent& behavior = e.modify<EntityBehaviorComponent>();
+            if (behavior.valid())
             {
-                EntityUpdateTimer& timer = e.modify<EntityUpdateTimer>();
-                EntityBehaviorComponent& behavior = e.modify<EntityBehaviorComponent>();
-                if (timer.mTimer.getElapsedTime().asMilliseconds() >= timer.mInterval && behavior.valid())
-                {
-                    behavior.mBehavior->execute(ON_UPDATE, timer.mInterval);
-                    timer.mTimer.restart();
-                }
+                dispatchUpdate(behavior.mBehavior->getGlobalState(), timer.mInterval);
+                dispatchUpdate(behavior.mBehavior->getCurrentState(), timer.mInterval);
             }
         }
+
+        flushUpdateBatches();
+    }
+
+    void EntityBehaviorHandler::scheduleUpdate(Entity e, EntityUpdateTimer& timer, uint64_t due)
+    {
+        if (timer.mScheduleID == 0)
+            timer.mLastUpdate = mUpdateWheel.getTime();
+        timer.mScheduleID = ++mNextScheduleID;
+        mUpdateWheel.schedule(ScheduledUpdate{ e, timer.mScheduleID }, due);
+    }
+
+    bool EntityBehaviorHandler::inUpdateArea(Entity e, const quad::Bounds& area) const
+    {
+        //entities without transform are meta entities and always updated
+        if (!e.has<TransformComponent>())
+            return true;
+        if (!mWorld->getQuadTree().getOwner(e))
+            return false;
+        const TransformComponent& t = e.get<TransformComponent>();
+        return t.getPosition().x <= area.position.x + area.size.x &&
+            t.getPosition().x + t.getSize().x >= area.position.x &&
+            t.getPosition().y <= area.position.y + area.size.y &&
+            t.getPosition().y + t.getSize().y >= area.position.y;
+    }
+
+    void EntityBehaviorHandler::dispatchUpdate(const detail::InstanceCache& state, float interval)
+    {
+        if (!state.hasCallback(ON_BATCH_UPDATE))
+        {
+            state.execute(ON_UPDATE, interval);
+            return;
+        }
+        //a script defines only a handful of states, so a linear search is cheaper than hashing here
+        auto batch = std::find_if(mUpdateBatches.begin(), mUpdateBatches.end(), [&state, interval](const UpdateBatch& b)
+            { return b.meta == &state.getMeta() && b.interval == interval; });
+        if (batch == mUpdateBatches.end())
+        {
+            mUpdateBatches.push_back(UpdateBatch{ &state.getMeta(), interval, {} });
+            batch = mUpdateBatches.end() - 1;
+        }
+        batch->instances.push_back(*state.getEnvironment());
+    }
+
+    void EntityBehaviorHandler::flushUpdateBatches()
+    {
+        for (auto& batch : mUpdateBatches)
+        {
+            if (batch.instances.empty())
+                continue;
+            sol::state_view lua{ batch.meta->getEnvironment().lua_state() };
+            sol::table instances = lua.create_table(static_cast<int>(batch.instances.size()), 0);
+            for (std::size_t i = 0; i < batch.instances.size(); i++)
+                instances[i + 1] = batch.instances[i];
+            batch.instances.clear();
+            batch.meta->execute(ON_BATCH_UPDATE, instances, batch.interval);
+        }
     }
 
     void EntityBehaviorHandler::handleCustomEvent(const CustomEvent& event)
@@ -178,7 +252,9 @@ namespace ungod
 
     void EntityBehaviorHandler::setUpdateInterval(Entity e, float interval)
     {
-        setUpdateInterval(e.modify<EntityUpdateTimer>(), interval);
+        EntityUpdateTimer& timer = e.modify<EntityUpdateTimer>();
+        setUpdateInterval(timer, interval);
+        scheduleUpdate(e, timer, timer.mLastUpdate + detail::intervalTicks(interval));
     }
 
     void EntityBehaviorHandler::setUpdateInterval(EntityUpdateTimer& timer, float interval)
@@ -186,6 +262,15 @@ namespace ungod
         timer.mInterval = interval;
     }
 
+    void EntityBehaviorHandler::scheduleCopy(Entity e)
+    {
+        if (!e.has<EntityUpdateTimer>())
+            return;
+        EntityUpdateTimer& timer = e.modify<EntityUpdateTimer>();
+        timer.mScheduleID = 0; //the id refers to the timer wheel of the source
+        scheduleUpdate(e, timer, mUpdateWheel.getTime() + 1);
+    }
+
     script::EventListenerLink EntityBehaviorHandler::addEventListener(Entity e, const std::string& eventType)
     {
         return mEventHandler.addListener([this, e](const CustomEvent& evt)
@@ -331,6 +416,7 @@ namespace ungod
     void EntityBehaviorHandler::scriptInternalDissociate(ScriptQueues& toReload)
     {
         auto q = toReload.emplace(this, std::queue<std::pair<Entity, std::string>>{});
+        mUpdateBatches.clear(); //the meta caches of the batches are rebuilt on reload
         //reassign for entities in the world
         quad::PullResult<Entity> res;
         mWorld->getQuadTree().getContent(res);
@@ -28,9 +28,9 @@
 
 
 #include <unordered_set>
-#include <SFML/System/Clock.hpp>
 #include "ungod/script/EntityBehavior.h"
 #include "ungod/base/Entity.h"
+#include "ungod/utility/TimerWheel.h"
 #include "ungod/script/CustomEvent.h"
 #include "ungod/serialization/Serializable.h"
 #include "ungod/script/EventHandler.h"
@@ -91,18 +91,20 @@ namespace ungod
 
     /**
     * \ingroup Components
-    * \brief A component that holds a timer for controlling the continous update of entities. */
+    * \brief A component that holds a timer for controlling the continous update of entities.
+    * The timer is scheduled in the timer wheel of the EntityBehaviorHandler of the world. */
     class EntityUpdateTimer : public Serializable<EntityUpdateTimer>
     {
         friend class EntityBehaviorHandler;
     private:
-        sf::Clock mTimer;
         float mInterval;
+        uint64_t mScheduleID; ///< id of the currently valid entry in the timer wheel, 0 if not scheduled
+        uint64_t mLastUpdate; ///< tick of the last update or of the time the timer was scheduled
 
     public:
-        EntityUpdateTimer() : mInterval(200.0f) {}
+        EntityUpdateTimer() : mInterval(200.0f), mScheduleID(0), mLastUpdate(0) {}
 
-        EntityUpdateTimer(float cInterval) : mInterval(cInterval) {}
+        EntityUpdateTimer(float cInterval) : mInterval(cInterval), mScheduleID(0), mLastUpdate(0) {}
     };
 
 
@@ -180,8 +182,9 @@ namespace ungod
         /** \brief Initializes the manager. */
         void init(World& world);
 
-        /** \brief Updates the manager and may invoke onUpdate scripts of entities. */
-        void update(const std::list<Entity>& entities, float delta);
+        /** \brief Advances the update timers by delta milliseconds and invokes the onUpdate scripts of the due entities inside the
+        * given area. Scripts that define onBatchUpdate are invoked once per update for all their due instances. */
+        void update(float delta, const quad::Bounds& area);
 
         /** \brief Forwards the custom event to the script behaviors. */
         void handleCustomEvent(const CustomEvent& event);
@@ -200,10 +203,17 @@ namespace ungod
         /** \brief Dissociates the current behavior from the entity, if any. */
         void dissociateBehavior(Entity e);
 
-        /** \brief Sets the update interval of the given entity. */
+        /** \brief Sets the update interval of the given entity. The entity is rescheduled, so that its next update
+        * happens the new interval after its last update. */
         void setUpdateInterval(Entity e, float interval);
+
+        /** \brief Sets the update interval of the given timer. Takes effect after the next update of the timer. */
         void setUpdateInterval(EntityUpdateTimer& timer, float interval);
 
+        /** \brief Schedules the update timer of an entity that was copied into the world, if it has one. Copies do not
+        * emit the component-added signal and carry the schedule of their source, which is discarded. */
+        void scheduleCopy(Entity e);
+
         /** \brief Registers an entity as a listener to an event type. */
         script::EventListenerLink addEventListener(Entity e, const std::string& eventType);
 
@@ -212,8 +222,29 @@ namespace ungod
 
         ~EntityBehaviorHandler();
 
+    private:
+        /** \brief Collects the due instances of a script (or script state) that share the same update interval. */
+        struct UpdateBatch
+        {
+            const detail::MetaCache* meta;
+            float interval;
+            std::vector<script::Environment> instances;
+        };
+
+        /** \brief An entry in the timer wheel. It is outdated if the timer of the entity was rescheduled meanwhile. */
+        struct ScheduledUpdate
+        {
+            Entity entity;
+            uint64_t id;
+        };
+
     private:
         const World* mWorld;
+        std::vector<UpdateBatch> mUpdateBatches; ///< reused between updates to avoid reallocations
+        TimerWheel<ScheduledUpdate> mUpdateWheel; ///< one tick equals one millisecond
+        std::vector<Entity> mDueEntities;
+        float mTickRemainder; ///< fraction of a tick not yet applied to the wheel
+        uint64_t mNextScheduleID;
         std::unordered_set<Entity> mMetaEntities; ///< stores entities with no transform components (at the time of script assignment) in order to process them
         script::EventHandler mEventHandler;
         owls::SignalLink<void, ScriptQueues&> mDissociateLink;
@@ -236,6 +267,10 @@ namespace ungod
         void entityDeserialized(Entity e, MetaNode deserializer, DeserializationContext& context);
         void scriptInternalReassign(ScriptQueues& toReload);
         void scriptInternalDissociate(ScriptQueues& toReload);
+        void scheduleUpdate(Entity e, EntityUpdateTimer& timer, uint64_t due);
+        bool inUpdateArea(Entity e, const quad::Bounds& area) const;
+        void dispatchUpdate(const detail::InstanceCache& state, float interval);
+        void flushUpdateBatches();
 
         template<typename ... PARAM>
         void callbackInvoker(std::size_t index, Entity e, PARAM&& ... param)
@@ -1,36 +1,58 @@
 #include "EventHandler.h"
 #include "ungod/base/Entity.h"
 #include "ungod/script/EntityBehavior.h"
+#include <algorithm>
 
 namespace ungod
 {
     namespace script
     {
         void EventScheduler::handleCustomEvent(const CustomEvent& evt)
+        {
+            schedule(evt, false);
+        }
+
+        void EventScheduler::emit(const script::SharedState& state, const std::string& type, script::Environment data, float delay)
+        {
+            schedule(mEventPool.acquire(state, type, data, delay), true);
+        }
+
+        void EventScheduler::schedule(const CustomEvent& evt, bool pooled)
         {
             float delay = evt.get_or("delay", 0.0f);
             if (delay > 0.0f)
             {
                 float dt = mClock.getElapsedTime().asSeconds() + delay;
-                mDelayedEvents.emplace(dt, evt);
+                mDelayedEvents.emplace_back(dt, mSequence++, evt, pooled);
+                std::push_heap(mDelayedEvents.begin(), mDelayedEvents.end(), detail::DelayedEventCompare{});
             }
             else
-                dispatch(evt);
+                dispatch(evt, pooled);
         }
 
         void EventScheduler::dispatchDelayed()
         {
             float curTime = mClock.getElapsedTime().asSeconds();
-            while (!mDelayedEvents.empty() && mDelayedEvents.begin()->dispatchTime <= curTime)
+            while (!mDelayedEvents.empty() && mDelayedEvents.front().dispatchTime <= curTime)
             {
-                dispatch(mDelayedEvents.begin()->evt);
-                mDelayedEvents.erase(mDelayedEvents.begin());
+                std::pop_heap(mDelayedEvents.begin(), mDelayedEvents.end(), detail::DelayedEventCompare{});
+                detail::DelayedEvent delayed = std::move(mDelayedEvents.back());
+                mDelayedEvents.pop_back();
+                dispatch(delayed.evt, delayed.pooled);
             }
         }
 
-        void EventScheduler::dispatch(const CustomEvent& evt)
+        void EventScheduler::dispatch(const CustomEvent& evt, bool pooled)
         {
             mEventSignal(evt);
+            if (pooled)
+                mEventPool.release(evt);
+        }
+
+        void EventScheduler::clear()
+        {
+            mDelayedEvents.clear();
+            mEventPool.clear();
         }
 
         EventListenerLink EventScheduler::addListener(const std::function<void(const CustomEvent&)>& callback)
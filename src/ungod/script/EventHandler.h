@@ -27,7 +27,7 @@
 #define UNGOD_SCRIPT_EVENT_HANDLER_H
 
 #include <unordered_map>
-#include <set>
+#include <vector>
 #include "ungod/script/CustomEvent.h"
 #include "owls/Signal.h"
 #include <SFML/System/Clock.hpp>
@@ -40,16 +40,21 @@ namespace ungod
         {
             struct DelayedEvent
             {
-                DelayedEvent(float dt, const CustomEvent& e) : dispatchTime(dt), evt(e) {}
+                DelayedEvent(float dt, uint64_t seq, const CustomEvent& e, bool p) : dispatchTime(dt), sequence(seq), evt(e), pooled(p) {}
                 float dispatchTime;
+                uint64_t sequence; ///< keeps events with equal dispatch time in emission order
                 CustomEvent evt;
+                bool pooled; ///< true if the event table was acquired from the event pool
             };
             
+            /** \brief Orders the heap of delayed events so that the earliest event is on top. */
             struct DelayedEventCompare 
             {
                 bool operator() (const DelayedEvent& lhs, const DelayedEvent& rhs) const 
                 {
-                    return lhs.dispatchTime < rhs.dispatchTime;
+                    if (lhs.dispatchTime != rhs.dispatchTime)
+                        return lhs.dispatchTime > rhs.dispatchTime;
+                    return lhs.sequence > rhs.sequence;
                 }
             };
         }
@@ -62,21 +67,36 @@ namespace ungod
         class EventScheduler
         {
         public:
-            EventScheduler() = default;
+            EventScheduler() : mSequence(0) {}
 
             void handleCustomEvent(const CustomEvent& evt);
 
+            /** \brief Emits an event built from a pooled table. The table is recycled after its dispatch, so this is only
+            * suitable for events whose listeners do not keep the event table. */
+            void emit(const script::SharedState& state, const std::string& type, script::Environment data, float delay = 0.0f);
+
             void dispatchDelayed();
 
             EventListenerLink addListener(const std::function<void(const CustomEvent&)>& callback);
 
+            /** \brief Drops all delayed events and pooled tables. Must be called if the script state is reset. */
+            void clear();
+
+            /** \brief Returns the number of events waiting for their dispatch. */
+            std::size_t getDelayedEventCount() const { return mDelayedEvents.size(); }
+
+            const CustomEventPool& getEventPool() const { return mEventPool; }
+
         private:
-            std::set<detail::DelayedEvent, detail::DelayedEventCompare> mDelayedEvents;
+            std::vector<detail::DelayedEvent> mDelayedEvents; ///< binary heap ordered by DelayedEventCompare
+            uint64_t mSequence;
             sf::Clock mClock;
             Signal mEventSignal;
+            CustomEventPool mEventPool;
 
         private:
-            void dispatch(const CustomEvent& evt);
+            void schedule(const CustomEvent& evt, bool pooled);
+            void dispatch(const CustomEvent& evt, bool pooled);
         };
 
         /**
@@ -1,8 +1,138 @@
 #include "Script.h"
 #include <boost/filesystem.hpp>
+#include <fstream>
+#include <iterator>
+#include <cstdio>
 
 namespace ungod
 {
+    namespace detail
+    {
+        constexpr char BYTECODE_MAGIC[8] = { 'u','n','g','o','d','l','c','1' };
+
+        /** \brief Header of a cached bytecode file. Bytecode is only portable between identical
+        * lua versions and pointer sizes, so both are stored along with the hash of the source. */
+        struct BytecodeHeader
+        {
+            char magic[8];
+            uint64_t sourceHash;
+            int32_t luaVersion;
+            uint32_t pointerSize;
+        };
+
+        //64 bit FNV-1a
+        uint64_t hashBytes(const std::string& data)
+        {
+            uint64_t hash = 14695981039346656037ull;
+            for (unsigned char c : data)
+            {
+                hash ^= c;
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        std::string bytecodeCachePath(const std::string& directory, const std::string& filepath)
+        {
+            char name[32];
+            std::snprintf(name, sizeof(name), "%016llx.luac",
+                (unsigned long long)hashBytes(boost::filesystem::absolute(filepath).generic_string()));
+            return (boost::filesystem::path(directory) / name).string();
+        }
+
+        bool readBytecode(const std::string& cachepath, uint64_t sourceHash, std::string& bytecode)
+        {
+            std::ifstream in(cachepath, std::ios::binary);
+            if (!in)
+                return false;
+            BytecodeHeader header;
+            if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+                !std::equal(std::begin(BYTECODE_MAGIC), std::end(BYTECODE_MAGIC), header.magic) ||
+                header.sourceHash != sourceHash ||
+                header.luaVersion != LUA_VERSION_NUM ||
+                header.pointerSize != sizeof(void*))
+                return false;
+            bytecode.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            return !bytecode.empty();
+        }
+
+        void writeBytecode(const std::string& cachepath, uint64_t sourceHash, const std::string& bytecode)
+        {
+            boost::system::error_code ec;
+            boost::filesystem::create_directories(boost::filesystem::path(cachepath).parent_path(), ec);
+            //write to a temporary file first, so that no other process ever reads a partial cache file
+            std::string tmppath = cachepath + ".tmp";
+            {
+                std::ofstream out(tmppath, std::ios::binary | std::ios::trunc);
+                BytecodeHeader header;
+                std::copy(std::begin(BYTECODE_MAGIC), std::end(BYTECODE_MAGIC), header.magic);
+                header.sourceHash = sourceHash;
+                header.luaVersion = LUA_VERSION_NUM;
+                header.pointerSize = sizeof(void*);
+                out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                out.write(bytecode.data(), bytecode.size());
+                if (!out)
+                {
+                    Logger::warning("Could not write bytecode cache file", tmppath);
+                    return;
+                }
+            }
+            boost::filesystem::rename(tmppath, cachepath, ec);
+            if (ec)
+                Logger::warning("Could not write bytecode cache file", cachepath, "\n", ec.message());
+        }
+
+        int bytecodeWriter(lua_State*, const void* data, size_t size, void* buffer)
+        {
+            static_cast<std::string*>(buffer)->append(static_cast<const char*>(data), size);
+            return 0;
+        }
+
+        /** \brief Loads the chunk of the given script file. Uses the bytecode cache if enabled and valid
+        * and renews the cache otherwise. */
+        sol::load_result loadChunk(script::StateRef& state, const std::string& filepath, const std::string& cachedir)
+        {
+            if (cachedir.empty())
+                return state.load_file(filepath);
+
+            std::ifstream in(filepath, std::ios::binary);
+            std::string source{ std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
+            if (!in)
+                return state.load_file(filepath);
+
+            uint64_t sourceHash = hashBytes(source);
+            std::string cachepath = bytecodeCachePath(cachedir, filepath);
+            std::string chunkname = "@" + filepath;
+            std::string bytecode;
+            if (readBytecode(cachepath, sourceHash, bytecode))
+            {
+                sol::load_result cached = state.load_buffer(bytecode.data(), bytecode.size(), chunkname, sol::load_mode::binary);
+                if (cached.valid())
+                    return cached;
+                Logger::warning("Discarding the invalid bytecode cache of script", filepath);
+            }
+
+            sol::load_result result = state.load_buffer(source.data(), source.size(), chunkname, sol::load_mode::any);
+            if (result.valid())
+            {
+                sol::protected_function chunk = result;
+                bytecode.clear();
+                chunk.push();
+#if LUA_VERSION_NUM >= 503
+                int error = lua_dump(state.lua_state(), &bytecodeWriter, &bytecode, 0);
+#else
+                int error = lua_dump(state.lua_state(), &bytecodeWriter, &bytecode);
+#endif
+                lua_pop(state.lua_state(), 1);
+                if (error == 0)
+                    writeBytecode(cachepath, sourceHash, bytecode);
+            }
+            return result;
+        }
+    }
+
+    std::string Script::sBytecodeCache;
+
     Script::Script(const std::string& filepath, script::StateRef state) { load(filepath, state); }
 
     bool Script::load(const std::string& filepath, script::StateRef state)
@@ -15,7 +145,7 @@ namespace ungod
             mState = state;
             try
             {
-                sol::load_result r = mState->load_file(filepath);
+                sol::load_result r = detail::loadChunk(*mState, filepath, sBytecodeCache);
                 mValid = r.valid();
                 if (mValid)
                     mCallback = r;
@@ -62,6 +192,16 @@ namespace ungod
         return mValid;
     }
 
+    void Script::setBytecodeCache(const std::string& directory)
+    {
+        sBytecodeCache = directory;
+    }
+
+    const std::string& Script::getBytecodeCache()
+    {
+        return sBytecodeCache;
+    }
+
     void Script::reset() 
     {
         mValid = false;
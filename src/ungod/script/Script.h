@@ -70,10 +70,20 @@ namespace ungod
         * It will be no longer valid. This automatically invalidates all other Script assets refering to that scriptdata. */
         void reset();
 
+        /** \brief Sets the directory in which compiled scripts are cached. Scripts are loaded from the cache if
+        * the cached bytecode was compiled from the same source, otherwise they are compiled and the cache is renewed.
+        * An empty path disables the cache. */
+        static void setBytecodeCache(const std::string& directory);
+
+        /** \brief Returns the directory of the bytecode cache, an empty string if the cache is disabled. */
+        static const std::string& getBytecodeCache();
+
     private:
         script::ProtectedFunc mCallback;
         bool mValid;
         std::string mFilepath;
+
+        static std::string sBytecodeCache; ///< directory of the bytecode cache, empty if disabled
     protected:
         script::OptionalStateRef mState;
     };
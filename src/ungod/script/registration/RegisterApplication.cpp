@@ -79,6 +79,12 @@ namespace ungod
             state.registerFunction("isFullscreen", [&app]() { return app.isFullscreen(); });
             state.registerFunction("isVsyncEnabled", [&app]() { return app.vsyncEnabled(); });
 
+            state.registerFunction("getScriptMemory", [&app]() { return app.getScriptStats().memory; });
+            state.registerFunction("getScriptPeakMemory", [&app]() { return app.getScriptStats().peakMemory; });
+            state.registerFunction("getScriptGCTime", [&app]() { return app.getScriptStats().gcTime; });
+            state.registerFunction("getScriptGCSteps", [&app]() { return app.getScriptStats().gcSteps; });
+            state.registerFunction("getScriptEmergencyCollections", [&app]() { return app.getScriptStats().emergencyCollections; });
+
             state.registerFunction("getMusicManager", [&app]() -> MusicManager& { return app.getMusicManager(); });
             state.registerFunction("getSoundProfileManager", [&app]() -> SoundProfileManager&{ return app.getSoundProfileManager(); });
             state.registerFunction("getInputManager", [&app]() -> InputManager& { return app.getInputManager(); });
@@ -96,6 +102,9 @@ namespace ungod
             state.registerFunction("emit", sol::overload(
                 [&app](const std::string& type, script::Environment data) { return app.emitCustomEvent(type, data); },
                 [&app](const std::string& type, script::Environment data, float delay) { return app.emitCustomEvent(type, data, delay); }));
+            state.registerFunction("emitPooled", sol::overload(
+                [&app](const std::string& type, script::Environment data) { return app.emitPooledCustomEvent(type, data); },
+                [&app](const std::string& type, script::Environment data, float delay) { return app.emitPooledCustomEvent(type, data, delay); }));
 
             state.registerFunction("setCursor", [&app](const std::string& cursor) { app.setCursor(cursor); });
             state.registerFunction("initCursor", [&app](const std::string& cursor, const std::string& path) { app.initCursor(cursor, path); });
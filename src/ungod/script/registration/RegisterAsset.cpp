@@ -30,11 +30,28 @@ namespace ungod
 {
     namespace scriptRegistration
     {
-        void registerAssets(ScriptStateBase& state)
+        void registerAssets(ScriptStateBase& state, AssetManager& manager)
         {
             state.registerEnum<LoadPolicy>("LoadPolicy", 
 				{ {"SYNC", LoadPolicy::SYNC},
 				{"ASYNC", LoadPolicy::ASYNC } });
+
+			script::Usertype<AssetStats> statsType = state.registerUsertype<AssetStats>("AssetStats");
+			statsType["loaded"] = &AssetStats::loaded;
+			statsType["loadedBytes"] = &AssetStats::loadedBytes;
+			statsType["cached"] = &AssetStats::cached;
+			statsType["cachedBytes"] = &AssetStats::cachedBytes;
+			statsType["hits"] = &AssetStats::hits;
+			statsType["misses"] = &AssetStats::misses;
+			statsType["evictions"] = &AssetStats::evictions;
+
+            state.registerFunction("getAssetStats", sol::overload([&manager] () { return manager.getStats(); },
+                                                                  [&manager] (const std::string& type) { return manager.getStats(type); }));
+            state.registerFunction("getAssetMemory", [&manager] () { return manager.getMemoryUsage(); });
+            state.registerFunction("getAssetBudget", [&manager] () { return manager.getBudget(); });
+            state.registerFunction("setAssetBudget", [&manager] (std::size_t bytes) { manager.setBudget(bytes); });
+            state.registerFunction("clearAssetCache", [&manager] () { manager.clearCache(); });
+            state.registerFunction("getPendingAssetLoads", [&manager] () { return manager.getLoader().getQueueSize(); });
         }
     }
 }
@@ -30,10 +30,12 @@
 
 namespace ungod
 {
+    class AssetManager;
+
     namespace scriptRegistration
     {
         /** \brief Registers asset data functionality for scripts. */
-        void registerAssets(ScriptStateBase& state);
+        void registerAssets(ScriptStateBase& state, AssetManager& manager);
     }
 }
 
@@ -55,6 +55,7 @@ namespace ungod
 			entityType["movement"] = [](Entity& e) { return MovementHandlerFrontEnd{ e, e.getWorld().getMovementHandler() }; };
 			entityType["steering"] = [](Entity& e) { return SteeringHandlerFrontEnd<script::Environment>{ e, e.getWorld().getSteeringHandler() }; };
 			entityType["path"] = [](Entity& e) { return PathPlannerFrontEnd{ e, e.getWorld().getPathPlanner() }; };
+			entityType["crowd"] = [](Entity& e) { return CrowdHandlerFrontEnd{ e, e.getWorld().getCrowdHandler() }; };
 			entityType["light"] = [](Entity& e) { return LightHandlerFrontEnd{ e, e.getWorld().getLightHandler() }; };
 			entityType["visuals"] = [](Entity& e) { return VisualHandlerFrontEnd{ e, e.getWorld().getVisualsHandler() }; };
 			entityType["tilemap"] = [](Entity& e) { return TileMapHandlerFrontEnd{ e, e.getWorld().getTileMapHandler() }; };
@@ -74,6 +75,7 @@ namespace ungod
 			hasType["movement"] = &Has::has<MovementComponent>;
 			hasType["steering"] = &Has::has<SteeringComponent<script::Environment>>;
 			hasType["path"] = &Has::has<PathFinderComponent>;
+			hasType["crowd"] = &Has::has<CrowdComponent>;
 			hasType["shadows"] = &Has::has<ShadowEmitterComponent>;
 			hasType["light"] = &Has::has<LightEmitterComponent>;
 			hasType["lightAffector"] = &Has::has<LightAffectorComponent>;
@@ -108,6 +110,7 @@ namespace ungod
 			addType["movement"] = &Add::add<MovementComponent>;
 			addType["steering"] = &Add::add<SteeringComponent<script::Environment>>;
 			addType["path"] = &Add::add<PathFinderComponent>;
+			addType["crowd"] = &Add::add<CrowdComponent>;
 			addType["shadows"] = &Add::add<ShadowEmitterComponent>;
 			addType["light"] = &Add::add<LightEmitterComponent>;
 			addType["lightAffector"] = &Add::add<LightAffectorComponent>;
@@ -141,6 +144,7 @@ namespace ungod
 			remType["movement"] = &Rem::rem<MovementComponent>;
 			remType["steering"] = &Rem::rem<SteeringComponent<script::Environment>>;
 			remType["path"] = &Rem::rem<PathFinderComponent>;
+			remType["crowd"] = &Rem::rem<CrowdComponent>;
 			remType["shadows"] = &Rem::rem<ShadowEmitterComponent>;
 			remType["light"] = &Rem::rem<LightEmitterComponent>;
 			remType["lightAffector"] = &Rem::rem<LightAffectorComponent>;
@@ -26,6 +26,7 @@
 #include "ungod/script/registration/RegisterLight.h"
 #include "ungod/script/registration/RegistrationDetail.h"
 #include "ungod/visual/LightHandler.h"
+#include "ungod/visual/LightManager.h"
 
 namespace ungod
 {
@@ -171,6 +172,12 @@ namespace ungod
 			script::Usertype<LightHandler> lightHandlerType = state.registerUsertype<LightHandler>("LightHandler");
 			lightHandlerType["setAmbientColor"] = & LightHandler::setAmbientColor;
 			lightHandlerType["getAmbientColor"] = &LightHandler::getAmbientColor;
+			lightHandlerType["setLightBudget"] = &LightHandler::setLightBudget;
+			lightHandlerType["getLightBudget"] = &LightHandler::getLightBudget;
+
+			script::Usertype<LightManager> lightManagerType = state.registerUsertype<LightManager>("LightManager");
+			lightManagerType["setResolutionDivisor"] = &LightManager::setResolutionDivisor;
+			lightManagerType["getResolutionDivisor"] = &LightManager::getResolutionDivisor;
 
 			script::Usertype<LightHandlerFrontEnd> lightHandlerFrontEndType = state.registerUsertype<LightHandlerFrontEnd>("LightHandlerFrontEnd");
 			lightHandlerFrontEndType["setLightPosition"] =
@@ -24,6 +24,7 @@
 */
 
 #include "ungod/script/registration/RegisterMovement.h"
+#include "ungod/base/World.h"
 
 namespace ungod
 {
@@ -140,6 +141,27 @@ namespace ungod
             mPathPlanner.setPath(mEntity, env2vec<sf::Vector2f>(points), policy, speed, radius);
         }
 
+        bool PathPlannerFrontEnd::findPathTo(const sf::Vector2f& position)
+        {
+            return mPathPlanner.findPathTo(mEntity, position);
+        }
+
+
+        void CrowdHandlerFrontEnd::setRadius(float radius)
+        {
+            mHandler.setRadius(mEntity, radius);
+        }
+
+        void CrowdHandlerFrontEnd::setWeights(float separation, float alignment, float cohesion, float avoidance)
+        {
+            mHandler.setWeights(mEntity, separation, alignment, cohesion, avoidance);
+        }
+
+        float CrowdHandlerFrontEnd::getRadius() const
+        {
+            return mEntity.get<CrowdComponent>().getRadius();
+        }
+
 
         void registerMovement(ScriptStateBase& state)
         {
@@ -205,6 +227,12 @@ namespace ungod
                                             { pathplanner.setPath(points); },
                                             [] (PathPlannerFrontEnd& pathplanner, Entity e, script::Environment points, PathFollowingPolicy policy, float speed, float radius)
                                             { pathplanner.setPath(points, policy, speed, radius); });
+			pathplannerType["findPathTo"] = [] (PathPlannerFrontEnd& pathplanner, const sf::Vector2f& position) { return pathplanner.findPathTo(position); };
+
+			script::Usertype<CrowdHandlerFrontEnd> crowdType = state.registerUsertype<CrowdHandlerFrontEnd>("CrowdHandlerFrontEnd");
+			crowdType["setRadius"] = &CrowdHandlerFrontEnd::setRadius;
+			crowdType["setWeights"] = &CrowdHandlerFrontEnd::setWeights;
+			crowdType["getRadius"] = &CrowdHandlerFrontEnd::getRadius;
 
 
             //steerings are added as a fixed-parameter and a modificable-parameter version
@@ -283,6 +311,19 @@ namespace ungod
                                        });
 
 
+            state.registerFunction("followFlowField",
+                                       [] () -> std::function< void(Entity, MovementHandler&, const script::Environment&) >
+                                       {
+                                            return [] (Entity e, MovementHandler& mvh, const script::Environment& parameters)
+                                            {
+                                                SteeringHandler<script::Environment>::followFlowField( e, mvh, e.getWorld().getFlowFieldPlanner(),
+                                                            detail::unpackParameter<sf::Vector2f>(parameters, "goal"),
+                                                            detail::unpackParameter<float>(parameters, "speed"),
+                                                            detail::unpackParameter<float>(parameters, "radius"));
+                                            };
+                                       });
+
+
             state.registerFunction("directMovement",
                                        [] () -> std::function< void(Entity, MovementHandler&, const script::Environment&) >
                                        {
@@ -30,6 +30,7 @@
 #include "ungod/physics/Movement.h"
 #include "ungod/physics/Path.h"
 #include "ungod/physics/Steering.h"
+#include "ungod/physics/Crowd.h"
 
 namespace ungod
 {
@@ -102,12 +103,26 @@ namespace ungod
             PathPlannerFrontEnd(Entity& e, PathPlanner& p) : mEntity(e), mPathPlanner(p) {}
             void setPath(script::Environment points);
             void setPath(script::Environment points, PathFollowingPolicy policy, float speed, float radius);
+            bool findPathTo(const sf::Vector2f& position);
         private:
             Entity& mEntity;
             PathPlanner& mPathPlanner;
         };
 
 
+        class CrowdHandlerFrontEnd
+        {
+        public:
+            CrowdHandlerFrontEnd(Entity& e, CrowdHandler& h) : mEntity(e), mHandler(h) {}
+            void setRadius(float radius);
+            void setWeights(float separation, float alignment, float cohesion, float avoidance);
+            float getRadius() const;
+        private:
+            Entity& mEntity;
+            CrowdHandler& mHandler;
+        };
+
+
         /** \brief Registers movement functionality for scripts. */
         void registerMovement(ScriptStateBase& state);
 
@@ -115,6 +115,29 @@ namespace ungod
     {
     }
 
+
+    void SerialBehavior<CrowdComponent, Entity>::serialize(const CrowdComponent& data, MetaNode serializer, SerializationContext& context, Entity e)
+    {
+        context.serializeProperty("radius", data.mRadius, serializer);
+        context.serializeProperty("separation", data.mSeparation, serializer);
+        context.serializeProperty("alignment", data.mAlignment, serializer);
+        context.serializeProperty("cohesion", data.mCohesion, serializer);
+        context.serializeProperty("avoidance", data.mAvoidance, serializer);
+    }
+
+    void DeserialBehavior<CrowdComponent, Entity, DeserialMemory&>::deserialize(CrowdComponent& data, MetaNode deserializer, DeserializationContext& context, Entity e, DeserialMemory& deserialmemory)
+    {
+        auto result = deserializer.getAttributes<float, float, float, float, float>
+                        ( {"radius", CrowdHandler::DEFAULT_RADIUS}, {"separation", CrowdHandler::DEFAULT_SEPARATION},
+                         {"alignment", CrowdHandler::DEFAULT_ALIGNMENT}, {"cohesion", CrowdHandler::DEFAULT_COHESION},
+                         {"avoidance", CrowdHandler::DEFAULT_AVOIDANCE} );
+        data.mRadius = std::get<0>(result);
+        data.mSeparation = std::get<1>(result);
+        data.mAlignment = std::get<2>(result);
+        data.mCohesion = std::get<3>(result);
+        data.mAvoidance = std::get<4>(result);
+    }
+
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     /// audio ///////////////////////////////////////////////////////////////////////////////////////////////////////////
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
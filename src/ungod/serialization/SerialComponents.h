@@ -41,6 +41,7 @@ namespace ungod
     class MovementComponent;
     template<typename GETTER > class SteeringComponent;
     class PathFinderComponent;
+    class CrowdComponent;
     class VisualsComponent;
     class VertexArrayComponent;
     class SpriteComponent;
@@ -198,6 +199,25 @@ namespace ungod
     };
 
 
+    template <>
+    struct SerialIdentifier<CrowdComponent>
+    {
+        static std::string get()  { return "CR"; }
+    };
+
+    template <>
+    struct SerialBehavior<CrowdComponent, Entity>
+    {
+        static void serialize(const CrowdComponent& data, MetaNode serializer, SerializationContext& context, Entity e);
+    };
+
+    template <>
+    struct DeserialBehavior<CrowdComponent, Entity, DeserialMemory&>
+    {
+        static void deserialize(CrowdComponent& data, MetaNode deserializer, DeserializationContext& context, Entity e, DeserialMemory& deserialmemory);
+    };
+
+
 
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     /// visuals ////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -25,6 +25,7 @@
 
 #include "ungod/serialization/SerialTileMap.h"
 #include "ungod/content/tilemap/TileMap.h"
+#include <algorithm>
 
 namespace ungod
 {
@@ -37,8 +38,18 @@ namespace ungod
 
         context.serializePropertyContainer("keys", data.mKeymap, serializer);
 
-        if (data.mTiles.ids)
-            context.serializePropertyContainer<int>("ids", [&data] (std::size_t i) { return data.mTiles.ids->at(i); } , data.mTiles.ids->size(), serializer);
+        if (data.mTiles.empty())
+            return;
+
+        //store the ids run-length encoded as (count, id)-pairs if that is shorter
+        std::vector<int> runs;
+        data.mTiles.forEachRun([&runs] (int id, std::size_t count) { runs.push_back((int)count); runs.push_back(id); });
+        if (runs.size() < (std::size_t)data.mMapSizeX * (std::size_t)data.mMapSizeY)
+            context.serializePropertyContainer("ids_rle", runs, serializer);
+        else
+            context.serializePropertyContainer<int>("ids", [&data] (std::size_t i)
+                { return data.mTiles.get((unsigned)(i / data.mMapSizeY), (unsigned)(i % data.mMapSizeY)); },
+                (std::size_t)data.mMapSizeX * (std::size_t)data.mMapSizeY, serializer);
     }
 
     void DeserialBehavior<TileMap>::deserialize(TileMap& data, MetaNode deserializer, DeserializationContext& context)
@@ -59,12 +70,24 @@ namespace ungod
         data.setTileDims( tileWidth, tileHeight, keymap);
 
         TileData tmdata;
-        tmdata.ids = std::make_unique<std::vector<int>>();
+        tmdata.ids = std::make_shared<std::vector<int>>();
         attr = context.next(
             context.deserializeContainer<int>([&tmdata] (std::size_t num) { tmdata.ids->reserve(num); },
                              [&tmdata] (int id) { tmdata.ids->emplace_back(id); }),
                              "ids", deserializer, attr );
 
+        if (tmdata.ids->empty())
+        {
+            std::vector<int> runs;
+            attr = context.next(
+                context.deserializeContainer<int>([&runs] (std::size_t num) { runs.reserve(num); },
+                                 [&runs] (int value) { runs.emplace_back(value); }),
+                                 "ids_rle", deserializer, attr );
+            tmdata.ids->reserve((std::size_t)mapWidth * (std::size_t)mapHeight);
+            for (std::size_t i = 0; i + 1 < runs.size(); i += 2)
+                tmdata.ids->insert(tmdata.ids->end(), (std::size_t)std::max(runs[i], 0), runs[i+1]);
+        }
+
         data.setTiles(tmdata, mapWidth, mapHeight);
     }
 }
@@ -1,8 +1,32 @@
 #include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <cmath>
 #include "ungod/AI/Predictor.h"
+#include "ungod/AI/InferenceService.h"
+#include "ungod/AI/TreeSearch.h"
+#include "ungod/AI/SceneDirector.h"
 
 BOOST_AUTO_TEST_SUITE(AITest)
 
+//walk on a line towards a goal, actions: left, stay, right
+class WalkEnvironment : public ungod::AI::SearchEnvironment
+{
+public:
+	WalkEnvironment() : mPosition(10), mSteps(0) {}
+	virtual std::unique_ptr<ungod::AI::SearchEnvironment> clone() const override { return std::unique_ptr<ungod::AI::SearchEnvironment>(new WalkEnvironment(*this)); }
+	virtual void assign(const ungod::AI::SearchEnvironment& other) override { *this = static_cast<const WalkEnvironment&>(other); }
+	virtual unsigned getActionCount() const override { return 3; }
+	virtual bool isValid(unsigned action) const override { return mPosition + (int)action - 1 >= 0 && mPosition + (int)action - 1 <= 20; }
+	virtual void apply(unsigned action) override { mPosition += (int)action - 1; mSteps++; }
+	virtual bool isTerminal() const override { return mPosition == 15 || mSteps >= 5; }
+	virtual float getValue() const override { return mPosition == 15 ? 1.0f - 0.05f*mSteps : -1.0f; }
+	virtual std::size_t getObservationSize() const override { return 2; }
+	virtual void getObservation(float* out) const override { out[0] = (float)mPosition; out[1] = (float)mSteps; }
+private:
+	int mPosition;
+	int mSteps;
+};
+
 BOOST_AUTO_TEST_CASE( predictor_test )
 {
 	/*ungod::AI::Model model;
@@ -12,4 +36,218 @@ BOOST_AUTO_TEST_CASE( predictor_test )
 	BOOST_REQUIRE(pred.setModel(model));*/
 }
 
+BOOST_AUTO_TEST_CASE( inference_service_test )
+{
+	ungod::AI::Model model;
+	model.load("test_data/converted_model.tflite");
+	BOOST_REQUIRE(model.isLoaded());
+
+	constexpr std::size_t NUM_REQUESTS = 512;
+
+	ungod::AI::InferenceSettings settings;
+	settings.maxBatchSize = 128;
+	ungod::AI::InferenceService service(settings);
+	BOOST_REQUIRE(service.setModel(model));
+
+	//deterministic pseudo random samples
+	std::vector<ungod::AI::InferenceService::Samples> samples(NUM_REQUESTS);
+	for (std::size_t r = 0; r < NUM_REQUESTS; r++)
+		for (std::size_t i = 0; i < service.getInputCount(); i++)
+		{
+			samples[r].emplace_back(service.getInputSize(i));
+			for (std::size_t k = 0; k < samples[r][i].size(); k++)
+				samples[r][i][k] = (float)((r * 31 + i * 17 + k * 7) % 101) / 101.0f;
+		}
+
+	//reference: one invocation per request
+	ungod::AI::Predictor pred;
+	BOOST_REQUIRE(pred.setModel(model));
+	BOOST_REQUIRE(pred.setBatchSize(1));
+	std::vector<ungod::AI::InferenceService::Samples> expected(NUM_REQUESTS);
+	auto start = std::chrono::steady_clock::now();
+	for (std::size_t r = 0; r < NUM_REQUESTS; r++)
+	{
+		for (std::size_t i = 0; i < samples[r].size(); i++)
+			std::copy(samples[r][i].begin(), samples[r][i].end(), pred.getInput<float>(i));
+		BOOST_REQUIRE(pred.invoke());
+		for (std::size_t o = 0; o < pred.getOutputCount(); o++)
+			expected[r].emplace_back(pred.getOutput<float>(o), pred.getOutput<float>(o) + pred.getOutputSize(o));
+	}
+	auto unbatched = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+	//batched: all requests answered in a single tick
+	std::vector<ungod::AI::InferenceService::Samples> results(NUM_REQUESTS);
+	start = std::chrono::steady_clock::now();
+	for (std::size_t r = 0; r < NUM_REQUESTS; r++)
+		BOOST_REQUIRE(service.request(samples[r], [&results, r] (const ungod::AI::InferenceService::Samples& out) { results[r] = out; }));
+	service.tick();
+	auto batched = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+	BOOST_CHECK_EQUAL(service.getProcessedRequests(), NUM_REQUESTS);
+	BOOST_CHECK_EQUAL(service.getInvocations(), NUM_REQUESTS / settings.maxBatchSize);
+	BOOST_CHECK_EQUAL(service.getPendingCount(), 0u);
+	for (std::size_t r = 0; r < NUM_REQUESTS; r++)
+	{
+		BOOST_REQUIRE_EQUAL(results[r].size(), expected[r].size());
+		for (std::size_t o = 0; o < results[r].size(); o++)
+		{
+			BOOST_REQUIRE_EQUAL(results[r][o].size(), expected[r][o].size());
+			for (std::size_t k = 0; k < results[r][o].size(); k++)
+				BOOST_CHECK_SMALL(results[r][o][k] - expected[r][o][k], 1e-4f);
+		}
+	}
+
+	ungod::Logger::info("Inference of", NUM_REQUESTS, "requests, unbatched:", unbatched, "us, batched:", batched, "us");
+
+	//malformed requests are rejected
+	BOOST_CHECK(!service.request({}, nullptr));
+
+	//worker thread: results arrive one tick later
+	settings.threaded = true;
+	settings.numThreads = 2;
+	ungod::AI::InferenceService threadedService(settings);
+	BOOST_REQUIRE(threadedService.setModel(model));
+	std::size_t answered = 0;
+	for (std::size_t r = 0; r < NUM_REQUESTS; r++)
+		threadedService.request(samples[r], [&answered] (const ungod::AI::InferenceService::Samples&) { answered++; });
+	threadedService.tick();
+	BOOST_CHECK_EQUAL(answered, 0u);
+	threadedService.request(samples[0], [&answered] (const ungod::AI::InferenceService::Samples&) { answered++; });
+	threadedService.flush();
+	BOOST_CHECK_EQUAL(answered, NUM_REQUESTS + 1);
+}
+
+BOOST_AUTO_TEST_CASE( tree_search_test )
+{
+	//only moving right in every step reaches the goal in time
+	WalkEnvironment env;
+	ungod::AI::RolloutEvaluator evaluator(8);
+
+	for (bool rootParallel : { false, true })
+		for (unsigned threads : { 1u, 4u })
+		{
+			ungod::AI::SearchSettings settings;
+			settings.simulations = 20000;
+			settings.threads = threads;
+			settings.rootParallel = rootParallel;
+			ungod::AI::TreeSearch search(evaluator, settings);
+
+			auto start = std::chrono::steady_clock::now();
+			BOOST_CHECK_EQUAL(search.decide(env), 2);
+			auto time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+			BOOST_CHECK_EQUAL(search.getSimulations(), settings.simulations);
+			BOOST_CHECK(search.getNodeCount() > 1);
+			const auto& visits = search.search(env);
+			BOOST_CHECK(visits[2] > visits[0] && visits[2] > visits[1]);
+
+			ungod::Logger::info("Tree search with", threads, "threads, root parallel:", rootParallel, ",", 
+				(long long)(settings.simulations * 1000000.0 / std::max<long long>(1, time)), "simulations per second");
+		}
+
+	//terminal root
+	ungod::AI::TreeSearch search(evaluator);
+	env.apply(0);
+	env.apply(0);
+	env.apply(0);
+	env.apply(0);
+	env.apply(0);
+	BOOST_CHECK(env.isTerminal());
+	search.search(env);
+	BOOST_CHECK_EQUAL(search.getNodeCount(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE( scene_simulator_test )
+{
+	ungod::AI::SceneSimulator sim(32);
+	BOOST_CHECK_EQUAL(sim.addBody({ 0.0f, 0.0f }, { 10.0f, 10.0f }, false), 0u);
+	BOOST_CHECK_EQUAL(sim.addBody({ 300.0f, 0.0f }, { 10.0f, 10.0f }, true), 1u);
+	BOOST_CHECK_EQUAL(sim.addBody({ 0.0f, 300.0f }, { 10.0f, 10.0f }, true), 2u);
+	BOOST_CHECK_EQUAL(sim.getActorCount(), 1u);
+	BOOST_CHECK_EQUAL(sim.getOpponentCount(), 2u);
+
+	//actors after opponents are rejected
+	BOOST_CHECK_EQUAL(sim.addBody({ 300.0f, 300.0f }, { 10.0f, 10.0f }, false), ungod::AI::SceneSimulator::INVALID_BODY);
+	BOOST_CHECK_EQUAL(sim.getActorCount(), 1u);
+	BOOST_CHECK_EQUAL(sim.getOpponentCount(), 2u);
+
+	//copies are independent
+	ungod::AI::SceneSimulator copy = sim;
+	copy.applyActions({ 3 });
+	BOOST_CHECK(copy.getPosition(0).x > 0.0f);
+	BOOST_CHECK_EQUAL(sim.getPosition(0).x, 0.0f);
+	BOOST_CHECK_EQUAL(sim.getStepCount(), 0u);
+
+	//opponents seek the actor
+	for (unsigned i = 0; i < 10; i++)
+		sim.applyActions({ 0 });
+	BOOST_CHECK(sim.getPosition(1).x < 300.0f);
+	BOOST_CHECK(sim.getPosition(2).y < 300.0f);
+	BOOST_CHECK_EQUAL(sim.getPosition(0).x, 0.0f);
+
+	sim.reset();
+	BOOST_CHECK_EQUAL(sim.getPosition(1).x, 300.0f);
+	BOOST_CHECK_EQUAL(sim.getStepCount(), 0u);
+
+	//the search interface steps once every actor has an action
+	while (!sim.isTerminal())
+		sim.apply(7);
+	BOOST_CHECK_EQUAL(sim.getStepCount(), 32u);
+	BOOST_CHECK(sim.getPosition(0).x < 0.0f);
+	BOOST_CHECK(!sim.isValid(0));
+	sim.reset();
+
+	//overlapping bodies are separated
+	ungod::AI::SceneSimulator crowd;
+	crowd.addBody({ 0.0f, 0.0f }, { 10.0f, 10.0f }, false);
+	crowd.addBody({ 5.0f, 2.0f }, { 10.0f, 10.0f }, false);
+	crowd.addBody({ 0.0f, -15.0f }, { 10.0f, 5.0f }, false, 0.0f, 0.0f, 0.0f);
+	crowd.step();
+	BOOST_CHECK(crowd.getPosition(1).x - crowd.getPosition(0).x >= 19.99f);
+	BOOST_CHECK(crowd.getPosition(0).y >= -0.01f);
+	BOOST_CHECK_EQUAL(crowd.getPosition(2).y, -15.0f);
+
+	//actors keep away from the opponents
+	ungod::AI::SceneSimulator scene(32);
+	for (unsigned i = 0; i < 4; i++)
+		scene.addBody({ 100.0f * i, 0.0f }, { 10.0f, 10.0f }, false);
+	for (unsigned i = 0; i < 4; i++)
+		scene.addBody({ 100.0f * i, 400.0f }, { 10.0f, 10.0f }, true);
+	scene.setValueFunction([] (const ungod::AI::SceneSimulator& s)
+		{
+			float value = 0.0f;
+			for (std::size_t a = 0; a < s.getActorCount(); a++)
+				for (std::size_t o = s.getActorCount(); o < s.getBodyCount(); o++)
+					value += std::min(1.0f, ungod::distance(s.getPosition(a), s.getPosition(o)) / 500.0f);
+			return 2.0f * value / (s.getActorCount() * s.getOpponentCount()) - 1.0f;
+		});
+	BOOST_CHECK(scene.getValue() > -1.0f);
+	BOOST_CHECK_EQUAL(scene.getObservationSize(), 32u);
+
+	std::vector<int> actions{ 1, 3, 5, 7 };
+	constexpr unsigned NUM_STEPS = 1000000;
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned i = 0; i < NUM_STEPS; i++)
+	{
+		if (scene.isTerminal())
+			scene.reset();
+		scene.applyActions(actions);
+	}
+	auto time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	ungod::Logger::info("Scene simulator with 8 bodies:", (long long)(NUM_STEPS * 1000000.0 / std::max<long long>(1, time)), "steps per second");
+	scene.reset();
+
+	ungod::AI::RolloutEvaluator evaluator(32);
+	ungod::AI::SearchSettings settings;
+	settings.simulations = 4000;
+	settings.threads = 4;
+	ungod::AI::TreeSearch search(evaluator, settings);
+	start = std::chrono::steady_clock::now();
+	int action = search.decide(scene);
+	time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	BOOST_CHECK(action >= 0 && action < (int)ungod::AI::SceneSimulator::ACTION_COUNT);
+	BOOST_CHECK_EQUAL(search.getSimulations(), settings.simulations);
+	ungod::Logger::info("Tree search on the scene simulator:", (long long)(settings.simulations * 1000000.0 / std::max<long long>(1, time)), "rollouts per second");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
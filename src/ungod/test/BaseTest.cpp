@@ -1,5 +1,12 @@
 #include <boost/test/unit_test.hpp>
 #include <chrono>
+#include <random>
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <cmath>
+#include <future>
+#include <mutex>
 #include "ungod/base/World.h"
 #include "ungod/application/Application.h"
 #include "ungod/utility/Graph.h"
@@ -282,6 +289,73 @@ BOOST_AUTO_TEST_CASE( disjoint_sets_test )
     BOOST_CHECK_EQUAL(ds.setCount(), 1u);
 }
 
+std::vector<std::array<std::size_t, 3>> canonicalTriangles(std::vector<std::array<std::size_t, 3>> triangles)
+{
+    for (auto& t : triangles)
+        std::sort(t.begin(), t.end());
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+//the previous O(n^2) Bowyer-Watson implementation that scans all triangles for every inserted point
+std::vector<std::array<std::size_t, 3>> referenceTriangulation(const std::vector<sf::Vector2f>& points, const sf::Vector2f& upperBound, const sf::Vector2f& lowerBound)
+{
+    struct RefTriangle
+    {
+        std::array<std::size_t, 3> v;
+        double cx, cy, radius;
+    };
+    std::size_t numPoints = points.size();
+    float dx = lowerBound.x - upperBound.x;
+    float dy = lowerBound.y - upperBound.y;
+    std::vector<sf::Vector2f> all = points;
+    all.emplace_back(upperBound.x + dx/2, upperBound.y - dy);
+    all.emplace_back(upperBound.x - dx, lowerBound.y);
+    all.emplace_back(lowerBound.x + dx, lowerBound.y);
+
+    auto makeTriangle = [&all] (std::size_t a, std::size_t b, std::size_t c)
+    {
+        double ax = all[a].x, ay = all[a].y, bx = all[b].x, by = all[b].y, cx = all[c].x, cy = all[c].y;
+        double d = 2 * (ax * (by - cy) + bx * (cy - ay) + cx * (ay - by));
+        double ux = ((ax*ax + ay*ay) * (by - cy) + (bx*bx + by*by) * (cy - ay) + (cx*cx + cy*cy) * (ay - by)) / d;
+        double uy = ((ax*ax + ay*ay) * (cx - bx) + (bx*bx + by*by) * (ax - cx) + (cx*cx + cy*cy) * (bx - ax)) / d;
+        return RefTriangle{ { a, b, c }, ux, uy, std::sqrt((ax - ux) * (ax - ux) + (ay - uy) * (ay - uy)) };
+    };
+
+    std::vector<RefTriangle> triangles = { makeTriangle(numPoints, numPoints + 1, numPoints + 2) };
+    for (std::size_t v = 0; v < numPoints; ++v)
+    {
+        std::vector<RefTriangle> bad, good;
+        for (const auto& t : triangles)
+        {
+            double dist = std::sqrt((all[v].x - t.cx) * (all[v].x - t.cx) + (all[v].y - t.cy) * (all[v].y - t.cy));
+            (dist <= t.radius ? bad : good).push_back(t);
+        }
+        //edges of the bad triangles that are not shared with another bad triangle form the hole
+        std::vector<std::pair<std::size_t, std::size_t>> polygon;
+        for (std::size_t i = 0; i < bad.size(); ++i)
+            for (unsigned k = 0; k < 3; ++k)
+            {
+                std::size_t a = bad[i].v[k], b = bad[i].v[(k + 1) % 3];
+                bool shared = false;
+                for (std::size_t j = 0; j < bad.size() && !shared; ++j)
+                    for (unsigned l = 0; l < 3 && j != i; ++l)
+                        shared = shared || (bad[j].v[l] == b && bad[j].v[(l + 1) % 3] == a) || (bad[j].v[l] == a && bad[j].v[(l + 1) % 3] == b);
+                if (!shared)
+                    polygon.emplace_back(a, b);
+            }
+        triangles = std::move(good);
+        for (const auto& e : polygon)
+            triangles.push_back(makeTriangle(e.first, e.second, v));
+    }
+
+    std::vector<std::array<std::size_t, 3>> result;
+    for (const auto& t : triangles)
+        if (t.v[0] < numPoints && t.v[1] < numPoints && t.v[2] < numPoints)
+            result.push_back(t.v);
+    return canonicalTriangles(result);
+}
+
 BOOST_AUTO_TEST_CASE( triangulation_test )
 {
     //simple test with just a single triangle
@@ -308,6 +382,338 @@ BOOST_AUTO_TEST_CASE( triangulation_test )
 
         BOOST_CHECK_EQUAL(5u, triag.getData().getTriangleContainer().size());
     }
+    //compare with the previous implementation on random point sets
+    for (std::size_t numPoints : { 10u, 100u, 1000u, 3000u })
+    {
+        std::mt19937 rng((unsigned)numPoints);
+        std::uniform_real_distribution<float> coord(0.0f, 1000.0f);
+        std::vector<sf::Vector2f> points(numPoints);
+        for (auto& p : points)
+            p = { coord(rng), coord(rng) };
+
+        ungod::DelaunayTriangulation<sf::Vector2f> triag;
+        triag.run(points, { 0, 0 }, { 1000, 1000 });
+        const auto& data = triag.getData();
+        std::vector<std::array<std::size_t, 3>> triangles;
+        for (std::size_t t = 0; t < data.getTriangleContainer().size(); ++t)
+        {
+            const ungod::Triangle& tri = data.getTriangleContainer()[t].triangle;
+            triangles.push_back({ tri.v0, tri.v1, tri.v2 });
+            for (unsigned i = 0; i < 3; ++i)
+            {
+                //adjacency has to be symmetric and the neighbor has to share the edge
+                std::size_t n = data.getNeighbor(t, i);
+                if (n == data.NO_EDGE)
+                    continue;
+                const ungod::Triangle& other = data.getTriangleContainer()[n].triangle;
+                bool back = false;
+                for (unsigned j = 0; j < 3; ++j)
+                    back = back || (data.getNeighbor(n, j) == t && other[j] == tri[(i + 1) % 3] && other[(j + 1) % 3] == tri[i]);
+                BOOST_CHECK(back);
+            }
+        }
+        BOOST_CHECK(referenceTriangulation(points, { 0, 0 }, { 1000, 1000 }) == canonicalTriangles(triangles));
+    }
+    //benchmark a large triangulation
+    {
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<float> coord(0.0f, 10000.0f);
+        std::vector<sf::Vector2f> points(100000);
+        for (auto& p : points)
+            p = { coord(rng), coord(rng) };
+        ungod::DelaunayTriangulation<sf::Vector2f> triag;
+        auto start = std::chrono::steady_clock::now();
+        triag.run(points, { 0, 0 }, { 10000, 10000 });
+        float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+        BOOST_CHECK(triag.getData().getTriangleContainer().size() > 190000u);
+        ungod::Logger::info("Triangulated", points.size(), "points in", seconds, "seconds.");
+        ungod::Logger::endl();
+    }
+}
+
+//grid mesh of about 10k triangles with a wall at x = [350,360] that is only open at the top
+void buildWallMesh(ungod::PathPlanner& planner)
+{
+    const int cells = 71;
+    const float cellSize = 10.0f;
+    ungod::PointContainer vertices;
+    std::vector<ungod::PathPlanner::NodeParameters> triangles;
+    for (int y = 0; y <= cells; ++y)
+        for (int x = 0; x <= cells; ++x)
+            vertices.emplace_back(x * cellSize, y * cellSize);
+    auto id = [cells] (int x, int y) { return (std::size_t)(y * (cells + 1) + x); };
+    for (int y = 0; y < cells; ++y)
+        for (int x = 0; x < cells; ++x)
+        {
+            if (x == 35 && y >= 10)
+                continue;
+            triangles.emplace_back(id(x, y), id(x + 1, y), id(x + 1, y + 1));
+            triangles.emplace_back(id(x, y), id(x + 1, y + 1), id(x, y + 1));
+        }
+    planner.buildNavMesh(vertices, triangles);
+}
+
+BOOST_AUTO_TEST_CASE( navmesh_pathfinding_test )
+{
+    ungod::PathPlanner planner;
+    buildWallMesh(planner);
+    BOOST_CHECK_EQUAL(planner.getNodeCount(), 9960u);
+
+    ungod::PointContainer waypoints;
+    BOOST_REQUIRE(planner.findPath({ 300, 650 }, { 500, 650 }, waypoints));
+    BOOST_CHECK(waypoints.back() == sf::Vector2f(500, 650));
+    //the path has to bend around both corners at the top of the wall
+    BOOST_CHECK(std::find(waypoints.begin(), waypoints.end(), sf::Vector2f(350, 100)) != waypoints.end());
+    BOOST_CHECK(std::find(waypoints.begin(), waypoints.end(), sf::Vector2f(360, 100)) != waypoints.end());
+    for (const auto& w : waypoints)
+        BOOST_CHECK(w.y >= 100 || w == sf::Vector2f(500, 650));
+
+    //free line of sight
+    BOOST_REQUIRE(planner.findPath({ 20, 20 }, { 300, 600 }, waypoints));
+    BOOST_CHECK_EQUAL(waypoints.size(), 1u);
+
+    //outside of the mesh and inside the wall
+    BOOST_CHECK(!planner.findPath({ 300, 650 }, { 800, 650 }, waypoints));
+    BOOST_CHECK(!planner.findPath({ 355, 650 }, { 300, 650 }, waypoints));
+
+    //benchmark random queries
+    {
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> coord(0.0f, 710.0f);
+        const unsigned queries = 10000;
+        unsigned found = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < queries; ++i)
+            found += planner.findPath({ coord(rng), coord(rng) }, { coord(rng), coord(rng) }, waypoints);
+        float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+        BOOST_CHECK(found > queries / 2);
+        ungod::Logger::info("Navmesh queries per second on", planner.getNodeCount(), "triangles:", queries / seconds);
+        ungod::Logger::endl();
+    }
+
+    //build from obstacles, a long wall and a small box overlapping with it
+    {
+        ungod::PathPlanner obstaclePlanner;
+        std::vector<ungod::PointContainer> obstacles = { { {400,100}, {600,100}, {600,900}, {400,900} },
+                                                         { {550,850}, {700,850}, {700,950}, {550,950} } };
+        obstaclePlanner.buildNavGraph(obstacles, sf::FloatRect(0, 0, 1000, 1000));
+        BOOST_CHECK(obstaclePlanner.getNodeCount() > 0u);
+        BOOST_CHECK_EQUAL(obstaclePlanner.getNodeAt({ 500, 500 }), -1);
+        BOOST_CHECK_EQUAL(obstaclePlanner.getNodeAt({ 650, 900 }), -1);
+        BOOST_REQUIRE(obstaclePlanner.findPath({ 200, 500 }, { 800, 500 }, waypoints));
+        BOOST_REQUIRE_EQUAL(waypoints.size(), 3u);
+        BOOST_CHECK(waypoints[0] == sf::Vector2f(400, 100));
+        BOOST_CHECK(waypoints[1] == sf::Vector2f(600, 100));
+        BOOST_CHECK(!obstaclePlanner.findPath({ 200, 500 }, { 500, 500 }, waypoints));
+    }
+}
+
+BOOST_AUTO_TEST_CASE( path_request_queue_test )
+{
+    ungod::ScriptedGameState state(EmbeddedTestApp::getApp(), 0);
+    ungod::WorldGraphNode& node = state.getWorldGraph().createNode(state, "nodeid", "nodefile");
+    node.setSaveContents(false); //do not serialize any changes we make to this node
+    node.setSize({ 800,600 });
+    ungod::World* world = node.addWorld();
+
+    //a crowd standing in 4 different triangles requests paths to the same target
+    std::vector<ungod::Entity> crowd;
+    for (unsigned i = 0; i < 100; ++i)
+    {
+        ungod::Entity e = world->create(ungod::BaseComponents<ungod::TransformComponent, ungod::PathFinderComponent>(), ungod::OptionalComponents<>());
+        world->getTransformHandler().setPosition(e, { 102.0f + (i % 4) * 10.0f, 605.0f });
+        crowd.push_back(e);
+    }
+
+    for (unsigned threads : { 0u, 2u })
+    {
+        ungod::PathPlanner planner;
+        planner.init(threads);
+        buildWallMesh(planner);
+        unsigned found = 0;
+        planner.onPathFound([&found] (ungod::Entity e, bool success) { if (success) found++; });
+
+        for (const auto& e : crowd)
+            BOOST_CHECK(planner.findPathTo(e, { 500, 650 }));
+        BOOST_CHECK(!planner.findPathTo(crowd[0], { 800, 650 })); //target off the mesh, the pending request is kept
+        BOOST_CHECK(planner.findPathTo(crowd[1], { 555, 652 })); //replaces the pending request of the entity
+
+        auto start = std::chrono::steady_clock::now();
+        while (found < crowd.size() && std::chrono::steady_clock::now() - start < std::chrono::seconds(10))
+            planner.processRequests();
+        BOOST_CHECK_EQUAL(found, crowd.size());
+        BOOST_CHECK_EQUAL(planner.getPendingRequests(), 0u);
+        //one search per distinct pair of triangles, the replaced request is solved but not applied
+        //workers may pick up a group before all requests of the frame are queued, so there can be more searches
+        if (threads == 0)
+            BOOST_CHECK_EQUAL(planner.getSolvedSearches(), 5u);
+        else
+            BOOST_CHECK(planner.getSolvedSearches() >= 5u);
+
+        //requests pending while the mesh is rebuilt fail
+        unsigned failed = 0;
+        planner.onPathFound([&failed] (ungod::Entity e, bool success) { if (!success) failed++; });
+        if (threads == 0)
+        {
+            planner.findPathTo(crowd[0], { 500, 650 });
+            buildWallMesh(planner);
+            planner.processRequests();
+            BOOST_CHECK_EQUAL(failed, 1u);
+        }
+    }
+
+    for (const auto& e : crowd)
+        world->destroy(e);
+    world->update(20.0f, {}, {});
+}
+
+BOOST_AUTO_TEST_CASE( flow_field_test )
+{
+    //a wall that can only be passed at the top
+    ungod::FlowFieldPlanner flowField;
+    std::vector<ungod::PointContainer> obstacles = { { {400,300}, {600,300}, {600,1000}, {400,1000} } };
+    flowField.setObstacles(obstacles, sf::FloatRect(0, 0, 1000, 1000), 20.0f);
+    BOOST_CHECK_EQUAL(flowField.getSizeX(), 50u);
+    BOOST_CHECK_EQUAL(flowField.getSizeY(), 50u);
+    BOOST_CHECK(flowField.isBlocked({ 500, 500 }));
+    BOOST_CHECK(!flowField.isBlocked({ 200, 500 }));
+
+    sf::Vector2f goal(800, 500);
+    sf::Vector2f dir = flowField.getDirection({ 200, 500 }, goal);
+    BOOST_CHECK(dir.y < 0.0f);
+    BOOST_CHECK(flowField.getDirection({ 200, 100 }, { 800, 100 }).x > 0.9f);
+    BOOST_CHECK(flowField.getDistance({ 200, 500 }, goal) > 750.0f); //straight distance is 600
+    BOOST_CHECK(flowField.getDirection(goal, goal) == sf::Vector2f());
+    BOOST_CHECK(flowField.getDirection({ 200, 500 }, { 500, 500 }) == sf::Vector2f()); //goal inside the wall
+    BOOST_CHECK(flowField.getDistance({ 200, 500 }, { 500, 500 }) == std::numeric_limits<float>::infinity());
+    BOOST_CHECK_EQUAL(flowField.getCachedFieldCount(), 2u);
+    flowField.setMaxCachedFields(1);
+    BOOST_CHECK_EQUAL(flowField.getCachedFieldCount(), 1u);
+
+    //move a crowd along the field, nobody may enter the wall
+    {
+        std::mt19937 rng(3);
+        std::uniform_real_distribution<float> coordX(20.0f, 380.0f);
+        std::uniform_real_distribution<float> coordY(20.0f, 980.0f);
+        std::vector<sf::Vector2f> crowd(1000);
+        for (auto& p : crowd)
+            p = { coordX(rng), coordY(rng) };
+        unsigned samples = 0;
+        bool touchedWall = false;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned step = 0; step < 400; ++step)
+            for (auto& p : crowd)
+            {
+                sf::Vector2f d = flowField.getDirection(p, goal);
+                samples++;
+                if (d == sf::Vector2f())
+                    p += (goal - p) * 0.5f;
+                else
+                    p += d * 5.0f;
+                touchedWall = touchedWall || flowField.isBlocked(p);
+            }
+        float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+        BOOST_CHECK(!touchedWall);
+        BOOST_CHECK(std::all_of(crowd.begin(), crowd.end(), [&goal] (const sf::Vector2f& p)
+                                { return std::abs(p.x - goal.x) < 20.0f && std::abs(p.y - goal.y) < 20.0f; }));
+        ungod::Logger::info("Flow field samples per second:", samples / seconds);
+        ungod::Logger::endl();
+    }
+
+    //static colliders of the world invalidate the fields
+    {
+        ungod::ScriptedGameState state(EmbeddedTestApp::getApp(), 0);
+        ungod::WorldGraphNode& node = state.getWorldGraph().createNode(state, "nodeid", "nodefile");
+        node.setSaveContents(false); //do not serialize any changes we make to this node
+        node.setSize({ 800,600 });
+        ungod::World* world = node.addWorld();
+        ungod::FlowFieldPlanner& worldField = world->getFlowFieldPlanner();
+        BOOST_CHECK(!worldField.isBlocked({ 300, 300 }));
+        worldField.getDirection({ 100, 100 }, { 700, 500 });
+        BOOST_CHECK_EQUAL(worldField.getCachedFieldCount(), 1u);
+
+        ungod::Entity e = world->create(ungod::BaseComponents<ungod::TransformComponent, ungod::RigidbodyComponent<>>());
+        world->getMovementRigidbodyHandler().addCollider(e, ungod::makeRotatedRect({200,200}, {400, 400}));
+        BOOST_CHECK_EQUAL(worldField.getCachedFieldCount(), 0u);
+        BOOST_CHECK(worldField.isBlocked({ 300, 300 }));
+        worldField.getDirection({ 100, 100 }, { 700, 500 });
+        world->getMovementRigidbodyHandler().clearCollider(e);
+        BOOST_CHECK_EQUAL(worldField.getCachedFieldCount(), 0u);
+        BOOST_CHECK(!worldField.isBlocked({ 300, 300 }));
+        world->destroy(e);
+        world->update(20.0f, {}, {});
+    }
+}
+
+BOOST_AUTO_TEST_CASE( crowd_test )
+{
+    ungod::ScriptedGameState state(EmbeddedTestApp::getApp(), 0);
+    ungod::WorldGraphNode& node = state.getWorldGraph().createNode(state, "nodeid", "nodefile");
+    node.setSaveContents(false); //do not serialize any changes we make to this node
+    node.setSize({ 800,600 });
+    ungod::World* world = node.addWorld();
+    ungod::CrowdHandler& crowd = world->getCrowdHandler();
+    ungod::MovementHandler& movement = world->getMovementHandler();
+    using CrowdAgent = ungod::BaseComponents<ungod::TransformComponent, ungod::MovementComponent, ungod::CrowdComponent>;
+
+    //two agents on a head-on course sidestep in opposite directions
+    {
+        ungod::Entity a = world->create(CrowdAgent());
+        ungod::Entity b = world->create(CrowdAgent());
+        world->getTransformHandler().setPosition(a, { 100,100 });
+        world->getTransformHandler().setPosition(b, { 150,100 });
+        movement.accelerate(a, { 1,0 });
+        movement.accelerate(b, { -1,0 });
+        std::list<ungod::Entity> agents = { a, b };
+        movement.update(agents, 0.0f); //applies the velocities without moving
+        crowd.setWeights(a, 0.0f, 0.0f, 0.0f, 1.0f);
+        crowd.setWeights(b, 0.0f, 0.0f, 0.0f, 1.0f);
+        crowd.update(agents);
+        BOOST_CHECK_EQUAL(crowd.getAgentCount(), 2u);
+        BOOST_CHECK(a.get<ungod::MovementComponent>().getAcceleration().y < 0.0f);
+        BOOST_CHECK(b.get<ungod::MovementComponent>().getAcceleration().y > 0.0f);
+
+        //agents that stand on top of each other are pushed apart
+        movement.stop(a);
+        movement.stop(b);
+        world->getTransformHandler().setPosition(b, { 105,100 });
+        crowd.setWeights(a, 1.0f, 0.0f, 0.0f, 0.0f);
+        crowd.setWeights(b, 1.0f, 0.0f, 0.0f, 0.0f);
+        crowd.update(agents);
+        BOOST_CHECK(a.get<ungod::MovementComponent>().getAcceleration().x < 0.0f);
+        BOOST_CHECK(b.get<ungod::MovementComponent>().getAcceleration().x > 0.0f);
+        world->destroy(a);
+        world->destroy(b);
+    }
+
+    //benchmark with a dense crowd
+    {
+        std::list<ungod::Entity> agents;
+        world->create(CrowdAgent(), ungod::OptionalComponents<>(), 10000, [&agents](ungod::Entity e) { agents.push_back(e); });
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> coord(0.0f, 2000.0f);
+        std::uniform_real_distribution<float> dir(-1.0f, 1.0f);
+        for (const auto& e : agents)
+        {
+            world->getTransformHandler().setPosition(e, { coord(rng), coord(rng) });
+            movement.accelerate(e, { dir(rng), dir(rng) });
+        }
+        movement.update(agents, 0.0f);
+        const unsigned steps = 20;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned step = 0; step < steps; ++step)
+            crowd.update(agents);
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        BOOST_CHECK_EQUAL(crowd.getAgentCount(), 10000u);
+        BOOST_CHECK(std::all_of(agents.begin(), agents.end(), [] (ungod::Entity e)
+                    { return std::isfinite(e.get<ungod::MovementComponent>().getAcceleration().x) &&
+                             std::isfinite(e.get<ungod::MovementComponent>().getAcceleration().y); }));
+        ungod::Logger::info("Crowd agents per millisecond:", steps * crowd.getAgentCount() / ms);
+        ungod::Logger::endl();
+        for (const auto& e : agents)
+            world->destroy(e);
+    }
+    world->update(20.0f, {}, {});
 }
 
 BOOST_AUTO_TEST_CASE( component_signal_test )
@@ -341,6 +747,65 @@ BOOST_AUTO_TEST_CASE( component_signal_test )
 	world->update(20.0f, {}, {}); //destroys entity in queue
 }
 
+BOOST_AUTO_TEST_CASE( slot_signal_test )
+{
+    owls::SlotSignal<int> signal;
+    int sum = 0;
+    owls::SlotLink<int> self;
+    auto first = signal.connect([&sum] (int i) { sum += i; });
+    self = signal.connect([&] (int i)
+        {
+            sum += 10*i;
+            self.disconnect(); //disconnect while emitting
+            signal.connect([&sum] (int i) { sum += 100*i; }); //connect while emitting, not called before the next emit
+        });
+    signal.emit(1);
+    BOOST_CHECK_EQUAL(sum, 11);
+    BOOST_CHECK_EQUAL(signal.callbackCount(), 2u);
+    signal.emit(1);
+    BOOST_CHECK_EQUAL(sum, 112);
+
+    signal.defer(2);
+    signal.defer(3);
+    BOOST_CHECK_EQUAL(sum, 112);
+    BOOST_CHECK_EQUAL(signal.deferredCount(), 2u);
+    signal.flush();
+    BOOST_CHECK_EQUAL(sum, 617);
+    BOOST_CHECK_EQUAL(signal.deferredCount(), 0u);
+
+    first.disconnect();
+    signal.emit(1);
+    BOOST_CHECK_EQUAL(sum, 717);
+
+    //emit cost compared to owls::Signal
+    const unsigned numEmits = 1000000;
+    for (unsigned listeners : { 0u, 1u, 10u })
+    {
+        owls::Signal<ungod::Entity, const sf::FloatRect&> listSignal;
+        owls::SlotSignal<ungod::Entity, const sf::FloatRect&> slotSignal;
+        float listSum = 0, slotSum = 0;
+        for (unsigned i = 0; i < listeners; ++i)
+        {
+            listSignal.connect([&listSum] (ungod::Entity, const sf::FloatRect& rect) { listSum += rect.width; });
+            slotSignal.connect([&slotSum] (ungod::Entity, const sf::FloatRect& rect) { slotSum += rect.width; });
+        }
+        sf::FloatRect rect{ 0, 0, 1, 1 };
+
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < numEmits; ++i)
+            listSignal.emit(ungod::Entity(), rect);
+        auto listTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < numEmits; ++i)
+            slotSignal.emit(ungod::Entity(), rect);
+        auto slotTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+        ungod::Logger::info("Emit with", listeners, "listeners: owls::Signal", listTime, "microseconds, owls::SlotSignal", slotTime, "microseconds for", numEmits, "emits");
+        BOOST_CHECK_EQUAL(listSum, slotSum);
+    }
+}
+
 BOOST_AUTO_TEST_CASE( entity_copy_test )
 {
     ungod::ScriptedGameState state(EmbeddedTestApp::getApp(), 0);
@@ -544,6 +1009,105 @@ BOOST_AUTO_TEST_CASE(multiple_threads_request_asset_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(asset_budget_test)
+{
+    ungod::AssetManager& manager = EmbeddedTestApp::getApp().getAssetManager();
+    std::size_t budget = manager.getBudget();
+    manager.clearCache();
+    ungod::AssetStats before = manager.getStats("Image");
+    BOOST_CHECK_EQUAL(before.cached, 0u);
+    {
+        ungod::Image img("test_data/test_sheet.png");
+        BOOST_REQUIRE(img.isLoaded());
+        std::size_t bytes = (std::size_t)img.get().getSize().x * img.get().getSize().y * 4;
+        BOOST_CHECK(manager.getStats("Image").loadedBytes >= before.loadedBytes + bytes);
+        BOOST_CHECK(manager.getMemoryUsage() >= bytes);
+    }
+    //the released image stays in memory and is reused without loading
+    BOOST_CHECK_EQUAL(manager.getStats("Image").cached, 1u);
+    {
+        ungod::Image img("test_data/test_sheet.png");
+        BOOST_CHECK(img.isLoaded());
+        BOOST_CHECK_EQUAL(manager.getStats("Image").hits, before.hits + 1);
+        BOOST_CHECK_EQUAL(manager.getStats("Image").cached, 0u);
+    }
+    //a budget that does not fit both images evicts the least recently released one
+    {
+        ungod::Image sheet("test_data/test_sheet.png");
+        ungod::Image warrior("test_data/blech_warrior.png");
+        manager.setBudget(manager.getMemoryUsage() - 1);
+        sheet.drop();
+        warrior.drop();
+    }
+    ungod::AssetStats after = manager.getStats("Image");
+    BOOST_CHECK_EQUAL(after.cached, 1u);
+    BOOST_CHECK_EQUAL(after.evictions, before.evictions + 1);
+    {
+        ungod::Image warrior("test_data/blech_warrior.png");
+        BOOST_CHECK_EQUAL(manager.getStats("Image").hits, after.hits + 1);
+        ungod::Image sheet("test_data/test_sheet.png");
+        BOOST_CHECK_EQUAL(manager.getStats("Image").misses, after.misses + 1);
+    }
+    //a cached asset is not revived for a request with other load parameters
+    {
+        ungod::AssetStats cached = manager.getStats("Image");
+        ungod::Image repeated("test_data/test_sheet.png", ungod::LoadPolicy::SYNC, false, true);
+        BOOST_CHECK(repeated.get().isRepeated());
+        BOOST_CHECK_EQUAL(manager.getStats("Image").hits, cached.hits);
+        BOOST_CHECK_EQUAL(manager.getStats("Image").misses, cached.misses + 1);
+    }
+    //without a budget, released assets are freed immediately
+    manager.setBudget(0);
+    BOOST_CHECK_EQUAL(manager.getStats().cached, 0u);
+    BOOST_CHECK_EQUAL(manager.getStats().cachedBytes, 0u);
+    manager.setBudget(budget);
+}
+
+BOOST_AUTO_TEST_CASE(asset_loader_test)
+{
+    //block the only worker, so that the order of the queued requests is deterministic
+    std::vector<std::string> order;
+    std::mutex orderMutex;
+    bool cancelled = false;
+    {
+        ungod::AssetLoader loader;
+        loader.init(1);
+        BOOST_CHECK_EQUAL(loader.getThreadCount(), 1u);
+        std::promise<void> gate;
+        std::shared_future<void> open = gate.get_future().share();
+        loader.push([open] () { open.wait(); }, [] () {});
+        auto record = [&order, &orderMutex] (const std::string& name)
+            { return [&order, &orderMutex, name] () { std::lock_guard<std::mutex> lg(orderMutex); order.push_back(name); }; };
+        auto a = loader.push(record("a"), [] () {});
+        auto b = loader.push(record("b"), [&cancelled] () { cancelled = true; });
+        auto c = loader.push(record("c"), [] () {});
+        loader.prioritize(c, ungod::AssetLoader::VISIBLE_PRIORITY);
+        BOOST_CHECK(b->cancel());
+        BOOST_CHECK(cancelled);
+        BOOST_CHECK(!b->execute());
+        gate.set_value();
+        while (loader.getQueueSize() > 0)
+            std::this_thread::yield();
+    }
+    BOOST_REQUIRE_EQUAL(order.size(), 2u);
+    BOOST_CHECK_EQUAL(order[0], "c");
+    BOOST_CHECK_EQUAL(order[1], "a");
+
+    //many async loads share the workers of the manager
+    ungod::AssetManager& manager = EmbeddedTestApp::getApp().getAssetManager();
+    {
+        std::vector<ungod::Image> images;
+        for (unsigned i = 0; i < 50; i++)
+            images.emplace_back(i % 2 == 0 ? "test_data/test_sheet.png" : "test_data/blech_warrior.png", ungod::LoadPolicy::ASYNC);
+        images.back().prioritize();
+        for (const auto& img : images)
+            BOOST_CHECK(img.getWait().getSize().x > 0);
+        BOOST_CHECK(manager.getLoader().getThreadCount() <= ungod::AssetLoader::DEFAULT_THREADS);
+    }
+    manager.update();
+    BOOST_CHECK_EQUAL(manager.getLoader().getQueueSize(), 0u);
+}
+
 BOOST_AUTO_TEST_CASE(world_extend_test)
 {
     ungod::ScriptedGameState state(EmbeddedTestApp::getApp(), 0);
@@ -1,8 +1,10 @@
 #include <boost/test/unit_test.hpp>
 #include "ungod/content/tilemap/TileMap.h"
+#include "ungod/content/tilemap/TileStorage.h"
 #include "ungod/content/tilemap/FloodFill.h"
 #include "ungod/content/tilemap/TilemapBrush.h"
 #include "ungod/base/World.h"
+#include "ungod/application/Application.h"
 #include "ungod/test/mainTest.h"
 #include <boost/filesystem.hpp>
 
@@ -60,7 +62,10 @@ BOOST_AUTO_TEST_CASE( tilemap_test )
 
     BOOST_CHECK_EQUAL(tilemap.getTileID(sf::Vector2f{50,50}), 3);
 
+    tilemap.setViewSize({800, 600});
+
     {  //test correct output with the default view
+        tilemap.update({0, 0});
         tilemap.render(rendertex, &tex.get(), {});
 
         sf::Image result = rendertex.getTexture().copyToImage();
@@ -77,6 +82,7 @@ BOOST_AUTO_TEST_CASE( tilemap_test )
         view.move(32,0);
         rendertex.setView(view);
 
+        tilemap.update({32, 0});
         tilemap.render(rendertex, &tex.get(), {});
 
         sf::Image result = rendertex.getTexture().copyToImage();
@@ -118,6 +124,82 @@ BOOST_AUTO_TEST_CASE( tilemap_brush_test )
     BOOST_CHECK_EQUAL( tilemap.getTileID(2,3), 12 );
 }
 
+BOOST_AUTO_TEST_CASE( tile_storage_test )
+{
+    const unsigned sizeX = 100;
+    const unsigned sizeY = 70;
+    std::vector<int> ids(sizeX*sizeY, 0);
+    for (unsigned i = 0; i < ids.size(); ++i)
+        ids[i] = (i / 500) % 3;
+
+    ungod::TileStorage storage;
+    BOOST_CHECK(!storage.assign(ids, sizeX, sizeY+1));
+    BOOST_CHECK(!storage.assign({ -2 }, 1, 1));
+    BOOST_REQUIRE(storage.assign(ids, sizeX, sizeY));
+    BOOST_CHECK(storage.toVector() == ids);
+
+    //random access writes, forcing some blocks to widen their palette beyond 8 bit
+    for (unsigned i = 0; i < 4000; ++i)
+    {
+        unsigned x = (i * 7) % sizeX;
+        unsigned y = (i * 13) % sizeY;
+        int id = i < 2000 ? (int)(i % 300) - 1 : 65534 - (int)(i % 3);
+        BOOST_REQUIRE(storage.set(x, y, id));
+        ids[x * sizeY + y] = id;
+    }
+    BOOST_CHECK(!storage.set(sizeX, 0, 1));
+    BOOST_CHECK(!storage.set(0, 0, 65535));
+    BOOST_CHECK_EQUAL(storage.get(sizeX, 0), -1);
+    BOOST_CHECK(storage.toVector() == ids);
+
+    std::size_t runLength = 0;
+    storage.forEachRun([&runLength] (int, std::size_t count) { runLength += count; });
+    BOOST_CHECK_EQUAL(runLength, ids.size());
+
+    //a large map with few tile types
+    std::vector<int> world(1024*1024, 0);
+    for (unsigned i = 0; i < world.size(); ++i)
+        world[i] = (i % 1024) < 700 ? 0 : (int)(i % 5);
+    BOOST_REQUIRE(storage.assign(world, 1024, 1024));
+    ungod::Logger::info("Tile storage:", storage.getMemoryUsage(), "bytes compared to", world.size()*sizeof(int), "bytes uncompressed");
+    BOOST_CHECK(storage.getMemoryUsage() * 8 < world.size()*sizeof(int));
+}
+
+BOOST_AUTO_TEST_CASE( tilemap_chunk_benchmark )
+{
+    const unsigned mapsize = 4096;
+    ungod::TileMap tilemap;
+    ungod::MetaMap meta{ "test_data/ground.xml" };
+    tilemap.setMetaMap(meta);
+    tilemap.setTileDims(128, 128, {"purple_stone", "brown_stone", "brown_stone_iso",
+                                    "brown_stone_pathend_down", "brown_stone_pathend_up", "brown_stone_pathend_left", "brown_stone_pathend_right",
+                                    "brown_stone_pathcurve_1", "brown_stone_pathcurve_2", "brown_stone_pathcurve_3", "brown_stone_pathcurve_4",
+                                    "brown_stone_corner_1", "brown_stone_corner_2", "brown_stone_corner_3", "brown_stone_corner_4"});
+    ungod::TileData tiledata;
+    tiledata.ids = std::make_shared<std::vector<int>>((std::size_t)mapsize * mapsize, 0);
+    tilemap.setTiles(tiledata, mapsize, mapsize);
+    tilemap.setViewSize({1920, 1080});
+
+    sf::Clock clock;
+    //scroll diagonally over the map, half a tile per frame
+    for (unsigned i = 0; i < 5000; ++i)
+        BOOST_REQUIRE(tilemap.update({ i*64.0f, i*32.0f }));
+    ungod::Logger::info("Tilemap scrolling:", clock.restart().asMicroseconds() / 5000.0f, "microseconds per frame");
+
+    //paint with a brush inside the visible area, update once per stroke
+    ungod::TilemapBrush brush("brown_stone", tilemap);
+    sf::Vector2f windowPos{ 2000*128.0f, 2000*128.0f };
+    for (unsigned i = 0; i < 5000; ++i)
+    {
+        brush.paintTile(2000 + i % 15, 2000 + (i / 15) % 8);
+        tilemap.update(windowPos);
+    }
+    ungod::Logger::info("Tilemap brush painting:", clock.restart().asMicroseconds() / 5000.0f, "microseconds per stroke");
+
+    BOOST_CHECK(tilemap.getTileID(2005, 2005) != 0);
+    BOOST_CHECK_EQUAL(tilemap.getTileID(1990, 1990), 0);
+}
+
 BOOST_AUTO_TEST_CASE( floodfill_test )
 {
     {
@@ -139,6 +221,60 @@ BOOST_AUTO_TEST_CASE( floodfill_test )
         BOOST_CHECK_EQUAL(1, tilemap.getTileID(0,0));
         BOOST_CHECK_EQUAL(1, tilemap.getTileID(3,2));
     }
+    {
+        ungod::TileMap tilemap;
+        ungod::TileData tiledata;
+        //a wall of 2s separates the first two columns, the bottom tile of the middle column touches the first column diagonally
+        tiledata.ids = std::make_shared<std::vector<int>>(std::initializer_list<int>{ 0,0,0,2,
+                                                                                      2,2,2,0,
+                                                                                      0,0,0,0 });
+        tilemap.setTiles(tiledata, 3, 4);
+
+        ungod::TileChangeSet changes = ungod::floodFill(tilemap, 0, 0, {1});
+
+        BOOST_CHECK_EQUAL(1, tilemap.getTileID(0,2));
+        BOOST_CHECK_EQUAL(1, tilemap.getTileID(1,3));
+        BOOST_CHECK_EQUAL(1, tilemap.getTileID(2,0));
+        BOOST_CHECK_EQUAL(2, tilemap.getTileID(1,0));
+        BOOST_CHECK_EQUAL(2, tilemap.getTileID(0,3));
+        BOOST_CHECK_EQUAL(changes.runs.size(), 3u);
+
+        tilemap.applyChanges(changes, true);
+        BOOST_CHECK_EQUAL(0, tilemap.getTileID(0,2));
+        BOOST_CHECK_EQUAL(0, tilemap.getTileID(1,3));
+        BOOST_CHECK_EQUAL(0, tilemap.getTileID(2,0));
+
+        tilemap.applyChanges(changes);
+        BOOST_CHECK_EQUAL(1, tilemap.getTileID(2,3));
+
+        BOOST_CHECK(ungod::floodFill(tilemap, 5, 5, {1}).empty());
+        BOOST_CHECK(ungod::floodFill(tilemap, 0, 0, {1}).empty());
+    }
+}
+
+BOOST_AUTO_TEST_CASE( floodfill_benchmark )
+{
+    const unsigned mapsize = 2048;
+    ungod::TileMap tilemap;
+    ungod::TileData tiledata;
+    tiledata.ids = std::make_shared<std::vector<int>>((std::size_t)mapsize * mapsize, 0);
+    tilemap.setTiles(tiledata, mapsize, mapsize);
+
+    sf::Clock clock;
+    ungod::TileChangeSet changes = ungod::floodFill(tilemap, mapsize / 2, mapsize / 2, {1});
+    ungod::Logger::info("Flood filling a", mapsize, "x", mapsize, "region took", clock.restart().asMilliseconds(), "ms");
+
+    BOOST_CHECK_EQUAL(changes.runs.size(), mapsize);
+    BOOST_CHECK_EQUAL(tilemap.getTileID(0, 0), 1);
+    BOOST_CHECK_EQUAL(tilemap.getTileID(mapsize - 1, mapsize - 1), 1);
+
+    tilemap.applyChanges(changes, true);
+    ungod::Logger::info("Reverting the flood fill took", clock.restart().asMilliseconds(), "ms");
+    BOOST_CHECK_EQUAL(tilemap.getTileID(mapsize / 3, mapsize / 5), 0);
+
+    changes = ungod::floodFill(tilemap, 0, 0, {1, 2, 3});
+    ungod::Logger::info("Flood filling with random replacements took", clock.restart().asMilliseconds(), "ms");
+    BOOST_CHECK(tilemap.getTileID(mapsize / 3, mapsize / 5) > 0);
 }
 
 BOOST_AUTO_TEST_CASE(tilemap_extend_test)
@@ -164,5 +300,81 @@ BOOST_AUTO_TEST_CASE(tilemap_extend_test)
     BOOST_CHECK_EQUAL(0, tilemap.getTileID(3, 2));
 }
 
+BOOST_AUTO_TEST_CASE(reflection_invalidation_test)
+{
+    ungod::ScriptedGameState state(EmbeddedTestApp::getApp(), 0);
+    ungod::WorldGraphNode& node = state.getWorldGraph().createNode(state, "nodeid", "nodefile");
+    node.setSaveContents(false); //do not serialize any changes we make to this node
+    node.setSize({ 5000,5000 });
+    ungod::World* world = node.addWorld();
+    ungod::WaterHandler& handler = world->getWaterHandler();
+    ungod::Entity e1 = world->create(ungod::BaseComponents<ungod::TransformComponent>(), ungod::OptionalComponents<>());
+    ungod::Entity e2 = world->create(ungod::BaseComponents<ungod::TransformComponent>(), ungod::OptionalComponents<>());
+    world->getTransformHandler().setPosition(e1, { 100,100 });
+    world->getTransformHandler().setPosition(e2, { 4000,4000 });
+
+    sf::FloatRect area{ 0, 0, 500, 500 };
+    unsigned revision = handler.getReflectionRevision();
+
+    //an unrelated entity moves far away from the reflected area
+    world->getTransformHandler().move(e2, { 10,10 });
+    BOOST_CHECK(handler.getReflectionRevision() > revision);
+    BOOST_CHECK(!handler.reflectionsChanged(revision, area));
+
+    //an entity moves inside of the reflected area
+    world->getTransformHandler().move(e1, { 10,10 });
+    BOOST_CHECK(handler.reflectionsChanged(revision, area));
+
+    //removing an entity outdates all reflections
+    revision = handler.getReflectionRevision();
+    BOOST_CHECK(!handler.reflectionsChanged(revision, area));
+    world->destroy(e2);
+    world->update(20.0f, {}, {});
+    BOOST_CHECK(handler.reflectionsChanged(revision, area));
+
+    world->destroy(e1);
+    world->update(20.0f, {}, {});
+}
+
+BOOST_AUTO_TEST_CASE(shared_distortion_texture_test)
+{
+    ungod::ScriptedGameState state(EmbeddedTestApp::getApp(), 0);
+    ungod::WorldGraphNode& node = state.getWorldGraph().createNode(state, "nodeid", "nodefile");
+    node.setSaveContents(false); //do not serialize any changes we make to this node
+    node.setSize({ 800,600 });
+    ungod::World* world = node.addWorld();
+    ungod::WaterHandler& handler = world->getWaterHandler();
+    ungod::Entity e1 = world->create(ungod::BaseComponents<ungod::TransformComponent, ungod::WaterComponent>(), ungod::OptionalComponents<>());
+    ungod::Entity e2 = world->create(ungod::BaseComponents<ungod::TransformComponent, ungod::WaterComponent>(), ungod::OptionalComponents<>());
+    ungod::Entity e3 = world->create(ungod::BaseComponents<ungod::TransformComponent, ungod::WaterComponent>(), ungod::OptionalComponents<>());
+    handler.targetSizeChanged(*world, { 64,64 });
+    handler.initWater(e1, "test_data/test.png", "", "");
+    handler.initWater(e2, "test_data/test.png", "", "");
+    handler.initWater(e3, "test_data/test_sheet.png", "", "");
+    for (ungod::Entity e : { e1, e2, e3 })
+        handler.setWaterShaders(e, true);
+    handler.update({ e1, e2, e3 }, state.getWorldGraph().getCamera());
+
+    //water bodies with the same map share one texture of the target size
+    const sf::Texture* texture = e1.get<ungod::WaterComponent>().getWater().getDistortionTexture();
+    BOOST_REQUIRE(texture);
+    BOOST_CHECK_EQUAL(texture, e2.get<ungod::WaterComponent>().getWater().getDistortionTexture());
+    BOOST_CHECK(e3.get<ungod::WaterComponent>().getWater().getDistortionTexture());
+    BOOST_CHECK(texture != e3.get<ungod::WaterComponent>().getWater().getDistortionTexture());
+    BOOST_CHECK_EQUAL(texture->getSize().x, 64u);
+    BOOST_CHECK_EQUAL(texture->getSize().y, 64u);
+
+    //a resize rebuilds the shared texture once, the water bodies keep pointing to it
+    handler.targetSizeChanged(*world, { 128,96 });
+    BOOST_CHECK_EQUAL(texture, e1.get<ungod::WaterComponent>().getWater().getDistortionTexture());
+    BOOST_CHECK_EQUAL(texture, e2.get<ungod::WaterComponent>().getWater().getDistortionTexture());
+    BOOST_CHECK_EQUAL(texture->getSize().x, 128u);
+    BOOST_CHECK_EQUAL(texture->getSize().y, 96u);
+
+    for (ungod::Entity e : { e1, e2, e3 })
+        world->destroy(e);
+    world->update(20.0f, {}, {});
+}
+
 
 BOOST_AUTO_TEST_SUITE_END()
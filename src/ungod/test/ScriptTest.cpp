@@ -8,6 +8,10 @@
 #include "ungod/test/mainTest.h"
 #include "ungod/serialization/DeserialInit.h"
 #include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <boost/filesystem.hpp>
 #include <thread>
 #include "ungod/test/mainTest.h"
 
@@ -404,4 +408,345 @@ BOOST_AUTO_TEST_CASE(parameter_serial_test)
         BOOST_REQUIRE(var_4->get<int>(1) == 110);
         BOOST_REQUIRE(var_4->get<std::string>(3) == "wuff");
     }
-}
\ No newline at end of file
+}
+
+BOOST_AUTO_TEST_CASE(bytecode_cache_test)
+{
+    using namespace ungod;
+    const unsigned numScripts = 200;
+    const std::string cacheDir = "test_output/script_cache";
+    const std::string previousCache = Script::getBytecodeCache();
+    boost::filesystem::remove_all(cacheDir);
+    boost::filesystem::create_directories("test_output/scripts");
+
+    //generate a bunch of behavior-sized scripts
+    std::vector<std::string> files;
+    for (unsigned i = 0; i < numScripts; ++i)
+    {
+        files.emplace_back("test_output/scripts/generated_" + std::to_string(i) + ".lua");
+        std::ofstream out(files.back());
+        out << "generated_" << i << " = {}\n";
+        for (unsigned j = 0; j < 100; ++j)
+            out << "function generated_" << i << ".f" << j << "(static, instance, x)\n"
+                << "    local t = {}\n    for k = 1, x do t[k] = k * " << j << " + instance.value end\n    return #t\nend\n";
+        out << "generated_" << i << ".result = " << i << "\n";
+    }
+
+    auto loadAll = [&files]()
+    {
+        script::State state;
+        sf::Clock clock;
+        for (unsigned i = 0; i < files.size(); ++i)
+        {
+            Script script(files[i], script::StateRef(state));
+            BOOST_REQUIRE(script.isValid());
+            BOOST_REQUIRE(script.run());
+            BOOST_CHECK_EQUAL(state["generated_" + std::to_string(i)]["result"].get<int>(), (int)i);
+        }
+        return clock.getElapsedTime().asMicroseconds();
+    };
+
+    //mirrors the cache file layout of Script.cpp
+    struct CacheHeader
+    {
+        char magic[8];
+        uint64_t sourceHash;
+        int32_t luaVersion;
+        uint32_t pointerSize;
+    };
+    auto readFile = [](const std::string& path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        return std::string{ std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
+    };
+    auto fnv1a = [](const std::string& data)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (unsigned char c : data)
+        {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    };
+    auto cachePath = [&fnv1a, &cacheDir](const std::string& file)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.luac",
+            (unsigned long long)fnv1a(boost::filesystem::absolute(file).generic_string()));
+        return (boost::filesystem::path(cacheDir) / name).string();
+    };
+    auto checkHeader = [&](const std::string& file)
+    {
+        std::string cached = readFile(cachePath(file));
+        BOOST_REQUIRE_GT(cached.size(), sizeof(CacheHeader));
+        CacheHeader header;
+        std::memcpy(&header, cached.data(), sizeof(header));
+        BOOST_CHECK_EQUAL(std::string(header.magic, sizeof(header.magic)), "ungodlc1");
+        BOOST_CHECK_EQUAL(header.sourceHash, fnv1a(readFile(file)));
+        BOOST_CHECK_EQUAL(header.luaVersion, LUA_VERSION_NUM);
+        BOOST_CHECK_EQUAL(header.pointerSize, sizeof(void*));
+    };
+
+    Script::setBytecodeCache("");
+    auto sourceTime = loadAll();
+    BOOST_CHECK(!boost::filesystem::exists(cacheDir));
+    Script::setBytecodeCache(cacheDir);
+    auto fillTime = loadAll();
+
+    //exactly one complete cache file per script, no leftover temporaries
+    unsigned numCached = 0;
+    for (auto it = boost::filesystem::directory_iterator(cacheDir); it != boost::filesystem::directory_iterator(); ++it)
+    {
+        BOOST_CHECK_EQUAL(it->path().extension().string(), ".luac");
+        ++numCached;
+    }
+    BOOST_CHECK_EQUAL(numCached, numScripts);
+    std::vector<std::string> cacheContents;
+    for (const auto& file : files)
+    {
+        checkHeader(file);
+        cacheContents.emplace_back(readFile(cachePath(file)));
+    }
+
+    auto cachedTime = loadAll();
+    Logger::info("Loading", numScripts, "scripts from source:", sourceTime, "us, filling the cache:", fillTime, "us, from cache:", cachedTime, "us");
+    for (unsigned i = 0; i < files.size(); ++i)
+        BOOST_CHECK(readFile(cachePath(files[i])) == cacheContents[i]);
+
+    //a valid cache file is loaded instead of the source: serve the bytecode of script 2
+    //under the header of script 1 and observe that script 2 is what runs
+    {
+        std::string swapped = cacheContents[1].substr(0, sizeof(CacheHeader)) + cacheContents[2].substr(sizeof(CacheHeader));
+        std::ofstream out(cachePath(files[1]), std::ios::binary | std::ios::trunc);
+        out.write(swapped.data(), swapped.size());
+    }
+    {
+        script::State state;
+        Script script(files[1], script::StateRef(state));
+        BOOST_REQUIRE(script.run());
+        BOOST_CHECK_EQUAL(state["generated_2"]["result"].get<int>(), 2);
+        BOOST_CHECK(!state["generated_1"].valid());
+    }
+
+    //a changed script with the same path must not be served from the outdated cache, but recompiled
+    {
+        std::ofstream out(files[0]);
+        out << "generated_0 = { result = 42 }\n";
+    }
+    {
+        script::State state;
+        Script script(files[0], script::StateRef(state));
+        BOOST_REQUIRE(script.run());
+        BOOST_CHECK_EQUAL(state["generated_0"]["result"].get<int>(), 42);
+    }
+    checkHeader(files[0]);
+    BOOST_CHECK(readFile(cachePath(files[0])) != cacheContents[0]);
+
+    //a corrupted cache falls back to the source
+    for (auto it = boost::filesystem::directory_iterator(cacheDir); it != boost::filesystem::directory_iterator(); ++it)
+    {
+        std::fstream out(it->path().string(), std::ios::in | std::ios::out | std::ios::binary);
+        out.seekp(24); //overwrite the signature of the lua chunk behind our header
+        out.write("garbage", 7);
+    }
+    {
+        script::State state;
+        Script script(files[1], script::StateRef(state));
+        BOOST_REQUIRE(script.run());
+        BOOST_CHECK_EQUAL(state["generated_1"]["result"].get<int>(), 1);
+    }
+
+    Script::setBytecodeCache(previousCache);
+}
+
+BOOST_AUTO_TEST_CASE(event_scheduler_test)
+{
+    using namespace ungod;
+    script::SharedState state = std::make_shared<script::State>();
+    script::EventScheduler scheduler;
+    std::vector<int> received;
+    auto link = scheduler.addListener([&received](const CustomEvent& evt)
+        {
+            received.push_back(evt.get<script::Environment>("data").get<int>("val"));
+        });
+
+    //immediately dispatched events reuse the same table
+    for (int i = 0; i < 1000; ++i)
+        scheduler.emit(state, "tick", state->create_table_with("val", i));
+    BOOST_REQUIRE_EQUAL(received.size(), 1000u);
+    BOOST_CHECK_EQUAL(received.back(), 999);
+    BOOST_CHECK_EQUAL(scheduler.getEventPool().getAllocated(), 1u);
+    BOOST_CHECK_EQUAL(scheduler.getEventPool().getPoolSize(), 1u);
+
+    //events that are not emitted through the pool stay intact after their dispatch
+    CustomEvent kept;
+    auto keepLink = scheduler.addListener([&kept](const CustomEvent& evt) { kept = evt; });
+    scheduler.handleCustomEvent(makeCustomEvent(state, "kept", 0.0f, "val", 7));
+    keepLink.disconnect();
+    BOOST_CHECK_EQUAL(kept.get<std::string>("type"), "kept");
+    BOOST_CHECK_EQUAL(kept.get<script::Environment>("data").get<int>("val"), 7);
+    BOOST_CHECK_EQUAL(scheduler.getEventPool().getPoolSize(), 1u);
+
+    //delayed events are dispatched ordered by time, events emitted with equal delay keep their order
+    received.clear();
+    scheduler.emit(state, "late", state->create_table_with("val", 3), 0.05f);
+    for (int i = 0; i < 3; ++i)
+        scheduler.emit(state, "early", state->create_table_with("val", i), 0.01f);
+    BOOST_CHECK_EQUAL(scheduler.getDelayedEventCount(), 4u);
+    scheduler.dispatchDelayed();
+    BOOST_CHECK(received.empty());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    scheduler.dispatchDelayed();
+    BOOST_CHECK_EQUAL(scheduler.getDelayedEventCount(), 0u);
+    BOOST_CHECK((received == std::vector<int>{ 0, 1, 2, 3 }));
+    BOOST_CHECK_EQUAL(scheduler.getEventPool().getPoolSize(), 4u);
+}
+
+BOOST_AUTO_TEST_CASE(gc_pacing_test)
+{
+    using namespace ungod;
+    Application& app = EmbeddedTestApp::getApp();
+    lua_State* L = app.getScriptState()->lua_state();
+    auto memory = [L]() { return (std::size_t)lua_gc(L, LUA_GCCOUNT, 0); }; //in KB
+    auto produceGarbage = [&app]() { app.getScriptState()->script("local t = {} for i = 1, 100000 do t[i] = { i } end"); };
+
+    app.setScriptGCPaced(true, 1024u * 1024u * 1024u);
+    lua_gc(L, LUA_GCCOLLECT, 0);
+    unsigned emergencies = app.getScriptStats().emergencyCollections;
+
+    //the stopped collector leaves all garbage alone
+    std::size_t before = memory();
+    produceGarbage();
+    std::size_t garbage = memory() - before;
+    BOOST_REQUIRE(garbage > 1024u);
+    produceGarbage();
+    produceGarbage();
+    BOOST_CHECK(memory() - before >= 3 * garbage * 9 / 10);
+
+    //above the threshold, collectScriptGarbage completes a cycle step by step
+    std::size_t peak = memory();
+    for (int i = 0; i < 100000 && memory() > peak / 2; ++i)
+        app.collectScriptGarbage();
+    BOOST_CHECK(memory() <= peak / 2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    BOOST_REQUIRE(app.update());
+    BOOST_CHECK(app.getScriptStats().gcSteps > 0u);
+    BOOST_CHECK_EQUAL(app.getScriptStats().emergencyCollections, emergencies);
+
+    //the steps do not restart the automatic collector
+    before = memory();
+    produceGarbage();
+    produceGarbage();
+    produceGarbage();
+    BOOST_CHECK(memory() - before >= 3 * garbage * 9 / 10);
+
+    //exceeding the memory ceiling forces a full collection
+    app.setScriptGCPaced(true, 1024u);
+    peak = memory();
+    app.collectScriptGarbage();
+    BOOST_CHECK_EQUAL(app.getScriptStats().emergencyCollections, emergencies + 1);
+    BOOST_CHECK(memory() < peak - 2 * garbage);
+
+    app.setScriptGCPaced(false, 512u * 1024u * 1024u);
+}
+
+BOOST_AUTO_TEST_CASE(update_timer_test)
+{
+    using namespace ungod;
+    ScriptedGameState state(EmbeddedTestApp::getApp(), 0);
+    WorldGraphNode& node = state.getWorldGraph().createNode(state, "nodeid", "nodefile");
+    node.setSize({ 15000, 15000 });
+    World* world = node.addWorld();
+    state.getEntityBehaviorManager().loadBehaviorScript("test_data/update_single.lua");
+    Entity e = world->create(BaseComponents<TransformComponent, EntityBehaviorComponent, EntityUpdateTimer>(), "update_single");
+    Entity outside = world->create(BaseComponents<TransformComponent, EntityBehaviorComponent, EntityUpdateTimer>(), "update_single");
+    world->getTransformHandler().setPosition(outside, { 5000,5000 });
+    world->addEntity(e);
+    world->addEntity(outside);
+    world->getBehaviorHandler().setUpdateInterval(e, 100.0f);
+    quad::Bounds area{ 0, 0, 800, 600 };
+
+    //first update on the next tick, then once every 100 milliseconds
+    for (unsigned i = 0; i < 10; ++i)
+        world->getBehaviorHandler().update(20.0f, area);
+    BOOST_CHECK_EQUAL(*e.get<EntityBehaviorComponent>().getStateVariable<int>("updates"), 2);
+    BOOST_CHECK_EQUAL(*outside.get<EntityBehaviorComponent>().getStateVariable<int>("updates"), 0);
+
+    //the last update is longer ago than the new interval, so the entity is due immediately
+    world->getBehaviorHandler().setUpdateInterval(e, 20.0f);
+    for (unsigned i = 0; i < 5; ++i)
+        world->getBehaviorHandler().update(20.0f, area);
+    BOOST_CHECK_EQUAL(*e.get<EntityBehaviorComponent>().getStateVariable<int>("updates"), 7);
+}
+
+BOOST_AUTO_TEST_CASE(update_timer_copy_test)
+{
+    using namespace ungod;
+    ScriptedGameState state(EmbeddedTestApp::getApp(), 0);
+    WorldGraphNode& node = state.getWorldGraph().createNode(state, "nodeid", "nodefile");
+    node.setSaveContents(false);
+    node.setSize({ 15000, 15000 });
+    World* world = node.addWorld();
+    World* other = node.addWorld();
+    state.getEntityBehaviorManager().loadBehaviorScript("test_data/update_single.lua");
+    quad::Bounds area{ 0, 0, 800, 600 };
+
+    //the source stays outside of the update area, so that only the copy is updated
+    Entity e = world->create(BaseComponents<TransformComponent, EntityBehaviorComponent, EntityUpdateTimer>(), "update_single");
+    world->getTransformHandler().setPosition(e, { 5000,5000 });
+    world->addEntity(e);
+    world->getBehaviorHandler().setUpdateInterval(e, 100.0f);
+    for (unsigned i = 0; i < 3; ++i)
+        world->getBehaviorHandler().update(20.0f, area);
+    Entity cpy = world->makeCopy(e);
+    world->getTransformHandler().setPosition(cpy, { 100,100 });
+    world->addEntity(cpy);
+    for (unsigned i = 0; i < 10; ++i)
+        world->getBehaviorHandler().update(20.0f, area);
+    BOOST_CHECK_EQUAL(*cpy.get<EntityBehaviorComponent>().getStateVariable<int>("updates"), 2);
+
+    //an entity that moves to another world is updated there, its behavior is initialized again
+    Entity moved = other->accomodateForeign(cpy);
+    for (unsigned i = 0; i < 10; ++i)
+        other->getBehaviorHandler().update(20.0f, area);
+    BOOST_CHECK_EQUAL(*moved.get<EntityBehaviorComponent>().getStateVariable<int>("updates"), 2);
+}
+
+BOOST_AUTO_TEST_CASE(batch_update_benchmark)
+{
+    using namespace ungod;
+    const unsigned numEntities = 3000;
+    const unsigned numUpdates = 100;
+    ScriptedGameState state(EmbeddedTestApp::getApp(), 0);
+    WorldGraphNode& node = state.getWorldGraph().createNode(state, "nodeid", "nodefile");
+    node.setSize({ 15000, 15000 });
+    state.getEntityBehaviorManager().loadBehaviorScript("test_data/update_single.lua");
+    state.getEntityBehaviorManager().loadBehaviorScript("test_data/update_batch.lua");
+    quad::Bounds area{ 0, 0, 800, 600 };
+
+    for (const std::string script : { "update_single", "update_batch" })
+    {
+        World* world = node.addWorld();
+        std::list<Entity> entities;
+        for (unsigned i = 0; i < numEntities; ++i)
+        {
+            Entity e = world->create(BaseComponents<TransformComponent, EntityBehaviorComponent, EntityUpdateTimer>(), script);
+            world->getBehaviorHandler().setUpdateInterval(e, 0.0f);
+            world->addEntity(e);
+            entities.push_back(e);
+        }
+
+        sf::Clock clock;
+        for (unsigned i = 0; i < numUpdates; ++i)
+            world->getBehaviorHandler().update(20.0f, area);
+        Logger::info("Behavior update", script, ":", clock.restart().asMicroseconds() / (float)numUpdates, "microseconds for", numEntities, "entities");
+
+        for (const auto& e : entities)
+        {
+            auto updates = e.get<EntityBehaviorComponent>().getStateVariable<int>("updates");
+            BOOST_REQUIRE(updates);
+            BOOST_CHECK_EQUAL(*updates, (int)numUpdates);
+        }
+    }
+}
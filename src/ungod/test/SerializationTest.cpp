@@ -78,6 +78,34 @@ BOOST_AUTO_TEST_CASE( serializsation_test )
         BOOST_CHECK_EQUAL(tilemap.getTileID(2,2), 2);
     }
 
+    //large uniform areas are stored run-length encoded
+    {
+        ungod::TileMap tilemap;
+        ungod::MetaMap meta{ "tilemap_tiles.xml" };
+        tilemap.setMetaMap(meta);
+        tilemap.setTileDims(128, 128, { "planks", "stones", "dirt", "grass" });
+        ungod::TileData tiledata;
+        tiledata.ids = std::make_shared<std::vector<int>>(64*48, 3);
+        tilemap.setTiles(tiledata, 64, 48);
+        tilemap.setTile(-1, 0, 0);
+        tilemap.setTile(1, 40, 20);
+        ungod::SerializationContext context;
+        context.serializeRootObject(tilemap);
+        context.save("test_output/tilemap_rle_sav.xml");
+    }
+    {
+        ungod::TileMap tilemap;
+        ungod::DeserializationContext context;
+        context.read("test_output/tilemap_rle_sav.xml");
+        context.deserializeRootObject(tilemap);
+
+        BOOST_REQUIRE_EQUAL(tilemap.getMapSizeX(), 64u);
+        BOOST_REQUIRE_EQUAL(tilemap.getMapSizeY(), 48u);
+        BOOST_CHECK_EQUAL(tilemap.getTileID(0,0), -1);
+        BOOST_CHECK_EQUAL(tilemap.getTileID(40,20), 1);
+        BOOST_CHECK_EQUAL(tilemap.getTileID(63,47), 3);
+    }
+
     //serialize world
     {
         sf::RenderWindow window;
@@ -1,6 +1,8 @@
 #include <boost/test/unit_test.hpp>
 #include "ungod/base/World.h"
 #include "ungod/application/Application.h"
+#include "ungod/audio/AudioStreamer.h"
+#include "ungod/test/mainTest.h"
 
 BOOST_AUTO_TEST_SUITE(AudioTest)
 
@@ -109,4 +111,105 @@ BOOST_AUTO_TEST_CASE( sound_test )
     } */
 }
 
+BOOST_AUTO_TEST_CASE( music_emitter_grid_test )
+{
+    using namespace ungod;
+    ScriptedGameState state(EmbeddedTestApp::getApp(), 0);
+    WorldGraphNode& node = state.getWorldGraph().createNode(state, "nodeid", "nodefile");
+    node.setSaveContents(false);
+    node.setSize({ 8000, 8000 });
+    World* world = node.addWorld();
+
+    Entity e = world->create(AudioEmitterBaseComponents(), AudioEmitterOptionalComponents());
+    world->getTransformHandler().setPosition(e, { 100, 100 });
+    BOOST_CHECK_EQUAL(world->getMusicEmitterMixer().getEmitterCount(), 0u); //not yet in the world
+
+    world->addEntity(e);
+    BOOST_CHECK_EQUAL(world->getMusicEmitterMixer().getEmitterCount(), 1u);
+
+    world->getTransformHandler().setPosition(e, { 7000, 7000 });
+    world->update(20.0f, { 0, 0 }, { 800, 600 });
+    BOOST_CHECK_EQUAL(world->getMusicEmitterMixer().getEmitterCount(), 1u);
+
+    world->destroy(e);
+    world->update(20.0f, { 0, 0 }, { 800, 600 });
+    BOOST_CHECK_EQUAL(world->getMusicEmitterMixer().getEmitterCount(), 0u);
+}
+
+namespace
+{
+    /** \brief Generates a stereo ramp, so that the continuity of the streamed samples can be checked. */
+    class RampSource : public ungod::SampleSource
+    {
+    public:
+        RampSource(std::size_t length) : mLength(length), mPos(0) {}
+        virtual bool open() override { return true; }
+        virtual unsigned getChannelCount() const override { return 2; }
+        virtual unsigned getSampleRate() const override { return 44100; }
+        virtual std::size_t read(sf::Int16* samples, std::size_t maxCount) override
+        {
+            std::size_t count = 0;
+            while (count < maxCount && mPos < mLength)
+                samples[count++] = (sf::Int16)(mPos++ % 1000);
+            return count;
+        }
+        virtual void restart() override { mPos = 0; }
+    private:
+        std::size_t mLength;
+        std::size_t mPos;
+    };
+}
+
+BOOST_AUTO_TEST_CASE( audio_streamer_test )
+{
+    using namespace ungod;
+    //no decoder thread, process is called by hand and the test reads the samples like a null audio device
+    AudioStreamer streamer(2, false);
+    auto looping = streamer.createStream(std::unique_ptr<SampleSource>(new RampSource(100000)), true);
+    auto once = streamer.createStream(std::unique_ptr<SampleSource>(new RampSource(1000)), false);
+    auto starved = streamer.createStream(std::unique_ptr<SampleSource>(new RampSource(100000)), true);
+    auto missing = streamer.createStream("test_data/no_such_music.ogg");
+
+    streamer.prebuffer(*looping);
+    streamer.prebuffer(*once);
+    streamer.prebuffer(*starved);
+    streamer.prebuffer(*missing);
+    streamer.process();
+
+    BOOST_REQUIRE(looping->isReady());
+    BOOST_CHECK_EQUAL(looping->getBufferedSamples(), AudioStreamer::BUFFER_SAMPLES);
+    BOOST_CHECK_EQUAL(once->getBufferedSamples(), 1000u);
+    BOOST_CHECK(!starved->isBuffered()); //pool of 2 buffers is exhausted
+    BOOST_CHECK_EQUAL(streamer.getPoolExhaustions(), 1u);
+    BOOST_CHECK(missing->hasFailed());
+
+    //a device consuming 100 milliseconds per tick
+    std::vector<sf::Int16> chunk(4410);
+    BOOST_CHECK_EQUAL(streamer.read(*looping, chunk.data(), chunk.size()), chunk.size());
+    BOOST_CHECK_EQUAL(chunk[999], 999);
+    BOOST_CHECK_EQUAL(chunk[1000], 0);
+    BOOST_CHECK_EQUAL(streamer.read(*once, chunk.data(), chunk.size()), 1000u);
+    BOOST_CHECK(once->isFinished());
+    BOOST_CHECK_EQUAL(streamer.getUnderruns(), 0u); //the end of a stream is no underrun
+
+    //without decoding, the device drains the ring and underruns
+    for (unsigned i = 0; i < 10; ++i)
+        streamer.read(*looping, chunk.data(), chunk.size());
+    BOOST_CHECK_EQUAL(looping->getUnderruns(), 1u);
+    streamer.process();
+    BOOST_CHECK_EQUAL(looping->getBufferedSamples(), AudioStreamer::BUFFER_SAMPLES);
+
+    //released buffers go to the waiting stream
+    streamer.release(*once);
+    streamer.process();
+    streamer.process();
+    BOOST_CHECK(!once->isBuffered());
+    BOOST_CHECK(starved->isBuffered());
+    BOOST_CHECK_EQUAL(streamer.getBuffersInUse(), 2u);
+
+    once.reset();
+    streamer.process();
+    BOOST_CHECK_EQUAL(streamer.getStreamCount(), 3u);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
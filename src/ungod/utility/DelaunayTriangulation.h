@@ -27,12 +27,14 @@
 #define UNGOD_DELAUNAY_TRIANGULATION_H
 
 #include "ungod/utility/Traits.h"
-#include "quadtree/Quadtree.h"
 
-#include <list>
 #include <vector>
-#include <queue>
-#include <iostream>
+#include <array>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
 
 namespace ungod
 {
@@ -44,6 +46,8 @@ namespace ungod
     {
         Triangle(Vertex cv0, Vertex cv1, Vertex cv2) : v0(cv0), v1(cv1), v2(cv2) {}
 
+        Vertex operator[](unsigned i) const { return i == 0 ? v0 : (i == 1 ? v1 : v2); }
+
         Vertex v0;
         Vertex v1;
         Vertex v2;
@@ -58,84 +62,98 @@ namespace ungod
         Vertex v1;
     };
 
+    template<typename POINT> class DelaunayTriangulation;
+
     namespace detail
     {
-        /** \brief Bundles a triangle along with precoputed properties. */
+        /** \brief Bundles a triangle along with precomputed properties. */
         struct TriangleData
         {
-            TriangleData(Triangle t) : triangle(t), circumX(0), circumY(0), circumRadius(0) {}
-
-            template<typename POINT, typename GETTER>
-            void init(const GETTER& pointGetter);
+            TriangleData(Triangle t) : triangle(t) {}
 
             Triangle triangle;
-            float circumX;
-            float circumY;
-            float circumRadius;
         };
 
-        using TriangleIter = typename std::list<TriangleData>::const_iterator;
-
-
-        /** \brief Attributes for an edge. */
-        template<typename POINT>
-        struct EdgeAttributes
-        {
-            std::list<TriangleIter> adjacent;
-        };
-
-        /** \brief Datastructure that stores a triangulation. */
+        /** \brief Datastructure that stores a triangulation in flat arrays. Edge i of triangle t is the half-edge
+        * 3*t+i and leads from vertex i to vertex (i+1)%3 of the triangle. For every half-edge, the opposite half-edge
+        * of the adjacent triangle is stored. Triangles are oriented counter-clockwise (with respect to a y-up axis). */
         template<typename POINT>
         class TriangulationData
         {
+        friend class DelaunayTriangulation<POINT>;
+        public:
+            static constexpr std::size_t NO_EDGE = std::numeric_limits<std::size_t>::max();
+
         public:
             TriangulationData() {}
 
-            void init(std::size_t numVertex);
+            const std::vector<TriangleData>& getTriangleContainer() const { return mTriangles; }
 
-            template<typename GETTER>
-            TriangleIter addTriangle(const Triangle& triangle, const GETTER& pointGetter);
+            /** \brief Returns the index of the triangle adjacent to the given edge of the given triangle or NO_EDGE
+            * if the edge lies on the border of the triangulation. */
+            std::size_t getNeighbor(std::size_t triangle, unsigned edge) const;
 
-            void removeTriangle(TriangleIter triangle);
+        private:
+            void clear();
 
-            void removeAdjacentTriangles(const Edge& e);
+            std::size_t addTriangle(Vertex a, Vertex b, Vertex c);
 
-            const EdgeAttributes<POINT>& getEdgeAttributes(const Edge& e) const;
+            void removeTriangle(std::size_t triangle);
 
-            const std::list<TriangleData>& getTriangleContainer() const;
+            void link(std::size_t halfEdge, std::size_t opposite);
 
-        private:
-            void accomodateEdge(Vertex v0, Vertex v1, TriangleIter triangle);
-            void removeEdge(Vertex v0, Vertex v1, TriangleIter triangle);
+            /** \brief Drops removed triangles and all triangles with a vertex >= firstDropped and compacts the arrays. */
+            void compact(Vertex firstDropped);
 
         private:
-            std::list< TriangleData > mTriangles;  //stores data of the triangles
-            std::vector< std::vector< EdgeAttributes<POINT> > > mEdgeAttributes;  //triangle matrix, that maps edges to its data (a,b) and (b,a) map to the same entry
+            std::vector<TriangleData> mTriangles;
+            std::vector<std::size_t> mHalfEdges;  //opposite half-edge per half-edge
+            std::vector<bool> mRemoved;
+            std::vector<std::size_t> mFree;  //slots of removed triangles
         };
+
+        /** \brief Returns the position of the cell (x,y) on a hilbert curve that fills a 2^16 x 2^16 grid. */
+        inline uint64_t hilbertIndex(uint32_t x, uint32_t y);
     }
 
 
-    /** \brief An algorithm object that performs delauny triangulation for a given set of points. */
+    /** \brief An algorithm object that performs delauny triangulation for a given set of points.
+    * Points are inserted incrementally (Bowyer-Watson) in the order of a hilbert curve through the bounding box, so that
+    * consecutive points are close to each other. The triangle containing the next point is found by walking the
+    * adjacency from the last inserted triangle and the cavity of the point is grown along the adjacency, too.
+    * This gives O(n log n) expected running time. Duplicate points are ignored. */
     template<typename POINT>
     class DelaunayTriangulation
     {
     public:
-        DelaunayTriangulation() {}
+        DelaunayTriangulation() : mStamp(0) {}
 
         void run(const std::vector<POINT>& points, const POINT& upperBound, const POINT& lowerBound);
 
         detail::TriangulationData<POINT>& getData() { return mTriangulation; }
 
     private:
-        //returns true if the circumcycle of the triangle <t1,t2,t3> contains the vertex v
-        template<typename GETTER>
-        bool circumcycleContains(const GETTER& pointGetter, detail::TriangleIter triangle, Vertex v);
+        //returns a value > 0 if the triangle <a,b,c> is oriented counter-clockwise, 0 if the points are collinear
+        double orientation(Vertex a, Vertex b, Vertex c) const;
 
-        void checkSharedStatus(Vertex v1, Vertex v2, detail::TriangleIter cur, const std::vector<detail::TriangleIter>& badTriangles, std::vector<Edge>& polygon);
-        void cleanupVertices(Vertex v1, Vertex v2);
+        //returns true if the circumcycle of the triangle strictly contains the vertex v
+        bool circumcycleContains(std::size_t triangle, Vertex v) const;
+
+        //returns the triangle containing v, starting the search at the given triangle
+        std::size_t locate(Vertex v, std::size_t start) const;
+
+        //inserts the vertex and returns one of the new triangles
+        std::size_t insert(Vertex v, std::size_t start);
 
     private:
         detail::TriangulationData<POINT> mTriangulation;  //holds the resulting triangulation
+        std::vector<double> mX;  //coordinates of the input points followed by the super triangle
+        std::vector<double> mY;
+        std::vector<unsigned> mCavityStamp;  //per triangle, equals mStamp if the triangle is part of the current cavity
+        unsigned mStamp;
+        std::vector<std::size_t> mCavity;
+        std::vector<std::array<std::size_t, 3>> mBoundary;  //start vertex, end vertex and outer half-edge of the cavity border
+        std::vector<std::pair<Vertex, std::size_t>> mFan;  //new triangles by their first vertex
     };
 
 
@@ -148,117 +166,113 @@ namespace ungod
 
     namespace detail
     {
-            template<typename POINT, typename GETTER>
-            void TriangleData::init(const GETTER& pointGetter)
-            {
-                float ab = (Point2DTraits<POINT>::getX(pointGetter(triangle.v0)) * Point2DTraits<POINT>::getX(pointGetter(triangle.v0))) +
-                            (Point2DTraits<POINT>::getY(pointGetter(triangle.v0)) * Point2DTraits<POINT>::getY(pointGetter(triangle.v0)));
-                float cd = (Point2DTraits<POINT>::getX(pointGetter(triangle.v1)) * Point2DTraits<POINT>::getX(pointGetter(triangle.v1))) +
-                            (Point2DTraits<POINT>::getY(pointGetter(triangle.v1)) * Point2DTraits<POINT>::getY(pointGetter(triangle.v1)));
-                float ef = (Point2DTraits<POINT>::getX(pointGetter(triangle.v2)) * Point2DTraits<POINT>::getX(pointGetter(triangle.v2))) +
-                            (Point2DTraits<POINT>::getY(pointGetter(triangle.v2)) * Point2DTraits<POINT>::getY(pointGetter(triangle.v2)));
-
-                circumX = (ab * (Point2DTraits<POINT>::getY(pointGetter(triangle.v2)) - Point2DTraits<POINT>::getY(pointGetter(triangle.v1))) +
-                                  cd * (Point2DTraits<POINT>::getY(pointGetter(triangle.v0)) - Point2DTraits<POINT>::getY(pointGetter(triangle.v2))) +
-                                  ef * (Point2DTraits<POINT>::getY(pointGetter(triangle.v1)) - Point2DTraits<POINT>::getY(pointGetter(triangle.v0)))) /
-                                    (Point2DTraits<POINT>::getX(pointGetter(triangle.v0)) * (Point2DTraits<POINT>::getY(pointGetter(triangle.v2)) - Point2DTraits<POINT>::getY(pointGetter(triangle.v1))) +
-                                     Point2DTraits<POINT>::getX(pointGetter(triangle.v1)) * (Point2DTraits<POINT>::getY(pointGetter(triangle.v0)) - Point2DTraits<POINT>::getY(pointGetter(triangle.v2))) +
-                                     Point2DTraits<POINT>::getX(pointGetter(triangle.v2)) * (Point2DTraits<POINT>::getY(pointGetter(triangle.v1)) - Point2DTraits<POINT>::getY(pointGetter(triangle.v0)))) / 2.f;
-
-                circumY = (ab * (Point2DTraits<POINT>::getX(pointGetter(triangle.v2)) - Point2DTraits<POINT>::getX(pointGetter(triangle.v1))) +
-                                  cd * (Point2DTraits<POINT>::getX(pointGetter(triangle.v0)) - Point2DTraits<POINT>::getX(pointGetter(triangle.v2))) +
-                                  ef * (Point2DTraits<POINT>::getX(pointGetter(triangle.v1)) - Point2DTraits<POINT>::getX(pointGetter(triangle.v0)))) /
-                                    (Point2DTraits<POINT>::getY(pointGetter(triangle.v0)) * (Point2DTraits<POINT>::getX(pointGetter(triangle.v2)) - Point2DTraits<POINT>::getX(pointGetter(triangle.v1))) +
-                                     Point2DTraits<POINT>::getY(pointGetter(triangle.v1)) * (Point2DTraits<POINT>::getX(pointGetter(triangle.v0)) - Point2DTraits<POINT>::getX(pointGetter(triangle.v2))) +
-                                     Point2DTraits<POINT>::getY(pointGetter(triangle.v2)) * (Point2DTraits<POINT>::getX(pointGetter(triangle.v1)) - Point2DTraits<POINT>::getX(pointGetter(triangle.v0)))) / 2.f;
-
-                circumRadius = std::sqrt(((Point2DTraits<POINT>::getX(pointGetter(triangle.v0)) - circumX) * (Point2DTraits<POINT>::getX(pointGetter(triangle.v0)) - circumX)) +
-                                                ((Point2DTraits<POINT>::getY(pointGetter(triangle.v0)) - circumY) * (Point2DTraits<POINT>::getY(pointGetter(triangle.v0)) - circumY)));
-            }
+            template<typename POINT>
+            constexpr std::size_t TriangulationData<POINT>::NO_EDGE;
 
             template<typename POINT>
-            void TriangulationData<POINT>::init(std::size_t numVertex)
+            std::size_t TriangulationData<POINT>::getNeighbor(std::size_t triangle, unsigned edge) const
             {
-                mEdgeAttributes.resize(numVertex);
-                for (std::size_t i = 1; i <= numVertex; ++i)
-                    mEdgeAttributes[i-1].resize(i);
+                std::size_t opposite = mHalfEdges[3 * triangle + edge];
+                return opposite == NO_EDGE ? NO_EDGE : opposite / 3;
             }
 
             template<typename POINT>
-            void TriangulationData<POINT>::removeTriangle(TriangleIter t)
+            void TriangulationData<POINT>::clear()
             {
-                removeEdge(t->triangle.v0, t->triangle.v1, t);
-                removeEdge(t->triangle.v1, t->triangle.v2, t);
-                removeEdge(t->triangle.v2, t->triangle.v0, t);
-                mTriangles.erase(t);
+                mTriangles.clear();
+                mHalfEdges.clear();
+                mRemoved.clear();
+                mFree.clear();
             }
 
             template<typename POINT>
-            void TriangulationData<POINT>::removeAdjacentTriangles(const Edge& e)
+            std::size_t TriangulationData<POINT>::addTriangle(Vertex a, Vertex b, Vertex c)
             {
-                EdgeAttributes<POINT>& attr = (e.v1 > e.v0) ? mEdgeAttributes[e.v1][e.v0] : mEdgeAttributes[e.v0][e.v1];
-                for (const auto& t : attr.adjacent)
+                std::size_t t;
+                if (mFree.empty())
                 {
-                    mTriangles.erase(t);
+                    t = mTriangles.size();
+                    mTriangles.emplace_back(Triangle{ a, b, c });
+                    mHalfEdges.resize(mHalfEdges.size() + 3, NO_EDGE);
+                    mRemoved.push_back(false);
                 }
-                attr.adjacent.clear();
-            }
-
-            template<typename POINT>
-            const EdgeAttributes<POINT>& TriangulationData<POINT>::getEdgeAttributes(const Edge& e) const
-            {
-                if (e.v1 > e.v0)
-                    return mEdgeAttributes[e.v1][e.v0];
                 else
-                    return mEdgeAttributes[e.v0][e.v1];
+                {
+                    t = mFree.back();
+                    mFree.pop_back();
+                    mTriangles[t].triangle = Triangle{ a, b, c };
+                    mHalfEdges[3 * t] = mHalfEdges[3 * t + 1] = mHalfEdges[3 * t + 2] = NO_EDGE;
+                    mRemoved[t] = false;
+                }
+                return t;
             }
 
             template<typename POINT>
-            const std::list<TriangleData>& TriangulationData<POINT>::getTriangleContainer() const
+            void TriangulationData<POINT>::removeTriangle(std::size_t triangle)
             {
-                return mTriangles;
+                mRemoved[triangle] = true;
+                mFree.push_back(triangle);
             }
 
-
             template<typename POINT>
-            void TriangulationData<POINT>::accomodateEdge(Vertex v0, Vertex v1, TriangleIter triangle)
+            void TriangulationData<POINT>::link(std::size_t halfEdge, std::size_t opposite)
             {
-                if (v1 > v0)
-                    std::swap(v0, v1);  //make sure v1 <= v0 is always true
-
-                EdgeAttributes<POINT>& attr = mEdgeAttributes[v0][v1];
-                attr.adjacent.emplace_back(triangle);
+                mHalfEdges[halfEdge] = opposite;
+                if (opposite != NO_EDGE)
+                    mHalfEdges[opposite] = halfEdge;
             }
 
-
             template<typename POINT>
-            void TriangulationData<POINT>::removeEdge(Vertex v0, Vertex v1, TriangleIter triangle)
+            void TriangulationData<POINT>::compact(Vertex firstDropped)
             {
-                if (v1 > v0)
-                    std::swap(v0, v1);  //make sure v1 <= v0 is always true
-
-                EdgeAttributes<POINT>& attr = mEdgeAttributes[v0][v1];
-                for (auto it = std::begin(attr.adjacent); it != std::end(attr.adjacent); ++it)
+                std::vector<std::size_t> remap(mTriangles.size(), NO_EDGE);
+                std::size_t count = 0;
+                for (std::size_t t = 0; t < mTriangles.size(); ++t)
+                {
+                    const Triangle& tri = mTriangles[t].triangle;
+                    if (!mRemoved[t] && tri.v0 < firstDropped && tri.v1 < firstDropped && tri.v2 < firstDropped)
+                        remap[t] = count++;
+                }
+                std::vector<TriangleData> triangles;
+                std::vector<std::size_t> halfEdges;
+                triangles.reserve(count);
+                halfEdges.reserve(3 * count);
+                for (std::size_t t = 0; t < mTriangles.size(); ++t)
                 {
-                    if (*it == triangle)
+                    if (remap[t] == NO_EDGE)
+                        continue;
+                    triangles.push_back(mTriangles[t]);
+                    for (unsigned i = 0; i < 3; ++i)
                     {
-                        attr.adjacent.erase(it);
-                        break;
+                        std::size_t opposite = mHalfEdges[3 * t + i];
+                        halfEdges.push_back((opposite == NO_EDGE || remap[opposite / 3] == NO_EDGE) ? NO_EDGE : 3 * remap[opposite / 3] + opposite % 3);
                     }
                 }
+                mTriangles = std::move(triangles);
+                mHalfEdges = std::move(halfEdges);
+                mRemoved.assign(mTriangles.size(), false);
+                mFree.clear();
             }
 
-            template<typename POINT>
-            template<typename GETTER>
-            TriangleIter TriangulationData<POINT>::addTriangle(const Triangle& triangle, const GETTER& pointGetter)
+            inline uint64_t hilbertIndex(uint32_t x, uint32_t y)
             {
-                mTriangles.emplace_back( triangle );
-                mTriangles.back().init<POINT>(pointGetter);
-                TriangleIter backIt = --std::end(mTriangles);
-                accomodateEdge(triangle.v0, triangle.v1, backIt);
-                accomodateEdge(triangle.v1, triangle.v2, backIt);
-                accomodateEdge(triangle.v2, triangle.v0, backIt);
-                return backIt;
+                uint64_t d = 0;
+                for (uint32_t s = 1u << 15; s > 0; s >>= 1)
+                {
+                    uint32_t rx = (x & s) > 0;
+                    uint32_t ry = (y & s) > 0;
+                    d += (uint64_t)s * s * ((3 * rx) ^ ry);
+                    if (ry == 0)
+                    {
+                        if (rx == 1)
+                        {
+                            x = s - 1 - (x & (s - 1));
+                            y = s - 1 - (y & (s - 1));
+                        }
+                        std::swap(x, y);
+                    }
+                }
+                return d;
             }
     }
 
@@ -267,112 +281,200 @@ namespace ungod
     void DelaunayTriangulation<POINT>::run(const std::vector<POINT>& points, const POINT& upperBound, const POINT& lowerBound)
     {
         std::size_t numPoints = points.size();
+        mTriangulation.clear();
+        mCavityStamp.clear();
+        mStamp = 0;
+
+        //the super triangle covers the given bounds and all points outside of them
+        float left = Point2DTraits<POINT>::getX(upperBound), top = Point2DTraits<POINT>::getY(upperBound);
+        float right = Point2DTraits<POINT>::getX(lowerBound), bottom = Point2DTraits<POINT>::getY(lowerBound);
+        mX.resize(numPoints + 3);
+        mY.resize(numPoints + 3);
+        for (std::size_t i = 0; i < numPoints; ++i)
+        {
+            mX[i] = Point2DTraits<POINT>::getX(points[i]);
+            mY[i] = Point2DTraits<POINT>::getY(points[i]);
+            left = std::min(left, (float)mX[i]);
+            top = std::min(top, (float)mY[i]);
+            right = std::max(right, (float)mX[i]);
+            bottom = std::max(bottom, (float)mY[i]);
+        }
+        float dx = std::max(right - left, 1.0f);
+        float dy = std::max(bottom - top, 1.0f);
+        mX[numPoints] = left + dx/2;
+        mY[numPoints] = top - dy;
+        mX[numPoints+1] = left - dx;
+        mY[numPoints+1] = bottom;
+        mX[numPoints+2] = right + dx;
+        mY[numPoints+2] = bottom;
+
+        std::size_t last;
+        if (orientation(numPoints, numPoints+1, numPoints+2) > 0)
+            last = mTriangulation.addTriangle(numPoints, numPoints+1, numPoints+2);
+        else
+            last = mTriangulation.addTriangle(numPoints, numPoints+2, numPoints+1);
+
+        //insert the points along a hilbert curve
+        std::vector<std::pair<uint64_t, Vertex>> order(numPoints);
+        for (Vertex v = 0; v < numPoints; ++v)
+        {
+            uint32_t hx = (uint32_t)(65535.0 * (mX[v] - left) / dx);
+            uint32_t hy = (uint32_t)(65535.0 * (mY[v] - top) / dy);
+            order[v] = { detail::hilbertIndex(hx, hy), v };
+        }
+        std::sort(order.begin(), order.end());
+
+        for (const auto& entry : order)
+            last = insert(entry.second, last);
 
-        //determine super triangle
-        float dx = Point2DTraits<POINT>::getX(lowerBound) - Point2DTraits<POINT>::getX(upperBound);
-        float dy = Point2DTraits<POINT>::getY(lowerBound) - Point2DTraits<POINT>::getY(upperBound);
+        //cleanup triangles that contain a point from the original supervertex
+        mTriangulation.compact(numPoints);
+    }
 
-        std::array<POINT, 3> superpoints;
-        superpoints[0] = Point2DTraits<POINT>::create(Point2DTraits<POINT>::getX(upperBound) + dx/2, Point2DTraits<POINT>::getY(upperBound) - dy);
-        superpoints[1] = Point2DTraits<POINT>::create(Point2DTraits<POINT>::getX(upperBound) - dx, Point2DTraits<POINT>::getY(lowerBound));
-        superpoints[2] = Point2DTraits<POINT>::create(Point2DTraits<POINT>::getX(lowerBound) + dx, Point2DTraits<POINT>::getY(lowerBound));
 
-        auto pointGetter = [=] (Vertex v) { return (v < numPoints) ? points[v] : superpoints[v-numPoints]; };
+    template<typename POINT>
+    double DelaunayTriangulation<POINT>::orientation(Vertex a, Vertex b, Vertex c) const
+    {
+        return (mX[b] - mX[a]) * (mY[c] - mY[a]) - (mY[b] - mY[a]) * (mX[c] - mX[a]);
+    }
 
-        mTriangulation.init( numPoints+3 );
-        mTriangulation.addTriangle( {numPoints,numPoints+1,numPoints+2}, pointGetter );
 
-        std::vector<detail::TriangleIter> badTriangles;
-        std::vector<Edge> polygon;
+    template<typename POINT>
+    bool DelaunayTriangulation<POINT>::circumcycleContains(std::size_t triangle, Vertex v) const
+    {
+        const Triangle& t = mTriangulation.mTriangles[triangle].triangle;
+        double adx = mX[t.v0] - mX[v], ady = mY[t.v0] - mY[v];
+        double bdx = mX[t.v1] - mX[v], bdy = mY[t.v1] - mY[v];
+        double cdx = mX[t.v2] - mX[v], cdy = mY[t.v2] - mY[v];
+        double det = (adx * adx + ady * ady) * (bdx * cdy - cdx * bdy)
+                   - (bdx * bdx + bdy * bdy) * (adx * cdy - cdx * ady)
+                   + (cdx * cdx + cdy * cdy) * (adx * bdy - bdx * ady);
+        return det > 0;
+    }
 
-        //iterate over the input points
-        for (Vertex v = 0; v < numPoints; ++v)
+
+    template<typename POINT>
+    std::size_t DelaunayTriangulation<POINT>::locate(Vertex v, std::size_t start) const
+    {
+        const auto& data = mTriangulation;
+        std::size_t t = start;
+        //the visibility walk terminates on delaunay triangulations, the step limit only guards against rounding issues
+        for (std::size_t steps = 0; steps <= data.mTriangles.size(); ++steps)
         {
-            // first find all the triangles that are no longer valid due to the insertion
-            for (detail::TriangleIter t = mTriangulation.getTriangleContainer().begin(); t != mTriangulation.getTriangleContainer().end(); ++t)
+            bool moved = false;
+            for (unsigned k = 0; k < 3 && !moved; ++k)
             {
-                if (circumcycleContains(pointGetter, t, v))
+                unsigned i = (unsigned)((k + steps) % 3);
+                const Triangle& tri = data.mTriangles[t].triangle;
+                if (orientation(tri[i], tri[(i + 1) % 3], v) < 0)
                 {
-                    badTriangles.emplace_back(t);
+                    std::size_t opposite = data.mHalfEdges[3 * t + i];
+                    if (opposite == data.NO_EDGE)
+                        return data.NO_EDGE;
+                    t = opposite / 3;
+                    moved = true;
                 }
             }
-            // find the boundary of the polygonal hole
-            for (const auto& titer : badTriangles)
-            {
-                const Triangle& triangle = titer->triangle;
-                checkSharedStatus(triangle.v0,triangle.v1, titer, badTriangles, polygon);
-                checkSharedStatus(triangle.v1,triangle.v2, titer, badTriangles, polygon);
-                checkSharedStatus(triangle.v2,triangle.v0, titer, badTriangles, polygon);
-            }
-            // remove them from the datastructure
-            for (const auto& titer : badTriangles)
-            {
-                mTriangulation.removeTriangle(titer);
-            }
-            // re-triangulate the polygonal hole
-            for (const auto& edge : polygon)
-            {
-                mTriangulation.addTriangle({edge.v0, edge.v1, v}, pointGetter);
-            }
-
-            badTriangles.clear();
-            polygon.clear();
+            if (!moved)
+                return t;
         }
-
-        //cleanup triangles that contain a point from the original supervertex
-        cleanupVertices(numPoints, numPoints+1);
-        cleanupVertices(numPoints+1, numPoints+2);
-        cleanupVertices(numPoints+2, numPoints);
-        for (std::size_t i = 0; i < numPoints; ++i)
+        for (t = 0; t < data.mTriangles.size(); ++t)
         {
-            cleanupVertices(numPoints, i);
-            cleanupVertices(numPoints+1, i);
-            cleanupVertices(numPoints+2, i);
+            const Triangle& tri = data.mTriangles[t].triangle;
+            if (!data.mRemoved[t] && orientation(tri.v0, tri.v1, v) >= 0 && orientation(tri.v1, tri.v2, v) >= 0 && orientation(tri.v2, tri.v0, v) >= 0)
+                return t;
         }
-    }
-
-    template<typename POINT>
-    template<typename GETTER>
-    bool DelaunayTriangulation<POINT>::circumcycleContains(const GETTER& pointGetter, detail::TriangleIter triangle, Vertex v)
-    {
-        float dist = std::sqrt(((Point2DTraits<POINT>::getX(pointGetter(v)) - triangle->circumX) * (Point2DTraits<POINT>::getX(pointGetter(v)) - triangle->circumX)) +
-                                        ((Point2DTraits<POINT>::getY(pointGetter(v)) - triangle->circumY) * (Point2DTraits<POINT>::getY(pointGetter(v)) - triangle->circumY)));
-
-        return dist <= triangle->circumRadius;
+        return data.NO_EDGE;
     }
 
 
     template<typename POINT>
-    void DelaunayTriangulation<POINT>::checkSharedStatus(Vertex v1, Vertex v2,
-                                                         detail::TriangleIter cur,
-                                                         const std::vector<detail::TriangleIter>& badTriangles,
-                                                         std::vector<Edge>& polygon)
+    std::size_t DelaunayTriangulation<POINT>::insert(Vertex v, std::size_t start)
     {
-        const detail::EdgeAttributes<POINT>& attr = mTriangulation.getEdgeAttributes( {v1, v2} );
-
-        for (const auto& bad : badTriangles)
+        auto& data = mTriangulation;
+        std::size_t t = locate(v, start);
+        if (t == data.NO_EDGE)
+            return start;
+        const Triangle& located = data.mTriangles[t].triangle;
+        for (unsigned i = 0; i < 3; ++i)
+            if (mX[located[i]] == mX[v] && mY[located[i]] == mY[v])
+                return t;
+
+        //grow the cavity of triangles whose circumcircle contains the point, starting at the located triangle
+        mCavityStamp.resize(data.mTriangles.size(), 0);
+        ++mStamp;
+        mCavity.clear();
+        mCavity.push_back(t);
+        mCavityStamp[t] = mStamp;
+        for (std::size_t k = 0; k < mCavity.size(); ++k)
         {
-            for (const auto& t : attr.adjacent)
+            std::size_t cur = mCavity[k];
+            for (unsigned i = 0; i < 3; ++i)
             {
-                if (bad == t && bad != cur)
-                    return;
+                std::size_t opposite = data.mHalfEdges[3 * cur + i];
+                if (opposite == data.NO_EDGE || mCavityStamp[opposite / 3] == mStamp)
+                    continue;
+                const Triangle& tri = data.mTriangles[cur].triangle;
+                //points on a shared edge always open up both triangles
+                if (circumcycleContains(opposite / 3, v) || orientation(tri[i], tri[(i + 1) % 3], v) == 0)
+                {
+                    mCavityStamp[opposite / 3] = mStamp;
+                    mCavity.push_back(opposite / 3);
+                }
             }
         }
 
-        //edge is border edge of the polygon
-        polygon.emplace_back(v1, v2);
-    }
+        //the cavity must be star-shaped with respect to the point, rounding errors may require to shrink it
+        bool valid = false;
+        while (!valid)
+        {
+            valid = true;
+            mBoundary.clear();
+            for (std::size_t cur : mCavity)
+            {
+                if (mCavityStamp[cur] != mStamp)
+                    continue;
+                const Triangle& tri = data.mTriangles[cur].triangle;
+                for (unsigned i = 0; i < 3; ++i)
+                {
+                    std::size_t opposite = data.mHalfEdges[3 * cur + i];
+                    if (opposite != data.NO_EDGE && mCavityStamp[opposite / 3] == mStamp)
+                        continue;
+                    if (cur != t && orientation(tri[i], tri[(i + 1) % 3], v) <= 0)
+                    {
+                        mCavityStamp[cur] = 0;
+                        valid = false;
+                        break;
+                    }
+                    mBoundary.push_back({ tri[i], tri[(i + 1) % 3], opposite });
+                }
+            }
+        }
 
-    template<typename POINT>
-    void DelaunayTriangulation<POINT>::cleanupVertices(Vertex v1, Vertex v2)
-    {
-        const detail::EdgeAttributes<POINT>& attr = mTriangulation.getEdgeAttributes( {v1, v2} );
-        for (auto it = std::begin(attr.adjacent); it != std::end(attr.adjacent);)
+        //replace the cavity by a fan of triangles around the point
+        for (std::size_t cur : mCavity)
+            if (mCavityStamp[cur] == mStamp)
+                data.removeTriangle(cur);
+        std::size_t first = data.NO_EDGE;
+        mFan.clear();
+        for (const auto& edge : mBoundary)
+        {
+            std::size_t n = data.addTriangle(edge[0], edge[1], v);
+            data.link(3 * n, edge[2]);
+            mFan.emplace_back(edge[0], n);
+            if (first == data.NO_EDGE)
+                first = n;
+        }
+        std::sort(mFan.begin(), mFan.end());
+        for (const auto& entry : mFan)
         {
-            detail::TriangleIter tcur = *it;
-            ++it;
-            mTriangulation.removeTriangle(tcur);
+            //edge (b,v) of the triangle (a,b,v) is shared with the triangle (b,c,v)
+            Vertex b = data.mTriangles[entry.second].triangle.v1;
+            auto next = std::lower_bound(mFan.begin(), mFan.end(), std::make_pair(b, std::size_t{0}));
+            if (next != mFan.end() && next->first == b)
+                data.link(3 * entry.second + 1, 3 * next->second + 2);
         }
+        return first;
     }
 }
 
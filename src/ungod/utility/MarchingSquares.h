@@ -27,6 +27,8 @@
 #define MARCHING_SQUARES_H
 
 #include <vector>
+#include <cmath>
+#include <algorithm>
 #include "ungod/utility/Traits.h"
 
 namespace ungod
@@ -54,11 +56,27 @@ namespace ungod
         template<typename INPUT_ITER>
         void run(INPUT_ITER polygonBegin, INPUT_ITER polygonEnd);
 
-    private:
+        /** \brief Creates the bit image of the given polygons. A cell is blocked if its center point is contained
+        * in at least one of the polygons. Cells blocked by earlier calls stay blocked. */
+        template<typename INPUT_ITER>
+        void rasterize(INPUT_ITER polygonBegin, INPUT_ITER polygonEnd);
+
+        /** \brief Returns the bit image in row major order (true = blocked). */
+        const std::vector<bool>& getBitImage() const { return mBitImage; }
+
+        std::size_t getImageSizeX() const { return mImageSizeX; }
+        std::size_t getImageSizeY() const { return mImageSizeY; }
+
+        /** \brief Returns the index of the cell that contains the given point. Points outside of the image are clamped. */
         std::size_t point2index(const POINT_TYPE& point) const;
 
+        /** \brief Returns the center point of the cell with the given index. */
         POINT_TYPE centerPoint(std::size_t index) const;
 
+    private:
+        std::size_t toCellX(float x) const;
+        std::size_t toCellY(float y) const;
+
     private:
         POINT_TYPE mGlobalUpperBounds;
         POINT_TYPE mGlobalLowerBounds;
@@ -94,20 +112,34 @@ namespace ungod
 
         float globalSizeX = Point2DTraits<POINT_TYPE>::getX(globalLowerBounds) - Point2DTraits<POINT_TYPE>::getX(globalUpperBounds);
         float globalSizeY = Point2DTraits<POINT_TYPE>::getY(globalLowerBounds) - Point2DTraits<POINT_TYPE>::getY(globalUpperBounds);
-        mImageSizeX = std::ceil( globalSizeX / gridDensityX );
-        mImageSizeY = std::ceil( globalSizeY / gridDensityY );
+        mImageSizeX = (std::size_t)std::max(1.0f, std::ceil( globalSizeX / gridDensityX ));
+        mImageSizeY = (std::size_t)std::max(1.0f, std::ceil( globalSizeY / gridDensityY ));
 
         mBitImage.clear();
-        mBitImage.resize(imageSizeX*imageSizeY, false);  //enconding: false = free space, true = blocked
+        mBitImage.resize(mImageSizeX*mImageSizeY, false);  //enconding: false = free space, true = blocked
+    }
+
+
+    template<typename POLYGON_TYPE, typename POINT_TYPE>
+    std::size_t MarchingSquares<POLYGON_TYPE, POINT_TYPE>::toCellX(float x) const
+    {
+        float normalized = std::floor((x - Point2DTraits<POINT_TYPE>::getX(mGlobalUpperBounds)) / mGridDensityX);
+        return (std::size_t)std::min(std::max(normalized, 0.0f), (float)(mImageSizeX - 1));
+    }
+
+
+    template<typename POLYGON_TYPE, typename POINT_TYPE>
+    std::size_t MarchingSquares<POLYGON_TYPE, POINT_TYPE>::toCellY(float y) const
+    {
+        float normalized = std::floor((y - Point2DTraits<POINT_TYPE>::getY(mGlobalUpperBounds)) / mGridDensityY);
+        return (std::size_t)std::min(std::max(normalized, 0.0f), (float)(mImageSizeY - 1));
     }
 
 
     template<typename POLYGON_TYPE, typename POINT_TYPE>
     std::size_t MarchingSquares<POLYGON_TYPE, POINT_TYPE>::point2index(const POINT_TYPE& point) const
     {
-        std::size_t normalizedX = std::floor((Point2DTraits<POINT_TYPE>::getX(point) - Point2DTraits<POINT_TYPE>::getX(mGlobalUpperBounds)) / mGridDensityX);
-        std::size_t normalizedY = std::floor((Point2DTraits<POINT_TYPE>::getX(point) - Point2DTraits<POINT_TYPE>::getX(mGlobalUpperBounds)) / mGridDensityX);
-        return normalizedY * mImageSizeX + normalizedX;
+        return toCellY(Point2DTraits<POINT_TYPE>::getY(point)) * mImageSizeX + toCellX(Point2DTraits<POINT_TYPE>::getX(point));
     }
 
 
@@ -115,16 +147,26 @@ namespace ungod
     POINT_TYPE MarchingSquares<POLYGON_TYPE, POINT_TYPE>::centerPoint(std::size_t index) const
     {
         float x = Point2DTraits<POINT_TYPE>::getX(mGlobalUpperBounds) + ((index % mImageSizeX) + 0.5f)*mGridDensityX;
-        float y = Point2DTraits<POINT_TYPE>::getY(mGlobalUpperBounds) + (std::floor((float)index / (float)mImageSizeY) + 0.5f)*mGridDensityY;
+        float y = Point2DTraits<POINT_TYPE>::getY(mGlobalUpperBounds) + ((index / mImageSizeX) + 0.5f)*mGridDensityY;
         return Point2DTraits<POINT_TYPE>::create(x, y);
     }
 
 
     template<typename POLYGON_TYPE, typename POINT_TYPE>
     template<typename INPUT_ITER>
-    void MarchingSquares<POLYGON_TYPE, POINT_TYPE>::run(INPUT_ITER polygonBegin, INPUT_ITER polygonEnd, const POINT_TYPE& globalUpperBounds, const POINT_TYPE& globalLowerBounds, float gridDensityX, float gridDensityY)
+    void MarchingSquares<POLYGON_TYPE, POINT_TYPE>::run(INPUT_ITER polygonBegin, INPUT_ITER polygonEnd)
     {
         //first step: create the bit image related to the provided colliders
+        rasterize(polygonBegin, polygonEnd);
+    }
+
+
+    template<typename POLYGON_TYPE, typename POINT_TYPE>
+    template<typename INPUT_ITER>
+    void MarchingSquares<POLYGON_TYPE, POINT_TYPE>::rasterize(INPUT_ITER polygonBegin, INPUT_ITER polygonEnd)
+    {
+        if (mBitImage.empty())
+            return;
         for (;polygonBegin != polygonEnd; ++polygonBegin)
         {
             //retrieve the upper bounds
@@ -132,17 +174,18 @@ namespace ungod
             POINT_TYPE polygonLowerBounds = Polygon2DTraits<POLYGON_TYPE, POINT_TYPE>::getLowerBounds(*polygonBegin);
 
             //transform the upper bounds to bit-ranges in the image field, that are related to the 2d-world polygons
-            std::size_t xBegin = point2index(polygonUpperBounds);
-            std::size_t xEnd = point2index( Point2DTraits<POINT_TYPE>::create( Point2DTraits<POINT_TYPE>::getX(polygonLowerBounds), Point2DTraits<POINT_TYPE>::getY(polygonUpperBounds) ) );
-            std::size_t yBegin = point2index( Point2DTraits<POINT_TYPE>::create( Point2DTraits<POINT_TYPE>::getX(polygonUpperBounds), Point2DTraits<POINT_TYPE>::getY(polygonLowerBounds) ) );
-            std::size_t yEnd = point2index(polygonLowerBounds);
+            std::size_t xBegin = toCellX(Point2DTraits<POINT_TYPE>::getX(polygonUpperBounds));
+            std::size_t xEnd = toCellX(Point2DTraits<POINT_TYPE>::getX(polygonLowerBounds));
+            std::size_t yBegin = toCellY(Point2DTraits<POINT_TYPE>::getY(polygonUpperBounds));
+            std::size_t yEnd = toCellY(Point2DTraits<POINT_TYPE>::getY(polygonLowerBounds));
 
             //iterate over the bit ranges and set bits, if the center points of the cells are within the polygon
-            for (std::size_t y = 0; y < yEnd - yBegin; ++y)
+            for (std::size_t y = yBegin; y <= yEnd; ++y)
                 for (std::size_t x = xBegin; x <= xEnd; ++x)
                 {
                     std::size_t curIndex = y*mImageSizeX + x;
-                    mBitImage[curIndex] = Polygon2DTraits<POLYGON_TYPE, POINT_TYPE>::contains(*polygonBegin, centerPoint(curIndex));
+                    if (!mBitImage[curIndex] && Polygon2DTraits<POLYGON_TYPE, POINT_TYPE>::contains(*polygonBegin, centerPoint(curIndex)))
+                        mBitImage[curIndex] = true;
                 }
         }
     }
@@ -0,0 +1,182 @@
+/*
+* This file is part of the ungod - framework.
+* Copyright (C) 2016 Felix Becker - fb132550@uni-greifswald.de
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#ifndef UNGOD_SPATIAL_HASH_H
+#define UNGOD_SPATIAL_HASH_H
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+#include <SFML/System/Vector2.hpp>
+
+namespace ungod
+{
+    /**
+    * \brief A sparse uniform grid that buckets values by position. Only occupied cells are stored.
+    * In contrast to the quadtree, nothing is rebuilt per query: users keep the cell key returned
+    * by insert and call move whenever the position of a value changes, which is a no-op as long as
+    * the value stays in its cell.
+    */
+    template<typename T>
+    class SpatialHash
+    {
+    public:
+        using CellKey = uint64_t;
+
+    public:
+        SpatialHash(float cellSize) : mCellSize(cellSize), mSize(0) {}
+
+        /** \brief Returns the key of the cell that contains the given position. */
+        CellKey getKey(const sf::Vector2f& position) const;
+
+        /** \brief Inserts the value at the given position and returns the key of its cell. */
+        CellKey insert(const T& value, const sf::Vector2f& position);
+
+        /** \brief Removes the value from the given cell. Returns false if it was not found there. */
+        bool erase(const T& value, CellKey key);
+
+        /** \brief Moves a value from the given cell to the cell of the new position and returns the new key. */
+        CellKey move(const T& value, CellKey key, const sf::Vector2f& position);
+
+        /** \brief Calls func(value) for every value in the cells overlapping the rect [lower, upper].
+        * Values in these cells may lie outside the rect. */
+        template<typename F>
+        void query(const sf::Vector2f& lower, const sf::Vector2f& upper, F func) const;
+
+        /** \brief Removes all values. */
+        void clear() { mCells.clear(); mSize = 0; }
+
+        /** \brief Removes all values but keeps the storage of the cells for the next insertions. Cells that stayed
+        * empty since the last reset are dropped. Meant for grids that are rebuilt every frame. */
+        void reset();
+
+        float getCellSize() const { return mCellSize; }
+
+        std::size_t size() const { return mSize; }
+
+    private:
+        std::unordered_map<CellKey, std::vector<T>> mCells;
+        float mCellSize;
+        std::size_t mSize;
+
+        static CellKey makeKey(int32_t x, int32_t y) { return ((CellKey)(uint32_t)x << 32) | (CellKey)(uint32_t)y; }
+        int32_t cellCoord(float c) const { return (int32_t)std::floor(c / mCellSize); }
+    };
+
+
+    template<typename T>
+    typename SpatialHash<T>::CellKey SpatialHash<T>::getKey(const sf::Vector2f& position) const
+    {
+        return makeKey(cellCoord(position.x), cellCoord(position.y));
+    }
+
+    template<typename T>
+    typename SpatialHash<T>::CellKey SpatialHash<T>::insert(const T& value, const sf::Vector2f& position)
+    {
+        CellKey key = getKey(position);
+        mCells[key].push_back(value);
+        mSize++;
+        return key;
+    }
+
+    template<typename T>
+    bool SpatialHash<T>::erase(const T& value, CellKey key)
+    {
+        auto cell = mCells.find(key);
+        if (cell == mCells.end())
+            return false;
+        auto it = std::find(cell->second.begin(), cell->second.end(), value);
+        if (it == cell->second.end())
+            return false;
+        *it = cell->second.back();
+        cell->second.pop_back();
+        if (cell->second.empty())
+            mCells.erase(cell);
+        mSize--;
+        return true;
+    }
+
+    template<typename T>
+    typename SpatialHash<T>::CellKey SpatialHash<T>::move(const T& value, CellKey key, const sf::Vector2f& position)
+    {
+        CellKey newKey = getKey(position);
+        if (newKey != key && erase(value, key))
+        {
+            mCells[newKey].push_back(value);
+            mSize++;
+        }
+        return newKey;
+    }
+
+    template<typename T>
+    void SpatialHash<T>::reset()
+    {
+        for (auto cell = mCells.begin(); cell != mCells.end();)
+        {
+            if (cell->second.empty())
+                cell = mCells.erase(cell);
+            else
+            {
+                cell->second.clear();
+                ++cell;
+            }
+        }
+        mSize = 0;
+    }
+
+    template<typename T>
+    template<typename F>
+    void SpatialHash<T>::query(const sf::Vector2f& lower, const sf::Vector2f& upper, F func) const
+    {
+        if (mCells.empty())
+            return;
+        int32_t x0 = cellCoord(lower.x), x1 = cellCoord(upper.x);
+        int32_t y0 = cellCoord(lower.y), y1 = cellCoord(upper.y);
+        //a large rect over a sparse grid is cheaper to answer by walking the occupied cells
+        if ((std::size_t)(x1 - x0 + 1) * (std::size_t)(y1 - y0 + 1) > mCells.size())
+        {
+            for (const auto& cell : mCells)
+            {
+                int32_t x = (int32_t)(uint32_t)(cell.first >> 32), y = (int32_t)(uint32_t)cell.first;
+                if (x >= x0 && x <= x1 && y >= y0 && y <= y1)
+                    for (const auto& value : cell.second)
+                        func(value);
+            }
+            return;
+        }
+        for (int32_t x = x0; x <= x1; x++)
+            for (int32_t y = y0; y <= y1; y++)
+            {
+                auto cell = mCells.find(makeKey(x, y));
+                if (cell != mCells.end())
+                    for (const auto& value : cell->second)
+                        func(value);
+            }
+    }
+}
+
+#endif // UNGOD_SPATIAL_HASH_H
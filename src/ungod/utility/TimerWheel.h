@@ -0,0 +1,166 @@
+/*
+* This file is part of the ungod - framework.
+* Copyright (C) 2016 Felix Becker - fb132550@uni-greifswald.de
+*
+* This software is provided 'as-is', without any express or
+* implied warranty. In no event will the authors be held
+* liable for any damages arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute
+* it freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented;
+*    you must not claim that you wrote the original software.
+*    If you use this software in a product, an acknowledgment
+*    in the product documentation would be appreciated but
+*    is not required.
+*
+* 2. Altered source versions must be plainly marked as such,
+*    and must not be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any
+*    source distribution.
+*/
+
+#ifndef UNGOD_TIMER_WHEEL_H
+#define UNGOD_TIMER_WHEEL_H
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace ungod
+{
+    /**
+    * \brief Hierarchical timer wheel that schedules values for an absolute tick.
+    * Level 0 has a slot for each of the next SLOTS ticks, each higher level covers SLOTS slots of the level below.
+    * Entries are moved down a level when the wheel reaches their slot, so advancing the wheel only touches
+    * entries that are due or cascade in this tick. Entries further in the future than the wheel covers are kept
+    * in an overflow list that is redistributed once per full revolution.
+    * There is no cancellation, users are expected to tag their values and drop stale ones when they fire.
+    */
+    template<typename T>
+    class TimerWheel
+    {
+    public:
+        static constexpr unsigned SLOT_BITS = 6;
+        static constexpr unsigned SLOTS = 1u << SLOT_BITS;
+        static constexpr unsigned LEVELS = 4;
+
+    public:
+        TimerWheel() : mNow(0), mSize(0) {}
+
+        /** \brief Schedules the value for the given tick. Ticks that are already processed are moved to the next tick. */
+        void schedule(const T& value, uint64_t due);
+
+        /** \brief Advances the wheel by the given number of ticks and calls func(value) for every entry that becomes due,
+        * ordered by tick. func may schedule new entries. */
+        template<typename F>
+        void advance(uint64_t ticks, F func);
+
+        /** \brief Removes all entries. The current tick is kept. */
+        void clear();
+
+        /** \brief Returns the last processed tick. */
+        uint64_t getTime() const { return mNow; }
+
+        /** \brief Returns the number of scheduled entries. */
+        std::size_t size() const { return mSize; }
+
+    private:
+        struct Entry
+        {
+            T value;
+            uint64_t due;
+        };
+
+        std::array<std::vector<Entry>, SLOTS*LEVELS> mSlots;
+        std::vector<Entry> mOverflow;
+        std::vector<Entry> mProcessing; ///<reused to take out a slot while it is processed
+        uint64_t mNow;
+        std::size_t mSize;
+
+        void insert(const Entry& entry);
+        void cascade(std::vector<Entry>& slot);
+    };
+
+
+    template<typename T>
+    void TimerWheel<T>::schedule(const T& value, uint64_t due)
+    {
+        insert(Entry{ value, due > mNow ? due : mNow + 1 });
+        mSize++;
+    }
+
+    template<typename T>
+    template<typename F>
+    void TimerWheel<T>::advance(uint64_t ticks, F func)
+    {
+        for (uint64_t i = 0; i < ticks; i++)
+        {
+            mNow++;
+            if ((mNow & ((uint64_t{1} << (LEVELS*SLOT_BITS)) - 1)) == 0)
+                cascade(mOverflow);
+            //find the highest level that wraps in this tick and cascade top down
+            unsigned level = 0;
+            while (level + 1 < LEVELS && (mNow & ((uint64_t{1} << ((level + 1)*SLOT_BITS)) - 1)) == 0)
+                level++;
+            for (; level > 0; level--)
+                cascade(mSlots[level*SLOTS + ((mNow >> (level*SLOT_BITS)) & (SLOTS - 1))]);
+
+            std::vector<Entry>& slot = mSlots[mNow & (SLOTS - 1)];
+            if (slot.empty())
+                continue;
+            mProcessing.swap(slot);
+            mSize -= mProcessing.size();
+            for (const auto& entry : mProcessing)
+                func(entry.value);
+            mProcessing.clear();
+        }
+    }
+
+    template<typename T>
+    void TimerWheel<T>::clear()
+    {
+        for (auto& slot : mSlots)
+            slot.clear();
+        mOverflow.clear();
+        mSize = 0;
+    }
+
+    template<typename T>
+    void TimerWheel<T>::insert(const Entry& entry)
+    {
+        //an entry goes to the lowest level, on which it shares all higher digits with the current tick
+        for (unsigned level = 0; level < LEVELS; level++)
+        {
+            if (((entry.due ^ mNow) >> ((level + 1)*SLOT_BITS)) == 0)
+            {
+                mSlots[level*SLOTS + ((entry.due >> (level*SLOT_BITS)) & (SLOTS - 1))].push_back(entry);
+                return;
+            }
+        }
+        mOverflow.push_back(entry);
+    }
+
+    template<typename T>
+    void TimerWheel<T>::cascade(std::vector<Entry>& slot)
+    {
+        if (slot.empty())
+            return;
+        std::vector<Entry> entries;
+        entries.swap(slot);
+        for (const auto& entry : entries)
+            insert(entry);
+        //hand the buffer back to keep its capacity
+        if (slot.empty())
+        {
+            entries.clear();
+            slot.swap(entries);
+        }
+    }
+}
+
+#endif // UNGOD_TIMER_WHEEL_H
@@ -28,6 +28,8 @@
 
 #include "ungod/utility/Traits.h"
 #include <SFML/System/Vector2.hpp>
+#include <vector>
+#include <algorithm>
 
 namespace ungod
 {
@@ -49,6 +51,61 @@ namespace ungod
             return v.y;
         }
     };
+
+    /** \brief Convex polygons given as a list of their corner points in either orientation. */
+    template <>
+    struct Polygon2DTraits<std::vector<sf::Vector2f>, sf::Vector2f>
+    {
+        static std::size_t getPointCount(const std::vector<sf::Vector2f>& polygon)
+        {
+            return polygon.size();
+        }
+
+        static sf::Vector2f getPoint(const std::vector<sf::Vector2f>& polygon, std::size_t i)
+        {
+            return polygon[i];
+        }
+
+        static sf::Vector2f getUpperBounds(const std::vector<sf::Vector2f>& polygon)
+        {
+            sf::Vector2f upper = polygon.empty() ? sf::Vector2f() : polygon.front();
+            for (const auto& p : polygon)
+            {
+                upper.x = std::min(upper.x, p.x);
+                upper.y = std::min(upper.y, p.y);
+            }
+            return upper;
+        }
+
+        static sf::Vector2f getLowerBounds(const std::vector<sf::Vector2f>& polygon)
+        {
+            sf::Vector2f lower = polygon.empty() ? sf::Vector2f() : polygon.front();
+            for (const auto& p : polygon)
+            {
+                lower.x = std::max(lower.x, p.x);
+                lower.y = std::max(lower.y, p.y);
+            }
+            return lower;
+        }
+
+        static bool contains(const std::vector<sf::Vector2f>& polygon, const sf::Vector2f& point)
+        {
+            if (polygon.size() < 3)
+                return false;
+            bool neg = false, pos = false;
+            for (std::size_t i = 0; i < polygon.size(); ++i)
+            {
+                const sf::Vector2f& a = polygon[i];
+                const sf::Vector2f& b = polygon[(i + 1) % polygon.size()];
+                float d = (b.x - a.x) * (point.y - a.y) - (b.y - a.y) * (point.x - a.x);
+                neg = neg || d < 0;
+                pos = pos || d > 0;
+                if (neg && pos)
+                    return false;
+            }
+            return true;
+        }
+    };
 }
 
 #endif // UNGOD_VEC2F_TRAITS_H
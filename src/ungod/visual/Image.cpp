@@ -46,6 +46,11 @@ namespace ungod
         return success;
     }
 
+    std::size_t LoadBehavior<sf::Texture, bool, bool>::getMemorySize(const sf::Texture& data)
+    {
+        return sizeof(sf::Texture) + (std::size_t)data.getSize().x * data.getSize().y * 4; //rgba
+    }
+
 
     BigImage::BigImage(const std::string& filePath, const LoadPolicy policy, bool smooth) : Asset<sf::BigTexture, bool>(filePath, policy, std::move(smooth)) {}
 
@@ -62,4 +67,9 @@ namespace ungod
         data.setSmooth(smooth);
         return success;
     }
+
+    std::size_t LoadBehavior<sf::BigTexture, bool>::getMemorySize(const sf::BigTexture& data)
+    {
+        return sizeof(sf::BigTexture) + (std::size_t)data.getSize().x * data.getSize().y * 4; //rgba
+    }
 }
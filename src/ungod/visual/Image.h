@@ -47,6 +47,7 @@ namespace ungod
     {
         static bool loadFromFile(const std::string& filepath, sf::Texture& data, bool smooth, bool repeated);
         static std::string getIdentifier() { return "Image"; }
+        static std::size_t getMemorySize(const sf::Texture& data);
     };
 
 
@@ -66,6 +67,7 @@ namespace ungod
     {
         static bool loadFromFile(const std::string& filepath, sf::BigTexture& data, bool smooth);
         static std::string getIdentifier() { return "BigImage"; }
+        static std::size_t getMemorySize(const sf::BigTexture& data);
     };
 }
 
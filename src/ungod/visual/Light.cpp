@@ -31,6 +31,19 @@
 
 namespace ungod
 {
+    namespace detail
+    {
+        //fills the given pixel region of the texture with the color, the rest of the texture is untouched
+        void clearRegion(sf::RenderTexture& texture, const sf::IntRect& region, const sf::Color& color)
+        {
+            sf::RectangleShape rect({ (float)region.width, (float)region.height });
+            rect.setPosition((float)region.left, (float)region.top);
+            rect.setFillColor(color);
+            texture.setView(texture.getDefaultView());
+            texture.draw(rect, sf::BlendNone);
+        }
+    }
+
     BaseLight::BaseLight() : mActive(true) {}
 
     void BaseLight::setActive(bool active)
@@ -163,12 +176,13 @@ namespace ungod
                 const std::vector< std::pair<LightCollider*, TransformComponent*> >& colliders,
                 sf::Shader& unshadowShader,
                 sf::Shader& lightOverShapeShader,
-                const TransformComponent& transf) const
+                const TransformComponent& transf,
+                const sf::IntRect& region) const
     {
         states.transform *= transf.getTransform();
 
         // Render on Emission Texture : used by lightOverShapeShader
-        emissionTexture.clear();
+        detail::clearRegion(emissionTexture, region, sf::Color::Black);
         emissionTexture.setView(view);
         emissionTexture.draw(mSprite, states);
         emissionTexture.display();
@@ -189,7 +203,7 @@ namespace ungod
         std::vector<Penumbra> penumbras;
 
         //draw light emission
-        lightTexture.clear(sf::Color::Black);
+        detail::clearRegion(lightTexture, region, sf::Color::Black);
         lightTexture.setView(view);
         lightTexture.draw(mSprite, states);
 
@@ -231,7 +245,7 @@ namespace ungod
                     sf::Vector2f adi = innerBoundaryVectors[0];
                     sf::Vector2f bdi = innerBoundaryVectors[1];
 
-                    antumbraTexture.clear(sf::Color::White);
+                    detail::clearRegion(antumbraTexture, region, sf::Color::White);
                     antumbraTexture.setView(view);
 
                     sf::Vector2f intersectionInner;
@@ -265,7 +279,9 @@ namespace ungod
                     antumbraTexture.display();
 
                     lightTexture.setView(lightTexture.getDefaultView());
-                    lightTexture.draw(sf::Sprite(antumbraTexture.getTexture()), sf::BlendMultiply);
+                    sf::Sprite antumbraSprite(antumbraTexture.getTexture(), region);
+                    antumbraSprite.setPosition((float)region.left, (float)region.top);
+                    lightTexture.draw(antumbraSprite, sf::BlendMultiply);
                     lightTexture.setView(view);
                 }
                 else
@@ -115,6 +115,8 @@ namespace ungod
 
         sf::FloatRect getBoundingBox() const;
 
+        /** \brief Renders the light and its shadows to the light texture. Only the given region of pixels
+        * of the render textures is cleared and kept up to date, the rest keeps its previous contents. */
         void render(const sf::View& view,
                     sf::RenderTexture& lightTexture,
                     sf::RenderTexture& emissionTexture,
@@ -123,7 +125,8 @@ namespace ungod
                     const std::vector< std::pair<LightCollider*, TransformComponent*> >& colliders,
                     sf::Shader& unshadowShader,
                     sf::Shader& lightOverShapeShader,
-                    const TransformComponent& transf) const;
+                    const TransformComponent& transf,
+                    const sf::IntRect& region) const;
 
         /** \brief Loads a texture for the light source. Replaces the default texture. */
         void loadTexture(const std::string& path = DEFAULT_TEXTURE_PATH);
@@ -29,14 +29,58 @@
 #include "ungod/visual/LightHandler.h"
 #include "ungod/physics/Physics.h"
 #include "ungod/base/World.h"
+#include <algorithm>
+#include <cmath>
 
 namespace ungod
 {
-    LightHandler::LightHandler() : mAmbientColor(sf::Color::White), mColorShift(0,0,0) {}
+    namespace detail
+    {
+        //tests whether the ellipse inscribed in the light bounds (the actually lit area
+        //of a radial light texture) intersects the given rect
+        bool lightIntersects(const sf::FloatRect& lightBounds, const sf::FloatRect& rect)
+        {
+            float hw = 0.5f * lightBounds.width;
+            float hh = 0.5f * lightBounds.height;
+            if (hw <= 0.0f || hh <= 0.0f)
+                return false;
+            float cx = lightBounds.left + hw;
+            float cy = lightBounds.top + hh;
+            float nx = std::max(rect.left, std::min(cx, rect.left + rect.width));
+            float ny = std::max(rect.top, std::min(cy, rect.top + rect.height));
+            float dx = (nx - cx) / hw;
+            float dy = (ny - cy) / hh;
+            return dx * dx + dy * dy <= 1.0f;
+        }
+
+        //computes the rect of light texture pixels covered by the given bounds, snapped
+        //outwards to the tile grid and clamped to the texture
+        sf::IntRect lightTileRect(const sf::FloatRect& bounds, const sf::View& view, const sf::Vector2u& texSize)
+        {
+            const int tile = (int)LightManager::LIGHT_TILE_SIZE;
+            sf::FloatRect viewport = view.getViewport();
+            sf::Vector2f topLeft = view.getCenter() - 0.5f * view.getSize();
+            float sx = viewport.width * texSize.x / view.getSize().x;
+            float sy = viewport.height * texSize.y / view.getSize().y;
+            float left = viewport.left * texSize.x + (bounds.left - topLeft.x) * sx;
+            float top = viewport.top * texSize.y + (bounds.top - topLeft.y) * sy;
+            float right = left + bounds.width * sx;
+            float bottom = top + bounds.height * sy;
+            int l = std::max(0, (int)std::floor(left / tile) * tile);
+            int t = std::max(0, (int)std::floor(top / tile) * tile);
+            int r = std::min((int)texSize.x, (int)std::ceil(right / tile) * tile);
+            int b = std::min((int)texSize.y, (int)std::ceil(bottom / tile) * tile);
+            return { l, t, r - l, b - t };
+        }
+    }
+
+    LightHandler::LightHandler() : mLightManager(nullptr), mAmbientColor(sf::Color::White), mColorShift(0,0,0),
+        mLightBudget(LightManager::DEFAULT_LIGHT_BUDGET), mShadowedLightCount(0), mSplattedLightCount(0) {}
 
     void LightHandler::init(LightManager& lightManager)
     {
         mLightManager = &lightManager;
+        mLightBudget = lightManager.getDefaultLightBudget();
     }
 
     void LightHandler::render(const quad::PullResult<Entity>& pull, const World& world, sf::RenderTarget& target, sf::RenderStates states, bool drawShadows)
@@ -57,49 +101,151 @@ namespace ungod
         col.g = (sf::Uint8)(col.g * fade + 255u * (1 - fade));
         col.b = (sf::Uint8)(col.b * fade + 255u * (1 - fade));
 
+        //the composition texture may be smaller than the target, lights are composed in its pixel space
+        sf::Vector2u compositionSize = mLightManager->getCompositionTexture().getSize();
+        sf::View compositionView{ sf::FloatRect{0.0f,0.0f,(float)compositionSize.x,(float)compositionSize.y} };
+
         mLightManager->getCompositionTexture().clear(col);
-        // mLightManager->getCompositionTexture().setView(mLightManager->getCompositionTexture().getDefaultView());
-        mLightManager->getCompositionTexture().setView(defaultView); 
+        mLightManager->getCompositionTexture().setView(compositionView); 
 
+        //cull the lights against the view rect and rate them by their contribution to the screen
+        sf::FloatRect viewRect{ target.getView().getCenter() - 0.5f*target.getView().getSize(), target.getView().getSize() };
+        mVisibleLights.clear();
 
         //iterator over the one-light-components
         dom::Utility<Entity>::iterate<TransformComponent, LightEmitterComponent>(pull.getList(),
-          [this, &target, &states, drawShadows, &world] (Entity e, TransformComponent& lightTransf, LightEmitterComponent& light)
+          [this, &viewRect, &states] (Entity e, TransformComponent& lightTransf, LightEmitterComponent& light)
           {
-              renderLight(target, states, world.getQuadTree(), e, lightTransf, light, drawShadows);
+              collectVisibleLight(e, lightTransf, light, viewRect, states.transform);
           });
 
         //iterate over the multiple-light-components
         dom::Utility<Entity>::iterate<TransformComponent, MultiLightEmitter>(pull.getList(),
-          [this, &target, &states, drawShadows, &world] (Entity e, TransformComponent& lightTransf, MultiLightEmitter& light)
+          [this, &viewRect, &states] (Entity e, TransformComponent& lightTransf, MultiLightEmitter& light)
           {
               for (std::size_t i = 0; i < light.getComponentCount(); ++i)
               {
-                renderLight(target, states, world.getQuadTree(), e, lightTransf, light.getComponent(i), drawShadows);
+                collectVisibleLight(e, lightTransf, light.getComponent(i), viewRect, states.transform);
               }
           });
 
+        std::size_t shadowed = std::min(mLightBudget, mVisibleLights.size());
+        std::partial_sort(mVisibleLights.begin(), mVisibleLights.begin() + shadowed, mVisibleLights.end(),
+            [] (const VisibleLight& a, const VisibleLight& b) { return a.contribution > b.contribution; });
+
+        //the most important lights are rendered with shadows
+        for (std::size_t i = 0; i < shadowed; ++i)
+        {
+            const VisibleLight& vl = mVisibleLights[i];
+            renderLight(target, states, world.getQuadTree(), vl.entity, *vl.transf, *vl.light, vl.bounds, drawShadows);
+        }
+
+        //the remaining lights are splatted without shadows, batched by texture
+        for (auto& batch : mSplatBatches)
+            batch.second.clear();
+        for (std::size_t i = shadowed; i < mVisibleLights.size(); ++i)
+            addLightSplat(*mVisibleLights[i].transf, *mVisibleLights[i].light);
+        if (shadowed < mVisibleLights.size())
+        {
+            mLightManager->getCompositionTexture().setView(target.getView());
+            sf::RenderStates splatStates = states;
+            splatStates.blendMode = sf::BlendAdd;
+            for (const auto& batch : mSplatBatches)
+            {
+                if (batch.second.getVertexCount() == 0)
+                    continue;
+                splatStates.texture = batch.first;
+                mLightManager->getCompositionTexture().draw(batch.second, splatStates);
+            }
+            mLightManager->getCompositionTexture().setView(compositionView);
+        }
+
+        mShadowedLightCount = shadowed;
+        mSplattedLightCount = mVisibleLights.size() - shadowed;
+
         mLightManager->getCompositionTexture().display();
 
         sf::RenderStates lightstates{};
 		lightstates.blendMode = sf::BlendMultiply;
 
 		mDisplaySprite.setTexture(mLightManager->getCompositionTexture().getTexture(), true);
+        mDisplaySprite.setPosition(0.0f, 0.0f);
+        mDisplaySprite.setScale((float)target.getSize().x / compositionSize.x, (float)target.getSize().y / compositionSize.y);
 
 		sf::View view = target.getView();
         target.setView(defaultView);
 		target.draw(mDisplaySprite, lightstates);
 		target.setView(view);
+        mDisplaySprite.setScale(1.0f, 1.0f);
     }
 
 
-    void LightHandler::renderLight(sf::RenderTarget& target, sf::RenderStates states, const quad::QuadTree<Entity>& quadtree, Entity e, TransformComponent& lightTransf, LightEmitterComponent& light, bool drawShadows)
+    void LightHandler::collectVisibleLight(Entity e, TransformComponent& lightTransf, LightEmitterComponent& light, const sf::FloatRect& viewRect, const sf::Transform& transform)
+    {
+        if (!light.mLight.isActive())
+            return;
+
+        sf::Transform t = transform;
+        t *= lightTransf.getTransform();
+        sf::FloatRect bounds = t.transformRect(light.mLight.getBoundingBox());
+        if (!detail::lightIntersects(bounds, viewRect))
+            return;
+
+        //contribution is the visible area of the light weighted by its brightness
+        sf::FloatRect visible;
+        bounds.intersects(viewRect, visible);
+        sf::Color color = light.mLight.getColor();
+        float brightness = (0.2126f*color.r + 0.7152f*color.g + 0.0722f*color.b) * color.a / (255.0f*255.0f);
+        mVisibleLights.push_back({ e, &lightTransf, &light, bounds, visible.width * visible.height * brightness });
+    }
+
+
+    void LightHandler::addLightSplat(TransformComponent& lightTransf, LightEmitterComponent& light)
+    {
+        const sf::Sprite& sprite = light.mLight.mSprite;
+        const sf::Texture* texture = sprite.getTexture();
+        if (!texture)
+            return;
+
+        auto batch = std::find_if(mSplatBatches.begin(), mSplatBatches.end(),
+            [texture] (const std::pair<const sf::Texture*, sf::VertexArray>& b) { return b.first == texture; });
+        if (batch == mSplatBatches.end())
+        {
+            mSplatBatches.emplace_back(texture, sf::VertexArray{ sf::Triangles });
+            batch = mSplatBatches.end() - 1;
+        }
+
+        sf::Transform t = lightTransf.getTransform();
+        t *= sprite.getTransform();
+        sf::FloatRect local = sprite.getLocalBounds();
+        sf::IntRect texRect = sprite.getTextureRect();
+        sf::Color color = sprite.getColor();
+
+        sf::Vertex topLeft{ t.transformPoint(local.left, local.top), color,
+                            sf::Vector2f((float)texRect.left, (float)texRect.top) };
+        sf::Vertex topRight{ t.transformPoint(local.left + local.width, local.top), color,
+                            sf::Vector2f((float)(texRect.left + texRect.width), (float)texRect.top) };
+        sf::Vertex botRight{ t.transformPoint(local.left + local.width, local.top + local.height), color,
+                            sf::Vector2f((float)(texRect.left + texRect.width), (float)(texRect.top + texRect.height)) };
+        sf::Vertex botLeft{ t.transformPoint(local.left, local.top + local.height), color,
+                            sf::Vector2f((float)texRect.left, (float)(texRect.top + texRect.height)) };
+
+        batch->second.append(topLeft);
+        batch->second.append(topRight);
+        batch->second.append(botRight);
+        batch->second.append(topLeft);
+        batch->second.append(botRight);
+        batch->second.append(botLeft);
+    }
+
+
+    void LightHandler::renderLight(sf::RenderTarget& target, sf::RenderStates states, const quad::QuadTree<Entity>& quadtree, Entity e, TransformComponent& lightTransf, LightEmitterComponent& light, const sf::FloatRect& bounds, bool drawShadows)
     {
         //pull all entities near the light
         quad::PullResult<Entity> shadowsPull;
-        sf::FloatRect bounds = light.mLight.getBoundingBox();
-        sf::Vector2f transformedUpperBound = lightTransf.getTransform().transformPoint( {bounds.left, bounds.top} );
-        quadtree.retrieve(shadowsPull, { transformedUpperBound.x, transformedUpperBound.y, bounds.width, bounds.height });
+        sf::FloatRect localBounds = light.mLight.getBoundingBox();
+        sf::Vector2f transformedUpperBound = lightTransf.getTransform().transformPoint( {localBounds.left, localBounds.top} );
+        quadtree.retrieve(shadowsPull, { transformedUpperBound.x, transformedUpperBound.y, localBounds.width, localBounds.height });
 
         std::vector< std::pair<LightCollider*, TransformComponent*> > colliders;
 
@@ -130,6 +276,11 @@ namespace ungod
             });
         }
 
+        //only the tiles the light actually touches are rendered and added to the composition
+        sf::IntRect tiles = detail::lightTileRect(bounds, target.getView(), mLightManager->getLightTexture().getSize());
+        if (tiles.width <= 0 || tiles.height <= 0)
+            return;
+
         //render the light and the colliders, draw umbras, penumbras + antumbras
         light.mLight.render(target.getView(), 
                             mLightManager->getLightTexture(),
@@ -139,12 +290,14 @@ namespace ungod
                             colliders, 
                             mLightManager->getUnshadowShader(),
                             mLightManager->getLightOverShapeShader(), 
-                            lightTransf);
+                            lightTransf,
+                            tiles);
 
-        //draw the resulting texture in the application window
         sf::RenderStates compoRenderStates;
         compoRenderStates.blendMode = sf::BlendAdd;
-        mDisplaySprite.setTexture(mLightManager->getLightTexture().getTexture(), true);
+        mDisplaySprite.setTexture(mLightManager->getLightTexture().getTexture());
+        mDisplaySprite.setTextureRect(tiles);
+        mDisplaySprite.setPosition((float)tiles.left, (float)tiles.top);
         mLightManager->getCompositionTexture().draw(mDisplaySprite, compoRenderStates);
     }
 
@@ -179,6 +332,16 @@ namespace ungod
         return mAmbientColor;
     }
 
+    void LightHandler::setLightBudget(std::size_t budget)
+    {
+        mLightBudget = budget;
+    }
+
+    std::size_t LightHandler::getLightBudget() const
+    {
+        return mLightBudget;
+    }
+
     void LightHandler::interpolateAmbientLight(const sf::Color& color, float strength)
     {
         //compute the new color through simple linear interpolation
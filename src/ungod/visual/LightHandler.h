@@ -31,6 +31,7 @@
 
 #include "ungod/visual/LightManager.h"
 #include "owls/Signal.h"
+#include "owls/SlotSignal.h"
 
 namespace ungod
 {
@@ -56,6 +57,20 @@ namespace ungod
         /** \brief Gets the color of the ambient light. */
         sf::Color getAmbientColor() const;
 
+        /** \brief Sets the maximum number of lights that are rendered with shadows per frame.
+        * Visible lights are sorted by their screen contribution. Lights beyond the budget are
+        * rendered as unshadowed splats in a single batched draw call. */
+        void setLightBudget(std::size_t budget);
+
+        /** \brief Returns the maximum number of lights rendered with shadows per frame. */
+        std::size_t getLightBudget() const;
+
+        /** \brief Returns the number of lights that were rendered with shadows in the last frame. */
+        std::size_t getShadowedLightCount() const { return mShadowedLightCount; }
+
+        /** \brief Returns the number of lights that were rendered as unshadowed splats in the last frame. */
+        std::size_t getSplattedLightCount() const { return mSplattedLightCount; }
+
         /**
         * \brief Calling this function over a certain amount of time will result in
         * smoothly color transform to the given color. The strength value should somehow
@@ -168,14 +183,31 @@ namespace ungod
 
 
     private:
+        /** \brief A light that survived culling in the current frame. */
+        struct VisibleLight
+        {
+            Entity entity;
+            TransformComponent* transf;
+            LightEmitterComponent* light;
+            sf::FloatRect bounds;
+            float contribution;
+        };
+
         LightManager* mLightManager;
         sf::Color mAmbientColor;
         sf::Vector3f mColorShift;
         sf::Sprite mDisplaySprite;
-        owls::Signal<Entity, const sf::FloatRect&> mContentsChangedSignal;
+        owls::SlotSignal<Entity, const sf::FloatRect&> mContentsChangedSignal;
+        std::size_t mLightBudget;
+        std::size_t mShadowedLightCount;
+        std::size_t mSplattedLightCount;
+        std::vector<VisibleLight> mVisibleLights;
+        std::vector< std::pair<const sf::Texture*, sf::VertexArray> > mSplatBatches;
 
     private:
-        void renderLight(sf::RenderTarget& target, sf::RenderStates states, const quad::QuadTree<Entity>& quadtree, Entity e, TransformComponent& lightTransf, LightEmitterComponent& light, bool drawShadows);
+        void collectVisibleLight(Entity e, TransformComponent& lightTransf, LightEmitterComponent& light, const sf::FloatRect& viewRect, const sf::Transform& transform);
+        void addLightSplat(TransformComponent& lightTransf, LightEmitterComponent& light);
+        void renderLight(sf::RenderTarget& target, sf::RenderStates states, const quad::QuadTree<Entity>& quadtree, Entity e, TransformComponent& lightTransf, LightEmitterComponent& light, const sf::FloatRect& bounds, bool drawShadows);
     };
 }
 
@@ -33,6 +33,8 @@ namespace ungod
 {
     LightManager::LightManager(Application& app) 
     {
+        mDefaultLightBudget = app.getConfig().getOr<unsigned>("light/light_budget", DEFAULT_LIGHT_BUDGET);
+        mResolutionDivisor = std::max(1u, app.getConfig().getOr<unsigned>("light/resolution_divisor", DEFAULT_RESOLUTION_DIVISOR));
         setImageSize(app.getWindow().getSize());
         mAppSignalLink = app.onTargetSizeChanged([this](const sf::Vector2u& targetsize)
             {
@@ -63,14 +65,27 @@ namespace ungod
 
     void LightManager::setImageSize(const sf::Vector2u& imageSize)
     {
-        mLightTexture.create(imageSize.x, imageSize.y);
-        mEmissionTexture.create(imageSize.x, imageSize.y);
-        mAntumbraTexture.create(imageSize.x, imageSize.y);
-        mCompositionTexture.create(imageSize.x, imageSize.y);
-        mLightOverShapeShader.setUniform("targetSizeInv", sf::Glsl::Vec2(1.0f / imageSize.x, 1.0f / imageSize.y));
+        mImageSize = imageSize;
+        sf::Vector2u lightSize{ std::max(1u, (imageSize.x + mResolutionDivisor - 1) / mResolutionDivisor),
+                                std::max(1u, (imageSize.y + mResolutionDivisor - 1) / mResolutionDivisor) };
+        mLightTexture.create(lightSize.x, lightSize.y);
+        mEmissionTexture.create(lightSize.x, lightSize.y);
+        mAntumbraTexture.create(lightSize.x, lightSize.y);
+        mCompositionTexture.create(lightSize.x, lightSize.y);
+        mCompositionTexture.setSmooth(mResolutionDivisor > 1);
+        mLightOverShapeShader.setUniform("targetSizeInv", sf::Glsl::Vec2(1.0f / lightSize.x, 1.0f / lightSize.y));
         mLightOverShapeShader.setUniform("emissionTexture", mEmissionTexture.getTexture());
     }
 
+    void LightManager::setResolutionDivisor(unsigned divisor)
+    {
+        divisor = std::max(1u, divisor);
+        if (divisor == mResolutionDivisor)
+            return;
+        mResolutionDivisor = divisor;
+        setImageSize(mImageSize);
+    }
+
 
     LightManager::~LightManager()
     {
@@ -46,6 +46,14 @@ namespace ungod
         /** \brief Updates the size of the underlying render-textures (e.g. if the window was resized). */
         void setImageSize(const sf::Vector2u& imageSize); 
 
+        /** \brief Sets the factor by which the light textures are smaller than the target, e.g.
+        * 2 or 4 for accumulating light at 1/2 or 1/4 of the target resolution. The composed light
+        * is upscaled when multiplied onto the scene. A divisor of 1 renders light at full resolution. */
+        void setResolutionDivisor(unsigned divisor);
+
+        /** \brief Returns the current resolution divisor. */
+        unsigned getResolutionDivisor() const { return mResolutionDivisor; }
+
         sf::RenderTexture& getLightTexture() { return mLightTexture; }
         sf::RenderTexture& getEmissionTexture() { return mEmissionTexture; }
         sf::RenderTexture& getAntumbraTexture() { return mAntumbraTexture; }
@@ -53,6 +61,10 @@ namespace ungod
 
         sf::Shader& getUnshadowShader() { return mUnshadowShader; }
         sf::Shader& getLightOverShapeShader() { return mLightOverShapeShader; }
+
+        /** \brief Returns the light budget read from the config, that is the maximum number of
+        * lights rendered with shadows per frame. Used as initial value for all LightHandlers. */
+        std::size_t getDefaultLightBudget() const { return mDefaultLightBudget; }
         
         ~LightManager();
 
@@ -61,6 +73,14 @@ namespace ungod
         sf::Shader mUnshadowShader, mLightOverShapeShader;
         ungod::Image mPenumbraTexture;
         owls::SignalLink<void, const sf::Vector2u&> mAppSignalLink;
+        std::size_t mDefaultLightBudget;
+        sf::Vector2u mImageSize;
+        unsigned mResolutionDivisor;
+
+    public:
+        static constexpr unsigned DEFAULT_LIGHT_BUDGET = 32;
+        static constexpr unsigned DEFAULT_RESOLUTION_DIVISOR = 1;
+        static constexpr unsigned LIGHT_TILE_SIZE = 32; ///<granularity in pixels at which lights are composed
     };
 }
 
@@ -33,17 +33,43 @@
 
 namespace ungod
 {
-    Renderer::Renderer(Application& app) : mShowWater(false), mDrawCalls(0)
+    namespace detail
     {
-        mShowWater = mWaterTex.create(app.getWindow().getSize().x, app.getWindow().getSize().y);
-        mWaterTex.setRepeated(true);
+        //multiplies the alpha of the drawn fragments with the opacity uniform
+        const char* const REFLECTION_FRAGMENT_SHADER =
+            "uniform sampler2D texture;"
+            "uniform float opacity;"
+            "void main()"
+            "{"
+            "    vec4 color = texture2D(texture, gl_TexCoord[0].xy) * gl_Color;"
+            "    gl_FragColor = vec4(color.rgb, color.a * opacity);"
+            "}";
+    }
+
+    constexpr unsigned Renderer::DEFAULT_REFLECTION_RESOLUTION_DIVISOR;
+
+    Renderer::Renderer(Application& app) : mReflectionShaderLoaded(false), mShowWater(false), mReflectionDivisor(DEFAULT_REFLECTION_RESOLUTION_DIVISOR), mDrawCalls(0)
+    {
+        mReflectionDivisor = std::max(1u, app.getConfig().getOr<unsigned>("water/reflection_resolution_divisor", DEFAULT_REFLECTION_RESOLUTION_DIVISOR));
+        mReflectionShaderLoaded = sf::Shader::isAvailable() && mReflectionShader.loadFromMemory(detail::REFLECTION_FRAGMENT_SHADER, sf::Shader::Fragment);
+        if (mReflectionShaderLoaded)
+            mReflectionShader.setUniform("texture", sf::Shader::CurrentTexture);
+        createWaterTextures(app.getWindow().getSize());
         app.onTargetSizeChanged([this, &app](const sf::Vector2u& targetsize)
             {
-                mShowWater = mWaterTex.create(app.getWindow().getSize().x, app.getWindow().getSize().y);
-                mWaterTex.setRepeated(true);
+                createWaterTextures(app.getWindow().getSize());
             });
     }
 
+
+    void Renderer::createWaterTextures(const sf::Vector2u& size)
+    {
+        mShowWater = mWaterTex.create(size.x, size.y);
+        mWaterTex.setRepeated(true);
+        mShowWater = mShowWater && mReflectionTex.create(std::max(1u, size.x / mReflectionDivisor), std::max(1u, size.y / mReflectionDivisor));
+        mReflectionTex.setSmooth(mReflectionDivisor > 1);
+    }
+
     void Renderer::renewRenderlist(const quad::QuadTree<Entity>& entities, quad::PullResult<Entity>& pull, const sf::RenderTarget& target, sf::RenderStates states) const
     {
         pull.getList().clear();
@@ -88,8 +114,8 @@ namespace ungod
               if (e.has<WaterComponent>())
               {
                   if (target.getSize() != mWaterTex.getSize())
-                      mWaterTex.create(target.getSize().x, target.getSize().y);
-                  e.get<WaterComponent>().mWater.render(target, mWaterTex, e.get<TileMapComponent>().mTileMap, &vis.getTexture(), states, e.get<WaterComponent>().getReflectionWorlds());
+                      createWaterTextures(target.getSize());
+                  e.get<WaterComponent>().mWater.render(target, mWaterTex, mReflectionTex, mReflectionShaderLoaded ? &mReflectionShader : nullptr, e.get<TileMapComponent>().mTileMap, &vis.getTexture(), states, e.get<WaterComponent>().getReflectionWorlds());
               }
               else
                   e.get<TileMapComponent>().mTileMap.render(target, &vis.getTexture(), states);
@@ -271,6 +297,9 @@ namespace ungod
         dom::Utility<Entity>::iterate<TransformComponent, VisualsComponent>(pull.getList(),
           [this, &target, &states, localCamCenter, &visualsHandler] (Entity e, TransformComponent& transf, VisualsComponent& vis)
           {
+            if (!vis.isLoaded())
+                vis.mImage.prioritize(); //entity is on screen, load its texture before the ones that are not
+
             if (vis.isHiddenForCamera())
             {
                 if (transf.getBounds().contains(localCamCenter))
@@ -307,6 +336,8 @@ namespace ungod
         dom::Utility<Entity>::iterate<TransformComponent, BigSpriteComponent>(pull.getList(),
           [this, &target, &states] (Entity e, TransformComponent& transf, BigSpriteComponent& bs)
           {
+              if (!bs.isLoaded())
+                  bs.mBigImage.prioritize();
               if (bs.isVisible() && bs.isLoaded())
               {
                 states.transform *= transf.getTransform();
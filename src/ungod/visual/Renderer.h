@@ -109,13 +109,20 @@ namespace ungod
         int getDrawCalls() const { return mDrawCalls;  }
 
         static constexpr float INNER_RECT_PERCENTAGE = 0.1f;
+        static constexpr unsigned DEFAULT_REFLECTION_RESOLUTION_DIVISOR = 2; ///< water reflections are rendered at the target size divided by this value
 
     private:
         sf::RenderTexture mWaterTex;
+        sf::RenderTexture mReflectionTex;
+        sf::Shader mReflectionShader; ///< scales the alpha of reflected entities by the reflection opacity of the water
+        bool mReflectionShaderLoaded;
         bool mShowWater;
+        unsigned mReflectionDivisor;
         int mDrawCalls;
 
     private:
+        void createWaterTextures(const sf::Vector2u& size);
+
         void updateAnimation(Entity e, AnimationComponent& animation, float delta, VisualsHandler& vh);
     };
 
@@ -27,6 +27,7 @@
 #define VISUAL_H
 
 #include "owls/Signal.h"
+#include "owls/SlotSignal.h"
 #include "quadtree/QuadTree.h"
 #include "ungod/visual/Image.h"
 #include "ungod/visual/Sprite.h"
@@ -52,6 +53,7 @@ namespace ungod
     class VisualsComponent : public Serializable<VisualsComponent>
     {
     friend class VisualsHandler;
+    friend class Renderer;
     friend struct SerialBehavior<VisualsComponent, Entity>;
     public:
         VisualsComponent();
@@ -510,11 +512,11 @@ namespace ungod
         static void componentOpacitySet(Entity e, float opacity);
 
     private:
-        owls::Signal<Entity, const sf::FloatRect&> mContentsChangedSignal;
-        owls::Signal<Entity, bool> mVisibilityChangedSignal;
-        owls::Signal<Entity, const std::string&> mAnimationStartSignal;
-        owls::Signal<Entity, const std::string&, int> mAnimationFrameSignal;
-        owls::Signal<Entity, const std::string&> mAnimationStopSignal;
+        owls::SlotSignal<Entity, const sf::FloatRect&> mContentsChangedSignal;
+        owls::SlotSignal<Entity, bool> mVisibilityChangedSignal;
+        owls::SlotSignal<Entity, const std::string&> mAnimationStartSignal;
+        owls::SlotSignal<Entity, const std::string&, int> mAnimationFrameSignal;
+        owls::SlotSignal<Entity, const std::string&> mAnimationStopSignal;
     };
 }
 